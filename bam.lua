@@ -234,7 +234,12 @@ function build(settings)
 	tools = {}
 	for i,v in ipairs(tools_src) do
 		toolname = PathFilename(PathBase(v))
-		tools[i] = Link(settings, toolname, Compile(settings, v), engine, zlib, pnglite)
+		if toolname == "fake_clients" or toolname == "snapshot_bench" then
+			-- speaks the game protocol, the bench reads demos
+			tools[i] = Link(settings, toolname, Compile(settings, v), game_shared, engine, zlib, pnglite)
+		else
+			tools[i] = Link(settings, toolname, Compile(settings, v), engine, zlib, pnglite)
+		end
 	end
 
 	-- build client, server, version server and master server
@@ -66,6 +66,7 @@ enum
 	TILECHANGE_MAX_PACKS=50,
 	TILE_DESTROY=-1,
 	TILE_CREATE,
+	TILE_SKIP, // a free slot of the map state, only sent to keep the chunk indices going
 };
 '''
 
@@ -293,6 +294,13 @@ Objects = [
 		NetIntRange("m_Item19", 0, 'NUM_WEAPONS+NUM_BLOCKS'), NetIntRange("m_Ammo19", 0, 64),
 		NetIntRange("m_Item20", 0, 'NUM_WEAPONS+NUM_BLOCKS'), NetIntRange("m_Ammo20", 0, 64),
 	]),
+	NetObject("Npc:CharacterCore", [
+		NetIntRange("m_Type", 'TEAM_ENEMY_TEEPER', 'TEAM_ANIMAL_TEEPIG'),
+		NetIntRange("m_Health", 0, 10),
+		NetIntRange("m_Weapon", 0, 'NUM_WEAPONS+NUM_BLOCKS-1'),
+		NetIntRange("m_Emote", 0, len(Emotes)),
+		NetIntRange("m_AttackTick", 0, 'max_int'),
+	]),
 ]
 
 Messages = [
@@ -443,7 +451,12 @@ Messages = [
 		NetIntAny("m_ITile"),
 		NetIntAny("m_State"),
 		NetIntAny("m_Col"),
-		NetIntRange("m_Act", 'TILE_DESTROY', 'TILE_CREATE'),
+		NetIntRange("m_Act", 'TILE_DESTROY', 'TILE_SKIP'),
+	]),
+
+	# followed by m_NumRuns runs of tile changes, see CGameContext::FlushTileChanges
+	NetMessage("Sv_TileChangeBatch", [
+		NetIntAny("m_NumRuns"),
 	]),
 
 	#NetMessage("Sv_TrunkItemSelected", [
@@ -1,5 +1,9 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE /* recvmmsg and sendmmsg */
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -29,6 +33,12 @@
 
 	#include <dirent.h>
 
+	#if defined(CONF_PLATFORM_LINUX)
+		#include <sys/epoll.h>
+		#include <sys/eventfd.h>
+		#include <sys/timerfd.h>
+	#endif
+
 	#if defined(CONF_PLATFORM_MACOSX)
 		#include <Carbon/Carbon.h>
 	#endif
@@ -549,6 +559,31 @@ void lock_release(LOCK lock)
 #endif
 }
 
+void sync_barrier()
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+#if !defined(CONF_PLATFORM_MACOSX)
+	#if defined(CONF_FAMILY_UNIX)
+	void semaphore_init(SEMAPHORE *sem) { sem_init(sem, 0, 0); }
+	void semaphore_wait(SEMAPHORE *sem) { sem_wait(sem); }
+	void semaphore_signal(SEMAPHORE *sem) { sem_post(sem); }
+	void semaphore_destroy(SEMAPHORE *sem) { sem_destroy(sem); }
+	#elif defined(CONF_FAMILY_WINDOWS)
+	void semaphore_init(SEMAPHORE *sem) { *sem = CreateSemaphore(0, 0, 10000, 0); }
+	void semaphore_wait(SEMAPHORE *sem) { WaitForSingleObject((HANDLE)*sem, INFINITE); }
+	void semaphore_signal(SEMAPHORE *sem) { ReleaseSemaphore((HANDLE)*sem, 1, NULL); }
+	void semaphore_destroy(SEMAPHORE *sem) { CloseHandle((HANDLE)*sem); }
+	#else
+		#error not implemented on this platform
+	#endif
+#endif
+
 /* -----  time ----- */
 int64 time_get()
 {
@@ -988,6 +1023,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in(addr, &sa);
 
 			d = sendto((int)sock.ipv4sock, (const char*)data, size, 0, (struct sockaddr *)&sa, sizeof(sa));
+			network_stats.send_calls++;
 		}
 		else
 			dbg_msg("net", "can't sent ipv4 traffic to this socket");
@@ -1011,6 +1047,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in6(addr, &sa);
 
 			d = sendto((int)sock.ipv6sock, (const char*)data, size, 0, (struct sockaddr *)&sa, sizeof(sa));
+			network_stats.send_calls++;
 		}
 		else
 			dbg_msg("net", "can't sent ipv6 traffic to this socket");
@@ -1046,12 +1083,14 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, void *data, int maxsize)
 	{
 		fromlen = sizeof(struct sockaddr_in);
 		bytes = recvfrom(sock.ipv4sock, (char*)data, maxsize, 0, (struct sockaddr *)&sockaddrbuf, &fromlen);
+		network_stats.recv_calls++;
 	}
 
 	if(bytes <= 0 && sock.ipv6sock >= 0)
 	{
 		fromlen = sizeof(struct sockaddr_in6);
 		bytes = recvfrom(sock.ipv6sock, (char*)data, maxsize, 0, (struct sockaddr *)&sockaddrbuf, &fromlen);
+		network_stats.recv_calls++;
 	}
 
 	if(bytes > 0)
@@ -1066,6 +1105,164 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, void *data, int maxsize)
 	return -1; /* error */
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+/* messages handed to the kernel per call */
+enum { NET_MMSG_MAX = 64 };
+
+typedef union
+{
+	struct sockaddr_in in;
+	struct sockaddr_in6 in6;
+} MMSG_ADDR;
+
+static int priv_net_sendmmsg(int sock, struct mmsghdr *msgs, int num)
+{
+	int sent = 0;
+	while(sent < num)
+	{
+		int r = sendmmsg(sock, msgs+sent, num-sent, 0);
+		network_stats.send_calls++;
+		if(r < 0)
+		{
+			/* the first message failed, drop it like sendto would */
+			sent++;
+			continue;
+		}
+		sent += r;
+	}
+	return sent;
+}
+#endif
+
+int net_udp_send_batch(NETSOCKET sock, const NETPACKET *packets, int num)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	struct mmsghdr msgs[NET_MMSG_MAX];
+	struct iovec iovs[NET_MMSG_MAX];
+	MMSG_ADDR addrs[NET_MMSG_MAX];
+	int sent = 0;
+	int i = 0;
+
+	while(i < num)
+	{
+		unsigned type = packets[i].addr.type;
+		int s = type == NETTYPE_IPV4 ? sock.ipv4sock : type == NETTYPE_IPV6 ? sock.ipv6sock : -1;
+		int n = 0;
+
+		/* broadcasts and sockets that can't take the packet go the slow way */
+		if(s < 0)
+		{
+			if(net_udp_send(sock, &packets[i].addr, packets[i].data, packets[i].size) >= 0)
+				sent++;
+			i++;
+			continue;
+		}
+
+		/* hand over a run of packets for the same socket at once */
+		for(; i+n < num && n < NET_MMSG_MAX && packets[i+n].addr.type == type; n++)
+		{
+			const NETPACKET *p = &packets[i+n];
+			mem_zero(&msgs[n], sizeof(msgs[n]));
+			if(type == NETTYPE_IPV4)
+			{
+				netaddr_to_sockaddr_in(&p->addr, &addrs[n].in);
+				msgs[n].msg_hdr.msg_namelen = sizeof(addrs[n].in);
+			}
+			else
+			{
+				netaddr_to_sockaddr_in6(&p->addr, &addrs[n].in6);
+				msgs[n].msg_hdr.msg_namelen = sizeof(addrs[n].in6);
+			}
+			iovs[n].iov_base = p->data;
+			iovs[n].iov_len = p->size;
+			msgs[n].msg_hdr.msg_name = &addrs[n];
+			msgs[n].msg_hdr.msg_iov = &iovs[n];
+			msgs[n].msg_hdr.msg_iovlen = 1;
+			network_stats.sent_bytes += p->size;
+			network_stats.sent_packets++;
+		}
+
+		sent += priv_net_sendmmsg(s, msgs, n);
+		i += n;
+	}
+	return sent;
+#else
+	int sent = 0;
+	int i;
+	for(i = 0; i < num; i++)
+	{
+		if(net_udp_send(sock, &packets[i].addr, packets[i].data, packets[i].size) >= 0)
+			sent++;
+	}
+	return sent;
+#endif
+}
+
+int net_udp_recv_batch(NETSOCKET sock, NETPACKET *packets, int num)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	struct mmsghdr msgs[NET_MMSG_MAX];
+	struct iovec iovs[NET_MMSG_MAX];
+	MMSG_ADDR addrs[NET_MMSG_MAX];
+	int socks[2];
+	int received = 0;
+	int i, j;
+
+	if(num > NET_MMSG_MAX)
+		num = NET_MMSG_MAX;
+
+	socks[0] = sock.ipv4sock;
+	socks[1] = sock.ipv6sock;
+	for(i = 0; i < 2 && received < num; i++)
+	{
+		int n = num-received;
+		int r;
+		if(socks[i] < 0)
+			continue;
+
+		for(j = 0; j < n; j++)
+		{
+			NETPACKET *p = &packets[received+j];
+			mem_zero(&msgs[j], sizeof(msgs[j]));
+			iovs[j].iov_base = p->data;
+			iovs[j].iov_len = p->size;
+			msgs[j].msg_hdr.msg_name = &addrs[j];
+			msgs[j].msg_hdr.msg_namelen = sizeof(addrs[j]);
+			msgs[j].msg_hdr.msg_iov = &iovs[j];
+			msgs[j].msg_hdr.msg_iovlen = 1;
+		}
+
+		r = recvmmsg(socks[i], msgs, n, MSG_DONTWAIT, 0);
+		network_stats.recv_calls++;
+		if(r <= 0)
+			continue;
+
+		for(j = 0; j < r; j++)
+		{
+			NETPACKET *p = &packets[received+j];
+			sockaddr_to_netaddr((struct sockaddr *)&addrs[j], &p->addr);
+			p->size = msgs[j].msg_len;
+			network_stats.recv_bytes += p->size;
+			network_stats.recv_packets++;
+		}
+		received += r;
+	}
+	return received;
+#else
+	int received = 0;
+	while(received < num)
+	{
+		NETPACKET *p = &packets[received];
+		int bytes = net_udp_recv(sock, &p->addr, p->data, p->size);
+		if(bytes <= 0)
+			break;
+		p->size = bytes;
+		received++;
+	}
+	return received;
+#endif
+}
+
 int net_udp_close(NETSOCKET sock)
 {
 	return priv_net_close_all_sockets(sock);
@@ -1541,6 +1738,175 @@ int net_socket_read_wait(NETSOCKET sock, int time)
 	return 0;
 }
 
+enum { NET_WAIT_MAX_FDS = 32 };
+
+struct NETWAITINTERNAL
+{
+	int fds[NET_WAIT_MAX_FDS]; /* sockets the last call waited for */
+	int num_fds;
+#if defined(CONF_PLATFORM_LINUX)
+	int epoll;
+	int timer;
+	int event;
+#else
+	volatile int signaled;
+#endif
+};
+
+static int priv_net_wait_fds(const NETSOCKET *socks, int num, int *fds)
+{
+	int num_fds = 0;
+	int i;
+	for(i = 0; i < num; i++)
+	{
+		if(socks[i].ipv4sock >= 0 && num_fds < NET_WAIT_MAX_FDS)
+			fds[num_fds++] = socks[i].ipv4sock;
+		if(socks[i].ipv6sock >= 0 && num_fds < NET_WAIT_MAX_FDS)
+			fds[num_fds++] = socks[i].ipv6sock;
+	}
+	return num_fds;
+}
+
+NETWAIT net_wait_create()
+{
+	struct NETWAITINTERNAL *wait = (struct NETWAITINTERNAL *)mem_alloc(sizeof(struct NETWAITINTERNAL), 1);
+	mem_zero(wait, sizeof(*wait));
+#if defined(CONF_PLATFORM_LINUX)
+	{
+		struct epoll_event ev;
+		wait->epoll = epoll_create(NET_WAIT_MAX_FDS+2);
+		wait->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+		wait->event = eventfd(0, EFD_NONBLOCK);
+
+		mem_zero(&ev, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = wait->timer;
+		epoll_ctl(wait->epoll, EPOLL_CTL_ADD, wait->timer, &ev);
+		ev.data.fd = wait->event;
+		epoll_ctl(wait->epoll, EPOLL_CTL_ADD, wait->event, &ev);
+	}
+#endif
+	return wait;
+}
+
+void net_wait_destroy(NETWAIT wait)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	close(wait->epoll);
+	close(wait->timer);
+	close(wait->event);
+#endif
+	mem_free(wait);
+}
+
+int net_wait(NETWAIT wait, const NETSOCKET *socks, int num, int64 deadline)
+{
+	int fds[NET_WAIT_MAX_FDS];
+	int num_fds = priv_net_wait_fds(socks, num, fds);
+	int64 now = time_get();
+	int64 remaining = deadline-now;
+	int i;
+
+	if(deadline >= 0 && remaining <= 0)
+		return 0;
+
+#if defined(CONF_PLATFORM_LINUX)
+	{
+		struct epoll_event events[NET_WAIT_MAX_FDS+2];
+		struct itimerspec timeout;
+		int woken = 0;
+		int n, j;
+
+		/* keep the registered sockets in sync with the ones asked for. adding
+		fails for the ones that are there already, but a closed socket leaves
+		the set on its own and its number might have been reused since */
+		for(i = 0; i < wait->num_fds; i++)
+		{
+			for(j = 0; j < num_fds && fds[j] != wait->fds[i]; j++);
+			if(j == num_fds)
+				epoll_ctl(wait->epoll, EPOLL_CTL_DEL, wait->fds[i], 0);
+		}
+		for(i = 0; i < num_fds; i++)
+		{
+			struct epoll_event ev;
+			mem_zero(&ev, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = fds[i];
+			epoll_ctl(wait->epoll, EPOLL_CTL_ADD, fds[i], &ev);
+		}
+		mem_copy(wait->fds, fds, sizeof(int)*num_fds);
+		wait->num_fds = num_fds;
+
+		/* arming the timer also clears an expiry that was not read */
+		mem_zero(&timeout, sizeof(timeout));
+		if(deadline >= 0)
+		{
+			int64 ns = remaining*1000000000/time_freq();
+			timeout.it_value.tv_sec = ns/1000000000;
+			timeout.it_value.tv_nsec = ns%1000000000;
+		}
+		timerfd_settime(wait->timer, 0, &timeout, 0);
+
+		n = epoll_wait(wait->epoll, events, NET_WAIT_MAX_FDS+2, -1);
+		for(i = 0; i < n; i++)
+		{
+			if(events[i].data.fd == wait->timer || events[i].data.fd == wait->event)
+			{
+				unsigned long long count;
+				if(read(events[i].data.fd, &count, sizeof(count)) < 0) {}
+				if(events[i].data.fd == wait->event)
+					woken = 1;
+			}
+			else
+				woken = 1;
+		}
+		return woken;
+	}
+#else
+	/* select in slices, a signal is only noticed between them */
+	while(!wait->signaled)
+	{
+		struct timeval tv;
+		fd_set readfds;
+		int max_fd = 0;
+		int64 slice = time_freq()/1000;
+
+		if(deadline >= 0)
+		{
+			remaining = deadline-time_get();
+			if(remaining <= 0)
+				return 0;
+			if(remaining < slice)
+				slice = remaining;
+		}
+
+		FD_ZERO(&readfds);
+		for(i = 0; i < num_fds; i++)
+		{
+			FD_SET(fds[i], &readfds);
+			if(fds[i] > max_fd)
+				max_fd = fds[i];
+		}
+		tv.tv_sec = 0;
+		tv.tv_usec = (long)(slice*1000000/time_freq());
+		if(select(max_fd+1, &readfds, NULL, NULL, &tv) > 0)
+			return 1;
+	}
+	wait->signaled = 0;
+	return 1;
+#endif
+}
+
+void net_wait_signal(NETWAIT wait)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	unsigned long long one = 1;
+	if(write(wait->event, &one, sizeof(one)) < 0) {}
+#else
+	wait->signaled = 1;
+#endif
+}
+
 unsigned time_timestamp()
 {
 	return time(0);
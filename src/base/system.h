@@ -388,6 +388,32 @@ int lock_try(LOCK lock);
 void lock_wait(LOCK lock);
 void lock_release(LOCK lock);
 
+/*
+	Function: sync_barrier
+		Makes sure that all memory operations before the barrier are
+		visible to other threads before any memory operation after it.
+*/
+void sync_barrier();
+
+
+/* Group: Semaphores */
+
+#if !defined(CONF_PLATFORM_MACOSX)
+	#if defined(CONF_FAMILY_UNIX)
+		#include <semaphore.h>
+		typedef sem_t SEMAPHORE;
+	#elif defined(CONF_FAMILY_WINDOWS)
+		typedef void* SEMAPHORE;
+	#else
+		#error missing sempahore implementation
+	#endif
+
+	void semaphore_init(SEMAPHORE *sem);
+	void semaphore_wait(SEMAPHORE *sem);
+	void semaphore_signal(SEMAPHORE *sem);
+	void semaphore_destroy(SEMAPHORE *sem);
+#endif
+
 /* Group: Timer */
 #ifdef __GNUC__
 /* if compiled with -pedantic-errors it will complain about long
@@ -452,6 +478,13 @@ typedef struct
 	unsigned short port;
 } NETADDR;
 
+typedef struct
+{
+	NETADDR addr;
+	void *data;
+	int size;
+} NETPACKET;
+
 /*
 	Function: net_init
 		Initiates network functionallity.
@@ -565,6 +598,45 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 */
 int net_udp_recv(NETSOCKET sock, NETADDR *addr, void *data, int maxsize);
 
+/*
+	Function: net_udp_send_batch
+		Sends several packets over an UDP socket with as few system
+		calls as possible.
+
+	Parameters:
+		sock - Socket to use.
+		packets - Packets to send, each with its address, data and size.
+		num - Number of packets.
+
+	Returns:
+		The number of packets that were sent.
+
+	Remarks:
+		- Uses sendmmsg where it is available, elsewhere it is the same
+		as calling net_udp_send for each packet.
+*/
+int net_udp_send_batch(NETSOCKET sock, const NETPACKET *packets, int num);
+
+/*
+	Function: net_udp_recv_batch
+		Recives the packets that are waiting on an UDP socket with as
+		few system calls as possible. Does not block.
+
+	Parameters:
+		sock - Socket to use.
+		packets - Packets to fill in. data has to point to a buffer of
+			size bytes, size is set to the number of bytes recived.
+		num - Maximum number of packets to recive.
+
+	Returns:
+		The number of packets that were recived.
+
+	Remarks:
+		- Uses recvmmsg where it is available, elsewhere it is the same
+		as calling net_udp_recv until there is nothing left.
+*/
+int net_udp_recv_batch(NETSOCKET sock, NETPACKET *packets, int num);
+
 /*
 	Function: net_udp_close
 		Closes an UDP socket.
@@ -1162,6 +1234,50 @@ int net_would_block();
 
 int net_socket_read_wait(NETSOCKET sock, int time);
 
+typedef struct NETWAITINTERNAL *NETWAIT;
+
+/*
+	Function: net_wait_create
+		Creates an object to sleep on several sockets with a precise
+		wake up time.
+
+	Remarks:
+		- Uses epoll, a timerfd and an eventfd where they are available,
+		elsewhere it falls back to select.
+*/
+NETWAIT net_wait_create();
+
+/*
+	Function: net_wait_destroy
+		Frees what net_wait_create created.
+*/
+void net_wait_destroy(NETWAIT wait);
+
+/*
+	Function: net_wait
+		Sleeps until one of the sockets is readable, the deadline has
+		passed or another thread called net_wait_signal.
+
+	Parameters:
+		wait - Object from net_wait_create.
+		socks - Sockets to wait for, may change between calls.
+		num - Number of sockets.
+		deadline - <time_get> value to wake up at, negative to wait
+			without a deadline.
+
+	Returns:
+		1 when woken up by a socket or a signal, 0 when the deadline
+		passed.
+*/
+int net_wait(NETWAIT wait, const NETSOCKET *socks, int num, int64 deadline);
+
+/*
+	Function: net_wait_signal
+		Wakes up a thread that sleeps in net_wait, or makes its next
+		net_wait return right away. Can be called from any thread.
+*/
+void net_wait_signal(NETWAIT wait);
+
 void mem_debug_dump(IOHANDLE file);
 
 void swap_endian(void *data, unsigned elem_size, unsigned num);
@@ -1208,6 +1324,8 @@ typedef struct
 	int sent_bytes;
 	int recv_packets;
 	int recv_bytes;
+	int send_calls; /* system calls, several packets can go in one */
+	int recv_calls;
 } NETSTATS;
 
 
@@ -299,7 +299,8 @@ CClient::CClient() : m_DemoPlayer(&m_SnapshotDelta), m_DemoRecorder(&m_SnapshotD
 
 	m_CurrentServerInfoRequestTime = -1;
 
-	m_CurrentInput = 0;
+	for(int i = 0; i < INPUT_RING_SIZE; i++)
+		m_aInputs[i].m_Tick = -1;
 
 	m_State = IClient::STATE_OFFLINE;
 	m_aServerAddressStr[0] = 0;
@@ -438,7 +439,8 @@ void CClient::SendInput()
 		return;
 
 	// fetch input
-	int Size = GameClient()->OnSnapInput(m_aInputs[m_CurrentInput].m_aData);
+	int aData[MAX_INPUT_SIZE];
+	int Size = GameClient()->OnSnapInput(aData);
 
 	if(!Size)
 		return;
@@ -449,16 +451,16 @@ void CClient::SendInput()
 	Msg.AddInt(m_PredTick);
 	Msg.AddInt(Size);
 
-	m_aInputs[m_CurrentInput].m_Tick = m_PredTick;
-	m_aInputs[m_CurrentInput].m_PredictedTime = m_PredictedTime.Get(Now);
-	m_aInputs[m_CurrentInput].m_Time = Now;
+	// a newer input for the same tick replaces the old one
+	int Slot = m_PredTick&INPUT_RING_MASK;
+	mem_copy(m_aInputs[Slot].m_aData, aData, Size);
+	m_aInputs[Slot].m_Tick = m_PredTick;
+	m_aInputs[Slot].m_PredictedTime = m_PredictedTime.Get(Now);
+	m_aInputs[Slot].m_Time = Now;
 
 	// pack it
 	for(int i = 0; i < Size/4; i++)
-		Msg.AddInt(m_aInputs[m_CurrentInput].m_aData[i]);
-
-	m_CurrentInput++;
-	m_CurrentInput%=200;
+		Msg.AddInt(aData[i]);
 
 	SendMsgEx(&Msg, MSGFLAG_FLUSH);
 }
@@ -468,18 +470,15 @@ const char *CClient::LatestVersion()
 	return m_aVersionStr;
 }
 
-// TODO: OPT: do this alot smarter!
 int *CClient::GetInput(int Tick)
 {
-	int Best = -1;
-	for(int i = 0; i < 200; i++)
+	// the latest input at or before the tick, ticks without an input of their own are rare
+	for(int i = 0; i < INPUT_RING_SIZE && Tick-i >= 0; i++)
 	{
-		if(m_aInputs[i].m_Tick <= Tick && (Best == -1 || m_aInputs[Best].m_Tick < m_aInputs[i].m_Tick))
-			Best = i;
+		int Slot = (Tick-i)&INPUT_RING_MASK;
+		if(m_aInputs[Slot].m_Tick == Tick-i)
+			return (int *)m_aInputs[Slot].m_aData;
 	}
-
-	if(Best != -1)
-		return (int *)m_aInputs[Best].m_aData;
 	return 0;
 }
 
@@ -507,9 +506,8 @@ void CClient::OnEnterGame()
 {
 	// reset input
 	int i;
-	for(i = 0; i < 200; i++)
+	for(i = 0; i < INPUT_RING_SIZE; i++)
 		m_aInputs[i].m_Tick = -1;
-	m_CurrentInput = 0;
 
 	// reset snapshots
 	m_aSnapshots[SNAP_CURRENT] = 0;
@@ -668,19 +666,20 @@ void CClient::SnapInvalidateItem(int SnapID, int Index)
 
 void *CClient::SnapFindItem(int SnapID, int Type, int ID)
 {
-	// TODO: linear search. should be fixed.
-	int i;
+	CSnapshotStorage::CHolder *pHolder = m_aSnapshots[SnapID];
+	if(!pHolder)
+		return 0x0;
 
-	if(!m_aSnapshots[SnapID])
+	int Key = (Type<<16)|ID;
+	int Index = pHolder->m_pIndex ? pHolder->m_pIndex->GetItemIndex(Key) : pHolder->m_pSnap->GetItemIndex(Key);
+	if(Index == -1)
 		return 0x0;
 
-	for(i = 0; i < m_aSnapshots[SnapID]->m_pSnap->NumItems(); i++)
-	{
-		CSnapshotItem *pItem = m_aSnapshots[SnapID]->m_pAltSnap->GetItem(i);
-		if(pItem->Type() == Type && pItem->ID() == ID)
-			return (void *)pItem->Data();
-	}
-	return 0x0;
+	// invalidated items only differ in the alternative snapshot
+	CSnapshotItem *pItem = pHolder->m_pAltSnap->GetItem(Index);
+	if(pItem->Key() != Key)
+		return 0x0;
+	return (void *)pItem->Data();
 }
 
 int CClient::SnapNumItems(int SnapID)
@@ -1007,12 +1006,14 @@ void CClient::ProcessConnlessPacket(CNetChunk *pPacket)
 		Info.m_MaxClients = str_toint(Up.GetString());
 
 		// don't add invalid info to the server browser list
-		if(Info.m_NumClients < 0 || Info.m_NumClients > MAX_CLIENTS-MAX_BOTS || Info.m_MaxClients < 0 || Info.m_MaxClients > MAX_CLIENTS-MAX_BOTS ||
+		if(Up.Error() || Info.m_NumClients < 0 || Info.m_NumClients > MAX_CLIENTS || Info.m_MaxClients < 0 || Info.m_MaxClients > MAX_CLIENTS ||
 			Info.m_NumPlayers < 0 || Info.m_NumPlayers > Info.m_NumClients || Info.m_MaxPlayers < 0 || Info.m_MaxPlayers > Info.m_MaxClients)
 			return;
 
 		net_addr_str(&pPacket->m_Address, Info.m_aAddress, sizeof(Info.m_aAddress));
 
+		// big servers only list as many clients as fit into the packet
+		int NumListed = 0;
 		for(int i = 0; i < Info.m_NumClients; i++)
 		{
 			str_copy(Info.m_aClients[i].m_aName, Up.GetString(CUnpacker::SANITIZE_CC|CUnpacker::SKIP_START_WHITESPACES), sizeof(Info.m_aClients[i].m_aName));
@@ -1020,22 +1021,25 @@ void CClient::ProcessConnlessPacket(CNetChunk *pPacket)
 			Info.m_aClients[i].m_Country = str_toint(Up.GetString());
 			Info.m_aClients[i].m_Score = str_toint(Up.GetString());
 			Info.m_aClients[i].m_Player = str_toint(Up.GetString()) != 0 ? true : false;
+			if(Up.Error())
+			{
+				mem_zero(&Info.m_aClients[i], sizeof(Info.m_aClients[i]));
+				break;
+			}
+			NumListed++;
 		}
 
-		if(!Up.Error())
-		{
-			// sort players
-			qsort(Info.m_aClients, Info.m_NumClients, sizeof(*Info.m_aClients), PlayerScoreComp);
+		// sort players
+		qsort(Info.m_aClients, NumListed, sizeof(*Info.m_aClients), PlayerScoreComp);
 
-			if(net_addr_comp(&m_ServerAddress, &pPacket->m_Address) == 0)
-			{
-				mem_copy(&m_CurrentServerInfo, &Info, sizeof(m_CurrentServerInfo));
-				m_CurrentServerInfo.m_NetAddr = m_ServerAddress;
-				m_CurrentServerInfoRequestTime = -1;
-			}
-			else
-				m_ServerBrowser.Set(pPacket->m_Address, IServerBrowser::SET_TOKEN, Token, &Info);
+		if(net_addr_comp(&m_ServerAddress, &pPacket->m_Address) == 0)
+		{
+			mem_copy(&m_CurrentServerInfo, &Info, sizeof(m_CurrentServerInfo));
+			m_CurrentServerInfo.m_NetAddr = m_ServerAddress;
+			m_CurrentServerInfoRequestTime = -1;
 		}
+		else
+			m_ServerBrowser.Set(pPacket->m_Address, IServerBrowser::SET_TOKEN, Token, &Info);
 	}
 }
 
@@ -1223,14 +1227,11 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 
 			// adjust our prediction time
 			int64 Target = 0;
-			for(int k = 0; k < 200; k++)
+			int Slot = InputPredTick&INPUT_RING_MASK;
+			if(m_aInputs[Slot].m_Tick == InputPredTick)
 			{
-				if(m_aInputs[k].m_Tick == InputPredTick)
-				{
-					Target = m_aInputs[k].m_PredictedTime + (time_get() - m_aInputs[k].m_Time);
-					Target = Target - (int64)(((TimeLeft-PREDICTION_MARGIN)/1000.0f)*time_freq());
-					break;
-				}
+				Target = m_aInputs[Slot].m_PredictedTime + (time_get() - m_aInputs[Slot].m_Time);
+				Target = Target - (int64)(((TimeLeft-PREDICTION_MARGIN)/1000.0f)*time_freq());
 			}
 
 			if(Target)
@@ -1329,7 +1330,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 
 					if(CompleteSize)
 					{
-						int IntSize = CVariableInt::Decompress(m_aSnapshotIncommingData, CompleteSize, aTmpBuffer2);
+						int IntSize = CVariableInt::Decompress(m_aSnapshotIncommingData, CompleteSize, aTmpBuffer2, sizeof(aTmpBuffer2));
 
 						if(IntSize < 0) // failure during decompression, bail
 							return;
@@ -1487,6 +1488,7 @@ void CClient::OnDemoPlayerSnapshot(void *pData, int Size)
 
 	mem_copy(m_aSnapshots[SNAP_CURRENT]->m_pSnap, pData, Size);
 	mem_copy(m_aSnapshots[SNAP_CURRENT]->m_pAltSnap, pData, Size);
+	m_aSnapshots[SNAP_CURRENT]->m_pIndex->Build(m_aSnapshots[SNAP_CURRENT]->m_pSnap);
 
 	GameClient()->OnNewSnapshot();
 }
@@ -2107,11 +2109,15 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 
 	m_aSnapshots[SNAP_CURRENT]->m_pSnap = (CSnapshot *)m_aDemorecSnapshotData[SNAP_CURRENT][0];
 	m_aSnapshots[SNAP_CURRENT]->m_pAltSnap = (CSnapshot *)m_aDemorecSnapshotData[SNAP_CURRENT][1];
+	m_aSnapshots[SNAP_CURRENT]->m_pIndex = &m_aDemorecSnapshotIndex[SNAP_CURRENT];
+	m_aSnapshots[SNAP_CURRENT]->m_pIndex->Build(m_aSnapshots[SNAP_CURRENT]->m_pSnap);
 	m_aSnapshots[SNAP_CURRENT]->m_SnapSize = 0;
 	m_aSnapshots[SNAP_CURRENT]->m_Tick = -1;
 
 	m_aSnapshots[SNAP_PREV]->m_pSnap = (CSnapshot *)m_aDemorecSnapshotData[SNAP_PREV][0];
 	m_aSnapshots[SNAP_PREV]->m_pAltSnap = (CSnapshot *)m_aDemorecSnapshotData[SNAP_PREV][1];
+	m_aSnapshots[SNAP_PREV]->m_pIndex = &m_aDemorecSnapshotIndex[SNAP_PREV];
+	m_aSnapshots[SNAP_PREV]->m_pIndex->Build(m_aSnapshots[SNAP_PREV]->m_pSnap);
 	m_aSnapshots[SNAP_PREV]->m_SnapSize = 0;
 	m_aSnapshots[SNAP_PREV]->m_Tick = -1;
 
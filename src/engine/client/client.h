@@ -143,16 +143,20 @@ class CClient : public IClient, public CDemoPlayer::IListner
 	CSmoothTime m_GameTime;
 	CSmoothTime m_PredictedTime;
 
-	// input
-	struct // TODO: handle input better
+	// input, stored at their tick modulo the ring size
+	enum
+	{
+		INPUT_RING_SIZE=256,
+		INPUT_RING_MASK=INPUT_RING_SIZE-1
+	};
+
+	struct
 	{
 		int m_aData[MAX_INPUT_SIZE]; // the input data
 		int m_Tick; // the tick that the input is for
 		int64 m_PredictedTime; // prediction latency when we sent this input
 		int64 m_Time;
-	} m_aInputs[200];
-
-	int m_CurrentInput;
+	} m_aInputs[INPUT_RING_SIZE];
 
 	// graphs
 	CGraph m_InputtimeMarginGraph;
@@ -168,6 +172,7 @@ class CClient : public IClient, public CDemoPlayer::IListner
 
 	class CSnapshotStorage::CHolder m_aDemorecSnapshotHolders[NUM_SNAPSHOT_TYPES];
 	char *m_aDemorecSnapshotData[NUM_SNAPSHOT_TYPES][2][CSnapshot::MAX_SIZE];
+	CSnapshotIndex m_aDemorecSnapshotIndex[NUM_SNAPSHOT_TYPES];
 
 	class CSnapshotDelta m_SnapshotDelta;
 
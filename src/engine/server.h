@@ -11,6 +11,7 @@ class IServer : public IInterface
 protected:
 	int m_CurrentGameTick;
 	int m_TickSpeed;
+	int m_MaxClients;
 
 public:
 	/*
@@ -25,6 +26,9 @@ public:
 	int Tick() const { return m_CurrentGameTick; }
 	int TickSpeed() const { return m_TickSpeed; }
 
+	// fixed from the start, sv_max_clients counts for the next one
+	int MaxClients() const { return m_MaxClients; }
+
 	virtual const char *ClientName(int ClientID) = 0;
 	virtual const char *ClientClan(int ClientID) = 0;
 	virtual int ClientCountry(int ClientID) = 0;
@@ -53,6 +57,7 @@ public:
 	virtual int SnapNewID() = 0;
 	virtual void SnapFreeID(int ID) = 0;
 	virtual void *SnapNewItem(int Type, int ID, int Size) = 0;
+	virtual void SnapSetLocal(int *pValue) = 0; // the only int of the item data that differs between the clients
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
@@ -62,7 +67,6 @@ public:
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
 	virtual unsigned GetCurrentMapCRC() = 0; //H-Client
-	virtual void InitBot(int ClientID, int BType) = 0; //H-Client
 	virtual void ReloadMap() = 0; //H-Client
 
 };
@@ -96,8 +100,6 @@ public:
 	virtual const char *Version() = 0;
 	virtual const char *NetVersion() = 0;
 	virtual const char *HClientNetVersion() = 0; //H-Client
-	virtual void CreateBot(int ClientID) = 0; //H-Client
-	virtual void UpdateBotInfo(int ClientID, int TEnemy) = 0; //H-Client
 };
 
 extern IGameServer *CreateGameServer();
@@ -0,0 +1,342 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/compression.h>
+
+#include "inputlog.h"
+
+static const unsigned char gs_aHeaderMarker[8] = {'T', 'W', 'I', 'N', 'P', 'U', 'T', 0};
+static const int gs_Version = 3;
+
+CInputLogRecorder::CInputLogRecorder()
+{
+	m_pConsole = 0;
+	m_File = 0;
+	m_BufferSize = 0;
+	m_NumTicks = 0;
+}
+
+void CInputLogRecorder::Flush()
+{
+	io_write(m_File, m_aBuffer, m_BufferSize);
+	m_BufferSize = 0;
+}
+
+void CInputLogRecorder::AddInt(int Value)
+{
+	if(m_BufferSize+CVariableInt::MAX_BYTES_PACKED > BUFFER_SIZE)
+		Flush();
+	m_BufferSize = (int)(CVariableInt::Pack(m_aBuffer+m_BufferSize, Value)-m_aBuffer);
+}
+
+void CInputLogRecorder::AddRaw(const void *pData, int Size)
+{
+	AddInt(Size);
+	if(m_BufferSize+Size > BUFFER_SIZE)
+		Flush();
+	if(Size > BUFFER_SIZE)
+		io_write(m_File, pData, Size);
+	else
+	{
+		mem_copy(m_aBuffer+m_BufferSize, pData, Size);
+		m_BufferSize += Size;
+	}
+}
+
+void CInputLogRecorder::AddString(const char *pString)
+{
+	AddRaw(pString, min(str_length(pString), (int)CInputLog::MAX_STRING_LENGTH-1));
+}
+
+void CInputLogRecorder::AddEvent(int Type, int ClientID)
+{
+	if(!m_File)
+		return;
+	AddInt(Type);
+	AddInt(ClientID);
+}
+
+int CInputLogRecorder::Start(class IStorageTW *pStorage, class IConsole *pConsole, const char *pFilename, const char *pMap, unsigned MapCrc,
+	const void *pMapData, int MapSize, const char *pGameType, int MaxClients, int Seed)
+{
+	if(m_File)
+		return -1;
+
+	m_pConsole = pConsole;
+	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorageTW::TYPE_SAVE);
+	if(!m_File)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "Unable to open '%s' for recording", pFilename);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+		return -1;
+	}
+
+	// the map goes in too, so the log replays without it
+	io_write(m_File, gs_aHeaderMarker, sizeof(gs_aHeaderMarker));
+	m_BufferSize = 0;
+	AddInt(gs_Version);
+	AddString(pMap);
+	AddInt((int)MapCrc);
+	AddString(pGameType);
+	AddInt(MaxClients);
+	AddInt(Seed);
+	AddRaw(pMapData, MapSize);
+
+	m_NumTicks = 0;
+	mem_zero(m_aaLastInput, sizeof(m_aaLastInput));
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "Recording inputs to '%s'", pFilename);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+	return 0;
+}
+
+int CInputLogRecorder::Stop()
+{
+	if(!m_File)
+		return -1;
+
+	Flush();
+	io_close(m_File);
+	m_File = 0;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "Stopped recording inputs after %d ticks", m_NumTicks);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+	return 0;
+}
+
+void CInputLogRecorder::RecordTick()
+{
+	if(!m_File)
+		return;
+	AddInt(CInputLog::EVENT_TICK);
+	m_NumTicks++;
+}
+
+void CInputLogRecorder::RecordDrop(int ClientID, const char *pReason)
+{
+	if(!m_File)
+		return;
+	AddEvent(CInputLog::EVENT_DROP, ClientID);
+	AddString(pReason ? pReason : "");
+}
+
+void CInputLogRecorder::RecordInput(int ClientID, int Tick, int Flags, const int *pInput, int Size)
+{
+	if(!m_File)
+		return;
+	AddEvent(CInputLog::EVENT_INPUT, ClientID);
+	AddInt(Tick);
+	AddInt(Flags);
+	AddInt(Size);
+
+	// most of it stays the same from one input to the next
+	int *pLast = m_aaLastInput[ClientID];
+	for(int i = 0; i < Size; i++)
+	{
+		AddInt(pInput[i]-pLast[i]);
+		pLast[i] = pInput[i];
+	}
+}
+
+void CInputLogRecorder::RecordMessage(int ClientID, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+	AddEvent(CInputLog::EVENT_MESSAGE, ClientID);
+	AddRaw(pData, Size);
+}
+
+void CInputLogRecorder::RecordRcon(int ClientID, int AuthLevel, const char *pLine)
+{
+	if(!m_File)
+		return;
+	AddEvent(CInputLog::EVENT_RCON, ClientID);
+	AddInt(AuthLevel);
+	AddString(pLine);
+}
+
+
+CInputLogPlayer::CInputLogPlayer()
+{
+	m_pData = 0;
+	m_Size = 0;
+	m_pCurrent = 0;
+	m_pEnd = 0;
+	m_pMapData = 0;
+	m_Error = false;
+}
+
+CInputLogPlayer::~CInputLogPlayer()
+{
+	Unload();
+}
+
+int CInputLogPlayer::GetInt()
+{
+	int Value = 0;
+	const unsigned char *pNext = m_Error ? 0 : CVariableInt::Unpack(m_pCurrent, &Value, (int)(m_pEnd-m_pCurrent));
+	if(!pNext)
+	{
+		m_Error = true;
+		return 0;
+	}
+	m_pCurrent = pNext;
+	return Value;
+}
+
+const void *CInputLogPlayer::GetRaw(int Size)
+{
+	if(m_Error || Size < 0 || Size > m_pEnd-m_pCurrent)
+	{
+		m_Error = true;
+		return 0;
+	}
+	const void *pData = m_pCurrent;
+	m_pCurrent += Size;
+	return pData;
+}
+
+void CInputLogPlayer::GetString(char *pString, int Size)
+{
+	int Length = GetInt();
+	const char *pData = (const char *)GetRaw(Length);
+	if(!pData)
+	{
+		pString[0] = 0;
+		return;
+	}
+	mem_copy(pString, pData, min(Length, Size-1));
+	pString[min(Length, Size-1)] = 0;
+}
+
+int CInputLogPlayer::Load(class IStorageTW *pStorage, class IConsole *pConsole, const char *pFilename)
+{
+	Unload();
+
+	char aBuf[256];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorageTW::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "could not open '%s'", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+		return -1;
+	}
+
+	// logs are small enough to keep them in memory as a whole
+	m_Size = (int)io_length(File);
+	m_pData = (unsigned char *)mem_alloc(max(m_Size, 1), 1);
+	io_read(File, m_pData, m_Size);
+	io_close(File);
+
+	m_pCurrent = m_pData;
+	m_pEnd = m_pData+m_Size;
+	m_Error = false;
+	mem_zero(&m_Header, sizeof(m_Header));
+	mem_zero(m_aaLastInput, sizeof(m_aaLastInput));
+
+	if(!GetRaw(sizeof(gs_aHeaderMarker)) || mem_comp(m_pData, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) != 0)
+	{
+		str_format(aBuf, sizeof(aBuf), "'%s' is not an input log", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+		Unload();
+		return -1;
+	}
+
+	m_Header.m_Version = GetInt();
+	if(m_Header.m_Version != gs_Version)
+	{
+		str_format(aBuf, sizeof(aBuf), "'%s' has version %d, only %d is supported", pFilename, m_Header.m_Version, gs_Version);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+		Unload();
+		return -1;
+	}
+
+	GetString(m_Header.m_aMap, sizeof(m_Header.m_aMap));
+	m_Header.m_MapCrc = (unsigned)GetInt();
+	GetString(m_Header.m_aGameType, sizeof(m_Header.m_aGameType));
+	m_Header.m_MaxClients = GetInt();
+	m_Header.m_Seed = GetInt();
+	m_Header.m_MapSize = GetInt();
+	m_pMapData = (const unsigned char *)GetRaw(m_Header.m_MapSize);
+	if(m_Header.m_MaxClients < 1 || m_Header.m_MaxClients > MAX_CLIENTS)
+		m_Error = true;
+	if(m_Error)
+	{
+		str_format(aBuf, sizeof(aBuf), "'%s' has a broken header", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+		Unload();
+		return -1;
+	}
+	return 0;
+}
+
+void CInputLogPlayer::Unload()
+{
+	if(m_pData)
+		mem_free(m_pData);
+	m_pData = 0;
+	m_Size = 0;
+	m_pCurrent = 0;
+	m_pEnd = 0;
+	m_pMapData = 0;
+}
+
+bool CInputLogPlayer::NextEvent(CInputLog::CEvent *pEvent)
+{
+	if(m_Error || m_pCurrent >= m_pEnd)
+		return false;
+
+	pEvent->m_Type = GetInt();
+	pEvent->m_ClientID = 0;
+	if(pEvent->m_Type == CInputLog::EVENT_TICK)
+		return !m_Error;
+
+	pEvent->m_ClientID = GetInt();
+	if(pEvent->m_ClientID < 0 || pEvent->m_ClientID >= m_Header.m_MaxClients)
+		m_Error = true;
+
+	switch(pEvent->m_Type)
+	{
+	case CInputLog::EVENT_CONNECT:
+	case CInputLog::EVENT_READY:
+	case CInputLog::EVENT_ENTER:
+		break;
+	case CInputLog::EVENT_DROP:
+		GetString(pEvent->m_aString, sizeof(pEvent->m_aString));
+		break;
+	case CInputLog::EVENT_INPUT:
+		{
+			pEvent->m_Tick = GetInt();
+			pEvent->m_Flags = GetInt();
+			pEvent->m_InputSize = GetInt();
+			if(m_Error || pEvent->m_InputSize < 0 || pEvent->m_InputSize > MAX_INPUT_SIZE)
+			{
+				m_Error = true;
+				break;
+			}
+			int *pLast = m_aaLastInput[pEvent->m_ClientID];
+			for(int i = 0; i < pEvent->m_InputSize; i++)
+				pLast[i] += GetInt();
+			mem_copy(pEvent->m_aInput, pLast, sizeof(pEvent->m_aInput));
+		}
+		break;
+	case CInputLog::EVENT_MESSAGE:
+		pEvent->m_DataSize = GetInt();
+		pEvent->m_pData = GetRaw(pEvent->m_DataSize);
+		break;
+	case CInputLog::EVENT_RCON:
+		pEvent->m_Flags = GetInt();
+		GetString(pEvent->m_aString, sizeof(pEvent->m_aString));
+		break;
+	default:
+		m_Error = true;
+	}
+	return !m_Error;
+}
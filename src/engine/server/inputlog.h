@@ -0,0 +1,134 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_INPUTLOG_H
+#define ENGINE_SERVER_INPUTLOG_H
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+
+// everything the clients did to the game, in the order the server handed it
+// to the mod. replaying it from the same map and random seed runs the same
+// ticks again without any network
+class CInputLog
+{
+public:
+	enum
+	{
+		EVENT_TICK=0,
+		EVENT_CONNECT,
+		EVENT_READY,
+		EVENT_ENTER,
+		EVENT_DROP,
+		EVENT_INPUT,
+		EVENT_MESSAGE,
+		EVENT_RCON,
+
+		INPUTFLAG_STORED=1, // went into the input ring
+		INPUTFLAG_LATE=2,
+
+		MAX_STRING_LENGTH=256,
+	};
+
+	class CHeader
+	{
+	public:
+		int m_Version;
+		char m_aMap[64];
+		unsigned m_MapCrc;
+		int m_MapSize;
+		char m_aGameType[32];
+		int m_MaxClients;
+		int m_Seed;
+	};
+
+	class CEvent
+	{
+	public:
+		int m_Type;
+		int m_ClientID;
+		int m_Tick; // EVENT_INPUT: where it was stored, relative to the current tick
+		int m_Flags; // EVENT_INPUT: INPUTFLAG_*, EVENT_RCON: auth level
+		int m_aInput[MAX_INPUT_SIZE];
+		int m_InputSize;
+		const void *m_pData; // EVENT_MESSAGE
+		int m_DataSize;
+		char m_aString[MAX_STRING_LENGTH]; // EVENT_DROP, EVENT_RCON
+	};
+};
+
+class CInputLogRecorder
+{
+	enum
+	{
+		BUFFER_SIZE=64*1024,
+	};
+
+	class IConsole *m_pConsole;
+	IOHANDLE m_File;
+	unsigned char m_aBuffer[BUFFER_SIZE];
+	int m_BufferSize;
+	int m_NumTicks;
+
+	// inputs are stored as the change to the last one of the client
+	int m_aaLastInput[MAX_CLIENTS][MAX_INPUT_SIZE];
+
+	void Flush();
+	void AddInt(int Value);
+	void AddRaw(const void *pData, int Size);
+	void AddString(const char *pString);
+	void AddEvent(int Type, int ClientID);
+public:
+	CInputLogRecorder();
+
+	int Start(class IStorageTW *pStorage, class IConsole *pConsole, const char *pFilename, const char *pMap, unsigned MapCrc,
+		const void *pMapData, int MapSize, const char *pGameType, int MaxClients, int Seed);
+	int Stop();
+	bool IsRecording() const { return m_File != 0; }
+
+	void RecordTick();
+	void RecordConnect(int ClientID) { AddEvent(CInputLog::EVENT_CONNECT, ClientID); }
+	void RecordReady(int ClientID) { AddEvent(CInputLog::EVENT_READY, ClientID); }
+	void RecordEnter(int ClientID) { AddEvent(CInputLog::EVENT_ENTER, ClientID); }
+	void RecordDrop(int ClientID, const char *pReason);
+	void RecordInput(int ClientID, int Tick, int Flags, const int *pInput, int Size);
+	void RecordMessage(int ClientID, const void *pData, int Size);
+	void RecordRcon(int ClientID, int AuthLevel, const char *pLine);
+};
+
+class CInputLogPlayer
+{
+	unsigned char *m_pData;
+	int m_Size;
+	const unsigned char *m_pCurrent;
+	const unsigned char *m_pEnd;
+	const unsigned char *m_pMapData;
+	bool m_Error;
+
+	CInputLog::CHeader m_Header;
+	int m_aaLastInput[MAX_CLIENTS][MAX_INPUT_SIZE];
+
+	int GetInt();
+	const void *GetRaw(int Size);
+	void GetString(char *pString, int Size);
+public:
+	CInputLogPlayer();
+	~CInputLogPlayer();
+
+	int Load(class IStorageTW *pStorage, class IConsole *pConsole, const char *pFilename);
+	void Unload();
+
+	const CInputLog::CHeader *Header() const { return &m_Header; }
+	const void *MapData() const { return m_pMapData; }
+
+	/*
+		Function: NextEvent
+			Reads the next event of the log.
+
+		Returns:
+			false at the end of the log or when the rest of it is broken.
+	*/
+	bool NextEvent(CInputLog::CEvent *pEvent);
+	bool Error() const { return m_Error; }
+};
+
+#endif
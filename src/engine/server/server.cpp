@@ -18,9 +18,11 @@
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/filecollection.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/mapchecker.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
 
@@ -29,6 +31,9 @@
 
 #include <mastersrv/mastersrv.h>
 
+#include <cstdlib>
+
+#include "inputlog.h"
 #include "register.h"
 #include "server.h"
 
@@ -157,13 +162,28 @@ void CSnapIDPool::FreeID(int ID)
 	}
 }
 
+void CServer::CSnapshotStats::Add(const CSnapshotStats *pOther)
+{
+	m_NumSnapshots += pOther->m_NumSnapshots;
+	m_NumEmpty += pOther->m_NumEmpty;
+	m_NumMultiPacket += pOther->m_NumMultiPacket;
+	m_SnapBytes += pOther->m_SnapBytes;
+	m_DeltaBytes += pOther->m_DeltaBytes;
+	m_CompBytes += pOther->m_CompBytes;
+	m_NumToRecover += pOther->m_NumToRecover;
+	m_NumToFull += pOther->m_NumToFull;
+}
+
 void CServer::CClient::Reset()
 {
 	// reset input
-	for(int i = 0; i < 200; i++)
+	for(int i = 0; i < INPUT_RING_SIZE; i++)
 		m_aInputs[i].m_GameTick = -1;
-	m_CurrentInput = 0;
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
+	m_NumInputs = 0;
+	m_NumLateInputs = 0;
+	m_NumDuplicateInputs = 0;
+	m_NumDroppedInputs = 0;
 
 	m_Snapshots.PurgeAll();
 	m_LastAckedSnapshot = -1;
@@ -189,7 +209,41 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 	m_RconClientID = -1;
 	m_RconAuthLevel = AUTHED_ADMIN;
 
-	Init();
+	m_NumSnapshotCache = 0;
+	m_SnapshotCacheHits = 0;
+	m_SnapshotCacheMisses = 0;
+	m_SnapshotCacheBytes = 0;
+
+	mem_zero(m_aTickTimes, sizeof(m_aTickTimes));
+	m_MaxTickTime = 0;
+	m_NetWait = 0;
+	ResetSchedulerStats();
+
+	m_DroppedSnapStats.Reset();
+	m_NetStatsStart = time_get();
+
+	m_aInputLogFile[0] = 0;
+	m_aInputLogReplay[0] = 0;
+	m_ReplayingInputLog = false;
+
+	m_ProfileTick = g_Profiler.Section("tick");
+	m_ProfileSnapDemo = g_Profiler.Section("snap.demo");
+	m_ProfileSnapGame = g_Profiler.Section("snap.game");
+	m_ProfileSnapBuild = g_Profiler.Section("snap.build");
+	m_ProfileSnapEncode = g_Profiler.Section("snap.encode");
+	m_ProfileSnapSend = g_Profiler.Section("snap.send");
+	m_ProfileNetwork = g_Profiler.Section("network");
+
+	// sized once the config is read
+	m_MaxClients = 0;
+	m_pClients = 0;
+	m_pSnapshotSlots = 0;
+}
+
+CServer::~CServer()
+{
+	delete [] m_pClients;
+	delete [] m_pSnapshotSlots;
 }
 
 
@@ -202,7 +256,7 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 	StrRtrim(aTrimmedName);
 
 	// check if new and old name are the same
-	if(m_aClients[ClientID].m_aName[0] && str_comp(m_aClients[ClientID].m_aName, aTrimmedName) == 0)
+	if(m_pClients[ClientID].m_aName[0] && str_comp(m_pClients[ClientID].m_aName, aTrimmedName) == 0)
 		return 0;
 
 	char aBuf[256];
@@ -216,15 +270,15 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 		return -1;
 
 	// make sure that two clients doesn't have the same name
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(i != ClientID && m_aClients[i].m_State >= CClient::STATE_READY)
+	for(int i = 0; i < MaxClients(); i++)
+		if(i != ClientID && m_pClients[i].m_State >= CClient::STATE_READY)
 		{
-			if(str_comp(pName, m_aClients[i].m_aName) == 0)
+			if(str_comp(pName, m_pClients[i].m_aName) == 0)
 				return -1;
 		}
 
 	// set the client name
-	str_copy(m_aClients[ClientID].m_aName, pName, MAX_NAME_LENGTH);
+	str_copy(m_pClients[ClientID].m_aName, pName, MAX_NAME_LENGTH);
 	return 0;
 }
 
@@ -232,7 +286,7 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 
 void CServer::SetClientName(int ClientID, const char *pName)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State < CClient::STATE_READY)
 		return;
 
 	if(!pName)
@@ -256,54 +310,32 @@ void CServer::SetClientName(int ClientID, const char *pName)
 	}
 }
 
-void CServer::InitBot(int ClientID, int BType)
-{
-    if (BType == TEAM_ENEMY_TEEPER)
-        str_copy(m_aClients[ClientID].m_aName , "TEEPER", MAX_NAME_LENGTH);
-    else if (BType == TEAM_ENEMY_ZOMBITEE)
-        str_copy(m_aClients[ClientID].m_aName , "ZOMBITEE", MAX_NAME_LENGTH);
-    else if (BType == TEAM_ENEMY_SKELETEE)
-        str_copy(m_aClients[ClientID].m_aName , "SKELETEE", MAX_NAME_LENGTH);
-    else if (BType == TEAM_ENEMY_SPIDERTEE)
-        str_copy(m_aClients[ClientID].m_aName , "SPIDERTEE", MAX_NAME_LENGTH);
-    else if (BType == TEAM_ANIMAL_TEECOW)
-        str_copy(m_aClients[ClientID].m_aName , "TEECOW", MAX_NAME_LENGTH);
-    else if (BType == TEAM_ANIMAL_TEEPIG)
-        str_copy(m_aClients[ClientID].m_aName , "TEEPIG", MAX_NAME_LENGTH);
-
-    str_copy(m_aClients[ClientID].m_aClan, "HDP-BOT", MAX_CLAN_LENGTH);
-    m_aClients[ClientID].m_Country = 724;
-
-    m_aClients[ClientID].m_Score = 0;
-    m_aClients[ClientID].m_State = CClient::STATE_INGAME;
-}
-
 void CServer::SetClientClan(int ClientID, const char *pClan)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY || !pClan || str_comp_nocase(pClan, "hdp-bot") == 0)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State < CClient::STATE_READY || !pClan || str_comp_nocase(pClan, "hdp-bot") == 0)
 		return;
 
-	str_copy(m_aClients[ClientID].m_aClan, pClan, MAX_CLAN_LENGTH);
+	str_copy(m_pClients[ClientID].m_aClan, pClan, MAX_CLAN_LENGTH);
 }
 
 void CServer::SetClientCountry(int ClientID, int Country)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State < CClient::STATE_READY)
 		return;
 
-	m_aClients[ClientID].m_Country = Country;
+	m_pClients[ClientID].m_Country = Country;
 }
 
 void CServer::SetClientScore(int ClientID, int Score)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State < CClient::STATE_READY)
 		return;
-	m_aClients[ClientID].m_Score = Score;
+	m_pClients[ClientID].m_Score = Score;
 }
 
 void CServer::Kick(int ClientID, const char *pReason)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == CClient::STATE_EMPTY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State == CClient::STATE_EMPTY)
 	{
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "invalid client id to kick");
 		return;
@@ -313,12 +345,16 @@ void CServer::Kick(int ClientID, const char *pReason)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "you can't kick yourself");
  		return;
 	}
-	else if(m_aClients[ClientID].m_Authed > m_RconAuthLevel)
+	else if(m_pClients[ClientID].m_Authed > m_RconAuthLevel)
 	{
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "kick command denied");
  		return;
 	}
 
+	// a replay has the drop in the log
+	if(m_ReplayingInputLog)
+		return;
+
 	m_NetServer.Drop(ClientID, pReason);
 }
 
@@ -337,15 +373,33 @@ int64 CServer::TickStartTime(int Tick)
 	return SERVER_TICK_SPEED;
 }*/
 
+void CServer::ResetSchedulerStats()
+{
+	mem_zero(m_aTickLateness, sizeof(m_aTickLateness));
+	m_TickLatenessSum = 0;
+	m_MaxTickLateness = 0;
+	m_SchedulerStatsStart = time_get();
+	m_SleepTime = 0;
+	m_NumWakeups = 0;
+}
+
 int CServer::Init()
 {
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	// as many slots as sv_max_clients allows
+	m_MaxClients = clamp(g_Config.m_SvMaxClients, 1, (int)NET_MAX_CLIENTS);
+	m_pClients = new CClient[MaxClients()];
+	m_pSnapshotSlots = new CSnapshotSlot[m_MaxClients];
+
+	for(int i = 0; i < MaxClients(); i++)
 	{
-		m_aClients[i].m_State = CClient::STATE_EMPTY;
-		m_aClients[i].m_aName[0] = 0;
-		m_aClients[i].m_aClan[0] = 0;
-		m_aClients[i].m_Country = -1;
-		m_aClients[i].m_Snapshots.Init();
+		m_pClients[i].m_State = CClient::STATE_EMPTY;
+		m_pClients[i].m_aName[0] = 0;
+		m_pClients[i].m_aClan[0] = 0;
+		m_pClients[i].m_Country = -1;
+		m_pClients[i].m_Latency = 0;
+		m_pClients[i].m_Authed = AUTHED_NO;
+		m_pClients[i].m_Snapshots.Init();
+		m_pClients[i].m_SnapStats.Reset();
 	}
 
 	m_CurrentGameTick = 0;
@@ -355,18 +409,18 @@ int CServer::Init()
 
 bool CServer::IsAuthed(int ClientID)
 {
-	return m_aClients[ClientID].m_Authed;
+	return m_pClients[ClientID].m_Authed;
 }
 
 int CServer::GetClientInfo(int ClientID, CClientInfo *pInfo)
 {
-	dbg_assert(ClientID >= 0 && ClientID < MAX_CLIENTS, "client_id is not valid");
+	dbg_assert(ClientID >= 0 && ClientID < MaxClients(), "client_id is not valid");
 	dbg_assert(pInfo != 0, "info can not be null");
 
-	if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+	if(m_pClients[ClientID].m_State == CClient::STATE_INGAME)
 	{
-		pInfo->m_pName = m_aClients[ClientID].m_aName;
-		pInfo->m_Latency = m_aClients[ClientID].m_Latency;
+		pInfo->m_pName = m_pClients[ClientID].m_aName;
+		pInfo->m_Latency = m_pClients[ClientID].m_Latency;
 		return 1;
 	}
 	return 0;
@@ -374,7 +428,7 @@ int CServer::GetClientInfo(int ClientID, CClientInfo *pInfo)
 
 void CServer::GetClientAddr(int ClientID, char *pAddrStr, int Size)
 {
-	if(ClientID >= 0 && ClientID < MAX_CLIENTS-MAX_BOTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+	if(ClientID >= 0 && ClientID < MaxClients() && m_pClients[ClientID].m_State == CClient::STATE_INGAME)
 	{
 		NETADDR Addr = m_NetServer.ClientAddr(ClientID);
 		Addr.port = 0;
@@ -385,10 +439,10 @@ void CServer::GetClientAddr(int ClientID, char *pAddrStr, int Size)
 
 const char *CServer::ClientName(int ClientID)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
 		return "(invalid)";
-	if(m_aClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
-		return m_aClients[ClientID].m_aName;
+	if(m_pClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
+		return m_pClients[ClientID].m_aName;
 	else
 		return "(connecting)";
 
@@ -396,27 +450,27 @@ const char *CServer::ClientName(int ClientID)
 
 const char *CServer::ClientClan(int ClientID)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
 		return "";
-	if(m_aClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
-		return m_aClients[ClientID].m_aClan;
+	if(m_pClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
+		return m_pClients[ClientID].m_aClan;
 	else
 		return "";
 }
 
 int CServer::ClientCountry(int ClientID)
 {
-	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
+	if(ClientID < 0 || ClientID >= MaxClients() || m_pClients[ClientID].m_State == CServer::CClient::STATE_EMPTY)
 		return -1;
-	if(m_aClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
-		return m_aClients[ClientID].m_Country;
+	if(m_pClients[ClientID].m_State == CServer::CClient::STATE_INGAME)
+		return m_pClients[ClientID].m_Country;
 	else
 		return -1;
 }
 
 bool CServer::ClientIngame(int ClientID)
 {
-	return ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CServer::CClient::STATE_INGAME;
+	return ClientID >= 0 && ClientID < MaxClients() && m_pClients[ClientID].m_State == CServer::CClient::STATE_INGAME;
 }
 
 int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
@@ -450,14 +504,14 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 	if(!(Flags&MSGFLAG_NORECORD))
 		m_DemoRecorder.RecordMessage(pMsg->Data(), pMsg->Size());
 
-	if(!(Flags&MSGFLAG_NOSEND))
+	if(!(Flags&MSGFLAG_NOSEND) && !m_ReplayingInputLog)
 	{
 		if(ClientID == -1)
 		{
 			// broadcast
 			int i;
-			for(i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
-				if(m_aClients[i].m_State == CClient::STATE_INGAME)
+			for(i = 0; i < MaxClients(); i++)
+				if(m_pClients[i].m_State == CClient::STATE_INGAME)
 				{
 					Packet.m_ClientID = i;
 					m_NetServer.Send(&Packet);
@@ -469,6 +523,139 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 	return 0;
 }
 
+int CServer::SnapshotJob(void *pUser)
+{
+	CSnapshotSlot *pSlot = (CSnapshotSlot *)pUser;
+	CSnapshot *pData = (CSnapshot *)pSlot->m_aData;
+
+	pSlot->m_Crc = pData->Crc();
+
+	// create delta
+	pSlot->m_DeltaSize = pSlot->m_pServer->m_SnapshotDelta.CreateDelta(pSlot->m_pDeltashot, pData, pSlot->m_aDeltaData);
+
+	// compress it
+	pSlot->m_CompSize = 0;
+	if(pSlot->m_DeltaSize)
+		pSlot->m_CompSize = CVariableInt::Compress(pSlot->m_aDeltaData, pSlot->m_DeltaSize, pSlot->m_aCompData, sizeof(pSlot->m_aCompData));
+	return 0;
+}
+
+// the same bytes once the local int of each snapshot counts as 0
+static bool SameSnapshot(const char *pA, int LocalA, const char *pB, int LocalB, int Size)
+{
+	if((LocalA < 0) != (LocalB < 0))
+		return false;
+	if(LocalA < 0)
+		return mem_comp(pA, pB, Size) == 0;
+
+	// the local values match each other, the other snapshot has a 0 there
+	if(*(const int *)(pA+LocalA) != *(const int *)(pB+LocalB))
+		return false;
+	if(LocalA != LocalB && (*(const int *)(pA+LocalB) != 0 || *(const int *)(pB+LocalA) != 0))
+		return false;
+
+	int First = min(LocalA, LocalB);
+	int Second = max(LocalA, LocalB);
+	if(mem_comp(pA, pB, First) != 0)
+		return false;
+	if(Second != First && mem_comp(pA+First+4, pB+First+4, Second-First-4) != 0)
+		return false;
+	return mem_comp(pA+Second+4, pB+Second+4, Size-Second-4) == 0;
+}
+
+CServer::CSnapshotSlot *CServer::FindCachedSnapshot(CSnapshotSlot *pSlot)
+{
+	for(int i = 0; i < m_NumSnapshotCache; i++)
+	{
+		CSnapshotSlot *pCached = m_apSnapshotCache[i];
+		if(pCached->m_Hash == pSlot->m_Hash && pCached->m_Size == pSlot->m_Size &&
+			pCached->m_DeltaHash == pSlot->m_DeltaHash && pCached->m_DeltashotSize == pSlot->m_DeltashotSize &&
+			SameSnapshot(pCached->m_aData, pCached->m_LocalOffset, pSlot->m_aData, pSlot->m_LocalOffset, pSlot->m_Size) &&
+			SameSnapshot((const char *)pCached->m_pDeltashot, pCached->m_DeltaLocalOffset,
+				(const char *)pSlot->m_pDeltashot, pSlot->m_DeltaLocalOffset, pSlot->m_DeltashotSize))
+			return pCached;
+	}
+	return 0;
+}
+
+void CServer::SendSnapshot(int ClientID, CSnapshotSlot *pSlot)
+{
+	// the data might come from another client with the same snapshot
+	int DeltaTick = pSlot->m_DeltaTick;
+	pSlot = pSlot->m_pSource;
+
+	// the delta did not fit into the buffer when packed, the client has to wait for the next one
+	if(pSlot->m_CompSize < 0)
+		return;
+
+	CSnapshotStats *pStats = &m_pClients[ClientID].m_SnapStats;
+	pStats->m_NumSnapshots++;
+	pStats->m_SnapBytes += pSlot->m_Size;
+	pStats->m_DeltaBytes += pSlot->m_DeltaSize;
+	pStats->m_CompBytes += pSlot->m_CompSize;
+
+	if(pSlot->m_DeltaSize)
+	{
+		const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		int NumPackets = (pSlot->m_CompSize+MaxSize-1)/MaxSize;
+		if(NumPackets > 1)
+			pStats->m_NumMultiPacket++;
+
+		for(int n = 0, Left = pSlot->m_CompSize; Left; n++)
+		{
+			int Chunk = Left < MaxSize ? Left : MaxSize;
+			Left -= Chunk;
+
+			if(NumPackets == 1)
+			{
+				CMsgPacker Msg(NETMSG_SNAPSINGLE);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick-DeltaTick);
+				Msg.AddInt(pSlot->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pSlot->m_aCompData[n*MaxSize], Chunk);
+				SendMsgEx(&Msg, MSGFLAG_FLUSH, ClientID, true);
+			}
+			else
+			{
+				CMsgPacker Msg(NETMSG_SNAP);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick-DeltaTick);
+				Msg.AddInt(NumPackets);
+				Msg.AddInt(n);
+				Msg.AddInt(pSlot->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pSlot->m_aCompData[n*MaxSize], Chunk);
+				SendMsgEx(&Msg, MSGFLAG_FLUSH, ClientID, true);
+			}
+		}
+	}
+	else
+	{
+		pStats->m_NumEmpty++;
+		CMsgPacker Msg(NETMSG_SNAPEMPTY);
+		Msg.AddInt(m_CurrentGameTick);
+		Msg.AddInt(m_CurrentGameTick-DeltaTick);
+		SendMsgEx(&Msg, MSGFLAG_FLUSH, ClientID, true);
+	}
+}
+
+void CServer::DoTick()
+{
+	// apply new input
+	for(int c = 0; c < MaxClients(); c++)
+	{
+		if(m_pClients[c].m_State != CClient::STATE_INGAME)
+			continue;
+		CClient::CInput *pInput = &m_pClients[c].m_aInputs[Tick()&CClient::INPUT_RING_MASK];
+		if(pInput->m_GameTick == Tick())
+			GameServer()->OnClientPredictedInput(c, pInput->m_aData);
+	}
+
+	CProfileScope Scope(m_ProfileTick);
+	GameServer()->OnTick();
+}
+
 void CServer::DoSnapshot()
 {
 	GameServer()->OnPreSnap();
@@ -476,6 +663,7 @@ void CServer::DoSnapshot()
 	// create snapshot for demo recording
 	if(m_DemoRecorder.IsRecording())
 	{
+		CProfileScope Scope(m_ProfileSnapDemo);
 		char aData[CSnapshot::MAX_SIZE];
 		int SnapshotSize;
 
@@ -488,116 +676,135 @@ void CServer::DoSnapshot()
 		m_DemoRecorder.RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	// start additional snapshot workers if requested
+	bool Threaded = g_Config.m_SvSnapThreads > 0;
+	if(m_SnapshotJobPool.NumThreads() < g_Config.m_SvSnapThreads)
+		m_SnapshotJobPool.Init(g_Config.m_SvSnapThreads-m_SnapshotJobPool.NumThreads());
+
+	static CSnapshot EmptySnap;
+	EmptySnap.Clear();
+	unsigned EmptyHash = EmptySnap.Hash();
+	m_NumSnapshotCache = 0;
+
+	int aSnapClients[NET_MAX_CLIENTS];
+	int NumSnapClients = 0;
+
 	// create snapshots for all clients
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i = 0; i < MaxClients(); i++)
 	{
 		// client must be ingame to recive snapshots
-		if(m_aClients[i].m_State != CClient::STATE_INGAME)
+		if(m_pClients[i].m_State != CClient::STATE_INGAME)
 			continue;
 
 		// this client is trying to recover, don't spam snapshots
-		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_RECOVER && (Tick()%50) != 0)
+		if(m_pClients[i].m_SnapRate == CClient::SNAPRATE_RECOVER && (Tick()%50) != 0)
 			continue;
 
 		// this client is trying to recover, don't spam snapshots
-		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick()%10) != 0)
+		if(m_pClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick()%10) != 0)
 			continue;
 
 		{
-			char aData[CSnapshot::MAX_SIZE];
-			CSnapshot *pData = (CSnapshot*)aData;	// Fix compiler warning for strict-aliasing
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			char aCompData[CSnapshot::MAX_SIZE];
-			int SnapshotSize;
-			int Crc;
-			static CSnapshot EmptySnap;
 			CSnapshot *pDeltashot = &EmptySnap;
-			int DeltashotSize;
 			int DeltaTick = -1;
-			int DeltaSize;
+
+			CSnapshotSlot *pSlot = &m_pSnapshotSlots[i];
+			CSnapshot *pData = (CSnapshot *)pSlot->m_aData;
 
 			m_SnapshotBuilder.Init();
 
-			GameServer()->OnSnap(i);
+			{
+				CProfileScope Scope(m_ProfileSnapGame);
+				GameServer()->OnSnap(i);
+			}
 
 			// finish snapshot
-			SnapshotSize = m_SnapshotBuilder.Finish(pData);
-			Crc = pData->Crc();
+			CProfileScope BuildScope(m_ProfileSnapBuild);
+			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
 
 			// remove old snapshos
 			// keep 3 seconds worth of snapshots
-			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick-SERVER_TICK_SPEED*3);
+			m_pClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick-SERVER_TICK_SPEED*3);
 
 			// save it the snapshot
-			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0);
+			m_pClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0);
 
 			// find snapshot that we can preform delta against
-			EmptySnap.Clear();
-
+			CSnapshotStorage::CHolder *pDeltaHolder = m_pClients[i].m_Snapshots.Find(m_pClients[i].m_LastAckedSnapshot);
+			if(pDeltaHolder)
 			{
-				DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, 0, &pDeltashot, 0);
-				if(DeltashotSize >= 0)
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				else
+				pDeltashot = pDeltaHolder->m_pSnap;
+				DeltaTick = m_pClients[i].m_LastAckedSnapshot;
+			}
+			else
+			{
+				// no acked package found, force client to recover rate
+				if(m_pClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
 				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
+					m_pClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
+					m_pClients[i].m_SnapStats.m_NumToRecover++;
 				}
 			}
 
-			// create delta
-			DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			pSlot->m_pServer = this;
+			pSlot->m_pDeltashot = pDeltashot;
+			pSlot->m_DeltaTick = DeltaTick;
+			pSlot->m_pSource = pSlot;
+			pSlot->m_Size = SnapshotSize;
+			aSnapClients[NumSnapClients++] = i;
 
-			if(DeltaSize)
+			if(g_Config.m_SvSnapCache)
 			{
-				// compress it
-				int SnapshotSize;
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
-				int NumPackets;
-
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData);
-				NumPackets = (SnapshotSize+MaxSize-1)/MaxSize;
-
-				for(int n = 0, Left = SnapshotSize; Left; n++)
+				// only hashed while the cache is on, FindCachedSnapshot compares the bytes anyway
+				CSnapshotStorage::CHolder *pHolder = m_pClients[i].m_Snapshots.m_pLast;
+				pSlot->m_LocalOffset = m_SnapshotBuilder.LocalOffset();
+				pHolder->m_LocalOffset = pSlot->m_LocalOffset;
+				pHolder->m_Hash = pData->Hash(pSlot->m_LocalOffset);
+				pSlot->m_Hash = pHolder->m_Hash;
+				pSlot->m_DeltaHash = pDeltaHolder ? pDeltaHolder->m_Hash : EmptyHash;
+				pSlot->m_DeltashotSize = pDeltaHolder ? pDeltaHolder->m_SnapSize : EmptySnap.Size();
+				pSlot->m_DeltaLocalOffset = pDeltaHolder ? pDeltaHolder->m_LocalOffset : -1;
+
+				// a local int that is not in the base goes into the delta as it is, that delta is only for this client
+				if(pSlot->m_LocalOffset < 0 || pSlot->m_DeltaLocalOffset >= 0)
 				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
-
-					if(NumPackets == 1)
+					CSnapshotSlot *pCached = FindCachedSnapshot(pSlot);
+					if(pCached)
 					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick-DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n*MaxSize], Chunk);
-						SendMsgEx(&Msg, MSGFLAG_FLUSH, i, true);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick-DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n*MaxSize], Chunk);
-						SendMsgEx(&Msg, MSGFLAG_FLUSH, i, true);
+						pSlot->m_pSource = pCached;
+						m_SnapshotCacheHits++;
+						continue;
 					}
+					m_apSnapshotCache[m_NumSnapshotCache++] = pSlot;
 				}
+				m_SnapshotCacheMisses++;
 			}
+
+			BuildScope.Stop();
+
+			// with workers this only counts handing it over
+			CProfileScope EncodeScope(m_ProfileSnapEncode);
+			if(Threaded)
+				m_SnapshotJobPool.Add(&pSlot->m_Job, SnapshotJob, pSlot);
 			else
-			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick-DeltaTick);
-				SendMsgEx(&Msg, MSGFLAG_FLUSH, i, true);
-			}
+				SnapshotJob(pSlot);
 		}
 	}
 
+	// send the snapshots in client order
+	CProfileScope SendScope(m_ProfileSnapSend);
+	for(int s = 0; s < NumSnapClients; s++)
+	{
+		CSnapshotSlot *pSlot = &m_pSnapshotSlots[aSnapClients[s]];
+		while(pSlot->m_pSource->m_Job.Status() != CJob::STATE_DONE)
+			thread_yield();
+		sync_barrier(); // don't read the compressed delta before the worker finished writing it
+
+		if(pSlot->m_pSource != pSlot)
+			m_SnapshotCacheBytes += pSlot->m_pSource->m_CompSize;
+		SendSnapshot(aSnapClients[s], pSlot);
+	}
+
 	GameServer()->OnPostSnap();
 }
 
@@ -605,14 +812,16 @@ void CServer::DoSnapshot()
 int CServer::NewClientCallback(int ClientID, void *pUser)
 {
 	CServer *pThis = (CServer *)pUser;
-	pThis->m_aClients[ClientID].m_State = CClient::STATE_AUTH;
-	pThis->m_aClients[ClientID].m_aName[0] = 0;
-	pThis->m_aClients[ClientID].m_aClan[0] = 0;
-	pThis->m_aClients[ClientID].m_Country = -1;
-	pThis->m_aClients[ClientID].m_Authed = AUTHED_NO;
-	pThis->m_aClients[ClientID].m_AuthTries = 0;
-	pThis->m_aClients[ClientID].m_pRconCmdToSend = 0;
-	pThis->m_aClients[ClientID].Reset();
+	pThis->m_pClients[ClientID].m_State = CClient::STATE_AUTH;
+	pThis->m_pClients[ClientID].m_aName[0] = 0;
+	pThis->m_pClients[ClientID].m_aClan[0] = 0;
+	pThis->m_pClients[ClientID].m_Country = -1;
+	pThis->m_pClients[ClientID].m_Authed = AUTHED_NO;
+	pThis->m_pClients[ClientID].m_AuthTries = 0;
+	pThis->m_pClients[ClientID].m_pRconCmdToSend = 0;
+	pThis->m_pClients[ClientID].m_SnapStats.Reset();
+	pThis->m_pClients[ClientID].Reset();
+	pThis->m_InputLog.RecordConnect(ClientID);
 	return 0;
 }
 
@@ -626,19 +835,22 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr,	pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
+	pThis->m_InputLog.RecordDrop(ClientID, pReason);
 
 	// notify the mod about the drop
-	if(pThis->m_aClients[ClientID].m_State >= CClient::STATE_READY)
+	if(pThis->m_pClients[ClientID].m_State >= CClient::STATE_READY)
 		pThis->GameServer()->OnClientDrop(ClientID, pReason);
 
-	pThis->m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
-	pThis->m_aClients[ClientID].m_aName[0] = 0;
-	pThis->m_aClients[ClientID].m_aClan[0] = 0;
-	pThis->m_aClients[ClientID].m_Country = -1;
-	pThis->m_aClients[ClientID].m_Authed = AUTHED_NO;
-	pThis->m_aClients[ClientID].m_AuthTries = 0;
-	pThis->m_aClients[ClientID].m_pRconCmdToSend = 0;
-	pThis->m_aClients[ClientID].m_Snapshots.PurgeAll();
+	pThis->m_pClients[ClientID].m_State = CClient::STATE_EMPTY;
+	pThis->m_pClients[ClientID].m_aName[0] = 0;
+	pThis->m_pClients[ClientID].m_aClan[0] = 0;
+	pThis->m_pClients[ClientID].m_Country = -1;
+	pThis->m_pClients[ClientID].m_Authed = AUTHED_NO;
+	pThis->m_pClients[ClientID].m_AuthTries = 0;
+	pThis->m_pClients[ClientID].m_pRconCmdToSend = 0;
+	pThis->m_pClients[ClientID].m_Snapshots.PurgeAll();
+	pThis->m_DroppedSnapStats.Add(&pThis->m_pClients[ClientID].m_SnapStats);
+	pThis->m_pClients[ClientID].m_SnapStats.Reset();
 	return 0;
 }
 
@@ -673,9 +885,9 @@ void CServer::SendRconLineAuthed(const char *pLine, void *pUser)
 	if(ReentryGuard) return;
 	ReentryGuard++;
 
-	for(i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(i = 0; i < pThis->MaxClients(); i++)
 	{
-		if(pThis->m_aClients[i].m_State != CClient::STATE_EMPTY && pThis->m_aClients[i].m_Authed >= pThis->m_RconAuthLevel)
+		if(pThis->m_pClients[i].m_State != CClient::STATE_EMPTY && pThis->m_pClients[i].m_Authed >= pThis->m_RconAuthLevel)
 			pThis->SendRconLine(i, pLine);
 	}
 
@@ -700,15 +912,15 @@ void CServer::SendRconCmdRem(const IConsole::CCommandInfo *pCommandInfo, int Cli
 
 void CServer::UpdateClientRconCommands()
 {
-	int ClientID = Tick() % (MAX_CLIENTS-MAX_BOTS);
+	int ClientID = Tick() % MaxClients();
 
-	if(m_aClients[ClientID].m_State != CClient::STATE_EMPTY && m_aClients[ClientID].m_Authed)
+	if(m_pClients[ClientID].m_State != CClient::STATE_EMPTY && m_pClients[ClientID].m_Authed)
 	{
-		int ConsoleAccessLevel = m_aClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : IConsole::ACCESS_LEVEL_MOD;
-		for(int i = 0; i < MAX_RCONCMD_SEND && m_aClients[ClientID].m_pRconCmdToSend; ++i)
+		int ConsoleAccessLevel = m_pClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : IConsole::ACCESS_LEVEL_MOD;
+		for(int i = 0; i < MAX_RCONCMD_SEND && m_pClients[ClientID].m_pRconCmdToSend; ++i)
 		{
-			SendRconCmdAdd(m_aClients[ClientID].m_pRconCmdToSend, ClientID);
-			m_aClients[ClientID].m_pRconCmdToSend = m_aClients[ClientID].m_pRconCmdToSend->NextCommandInfo(ConsoleAccessLevel, CFGFLAG_SERVER);
+			SendRconCmdAdd(m_pClients[ClientID].m_pRconCmdToSend, ClientID);
+			m_pClients[ClientID].m_pRconCmdToSend = m_pClients[ClientID].m_pRconCmdToSend->NextCommandInfo(ConsoleAccessLevel, CFGFLAG_SERVER);
 		}
 	}
 }
@@ -733,7 +945,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 		// system message
 		if(Msg == NETMSG_INFO)
 		{
-			if(m_aClients[ClientID].m_State == CClient::STATE_AUTH)
+			if(m_pClients[ClientID].m_State == CClient::STATE_AUTH)
 			{
 				const char *pVersion = Unpacker.GetString(CUnpacker::SANITIZE_CC);
 				if(str_comp(pVersion, GameServer()->NetVersion()) != 0)
@@ -765,7 +977,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
                     }
                 }
 
-				m_aClients[ClientID].m_State = CClient::STATE_CONNECTING;
+				m_pClients[ClientID].m_State = CClient::STATE_CONNECTING;
 				SendMap(ClientID);
 			}
 		}
@@ -805,7 +1017,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 		}
 		else if(Msg == NETMSG_READY)
 		{
-			if(m_aClients[ClientID].m_State == CClient::STATE_CONNECTING)
+			if(m_pClients[ClientID].m_State == CClient::STATE_CONNECTING)
 			{
                 Addr = m_NetServer.ClientAddr(ClientID);
                 char aAddrStr[NETADDR_MAXSTRSIZE];
@@ -814,14 +1026,15 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
                 char aBuf[256];
                 str_format(aBuf, sizeof(aBuf), "player is ready. ClientID=%x addr=%s", ClientID, aAddrStr);
                 Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
-                m_aClients[ClientID].m_State = CClient::STATE_READY;
+                m_pClients[ClientID].m_State = CClient::STATE_READY;
+                m_InputLog.RecordReady(ClientID);
                 GameServer()->OnClientConnected(ClientID);
                 SendConnectionReady(ClientID);
 			}
 		}
 		else if(Msg == NETMSG_ENTERGAME)
 		{
-			if(m_aClients[ClientID].m_State == CClient::STATE_READY && GameServer()->IsClientReady(ClientID))
+			if(m_pClients[ClientID].m_State == CClient::STATE_READY && GameServer()->IsClientReady(ClientID))
 			{
 				Addr = m_NetServer.ClientAddr(ClientID);
 				char aAddrStr[NETADDR_MAXSTRSIZE];
@@ -830,7 +1043,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				char aBuf[256];
 				str_format(aBuf, sizeof(aBuf), "player has entered the game. ClientID=%x addr=%s", ClientID, aAddrStr);
 				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
-				m_aClients[ClientID].m_State = CClient::STATE_INGAME;
+				m_pClients[ClientID].m_State = CClient::STATE_INGAME;
+				m_InputLog.RecordEnter(ClientID);
 				GameServer()->OnClientEnter(ClientID);
             }
 		}
@@ -839,7 +1053,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			CClient::CInput *pInput;
 			int64 TagTime;
 
-			m_aClients[ClientID].m_LastAckedSnapshot = Unpacker.GetInt();
+			m_pClients[ClientID].m_LastAckedSnapshot = Unpacker.GetInt();
 			int IntendedTick = Unpacker.GetInt();
 			int Size = Unpacker.GetInt();
 
@@ -847,15 +1061,18 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			if(Unpacker.Error() || Size/4 > MAX_INPUT_SIZE)
 				return;
 
-			if(m_aClients[ClientID].m_LastAckedSnapshot > 0)
-				m_aClients[ClientID].m_SnapRate = CClient::SNAPRATE_FULL;
+			if(m_pClients[ClientID].m_LastAckedSnapshot > 0 && m_pClients[ClientID].m_SnapRate != CClient::SNAPRATE_FULL)
+			{
+				m_pClients[ClientID].m_SnapRate = CClient::SNAPRATE_FULL;
+				m_pClients[ClientID].m_SnapStats.m_NumToFull++;
+			}
 
-			if(m_aClients[ClientID].m_Snapshots.Get(m_aClients[ClientID].m_LastAckedSnapshot, &TagTime, 0, 0) >= 0)
-				m_aClients[ClientID].m_Latency = (int)(((time_get()-TagTime)*1000)/time_freq());
+			if(m_pClients[ClientID].m_Snapshots.Get(m_pClients[ClientID].m_LastAckedSnapshot, &TagTime, 0, 0) >= 0)
+				m_pClients[ClientID].m_Latency = (int)(((time_get()-TagTime)*1000)/time_freq());
 
 			// add message to report the input timing
 			// skip packets that are old
-			if(IntendedTick > m_aClients[ClientID].m_LastInputTick)
+			if(IntendedTick > m_pClients[ClientID].m_LastInputTick)
 			{
 				int TimeLeft = ((TickStartTime(IntendedTick)-time_get())*1000) / time_freq();
 
@@ -865,39 +1082,56 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				SendMsgEx(&Msg, 0, ClientID, true);
 			}
 
-			m_aClients[ClientID].m_LastInputTick = IntendedTick;
-
-			pInput = &m_aClients[ClientID].m_aInputs[m_aClients[ClientID].m_CurrentInput];
-
-			if(IntendedTick <= Tick())
-				IntendedTick = Tick()+1;
-
-			pInput->m_GameTick = IntendedTick;
+			m_pClients[ClientID].m_LastInputTick = IntendedTick;
 
 			for(int i = 0; i < Size/4; i++)
-				pInput->m_aData[i] = Unpacker.GetInt();
+				m_pClients[ClientID].m_LatestInput.m_aData[i] = Unpacker.GetInt();
 
-			mem_copy(m_aClients[ClientID].m_LatestInput.m_aData, pInput->m_aData, MAX_INPUT_SIZE*sizeof(int));
+			// store it at the tick it gets applied
+			bool Late = IntendedTick <= Tick();
+			if(Late)
+			{
+				IntendedTick = Tick()+1;
+				m_pClients[ClientID].m_NumLateInputs++;
+			}
+			m_pClients[ClientID].m_NumInputs++;
 
-			m_aClients[ClientID].m_CurrentInput++;
-			m_aClients[ClientID].m_CurrentInput %= 200;
+			pInput = &m_pClients[ClientID].m_aInputs[IntendedTick&CClient::INPUT_RING_MASK];
+			int LogFlags = Late ? CInputLog::INPUTFLAG_LATE : 0;
+			if(IntendedTick > Tick()+CClient::INPUT_RING_SIZE || (Late && pInput->m_GameTick == IntendedTick && !pInput->m_Late))
+			{
+				// the ring does not reach that far or the tick already has an input that came in time
+				m_pClients[ClientID].m_NumDroppedInputs++;
+			}
+			else
+			{
+				if(pInput->m_GameTick == IntendedTick)
+					m_pClients[ClientID].m_NumDuplicateInputs++;
+				pInput->m_GameTick = IntendedTick;
+				pInput->m_Late = Late;
+				mem_copy(pInput->m_aData, m_pClients[ClientID].m_LatestInput.m_aData, MAX_INPUT_SIZE*sizeof(int));
+				LogFlags |= CInputLog::INPUTFLAG_STORED;
+			}
+			// a negative size reads no ints here, the log must not take it as it is
+			m_InputLog.RecordInput(ClientID, IntendedTick-Tick(), LogFlags, m_pClients[ClientID].m_LatestInput.m_aData, clamp(Size/4, 0, (int)MAX_INPUT_SIZE));
 
 			// call the mod with the fresh input data
-			if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
-				GameServer()->OnClientDirectInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
+			if(m_pClients[ClientID].m_State == CClient::STATE_INGAME)
+				GameServer()->OnClientDirectInput(ClientID, m_pClients[ClientID].m_LatestInput.m_aData);
 		}
 		else if(Msg == NETMSG_RCON_CMD)
 		{
 			const char *pCmd = Unpacker.GetString();
 
-			if(Unpacker.Error() == 0 && m_aClients[ClientID].m_Authed)
+			if(Unpacker.Error() == 0 && m_pClients[ClientID].m_Authed)
 			{
 				char aBuf[256];
 				str_format(aBuf, sizeof(aBuf), "ClientID=%d rcon='%s'", ClientID, pCmd);
 				Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
 				m_RconClientID = ClientID;
-				m_RconAuthLevel = m_aClients[ClientID].m_Authed;
-				Console()->SetAccessLevel(m_aClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : IConsole::ACCESS_LEVEL_MOD);
+				m_RconAuthLevel = m_pClients[ClientID].m_Authed;
+				m_InputLog.RecordRcon(ClientID, m_pClients[ClientID].m_Authed, pCmd);
+				Console()->SetAccessLevel(m_pClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : IConsole::ACCESS_LEVEL_MOD);
 				Console()->ExecuteLine(pCmd);
 				Console()->SetAccessLevel(IConsole::ACCESS_LEVEL_ADMIN);
 				m_RconClientID = -1;
@@ -923,10 +1157,10 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 					Msg.AddInt(1);	//cmdlist
 					SendMsgEx(&Msg, MSGFLAG_VITAL, ClientID, true);
 
-					m_aClients[ClientID].m_Authed = AUTHED_ADMIN;
+					m_pClients[ClientID].m_Authed = AUTHED_ADMIN;
 					int SendRconCmds = Unpacker.GetInt();
 					if(Unpacker.Error() == 0 && SendRconCmds)
-						m_aClients[ClientID].m_pRconCmdToSend = Console()->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER);
+						m_pClients[ClientID].m_pRconCmdToSend = Console()->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER);
 					SendRconLine(ClientID, "Admin authentication successful. Full remote console access granted.");
 					char aBuf[256];
 					str_format(aBuf, sizeof(aBuf), "ClientID=%d authed (admin)", ClientID);
@@ -939,10 +1173,10 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 					Msg.AddInt(1);	//cmdlist
 					SendMsgEx(&Msg, MSGFLAG_VITAL, ClientID, true);
 
-					m_aClients[ClientID].m_Authed = AUTHED_MOD;
+					m_pClients[ClientID].m_Authed = AUTHED_MOD;
 					int SendRconCmds = Unpacker.GetInt();
 					if(Unpacker.Error() == 0 && SendRconCmds)
-						m_aClients[ClientID].m_pRconCmdToSend = Console()->FirstCommandInfo(IConsole::ACCESS_LEVEL_MOD, CFGFLAG_SERVER);
+						m_pClients[ClientID].m_pRconCmdToSend = Console()->FirstCommandInfo(IConsole::ACCESS_LEVEL_MOD, CFGFLAG_SERVER);
 					SendRconLine(ClientID, "Moderator authentication successful. Limited remote console access granted.");
 					char aBuf[256];
 					str_format(aBuf, sizeof(aBuf), "ClientID=%d authed (moderator)", ClientID);
@@ -950,11 +1184,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				}
 				else if(g_Config.m_SvRconMaxTries)
 				{
-					m_aClients[ClientID].m_AuthTries++;
+					m_pClients[ClientID].m_AuthTries++;
 					char aBuf[128];
-					str_format(aBuf, sizeof(aBuf), "Wrong password %d/%d.", m_aClients[ClientID].m_AuthTries, g_Config.m_SvRconMaxTries);
+					str_format(aBuf, sizeof(aBuf), "Wrong password %d/%d.", m_pClients[ClientID].m_AuthTries, g_Config.m_SvRconMaxTries);
 					SendRconLine(ClientID, aBuf);
-					if(m_aClients[ClientID].m_AuthTries >= g_Config.m_SvRconMaxTries)
+					if(m_pClients[ClientID].m_AuthTries >= g_Config.m_SvRconMaxTries)
 					{
 						if(!g_Config.m_SvRconBantime)
 							m_NetServer.Drop(ClientID, "Too many remote console authentication tries");
@@ -1001,8 +1235,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	else
 	{
 		// game message
-		if(m_aClients[ClientID].m_State >= CClient::STATE_READY)
+		if(m_pClients[ClientID].m_State >= CClient::STATE_READY)
+		{
+			m_InputLog.RecordMessage(ClientID, pPacket->m_pData, pPacket->m_DataSize);
 			GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+		}
 	}
 }
 
@@ -1014,9 +1251,9 @@ void CServer::SendServerInfo(NETADDR *pAddr, int Token)
 
 	// count the players
 	int PlayerCount = 0, ClientCount = 0;
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(int i = 0; i < MaxClients(); i++)
 	{
-		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+		if(m_pClients[i].m_State != CClient::STATE_EMPTY)
 		{
 			if(GameServer()->IsClientPlayer(i))
 				PlayerCount++;
@@ -1050,14 +1287,16 @@ void CServer::SendServerInfo(NETADDR *pAddr, int Token)
 	str_format(aBuf, sizeof(aBuf), "%d", ClientCount); p.AddString(aBuf, 3); // num clients
 	str_format(aBuf, sizeof(aBuf), "%d", m_NetServer.MaxClients()); p.AddString(aBuf, 3); // max clients
 
-	for(i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	// the list stops where the packet is full, the counts above stay right
+	const int MaxClientInfoSize = MAX_NAME_LENGTH+MAX_CLAN_LENGTH+6+6+2;
+	for(i = 0; i < MaxClients() && p.Size()+MaxClientInfoSize <= NET_MAX_PAYLOAD; i++)
 	{
-		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+		if(m_pClients[i].m_State != CClient::STATE_EMPTY)
 		{
 			p.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
 			p.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-			str_format(aBuf, sizeof(aBuf), "%d", m_aClients[i].m_Country); p.AddString(aBuf, 6); // client country
-			str_format(aBuf, sizeof(aBuf), "%d", m_aClients[i].m_Score); p.AddString(aBuf, 6); // client score
+			str_format(aBuf, sizeof(aBuf), "%d", m_pClients[i].m_Country); p.AddString(aBuf, 6); // client country
+			str_format(aBuf, sizeof(aBuf), "%d", m_pClients[i].m_Score); p.AddString(aBuf, 6); // client score
 			str_format(aBuf, sizeof(aBuf), "%d", GameServer()->IsClientPlayer(i)?1:0); p.AddString(aBuf, 2); // is player?
 		}
 	}
@@ -1072,9 +1311,9 @@ void CServer::SendServerInfo(NETADDR *pAddr, int Token)
 
 void CServer::UpdateServerInfo()
 {
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+	for(int i = 0; i < MaxClients(); ++i)
 	{
-		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+		if(m_pClients[i].m_State != CClient::STATE_EMPTY)
 		{
 			NETADDR Addr = m_NetServer.ClientAddr(i);
 			SendServerInfo(&Addr, -1);
@@ -1165,6 +1404,7 @@ int CServer::LoadMap(const char *pMapName)
 
 	// stop recording when we change map
 	m_DemoRecorder.Stop();
+	m_InputLog.Stop();
 
 	// reinit snapshot ids
 	m_IDPool.TimeoutIDs();
@@ -1206,6 +1446,13 @@ int CServer::Run()
 	//
 	m_PrintCBIndex = Console()->RegisterPrintCallback(g_Config.m_ConsoleOutputLevel, SendRconLineAuthed, this);
 
+	// benchmark run without network
+	if(m_aInputLogReplay[0])
+		return ReplayInputLog();
+
+	// the client slots, now that sv_max_clients is known
+	Init();
+
 	// load map
 	if(!LoadMap(g_Config.m_SvMap))
 	{
@@ -1227,7 +1474,7 @@ int CServer::Run()
 		BindAddr.port = g_Config.m_SvPort;
 	}
 
-	if(!m_NetServer.Open(BindAddr, g_Config.m_SvMaxClients, g_Config.m_SvMaxClientsPerIP, 0))
+	if(!m_NetServer.Open(BindAddr, MaxClients(), g_Config.m_SvMaxClientsPerIP, g_Config.m_SvNetThread ? NETFLAG_THREADED : 0))
 	{
 		dbg_msg("server", "couldn't open socket. port might already be in use");
 		return -1;
@@ -1235,6 +1482,10 @@ int CServer::Run()
 
 	m_NetServer.SetCallbacks(NewClientCallback, DelClientCallback, this);
 
+	// the main loop sleeps on this between the ticks
+	m_NetWait = net_wait_create();
+	m_NetServer.SetRecvWait(m_NetWait);
+
 	m_Econ.Init(Console());
 
 	char aBuf[256];
@@ -1252,9 +1503,13 @@ int CServer::Run()
 	{
 		int64 ReportTime = time_get();
 		int ReportInterval = 3;
+		NETSTATS PrevStats;
+		net_stats(&PrevStats);
+		int64 ProfileLogTime = time_get();
 
 		m_Lastheartbeat = 0;
 		m_GameStartTime = time_get();
+		ResetSchedulerStats();
 
 		if(g_Config.m_Debug)
 		{
@@ -1266,6 +1521,7 @@ int CServer::Run()
 		{
 			int64 t = time_get();
 			int NewTicks = 0;
+			g_Profiler.SetEnabled(g_Config.m_SvProfile != 0);
 
 			// load new map TODO: don't poll this
 			if(str_comp(g_Config.m_SvMap, m_aCurrentMap) != 0 || m_MapReload)
@@ -1278,18 +1534,20 @@ int CServer::Run()
 					// new map loaded
 					GameServer()->OnShutdown();
 
-					for(int c = 0; c < MAX_CLIENTS; c++)
+					for(int c = 0; c < MaxClients(); c++)
 					{
-						if(m_aClients[c].m_State <= CClient::STATE_AUTH)
+						if(m_pClients[c].m_State <= CClient::STATE_AUTH)
 							continue;
 
 						SendMap(c);
-						m_aClients[c].Reset();
-						m_aClients[c].m_State = CClient::STATE_CONNECTING;
+						m_pClients[c].Reset();
+						m_pClients[c].m_State = CClient::STATE_CONNECTING;
 					}
 
 					m_GameStartTime = time_get();
 					m_CurrentGameTick = 0;
+					if(m_aInputLogFile[0])
+						StartInputLog();
 					Kernel()->ReregisterInterface(GameServer());
 					GameServer()->OnInit();
 					UpdateServerInfo();
@@ -1307,23 +1565,17 @@ int CServer::Run()
 				m_CurrentGameTick++;
 				NewTicks++;
 
-				// apply new input
-				for(int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(m_aClients[c].m_State == CClient::STATE_EMPTY)
-						continue;
-					for(int i = 0; i < 200; i++)
-					{
-						if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
-						{
-							if(m_aClients[c].m_State == CClient::STATE_INGAME)
-								GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
-							break;
-						}
-					}
-				}
-
-				GameServer()->OnTick();
+				// how late the tick starts
+				int64 Lateness = (t-TickStartTime(m_CurrentGameTick))*1000000/time_freq();
+				int Bucket = 0;
+				while(Bucket < TICKTIME_BUCKETS-1 && Lateness >= (1<<Bucket))
+					Bucket++;
+				m_aTickLateness[Bucket]++;
+				m_TickLatenessSum += Lateness;
+				m_MaxTickLateness = max(m_MaxTickLateness, Lateness);
+
+				m_InputLog.RecordTick();
+				DoTick();
 			}
 
 			// snap game
@@ -1338,45 +1590,74 @@ int CServer::Run()
 			// master server stuff
 			m_Register.RegisterUpdate(m_NetServer.NetType());
 
-			PumpNetwork();
+			{
+				CProfileScope Scope(m_ProfileNetwork);
+				PumpNetwork();
+			}
+
+			if(NewTicks)
+			{
+				int64 TickTime = (time_get()-t)*1000000/time_freq();
+				int Bucket = 0;
+				while(Bucket < TICKTIME_BUCKETS-1 && TickTime >= (1<<Bucket))
+					Bucket++;
+				m_aTickTimes[Bucket]++;
+				m_MaxTickTime = max(m_MaxTickTime, TickTime);
+
+				g_Profiler.EndTick();
+			}
+
+			if(g_Profiler.Enabled() && g_Config.m_SvProfileLog && ProfileLogTime < time_get())
+			{
+				LogProfile();
+				ProfileLogTime = time_get()+time_freq()*g_Config.m_SvProfileLog;
+			}
 
 			if(ReportTime < time_get())
 			{
+				NETSTATS Stats;
+				net_stats(&Stats);
 				if(g_Config.m_Debug)
 				{
-					/*
-					static NETSTATS prev_stats;
-					NETSTATS stats;
-					netserver_stats(net, &stats);
-
-					perf_next();
-
-					if(config.dbg_pref)
-						perf_dump(&rootscope);
-
-					dbg_msg("server", "send=%8d recv=%8d",
-						(stats.send_bytes - prev_stats.send_bytes)/reportinterval,
-						(stats.recv_bytes - prev_stats.recv_bytes)/reportinterval);
-
-					prev_stats = stats;
-					*/
+					// packets per system call shows how well the batching works
+					dbg_msg("server", "send=%d B/s %d packets/s %d calls/s recv=%d B/s %d packets/s %d calls/s",
+						(Stats.sent_bytes-PrevStats.sent_bytes)/ReportInterval,
+						(Stats.sent_packets-PrevStats.sent_packets)/ReportInterval,
+						(Stats.send_calls-PrevStats.send_calls)/ReportInterval,
+						(Stats.recv_bytes-PrevStats.recv_bytes)/ReportInterval,
+						(Stats.recv_packets-PrevStats.recv_packets)/ReportInterval,
+						(Stats.recv_calls-PrevStats.recv_calls)/ReportInterval);
 				}
+				PrevStats = Stats;
 
 				ReportTime += time_freq()*ReportInterval;
 			}
 
-			// wait for incomming data
-			net_socket_read_wait(m_NetServer.Socket(), 5);
+			// sleep until the next tick or until something comes in. the
+			// network thread signals the wait itself
+			NETSOCKET aSockets[2+NET_MAX_CONSOLE_CLIENTS];
+			int NumSockets = 0;
+			if(!m_NetServer.Threaded())
+				aSockets[NumSockets++] = m_NetServer.Socket();
+			NumSockets += m_Econ.Sockets(aSockets+NumSockets, (int)(sizeof(aSockets)/sizeof(aSockets[0]))-NumSockets);
+
+			int64 SleepStart = time_get();
+			net_wait(m_NetWait, aSockets, NumSockets, TickStartTime(m_CurrentGameTick+1));
+			m_SleepTime += time_get()-SleepStart;
+			m_NumWakeups++;
 		}
 	}
 	// disconnect all clients on shutdown
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+	for(int i = 0; i < MaxClients(); ++i)
 	{
-		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+		if(m_pClients[i].m_State != CClient::STATE_EMPTY)
 			m_NetServer.Drop(i, "Server shutdown");
 
 		m_Econ.Shutdown();
 	}
+	m_NetServer.Close();
+	net_wait_destroy(m_NetWait);
+	m_InputLog.Stop();
 
 	GameServer()->OnShutdown();
 	m_pMap->Unload();
@@ -1386,6 +1667,172 @@ int CServer::Run()
 	return 0;
 }
 
+void CServer::StartInputLog()
+{
+	// the replay seeds the same, so the random choices of the mod match
+	int Seed = (int)time_get();
+	srand(Seed);
+	m_InputLog.Start(Storage(), Console(), m_aInputLogFile, m_aCurrentMap, m_CurrentMapCrc, m_pCurrentMapData, m_CurrentMapSize,
+		g_Config.m_SvGametype, MaxClients(), Seed);
+	m_aInputLogFile[0] = 0;
+
+	// the clients that stay for the new map
+	for(int c = 0; c < MaxClients(); c++)
+		if(m_pClients[c].m_State > CClient::STATE_AUTH)
+			m_InputLog.RecordConnect(c);
+}
+
+void CServer::ReplaySnapshot()
+{
+	// only the game part, the rest does not depend on the game
+	GameServer()->OnPreSnap();
+	for(int i = 0; i < MaxClients(); i++)
+	{
+		if(m_pClients[i].m_State != CClient::STATE_INGAME)
+			continue;
+
+		char aData[CSnapshot::MAX_SIZE];
+		m_SnapshotBuilder.Init();
+		{
+			CProfileScope Scope(m_ProfileSnapGame);
+			GameServer()->OnSnap(i);
+		}
+		CProfileScope Scope(m_ProfileSnapBuild);
+		m_SnapshotBuilder.Finish(aData);
+	}
+	GameServer()->OnPostSnap();
+}
+
+int CServer::ReplayInputLog()
+{
+	CInputLogPlayer Player;
+	if(Player.Load(Storage(), Console(), m_aInputLogReplay) != 0)
+		return -1;
+	const CInputLog::CHeader *pHeader = Player.Header();
+
+	// the same slots as the recording
+	g_Config.m_SvMaxClients = pHeader->m_MaxClients;
+	Init();
+
+	// take the map from the log unless it is here already
+	char aMap[128];
+	char aBuf[256];
+	str_copy(aMap, pHeader->m_aMap, sizeof(aMap));
+	if(!LoadMap(aMap) || m_CurrentMapCrc != pHeader->m_MapCrc)
+	{
+		str_format(aMap, sizeof(aMap), "%s_%08x", pHeader->m_aMap, pHeader->m_MapCrc);
+		str_format(aBuf, sizeof(aBuf), "maps/%s.map", aMap);
+		IOHANDLE File = Storage()->OpenFile(aBuf, IOFLAG_WRITE, IStorageTW::TYPE_SAVE);
+		if(File)
+		{
+			io_write(File, Player.MapData(), pHeader->m_MapSize);
+			io_close(File);
+		}
+		if(!File || !LoadMap(aMap))
+		{
+			dbg_msg("server", "failed to load the map of the input log. mapname='%s'", aMap);
+			return -1;
+		}
+	}
+	str_copy(g_Config.m_SvMap, aMap, sizeof(g_Config.m_SvMap));
+	str_copy(g_Config.m_SvGametype, pHeader->m_aGameType, sizeof(g_Config.m_SvGametype));
+
+	m_ReplayingInputLog = true;
+	srand(pHeader->m_Seed);
+	m_GameStartTime = time_get();
+	m_CurrentGameTick = 0;
+	GameServer()->OnInit();
+	m_pConsole->StoreCommands(false);
+
+	g_Profiler.SetEnabled(true);
+	g_Profiler.Reset();
+
+	// as fast as it goes, no network and no sleeping
+	int NumTicks = 0;
+	int64 StartTime = time_get();
+	CInputLog::CEvent Event;
+	while(Player.NextEvent(&Event))
+	{
+		int ClientID = Event.m_ClientID;
+		CClient *pClient = &m_pClients[ClientID];
+		switch(Event.m_Type)
+		{
+		case CInputLog::EVENT_TICK:
+			m_CurrentGameTick++;
+			NumTicks++;
+			DoTick();
+			if(g_Config.m_SvHighBandwidth || (m_CurrentGameTick%2) == 0)
+				ReplaySnapshot();
+			g_Profiler.EndTick();
+			break;
+		case CInputLog::EVENT_CONNECT:
+			NewClientCallback(ClientID, this);
+			break;
+		case CInputLog::EVENT_READY:
+			pClient->m_State = CClient::STATE_READY;
+			GameServer()->OnClientConnected(ClientID);
+			break;
+		case CInputLog::EVENT_ENTER:
+			pClient->m_State = CClient::STATE_INGAME;
+			GameServer()->OnClientEnter(ClientID);
+			break;
+		case CInputLog::EVENT_DROP:
+			DelClientCallback(ClientID, Event.m_aString, this);
+			break;
+		case CInputLog::EVENT_INPUT:
+			mem_copy(pClient->m_LatestInput.m_aData, Event.m_aInput, Event.m_InputSize*sizeof(int));
+			if(Event.m_Flags&CInputLog::INPUTFLAG_STORED)
+			{
+				CClient::CInput *pInput = &pClient->m_aInputs[(Tick()+Event.m_Tick)&CClient::INPUT_RING_MASK];
+				pInput->m_GameTick = Tick()+Event.m_Tick;
+				pInput->m_Late = (Event.m_Flags&CInputLog::INPUTFLAG_LATE) != 0;
+				mem_copy(pInput->m_aData, pClient->m_LatestInput.m_aData, MAX_INPUT_SIZE*sizeof(int));
+			}
+			if(pClient->m_State == CClient::STATE_INGAME)
+				GameServer()->OnClientDirectInput(ClientID, pClient->m_LatestInput.m_aData);
+			break;
+		case CInputLog::EVENT_MESSAGE:
+			{
+				CUnpacker Unpacker;
+				Unpacker.Reset(Event.m_pData, Event.m_DataSize);
+				int Msg = Unpacker.GetInt()>>1;
+				if(!Unpacker.Error() && pClient->m_State >= CClient::STATE_READY)
+					GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+			}
+			break;
+		case CInputLog::EVENT_RCON:
+			m_RconClientID = ClientID;
+			m_RconAuthLevel = Event.m_Flags;
+			Console()->SetAccessLevel(Event.m_Flags == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : IConsole::ACCESS_LEVEL_MOD);
+			Console()->ExecuteLine(Event.m_aString);
+			Console()->SetAccessLevel(IConsole::ACCESS_LEVEL_ADMIN);
+			m_RconClientID = -1;
+			m_RconAuthLevel = AUTHED_ADMIN;
+			break;
+		}
+	}
+	int64 Elapsed = max(time_get()-StartTime, (int64)1);
+
+	// the whole world at the end, a change that keeps the game the same keeps this
+	char aData[CSnapshot::MAX_SIZE];
+	m_SnapshotBuilder.Init();
+	GameServer()->OnSnap(-1);
+	m_SnapshotBuilder.Finish(aData);
+
+	float Seconds = Elapsed/(float)time_freq();
+	str_format(aBuf, sizeof(aBuf), "ticks=%d time=%.3fs ticks/s=%.0f realtime=x%.1f crc=%08x%s", NumTicks, Seconds, NumTicks/Seconds,
+		NumTicks/Seconds/SERVER_TICK_SPEED, ((CSnapshot *)aData)->Crc(), Player.Error() ? " (log is broken, stopped early)" : "");
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", aBuf);
+	PrintProfile();
+
+	GameServer()->OnShutdown();
+	m_pMap->Unload();
+	if(m_pCurrentMapData)
+		mem_free(m_pCurrentMapData);
+	m_pCurrentMapData = 0;
+	return Player.Error() ? -1 : 0;
+}
+
 void CServer::ConKick(IConsole::IResult *pResult, void *pUser)
 {
 	if(pResult->NumArguments() > 1)
@@ -1414,7 +1861,7 @@ void CServer::ConBan(IConsole::IResult *pResult, void *pUser)
 
 	if(net_addr_from_str(&Addr, pStr) == 0)
 	{
-		if(pServer->m_RconClientID >= 0 && pServer->m_RconClientID < MAX_CLIENTS && pServer->m_aClients[pServer->m_RconClientID].m_State != CClient::STATE_EMPTY)
+		if(pServer->m_RconClientID >= 0 && pServer->m_RconClientID < pServer->MaxClients() && pServer->m_pClients[pServer->m_RconClientID].m_State != CClient::STATE_EMPTY)
 		{
 			NETADDR AddrCheck = pServer->m_NetServer.ClientAddr(pServer->m_RconClientID);
 			Addr.port = AddrCheck.port = 0;
@@ -1424,14 +1871,14 @@ void CServer::ConBan(IConsole::IResult *pResult, void *pUser)
 				return;
 			}
 
-			for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+			for(int i = 0; i < pServer->MaxClients(); ++i)
 			{
 				if(i == pServer->m_RconClientID)
 					continue;
 
 				AddrCheck = pServer->m_NetServer.ClientAddr(i);
 				AddrCheck.port = 0;
-				if(net_addr_comp(&Addr, &AddrCheck) == 0 && pServer->m_aClients[i].m_Authed > pServer->m_RconAuthLevel)
+				if(net_addr_comp(&Addr, &AddrCheck) == 0 && pServer->m_pClients[i].m_Authed > pServer->m_RconAuthLevel)
 				{
 					pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "ban command denied");
 					return;
@@ -1444,7 +1891,7 @@ void CServer::ConBan(IConsole::IResult *pResult, void *pUser)
 	{
 		int ClientID = str_toint(pStr);
 
-		if(ClientID < 0 || ClientID >= MAX_CLIENTS || pServer->m_aClients[ClientID].m_State == CClient::STATE_EMPTY)
+		if(ClientID < 0 || ClientID >= pServer->MaxClients() || pServer->m_pClients[ClientID].m_State == CClient::STATE_EMPTY)
 		{
 			pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "invalid client id");
 			return;
@@ -1454,7 +1901,7 @@ void CServer::ConBan(IConsole::IResult *pResult, void *pUser)
 			pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "you can't ban yourself");
 			return;
 		}
-		else if(pServer->m_aClients[ClientID].m_Authed > pServer->m_RconAuthLevel)
+		else if(pServer->m_pClients[ClientID].m_Authed > pServer->m_RconAuthLevel)
 		{
 			pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "ban command denied");
 			return;
@@ -1543,15 +1990,15 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	CServer* pServer = (CServer *)pUser;
 
-	for(i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(i = 0; i < pServer->MaxClients(); i++)
 	{
-		if(pServer->m_aClients[i].m_State != CClient::STATE_EMPTY)
+		if(pServer->m_pClients[i].m_State != CClient::STATE_EMPTY)
 		{
 			Addr = pServer->m_NetServer.ClientAddr(i);
 			net_addr_str(&Addr, aAddrStr, sizeof(aAddrStr));
-			if(pServer->m_aClients[i].m_State == CClient::STATE_INGAME)
+			if(pServer->m_pClients[i].m_State == CClient::STATE_INGAME)
 				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s name='%s' score=%d", i, aAddrStr,
-					pServer->m_aClients[i].m_aName, pServer->m_aClients[i].m_Score);
+					pServer->m_pClients[i].m_aName, pServer->m_pClients[i].m_Score);
 			else
 				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s connecting", i, aAddrStr);
 			pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
@@ -1559,6 +2006,229 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConSnapshotMemory(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[256];
+	CServer* pServer = (CServer *)pUser;
+	int TotalUsed = 0;
+	int TotalReserved = 0;
+
+	for(int i = 0; i < pServer->MaxClients(); i++)
+	{
+		if(pServer->m_pClients[i].m_State == CClient::STATE_EMPTY)
+			continue;
+
+		const CSnapshotStorage *pStorage = &pServer->m_pClients[i].m_Snapshots;
+		str_format(aBuf, sizeof(aBuf), "id=%d snapshots=%d used=%dk reserved=%dk overflows=%d", i, pStorage->NumSnapshots(),
+			pStorage->UsedMemory()/1024, pStorage->ReservedMemory()/1024, pStorage->NumOverflows());
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+		TotalUsed += pStorage->UsedMemory();
+		TotalReserved += pStorage->ReservedMemory();
+	}
+
+	str_format(aBuf, sizeof(aBuf), "total used=%dk reserved=%dk", TotalUsed/1024, TotalReserved/1024);
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+}
+
+void CServer::ConSnapshotCache(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[256];
+	CServer* pServer = (CServer *)pUser;
+	int64 Total = pServer->m_SnapshotCacheHits+pServer->m_SnapshotCacheMisses;
+	str_format(aBuf, sizeof(aBuf), "hits=%d misses=%d hitrate=%.1f%% reused=%dk", (int)pServer->m_SnapshotCacheHits, (int)pServer->m_SnapshotCacheMisses,
+		Total ? pServer->m_SnapshotCacheHits*100.0f/Total : 0.0f, (int)(pServer->m_SnapshotCacheBytes/1024));
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+}
+
+void CServer::ConInputStats(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[256];
+	CServer* pServer = (CServer *)pUser;
+
+	for(int i = 0; i < pServer->MaxClients(); i++)
+	{
+		const CClient *pClient = &pServer->m_pClients[i];
+		if(pClient->m_State == CClient::STATE_EMPTY)
+			continue;
+
+		str_format(aBuf, sizeof(aBuf), "id=%d inputs=%d late=%d (%.1f%%) duplicate=%d dropped=%d", i, pClient->m_NumInputs, pClient->m_NumLateInputs,
+			pClient->m_NumInputs ? pClient->m_NumLateInputs*100.0f/pClient->m_NumInputs : 0.0f, pClient->m_NumDuplicateInputs, pClient->m_NumDroppedInputs);
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	}
+}
+
+void CServer::ConNetStats(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[512];
+	CServer* pServer = (CServer *)pUser;
+
+	// one line of key=value pairs per connection, then the totals
+	CSnapshotStats Total = pServer->m_DroppedSnapStats;
+	int TotalVital = 0;
+	for(int i = 0; i < pServer->m_NetServer.MaxClients(); i++)
+	{
+		const CClient *pClient = &pServer->m_pClients[i];
+		if(pClient->m_State == CClient::STATE_EMPTY)
+			continue;
+
+		NETSTATS Stats;
+		int ResentChunks, VitalChunks;
+		pServer->m_NetServer.ClientStats(i, &Stats, &ResentChunks, &VitalChunks);
+		const CSnapshotStats *pSnap = &pClient->m_SnapStats;
+		Total.Add(pSnap);
+		TotalVital += VitalChunks;
+
+		str_format(aBuf, sizeof(aBuf), "client id=%d state=%d snaprate=%d in_packets=%d in_bytes=%d out_packets=%d out_bytes=%d vital=%d resends=%d "
+			"snaps=%lld empty=%lld multi=%lld snap_bytes=%lld delta_bytes=%lld comp_bytes=%lld to_recover=%d to_full=%d",
+			i, pClient->m_State, pClient->m_SnapRate, Stats.recv_packets, Stats.recv_bytes, Stats.sent_packets, Stats.sent_bytes, VitalChunks, ResentChunks,
+			pSnap->m_NumSnapshots, pSnap->m_NumEmpty, pSnap->m_NumMultiPacket, pSnap->m_SnapBytes, pSnap->m_DeltaBytes, pSnap->m_CompBytes,
+			pSnap->m_NumToRecover, pSnap->m_NumToFull);
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_stats", aBuf);
+	}
+
+	// the socket counters include connless traffic like server info
+	NETSTATS Stats;
+	net_stats(&Stats);
+	int Uptime = (int)((time_get()-pServer->m_NetStatsStart)/time_freq());
+	str_format(aBuf, sizeof(aBuf), "total uptime=%d in_packets=%d in_bytes=%d in_calls=%d out_packets=%d out_bytes=%d out_calls=%d vital=%d "
+		"snaps=%lld empty=%lld multi=%lld snap_bytes=%lld delta_bytes=%lld comp_bytes=%lld to_recover=%d to_full=%d",
+		Uptime, Stats.recv_packets, Stats.recv_bytes, Stats.recv_calls, Stats.sent_packets, Stats.sent_bytes, Stats.send_calls, TotalVital,
+		Total.m_NumSnapshots, Total.m_NumEmpty, Total.m_NumMultiPacket, Total.m_SnapBytes, Total.m_DeltaBytes, Total.m_CompBytes,
+		Total.m_NumToRecover, Total.m_NumToFull);
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_stats", aBuf);
+}
+
+void CServer::ConTickTimes(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[256];
+	CServer* pServer = (CServer *)pUser;
+
+	int Total = 0;
+	for(int i = 0; i < TICKTIME_BUCKETS; i++)
+		Total += pServer->m_aTickTimes[i];
+
+	str_format(aBuf, sizeof(aBuf), "ticks=%d max=%dus network=%s", Total, (int)pServer->m_MaxTickTime,
+		pServer->m_NetServer.Threaded() ? "thread" : "tick");
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	for(int i = 0; i < TICKTIME_BUCKETS; i++)
+	{
+		if(!pServer->m_aTickTimes[i])
+			continue;
+		if(i == TICKTIME_BUCKETS-1)
+			str_format(aBuf, sizeof(aBuf), ">=%6dus %8d (%.1f%%)", 1<<(i-1), pServer->m_aTickTimes[i], pServer->m_aTickTimes[i]*100.0f/Total);
+		else
+			str_format(aBuf, sizeof(aBuf), " <%6dus %8d (%.1f%%)", 1<<i, pServer->m_aTickTimes[i], pServer->m_aTickTimes[i]*100.0f/Total);
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	}
+}
+
+void CServer::LogProfile()
+{
+	CProfiler::CStats aStats[CProfiler::MAX_SECTIONS];
+	for(int i = 0; i < g_Profiler.NumSections(); i++)
+		g_Profiler.GetStats(i, &aStats[i]);
+
+	// the slowest sections by p99 on one line
+	char aBuf[512];
+	aBuf[0] = 0;
+	for(int n = 0; n < 6; n++)
+	{
+		int Slowest = -1;
+		for(int i = 0; i < g_Profiler.NumSections(); i++)
+			if(aStats[i].m_NumSamples && (Slowest == -1 || aStats[i].m_P99 > aStats[Slowest].m_P99))
+				Slowest = i;
+		if(Slowest == -1)
+			break;
+
+		char aSection[96];
+		str_format(aSection, sizeof(aSection), "%s%s=%d/%d/%d", n ? " " : "", g_Profiler.Name(Slowest),
+			aStats[Slowest].m_P50, aStats[Slowest].m_P99, aStats[Slowest].m_Max);
+		str_append(aBuf, aSection, sizeof(aBuf));
+		aStats[Slowest].m_NumSamples = 0;
+	}
+	if(aBuf[0])
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+}
+
+void CServer::PrintProfile()
+{
+	// time per tick in microseconds over the last ticks the section ran in
+	char aBuf[256];
+	for(int i = 0; i < g_Profiler.NumSections(); i++)
+	{
+		CProfiler::CStats Stats;
+		g_Profiler.GetStats(i, &Stats);
+		if(!Stats.m_NumSamples)
+			continue;
+		str_format(aBuf, sizeof(aBuf), "%s p50=%d p99=%d max=%d avg=%d calls=%.1f samples=%d", g_Profiler.Name(i),
+			Stats.m_P50, Stats.m_P99, Stats.m_Max, Stats.m_Avg, Stats.m_CallsPerSample, Stats.m_NumSamples);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+	}
+}
+
+void CServer::ConProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer* pServer = (CServer *)pUser;
+	if(!g_Profiler.Enabled())
+	{
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "profiling is off, enable it with sv_profile 1");
+		return;
+	}
+
+	pServer->PrintProfile();
+
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		g_Profiler.Reset();
+}
+
+void CServer::ConTickJitter(IConsole::IResult *pResult, void *pUser)
+{
+	char aBuf[256];
+	CServer* pServer = (CServer *)pUser;
+
+	int Total = 0;
+	for(int i = 0; i < TICKTIME_BUCKETS; i++)
+		Total += pServer->m_aTickLateness[i];
+
+	// percentiles as the upper bound of their bucket
+	int aPercentiles[2] = {50, 99};
+	int aBounds[2] = {0, 0};
+	for(int p = 0; p < 2; p++)
+	{
+		int Count = 0;
+		for(int i = 0; i < TICKTIME_BUCKETS; i++)
+		{
+			Count += pServer->m_aTickLateness[i];
+			if(Count*100 >= Total*aPercentiles[p])
+			{
+				aBounds[p] = 1<<i;
+				break;
+			}
+		}
+	}
+
+	int64 Elapsed = max(time_get()-pServer->m_SchedulerStatsStart, (int64)1);
+	float Seconds = Elapsed/(float)time_freq();
+	str_format(aBuf, sizeof(aBuf), "ticks=%d late_mean=%dus late_p50<%dus late_p99<%dus late_max=%dus wakeups=%.1f/s busy=%.2f%%",
+		Total, Total ? (int)(pServer->m_TickLatenessSum/Total) : 0, aBounds[0], aBounds[1], (int)pServer->m_MaxTickLateness,
+		pServer->m_NumWakeups/Seconds, 100.0f-pServer->m_SleepTime*100.0f/Elapsed);
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+
+	for(int i = 0; i < TICKTIME_BUCKETS; i++)
+	{
+		if(!pServer->m_aTickLateness[i])
+			continue;
+		if(i == TICKTIME_BUCKETS-1)
+			str_format(aBuf, sizeof(aBuf), ">=%6dus %8d (%.1f%%)", 1<<(i-1), pServer->m_aTickLateness[i], pServer->m_aTickLateness[i]*100.0f/Total);
+		else
+			str_format(aBuf, sizeof(aBuf), " <%6dus %8d (%.1f%%)", 1<<i, pServer->m_aTickLateness[i], pServer->m_aTickLateness[i]*100.0f/Total);
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	}
+
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		pServer->ResetSchedulerStats();
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = 0;
@@ -1604,6 +2274,40 @@ void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_DemoRecorder.Stop();
 }
 
+void CServer::ConInputLogRecord(IConsole::IResult *pResult, void *pUser)
+{
+	CServer* pServer = (CServer *)pUser;
+	if(pResult->NumArguments())
+		str_format(pServer->m_aInputLogFile, sizeof(pServer->m_aInputLogFile), "inputlogs/%s.inputlog", pResult->GetString(0));
+	else
+	{
+		char aDate[20];
+		str_timestamp(aDate, sizeof(aDate));
+		str_format(pServer->m_aInputLogFile, sizeof(pServer->m_aInputLogFile), "inputlogs/inputlog_%s.inputlog", aDate);
+	}
+	pServer->Storage()->CreateFolder("inputlogs", IStorageTW::TYPE_SAVE);
+
+	// a log has to start from a fresh map
+	pServer->m_MapReload = 1;
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", "reloading the map to start recording");
+}
+
+void CServer::ConInputLogStop(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->m_InputLog.Stop();
+}
+
+void CServer::ConInputLogBench(IConsole::IResult *pResult, void *pUser)
+{
+	CServer* pServer = (CServer *)pUser;
+	if(pServer->m_pGameServer)
+	{
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "input_log", "replays only start from the command line");
+		return;
+	}
+	str_format(pServer->m_aInputLogReplay, sizeof(pServer->m_aInputLogReplay), "inputlogs/%s.inputlog", pResult->GetString(0));
+}
+
 void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_MapReload = 1;
@@ -1635,10 +2339,10 @@ void CServer::ConchainModCommandUpdate(IConsole::IResult *pResult, void *pUserDa
 		pfnCallback(pResult, pCallbackUserData);
 		if(pInfo && OldAccessLevel != pInfo->GetAccessLevel())
 		{
-			for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+			for(int i = 0; i < pThis->MaxClients(); ++i)
 			{
-				if(pThis->m_aClients[i].m_State == CServer::CClient::STATE_EMPTY || pThis->m_aClients[i].m_Authed != CServer::AUTHED_MOD ||
-					(pThis->m_aClients[i].m_pRconCmdToSend && str_comp(pResult->GetString(0), pThis->m_aClients[i].m_pRconCmdToSend->m_pName) >= 0))
+				if(pThis->m_pClients[i].m_State == CServer::CClient::STATE_EMPTY || pThis->m_pClients[i].m_Authed != CServer::AUTHED_MOD ||
+					(pThis->m_pClients[i].m_pRconCmdToSend && str_comp(pResult->GetString(0), pThis->m_pClients[i].m_pRconCmdToSend->m_pName) >= 0))
 					continue;
 
 				if(OldAccessLevel == IConsole::ACCESS_LEVEL_ADMIN)
@@ -1671,10 +2375,20 @@ void CServer::RegisterCommands()
 	Console()->Register("unban", "s", CFGFLAG_SERVER|CFGFLAG_STORE, ConUnban, this, "Unban ip");
 	Console()->Register("bans", "", CFGFLAG_SERVER|CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("status", "", CFGFLAG_SERVER, ConStatus, this, "List players");
+	Console()->Register("snapshot_memory", "", CFGFLAG_SERVER, ConSnapshotMemory, this, "Show the snapshot history memory of each player");
+	Console()->Register("snapshot_cache", "", CFGFLAG_SERVER, ConSnapshotCache, this, "Show how often snapshot deltas were shared between players");
+	Console()->Register("input_stats", "", CFGFLAG_SERVER, ConInputStats, this, "Show how many inputs of each player came too late");
+	Console()->Register("tick_times", "", CFGFLAG_SERVER, ConTickTimes, this, "Show how long the ticks took");
+	Console()->Register("tick_jitter", "?i", CFGFLAG_SERVER, ConTickJitter, this, "Show how late the ticks started and how much the server slept, 1 to start counting anew");
+	Console()->Register("net_stats", "", CFGFLAG_SERVER, ConNetStats, this, "Show the traffic and snapshot sizes per client and in total");
+	Console()->Register("profile", "?i", CFGFLAG_SERVER, ConProfile, this, "Show p50/p99/max of the profiler sections in microseconds, 1 to start counting anew");
 	Console()->Register("shutdown", "", CFGFLAG_SERVER, ConShutdown, this, "Shut down");
 
 	Console()->Register("record", "?s", CFGFLAG_SERVER|CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
+	Console()->Register("inputlog_record", "?s", CFGFLAG_SERVER, ConInputLogRecord, this, "Reload the map and record what the clients do to a file");
+	Console()->Register("inputlog_stop", "", CFGFLAG_SERVER, ConInputLogStop, this, "Stop recording the inputs");
+	Console()->Register("inputlog_bench", "s", CFGFLAG_SERVER, ConInputLogBench, this, "Replay an input log as fast as possible instead of running the server, command line only");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
 
@@ -1705,6 +2419,11 @@ void *CServer::SnapNewItem(int Type, int ID, int Size)
 	return ID < 0 ? 0 : m_SnapshotBuilder.NewItem(Type, ID, Size);
 }
 
+void CServer::SnapSetLocal(int *pValue)
+{
+	m_SnapshotBuilder.SetLocal(pValue);
+}
+
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
@@ -58,6 +58,23 @@ public:
 		MAX_RCONCMD_SEND=16,
 	};
 
+	// what the snapshots cost on the wire, per client and for the server
+	class CSnapshotStats
+	{
+	public:
+		int64 m_NumSnapshots;
+		int64 m_NumEmpty; // nothing changed against the acked snapshot
+		int64 m_NumMultiPacket; // had to be split over several packets
+		int64 m_SnapBytes; // the full snapshots
+		int64 m_DeltaBytes; // the deltas against the acked ones
+		int64 m_CompBytes; // the deltas after compression
+		int m_NumToRecover; // lost track of the acked snapshots
+		int m_NumToFull; // acked a snapshot again
+
+		void Reset() { mem_zero(this, sizeof(*this)); }
+		void Add(const CSnapshotStats *pOther);
+	};
+
 	class CClient
 	{
 	public:
@@ -72,7 +89,11 @@ public:
 
 			SNAPRATE_INIT=0,
 			SNAPRATE_FULL,
-			SNAPRATE_RECOVER
+			SNAPRATE_RECOVER,
+
+			// power of two, inputs are stored at their tick modulo this
+			INPUT_RING_SIZE=128,
+			INPUT_RING_MASK=INPUT_RING_SIZE-1
 		};
 
 		class CInput
@@ -80,6 +101,7 @@ public:
 		public:
 			int m_aData[MAX_INPUT_SIZE];
 			int m_GameTick; // the tick that was chosen for the input
+			bool m_Late; // was meant for a tick that already passed
 		};
 
 		// connection state info
@@ -92,8 +114,15 @@ public:
 		CSnapshotStorage m_Snapshots;
 
 		CInput m_LatestInput;
-		CInput m_aInputs[200]; // TODO: handle input better
-		int m_CurrentInput;
+		CInput m_aInputs[INPUT_RING_SIZE];
+
+		// input stats
+		int m_NumInputs;
+		int m_NumLateInputs; // arrived after their tick, moved to the next one
+		int m_NumDuplicateInputs; // replaced an input for the same tick
+		int m_NumDroppedInputs; // too far ahead or late for a tick that already had one
+
+		CSnapshotStats m_SnapStats;
 
 		char m_aName[MAX_NAME_LENGTH];
 		char m_aClan[MAX_CLAN_LENGTH];
@@ -107,7 +136,86 @@ public:
 		void Reset();
 	};
 
-	CClient m_aClients[MAX_CLIENTS];
+	CClient *m_pClients; // the network slots, then the bots
+
+	// per connection scratch space for the snapshot stage. the crc, delta
+	// and compression of a snapshot only touch its slot, so they can be
+	// handed to the snapshot workers while the next client gets snapped
+	class CSnapshotSlot
+	{
+	public:
+		CJob m_Job;
+		class CServer *m_pServer;
+
+		CSnapshot *m_pDeltashot;
+		int m_DeltaTick;
+		unsigned m_Hash;
+		unsigned m_DeltaHash;
+		int m_Size;
+		int m_DeltashotSize;
+		int m_LocalOffset; // of the int only this client has, see CSnapshotBuilder::SetLocal
+		int m_DeltaLocalOffset;
+		CSnapshotSlot *m_pSource; // the slot that has the compressed data, itself unless it was cached
+		int m_Crc;
+		int m_DeltaSize;
+		int m_CompSize;
+
+		char m_aData[CSnapshot::MAX_SIZE];
+		char m_aDeltaData[CSnapshot::MAX_SIZE];
+		char m_aCompData[CSnapshot::MAX_SIZE];
+	};
+
+	CSnapshotSlot *m_pSnapshotSlots; // one per network slot
+	CJobPool m_SnapshotJobPool;
+
+	// snapshots deltaed this tick. clients with the same snapshot and the same
+	// base get the same compressed delta, so it is only created once. the own
+	// player info differs in the local flag, so that int is left out of the
+	// comparison. it is the same in the snapshot and the base, so the delta
+	// does not depend on it
+	CSnapshotSlot *m_apSnapshotCache[NET_MAX_CLIENTS];
+	int m_NumSnapshotCache;
+	int64 m_SnapshotCacheHits;
+	int64 m_SnapshotCacheMisses;
+	int64 m_SnapshotCacheBytes;
+
+	// how long the ticks took, bucket i counts the ticks below 2^i microseconds
+	enum
+	{
+		TICKTIME_BUCKETS=16,
+	};
+	int m_aTickTimes[TICKTIME_BUCKETS];
+	int64 m_MaxTickTime;
+
+	// tick scheduling. how late the ticks started, same buckets as above,
+	// and how much the main loop slept in between
+	NETWAIT m_NetWait;
+	int m_aTickLateness[TICKTIME_BUCKETS];
+	int64 m_TickLatenessSum;
+	int64 m_MaxTickLateness;
+	int64 m_SchedulerStatsStart;
+	int64 m_SleepTime;
+	int m_NumWakeups;
+
+	// profiler sections of the server stages
+	int m_ProfileTick;
+	int m_ProfileSnapDemo;
+	int m_ProfileSnapGame;
+	int m_ProfileSnapBuild;
+	int m_ProfileSnapEncode;
+	int m_ProfileSnapSend;
+	int m_ProfileNetwork;
+
+	// snapshot stats of the clients that left, and when counting started
+	CSnapshotStats m_DroppedSnapStats;
+	int64 m_NetStatsStart;
+
+	// input log of the current map, the one to start with the next map
+	// and the one to replay instead of running the server
+	CInputLogRecorder m_InputLog;
+	char m_aInputLogFile[128];
+	char m_aInputLogReplay[128];
+	bool m_ReplayingInputLog;
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
@@ -138,6 +246,7 @@ public:
 	CMapChecker m_MapChecker;
 
 	CServer();
+	~CServer();
 
 	int TrySetClientName(int ClientID, const char *pName);
 
@@ -153,6 +262,9 @@ public:
 	//int Tick()
 	int64 TickStartTime(int Tick);
 	//int TickSpeed()
+	void ResetSchedulerStats();
+	void LogProfile();
+	void PrintProfile();
 
 	int Init();
 
@@ -167,7 +279,11 @@ public:
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID);
 	virtual int SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System);
 
+	static int SnapshotJob(void *pUser);
+	CSnapshotSlot *FindCachedSnapshot(CSnapshotSlot *pSlot);
+	void SendSnapshot(int ClientID, CSnapshotSlot *pSlot);
 	void DoSnapshot();
+	void DoTick();
 
 	static int NewClientCallback(int ClientID, void *pUser);
 	static int DelClientCallback(int ClientID, const char *pReason, void *pUser);
@@ -198,14 +314,28 @@ public:
 	void InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, IConsole *pConsole);
 	int Run();
 
+	void StartInputLog();
+	void ReplaySnapshot();
+	int ReplayInputLog();
+
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
 	static void ConBan(IConsole::IResult *pResult, void *pUser);
 	static void ConUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConBans(IConsole::IResult *pResult, void *pUser);
  	static void ConStatus(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapshotMemory(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapshotCache(IConsole::IResult *pResult, void *pUser);
+	static void ConInputStats(IConsole::IResult *pResult, void *pUser);
+	static void ConTickTimes(IConsole::IResult *pResult, void *pUser);
+	static void ConTickJitter(IConsole::IResult *pResult, void *pUser);
+	static void ConProfile(IConsole::IResult *pResult, void *pUser);
+	static void ConNetStats(IConsole::IResult *pResult, void *pUser);
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConInputLogRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConInputLogStop(IConsole::IResult *pResult, void *pUser);
+	static void ConInputLogBench(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -218,9 +348,9 @@ public:
 	virtual int SnapNewID();
 	virtual void SnapFreeID(int ID);
 	virtual void *SnapNewItem(int Type, int ID, int Size);
+	virtual void SnapSetLocal(int *pValue);
 	void SnapSetStaticsize(int ItemType, int Size);
 
-	void InitBot(int ClientID, int BType); //H-Client
 	void ReloadMap() { m_MapReload = 1; }
 };
 
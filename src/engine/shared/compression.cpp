@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 
 #include "compression.h"
@@ -7,83 +8,153 @@
 // Format: ESDDDDDD EDDDDDDD EDD... Extended, Data, Sign
 unsigned char *CVariableInt::Pack(unsigned char *pDst, int i)
 {
-	*pDst = (i>>25)&0x40; // set sign bit if i<0
-	i = i^(i>>31); // if(i<0) i = ~i
+	unsigned Sign = (i>>25)&0x40; // set sign bit if i<0
+	unsigned Value = i^(i>>31); // if(i<0) i = ~i
 
-	*pDst |= i&0x3F; // pack 6bit into dst
-	i >>= 6; // discard 6 bits
-	if(i)
-	{
-		*pDst |= 0x80; // set extend bit
-		while(1)
-		{
-			pDst++;
-			*pDst = i&(0x7F); // pack 7bit
-			i >>= 7; // discard 7 bits
-			*pDst |= (i!=0)<<7; // set extend bit (may branch)
-			if(!i)
-				break;
-		}
-	}
+	// extend bits for every 7 bits that are still left
+	unsigned Ext1 = (Value > 0x3F)<<7;
+	unsigned Ext2 = (Value > 0x1FFF)<<7;
+	unsigned Ext3 = (Value > 0xFFFFF)<<7;
+	unsigned Ext4 = (Value > 0x7FFFFFF)<<7;
 
-	pDst++;
-	return pDst;
+	pDst[0] = Sign | (Value&0x3F) | Ext1;
+	if(!Ext1)
+		return pDst+1;
+
+	// always write all bytes, only the used ones count
+	pDst[1] = ((Value>>6)&0x7F) | Ext2;
+	pDst[2] = ((Value>>13)&0x7F) | Ext3;
+	pDst[3] = ((Value>>20)&0x7F) | Ext4;
+	pDst[4] = (Value>>27)&0x7F;
+	return pDst + 2 + (Ext2>>7) + (Ext3>>7) + (Ext4>>7);
 }
 
-const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut)
+// reads an int that is known to have all its bytes in the buffer
+static inline const unsigned char *UnpackUnchecked(const unsigned char *pSrc, int *pOut)
 {
-	int Sign = (*pSrc>>6)&1;
-	*pInOut = *pSrc&0x3F;
+	unsigned Sign = -(unsigned)((*pSrc>>6)&1);
+	unsigned Value = *pSrc&0x3F;
 
-	do
+	if(*pSrc&0x80)
 	{
-		if(!(*pSrc&0x80)) break;
 		pSrc++;
-		*pInOut |= (*pSrc&(0x7F))<<(6);
+		Value |= (*pSrc&0x7Fu)<<6;
+		if(*pSrc&0x80)
+		{
+			pSrc++;
+			Value |= (*pSrc&0x7Fu)<<(6+7);
+			if(*pSrc&0x80)
+			{
+				pSrc++;
+				Value |= (*pSrc&0x7Fu)<<(6+7+7);
+				if(*pSrc&0x80)
+				{
+					pSrc++;
+					Value |= (*pSrc&0x7Fu)<<(6+7+7+7);
+				}
+			}
+		}
+	}
 
-		if(!(*pSrc&0x80)) break;
-		pSrc++;
-		*pInOut |= (*pSrc&(0x7F))<<(6+7);
+	*pOut = (int)(Value^Sign); // if(sign) *i = ~(*i)
+	return pSrc+1;
+}
 
-		if(!(*pSrc&0x80)) break;
-		pSrc++;
-		*pInOut |= (*pSrc&(0x7F))<<(6+7+7);
+const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut, int SrcSize)
+{
+	if(SrcSize <= 0)
+		return 0;
+	if(SrcSize >= MAX_BYTES_PACKED)
+		return UnpackUnchecked(pSrc, pInOut);
 
-		if(!(*pSrc&0x80)) break;
+	// near the end, every byte has to be checked
+	unsigned Sign = -(unsigned)((*pSrc>>6)&1);
+	unsigned Value = *pSrc&0x3F;
+	const unsigned char *pEnd = pSrc+SrcSize;
+	for(int Shift = 6; Shift < 6+7*4 && (*pSrc&0x80); Shift += 7)
+	{
 		pSrc++;
-		*pInOut |= (*pSrc&(0x7F))<<(6+7+7+7);
-	} while(0);
+		if(pSrc >= pEnd)
+			return 0;
+		Value |= (*pSrc&0x7Fu)<<Shift;
+	}
 
-	pSrc++;
-	*pInOut ^= -Sign; // if(sign) *i = ~(*i)
-	return pSrc;
+	*pInOut = (int)(Value^Sign);
+	return pSrc+1;
 }
 
 
-long CVariableInt::Decompress(const void *pSrc_, int Size, void *pDst_)
+long CVariableInt::Decompress(const void *pSrc_, int Size, void *pDst_, int DstSize)
 {
 	const unsigned char *pSrc = (unsigned char *)pSrc_;
 	const unsigned char *pEnd = pSrc + Size;
 	int *pDst = (int *)pDst_;
+	int *pDstEnd = pDst + DstSize/4;
+
+	// every int takes at least one byte, so as long as we are this far from both
+	// ends no int can be cut off and none can be written past the output
+	int Unchecked = min(Size-(MAX_BYTES_PACKED-1), DstSize/4);
+	const unsigned char *pUnchecked = pSrc + max(Unchecked, 0);
+	while(pSrc < pUnchecked)
+		pSrc = UnpackUnchecked(pSrc, pDst++);
+
 	while(pSrc < pEnd)
 	{
-		pSrc = CVariableInt::Unpack(pSrc, pDst);
+		if(pDst >= pDstEnd)
+			return -1;
+		pSrc = CVariableInt::Unpack(pSrc, pDst, (int)(pEnd-pSrc));
+		if(!pSrc)
+			return -1;
 		pDst++;
 	}
 	return (long)((unsigned char *)pDst-(unsigned char *)pDst_);
 }
 
-long CVariableInt::Compress(const void *pSrc_, int Size, void *pDst_)
+long CVariableInt::Compress(const void *pSrc_, int Size, void *pDst_, int DstSize)
 {
-	int *pSrc = (int *)pSrc_;
+	const int *pSrc = (const int *)pSrc_;
 	unsigned char *pDst = (unsigned char *)pDst_;
+	unsigned char *pDstEnd = pDst + DstSize;
 	Size /= 4;
-	while(Size)
+
+	// room for four whole ints, no need to check each byte
+	while(Size && pDstEnd - pDst >= 4*MAX_BYTES_PACKED)
 	{
+		if(Size >= 4)
+		{
+			// four small ints in a row, one byte each. common for the unchanged parts of a delta
+			unsigned a0 = pSrc[0]^(pSrc[0]>>31);
+			unsigned a1 = pSrc[1]^(pSrc[1]>>31);
+			unsigned a2 = pSrc[2]^(pSrc[2]>>31);
+			unsigned a3 = pSrc[3]^(pSrc[3]>>31);
+			if((a0|a1|a2|a3) <= 0x3F)
+			{
+				pDst[0] = ((pSrc[0]>>25)&0x40) | a0;
+				pDst[1] = ((pSrc[1]>>25)&0x40) | a1;
+				pDst[2] = ((pSrc[2]>>25)&0x40) | a2;
+				pDst[3] = ((pSrc[3]>>25)&0x40) | a3;
+				pDst += 4;
+				pSrc += 4;
+				Size -= 4;
+				continue;
+			}
+		}
+
 		pDst = CVariableInt::Pack(pDst, *pSrc);
 		Size--;
 		pSrc++;
 	}
+
+	while(Size)
+	{
+		unsigned char aBuf[MAX_BYTES_PACKED];
+		int Packed = (int)(CVariableInt::Pack(aBuf, *pSrc)-aBuf);
+		if(pDstEnd - pDst < Packed)
+			return -1;
+		mem_copy(pDst, aBuf, Packed);
+		pDst += Packed;
+		Size--;
+		pSrc++;
+	}
 	return (long)(pDst-(unsigned char *)pDst_);
 }
-
@@ -6,9 +6,14 @@
 class CVariableInt
 {
 public:
-	static unsigned char *Pack(unsigned char *pDst, int i);
-	static const unsigned char *Unpack(const unsigned char *pSrc, int *pInOut);
-	static long Compress(const void *pSrc, int Size, void *pDst);
-	static long Decompress(const void *pSrc, int Size, void *pDst);
+	enum
+	{
+		MAX_BYTES_PACKED=5, // the most bytes one int can take
+	};
+
+	static unsigned char *Pack(unsigned char *pDst, int i); // needs room for MAX_BYTES_PACKED
+	static const unsigned char *Unpack(const unsigned char *pSrc, int *pInOut, int SrcSize); // 0 if the int is cut off
+	static long Compress(const void *pSrc, int Size, void *pDst, int DstSize); // -1 if it does not fit
+	static long Decompress(const void *pSrc, int Size, void *pDst, int DstSize); // -1 on broken input or if it does not fit
 };
 #endif
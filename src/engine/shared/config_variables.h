@@ -94,6 +94,11 @@ MACRO_CONFIG_STR(SvMap, sv_map, 128, "dm1", CFGFLAG_SERVER, "Map to use on the s
 MACRO_CONFIG_INT(SvMaxClients, sv_max_clients, 8, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients that are allowed on a server")
 MACRO_CONFIG_INT(SvMaxClientsPerIP, sv_max_clients_per_ip, 4, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients with the same IP that can connect to the server")
 MACRO_CONFIG_INT(SvHighBandwidth, sv_high_bandwidth, 0, 0, 1, CFGFLAG_SERVER, "Use high bandwidth mode. Doubles the bandwidth required for the server. LAN use only")
+MACRO_CONFIG_INT(SvSnapThreads, sv_snap_threads, 0, 0, 16, CFGFLAG_SERVER, "Number of worker threads used to delta and compress client snapshots (0 = tick thread only)")
+MACRO_CONFIG_INT(SvSnapCache, sv_snap_cache, 1, 0, 1, CFGFLAG_SERVER, "Reuse the compressed delta of clients with the same snapshot and delta base, like the spectators of the same player")
+MACRO_CONFIG_INT(SvNetThread, sv_net_thread, 0, 0, 1, CFGFLAG_SERVER, "Receive, decode and send packets on a separate thread (needs a restart)")
+MACRO_CONFIG_INT(SvProfile, sv_profile, 0, 0, 1, CFGFLAG_SERVER, "Time the game and snapshot stages, see the profile command")
+MACRO_CONFIG_INT(SvProfileLog, sv_profile_log, 0, 0, 3600, CFGFLAG_SERVER, "Log the slowest profiler sections every this many seconds (0 = never)")
 MACRO_CONFIG_INT(SvRegister, sv_register, 1, 0, 1, CFGFLAG_SERVER, "Register server with master server for public listing")
 MACRO_CONFIG_STR(SvRconPassword, sv_rcon_password, 32, "", CFGFLAG_SERVER, "Remote console password (full access)")
 MACRO_CONFIG_STR(SvRconModPassword, sv_rcon_mod_password, 32, "", CFGFLAG_SERVER, "Remote console password for moderators (limited access)")
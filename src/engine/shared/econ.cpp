@@ -90,6 +90,13 @@ void CEcon::Init(IConsole *pConsole)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD,"econ", "couldn't open socket. port might already be in use");
 }
 
+int CEcon::Sockets(NETSOCKET *pSockets, int MaxSockets) const
+{
+	if(!m_Ready)
+		return 0;
+	return m_NetConsole.Sockets(pSockets, MaxSockets);
+}
+
 void CEcon::Update()
 {
 	if(!m_Ready)
@@ -150,7 +157,7 @@ void CEcon::Update()
 
 void CEcon::Send(int ClientID, const char *pLine)
 {
-	if(!m_Ready || ClientID >= MAX_CLIENTS-MAX_BOTS)
+	if(!m_Ready || ClientID >= NET_MAX_CONSOLE_CLIENTS)
 		return;
 
 	if(ClientID == -1)
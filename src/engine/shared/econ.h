@@ -44,6 +44,7 @@ public:
 	void Init(IConsole *pConsole);
 	void Update();
 	void Send(int ClientID, const char *pLine);
+	int Sockets(NETSOCKET *pSockets, int MaxSockets) const;
 	void Shutdown();
 };
 
@@ -96,106 +96,98 @@ void CHuffman::ConstructTree(const unsigned *pFrequencies)
 
 void CHuffman::Init(const unsigned *pFrequencies)
 {
-	int i;
-
 	// make sure to cleanout every thing
 	mem_zero(this, sizeof(*this));
 
 	// construct the tree
 	ConstructTree(pFrequencies);
 
-	// build decode LUT
-	for(i = 0; i < HUFFMAN_LUTSIZE; i++)
+	// build decode LUT, walk the bits of every entry and note all symbols that end in them
+	CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
+	for(int i = 0; i < HUFFMAN_LUTSIZE; i++)
 	{
+		CDecodeEntry *pEntry = &m_aDecodeLut[i];
 		unsigned Bits = i;
-		int k;
 		CNode *pNode = m_pStartNode;
-		for(k = 0; k < HUFFMAN_LUTBITS; k++)
+		for(int k = 0; k < HUFFMAN_LUTBITS; k++)
 		{
 			pNode = &m_aNodes[pNode->m_aLeafs[Bits&1]];
 			Bits >>= 1;
 
-			if(!pNode)
-				break;
+			if(!pNode->m_NumBits)
+				continue;
 
-			if(pNode->m_NumBits)
+			pEntry->m_NumBits = k+1;
+			if(pNode == pEof)
 			{
-				m_apDecodeLut[i] = pNode;
+				pEntry->m_Eof = 1;
 				break;
 			}
+
+			pEntry->m_aSymbols[pEntry->m_NumSymbols++] = pNode->m_Symbol;
+			if(pEntry->m_NumSymbols == HUFFMAN_LUTSYMBOLS)
+				break;
+			pNode = m_pStartNode;
 		}
 
-		if(k == HUFFMAN_LUTBITS)
-			m_apDecodeLut[i] = pNode;
+		// the symbol is longer than the lut, the rest has to be walked
+		if(!pEntry->m_NumBits)
+			pEntry->m_Node = (unsigned short)(pNode-m_aNodes);
 	}
-
 }
 
 //***************************************************************
 int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize)
 {
-	// this macro loads a symbol for a byte into bits and bitcount
-#define HUFFMAN_MACRO_LOADSYMBOL(Sym) \
-	Bits |= m_aNodes[Sym].m_Bits << Bitcount; \
-	Bitcount += m_aNodes[Sym].m_NumBits;
-
-	// this macro writes the symbol stored in bits and bitcount to the dst pointer
-#define HUFFMAN_MACRO_WRITE() \
-	while(Bitcount >= 8) \
-	{ \
-		*pDst++ = (unsigned char)(Bits&0xff); \
-		if(pDst == pDstEnd) \
-			return -1; \
-		Bits >>= 8; \
-		Bitcount -= 8; \
-	}
-
 	// setup buffer pointers
 	const unsigned char *pSrc = (const unsigned char *)pInput;
 	const unsigned char *pSrcEnd = pSrc + InputSize;
 	unsigned char *pDst = (unsigned char *)pOutput;
 	unsigned char *pDstEnd = pDst + OutputSize;
 
-	// symbol variables
-	unsigned Bits = 0;
+	// symbols are collected and written out 32 bits at once
+	unsigned long long Bits = 0;
 	unsigned Bitcount = 0;
 
-	// make sure that we have data that we want to compress
-	if(InputSize)
+	while(pSrc != pSrcEnd)
 	{
-		// {A} load the first symbol
-		int Symbol = *pSrc++;
+		const CNode *pNode = &m_aNodes[*pSrc++];
+		Bits |= (unsigned long long)pNode->m_Bits << Bitcount;
+		Bitcount += pNode->m_NumBits;
 
-		while(pSrc != pSrcEnd)
+		if(Bitcount >= 32)
 		{
-			// {B} load the symbol
-			HUFFMAN_MACRO_LOADSYMBOL(Symbol)
-
-			// {C} fetch next symbol, this is done here because it will reduce dependency in the code
-			Symbol = *pSrc++;
-
-			// {B} write the symbol loaded at
-			HUFFMAN_MACRO_WRITE()
+			// the last byte of the buffer is always kept for the remaining bits
+			if(pDstEnd - pDst <= 4)
+				return -1;
+			pDst[0] = (unsigned char)Bits;
+			pDst[1] = (unsigned char)(Bits>>8);
+			pDst[2] = (unsigned char)(Bits>>16);
+			pDst[3] = (unsigned char)(Bits>>24);
+			pDst += 4;
+			Bits >>= 32;
+			Bitcount -= 32;
 		}
-
-		// write the last symbol loaded from {C} or {A} in the case of only 1 byte input buffer
-		HUFFMAN_MACRO_LOADSYMBOL(Symbol)
-		HUFFMAN_MACRO_WRITE()
 	}
 
-	// write EOF symbol
-	HUFFMAN_MACRO_LOADSYMBOL(HUFFMAN_EOF_SYMBOL)
-	HUFFMAN_MACRO_WRITE()
+	// add EOF symbol
+	Bits |= (unsigned long long)m_aNodes[HUFFMAN_EOF_SYMBOL].m_Bits << Bitcount;
+	Bitcount += m_aNodes[HUFFMAN_EOF_SYMBOL].m_NumBits;
+
+	while(Bitcount >= 8)
+	{
+		*pDst++ = (unsigned char)(Bits&0xff);
+		if(pDst == pDstEnd)
+			return -1;
+		Bits >>= 8;
+		Bitcount -= 8;
+	}
 
 	// write out the last bits
-	*pDst++ = Bits;
+	*pDst++ = (unsigned char)Bits;
 
 	// return the size of the output
 	return (int)(pDst - (const unsigned char *)pOutput);
-
-	// remove macros
-#undef HUFFMAN_MACRO_LOADSYMBOL
-#undef HUFFMAN_MACRO_WRITE
 }
 
 //***************************************************************
@@ -207,64 +199,79 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 	unsigned char *pDstEnd = pDst + OutputSize;
 	unsigned char *pSrcEnd = pSrc + InputSize;
 
-	unsigned Bits = 0;
+	unsigned long long Bits = 0;
 	unsigned Bitcount = 0;
 
 	CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
-	CNode *pNode = 0;
 
 	while(1)
 	{
-		// {A} try to load a node now, this will reduce dependency at location {D}
-		pNode = 0;
-		if(Bitcount >= HUFFMAN_LUTBITS)
-			pNode = m_apDecodeLut[Bits&HUFFMAN_LUTMASK];
-
-		// {B} fill with new bits
-		while(Bitcount < 24 && pSrc != pSrcEnd)
+		// fill with new bits
+		while(Bitcount <= 56 && pSrc != pSrcEnd)
 		{
-			Bits |= (*pSrc++) << Bitcount;
+			Bits |= (unsigned long long)(*pSrc++) << Bitcount;
 			Bitcount += 8;
 		}
 
-		// {C} load symbol now if we didn't that earlier at location {A}
-		if(!pNode)
-			pNode = m_apDecodeLut[Bits&HUFFMAN_LUTMASK];
+		const CDecodeEntry *pEntry = &m_aDecodeLut[Bits&HUFFMAN_LUTMASK];
+		if(pEntry->m_NumBits)
+		{
+			// the symbols have to be made of real bits, not of the zeros after the input
+			if(pEntry->m_NumBits > Bitcount)
+				return -1;
+
+			// output characters
+			if(pDstEnd - pDst >= HUFFMAN_LUTSYMBOLS)
+			{
+				pDst[0] = pEntry->m_aSymbols[0];
+				pDst[1] = pEntry->m_aSymbols[1];
+				pDst[2] = pEntry->m_aSymbols[2];
+			}
+			else
+			{
+				for(int i = 0; i < pEntry->m_NumSymbols; i++)
+				{
+					if(pDst+i == pDstEnd)
+						return -1;
+					pDst[i] = pEntry->m_aSymbols[i];
+				}
+			}
+			pDst += pEntry->m_NumSymbols;
 
-		if(!pNode)
-			return -1;
+			// remove the bits for the symbols
+			Bits >>= pEntry->m_NumBits;
+			Bitcount -= pEntry->m_NumBits;
 
-		// {D} check if we hit a symbol already
-		if(pNode->m_NumBits)
-		{
-			// remove the bits for that symbol
-			Bits >>= pNode->m_NumBits;
-			Bitcount -= pNode->m_NumBits;
+			if(pEntry->m_Eof)
+				break;
+			continue;
 		}
-		else
-		{
-			// remove the bits that the lut checked up for us
-			Bits >>= HUFFMAN_LUTBITS;
-			Bitcount -= HUFFMAN_LUTBITS;
 
-			// walk the tree bit by bit
-			while(1)
-			{
-				// traverse tree
-				pNode = &m_aNodes[pNode->m_aLeafs[Bits&1]];
+		if(Bitcount < HUFFMAN_LUTBITS)
+			return -1;
 
-				// remove bit
-				Bitcount--;
-				Bits >>= 1;
+		// remove the bits that the lut checked up for us
+		Bits >>= HUFFMAN_LUTBITS;
+		Bitcount -= HUFFMAN_LUTBITS;
 
-				// check if we hit a symbol
-				if(pNode->m_NumBits)
-					break;
+		// walk the tree bit by bit
+		CNode *pNode = &m_aNodes[pEntry->m_Node];
+		while(1)
+		{
+			// no more bits, decoding error
+			if(Bitcount == 0)
+				return -1;
 
-				// no more bits, decoding error
-				if(Bitcount == 0)
-					return -1;
-			}
+			// traverse tree
+			pNode = &m_aNodes[pNode->m_aLeafs[Bits&1]];
+
+			// remove bit
+			Bitcount--;
+			Bits >>= 1;
+
+			// check if we hit a symbol
+			if(pNode->m_NumBits)
+				break;
 		}
 
 		// check for eof
@@ -14,9 +14,11 @@ class CHuffman
 		HUFFMAN_MAX_SYMBOLS=HUFFMAN_EOF_SYMBOL+1,
 		HUFFMAN_MAX_NODES=HUFFMAN_MAX_SYMBOLS*2-1,
 
-		HUFFMAN_LUTBITS = 10,
+		// every lut entry decodes as many whole symbols as fit into its bits
+		HUFFMAN_LUTBITS = 11,
 		HUFFMAN_LUTSIZE = (1<<HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE-1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE-1),
+		HUFFMAN_LUTSYMBOLS = 3
 	};
 
 	struct CNode
@@ -32,8 +34,17 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	struct CDecodeEntry
+	{
+		unsigned char m_aSymbols[HUFFMAN_LUTSYMBOLS];
+		unsigned char m_NumSymbols;
+		unsigned char m_NumBits; // of the whole symbols, 0 if the first one is longer than the lut
+		unsigned char m_Eof; // the eof symbol follows the others
+		unsigned short m_Node; // where to continue in the tree if the first symbol is longer than the lut
+	};
+
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
-	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CDecodeEntry m_aDecodeLut[HUFFMAN_LUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
 
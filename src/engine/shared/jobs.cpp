@@ -9,6 +9,10 @@ CJobPool::CJobPool()
 	m_Lock = lock_create();
 	m_pFirstJob = 0;
 	m_pLastJob = 0;
+	m_NumThreads = 0;
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_Semaphore);
+#endif
 }
 
 void CJobPool::WorkerThread(void *pUser)
@@ -19,6 +23,11 @@ void CJobPool::WorkerThread(void *pUser)
 	{
 		CJob *pJob = 0;
 
+#if !defined(CONF_PLATFORM_MACOSX)
+		// sleep until a job gets added
+		semaphore_wait(&pPool->m_Semaphore);
+#endif
+
 		// fetch job from queue
 		lock_wait(pPool->m_Lock);
 		if(pPool->m_pFirstJob)
@@ -37,10 +46,16 @@ void CJobPool::WorkerThread(void *pUser)
 		{
 			pJob->m_Status = CJob::STATE_RUNNING;
 			pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+
+			// the lock makes sure the results are visible before the job is flagged as done
+			lock_wait(pPool->m_Lock);
 			pJob->m_Status = CJob::STATE_DONE;
+			lock_release(pPool->m_Lock);
 		}
+#if defined(CONF_PLATFORM_MACOSX)
 		else
 			thread_sleep(10);
+#endif
 	}
 
 }
@@ -50,6 +65,7 @@ int CJobPool::Init(int NumThreads)
 	// start threads
 	for(int i = 0; i < NumThreads; i++)
 		thread_create(WorkerThread, this);
+	m_NumThreads += NumThreads;
 	return 0;
 }
 
@@ -70,6 +86,11 @@ int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData)
 		m_pFirstJob = pJob;
 
 	lock_release(m_Lock);
+
+#if !defined(CONF_PLATFORM_MACOSX)
+	// wake up a worker
+	semaphore_signal(&m_Semaphore);
+#endif
 	return 0;
 }
 
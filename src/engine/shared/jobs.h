@@ -2,6 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_JOBS_H
 #define ENGINE_SHARED_JOBS_H
+
+#include <base/system.h>
+
 typedef int (*JOBFUNC)(void *pData);
 
 class CJobPool;
@@ -42,6 +45,10 @@ class CJobPool
 	LOCK m_Lock;
 	CJob *m_pFirstJob;
 	CJob *m_pLastJob;
+	int m_NumThreads;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_Semaphore;
+#endif
 
 	static void WorkerThread(void *pUser);
 
@@ -50,5 +57,6 @@ public:
 
 	int Init(int NumThreads);
 	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData);
+	int NumThreads() const { return m_NumThreads; }
 };
 #endif
@@ -87,23 +87,60 @@ int CNetRecvUnpacker::FetchChunk(CNetChunk *pChunk)
 	}
 }
 
+// the buffer of the next free slot in the send queue, makes room if needed.
+// the packet is only queued by QueuePacket
+unsigned char *CNetBase::NextPacketBuffer(NETSOCKET Socket, const NETADDR *pAddr)
+{
+	if(ms_NumSendPackets == NET_BATCH_SIZE)
+		FlushPackets();
+
+	ms_aSendSockets[ms_NumSendPackets] = Socket;
+	ms_aSendPackets[ms_NumSendPackets].addr = *pAddr;
+	ms_aSendPackets[ms_NumSendPackets].data = ms_aaSendBuffers[ms_NumSendPackets];
+	return ms_aaSendBuffers[ms_NumSendPackets];
+}
+
+void CNetBase::QueuePacket(int Size)
+{
+	ms_aSendPackets[ms_NumSendPackets].size = Size;
+	ms_NumSendPackets++;
+}
+
+void CNetBase::FlushPackets()
+{
+	// one batch for each run of packets that go out over the same socket
+	int Start = 0;
+	while(Start < ms_NumSendPackets)
+	{
+		NETSOCKET Socket = ms_aSendSockets[Start];
+		int End = Start+1;
+		while(End < ms_NumSendPackets && ms_aSendSockets[End].ipv4sock == Socket.ipv4sock &&
+			ms_aSendSockets[End].ipv6sock == Socket.ipv6sock)
+			End++;
+
+		net_udp_send_batch(Socket, &ms_aSendPackets[Start], End-Start);
+		Start = End;
+	}
+	ms_NumSendPackets = 0;
+}
+
 // packs the data tight and sends it
 void CNetBase::SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize)
 {
-	unsigned char aBuffer[NET_MAX_PACKETSIZE];
-	aBuffer[0] = 0xff;
-	aBuffer[1] = 0xff;
-	aBuffer[2] = 0xff;
-	aBuffer[3] = 0xff;
-	aBuffer[4] = 0xff;
-	aBuffer[5] = 0xff;
-	mem_copy(&aBuffer[6], pData, DataSize);
-	net_udp_send(Socket, pAddr, aBuffer, 6+DataSize);
+	unsigned char *pBuffer = NextPacketBuffer(Socket, pAddr);
+	pBuffer[0] = 0xff;
+	pBuffer[1] = 0xff;
+	pBuffer[2] = 0xff;
+	pBuffer[3] = 0xff;
+	pBuffer[4] = 0xff;
+	pBuffer[5] = 0xff;
+	mem_copy(&pBuffer[6], pData, DataSize);
+	QueuePacket(6+DataSize);
 }
 
-void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket)
+int CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket)
 {
-	unsigned char aBuffer[NET_MAX_PACKETSIZE];
+	unsigned char *pBuffer = NextPacketBuffer(Socket, pAddr);
 	int CompressedSize = -1;
 	int FinalSize = -1;
 
@@ -118,7 +155,7 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 	}
 
 	// compress
-	CompressedSize = ms_Huffman.Compress(pPacket->m_aChunkData, pPacket->m_DataSize, &aBuffer[3], NET_MAX_PACKETSIZE-4);
+	CompressedSize = ms_Huffman.Compress(pPacket->m_aChunkData, pPacket->m_DataSize, &pBuffer[3], NET_MAX_PACKETSIZE-4);
 
 	// check if the compression was enabled, successful and good enough
 	if(CompressedSize > 0 && CompressedSize < pPacket->m_DataSize)
@@ -130,18 +167,18 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 	{
 		// use uncompressed data
 		FinalSize = pPacket->m_DataSize;
-		mem_copy(&aBuffer[3], pPacket->m_aChunkData, pPacket->m_DataSize);
+		mem_copy(&pBuffer[3], pPacket->m_aChunkData, pPacket->m_DataSize);
 		pPacket->m_Flags &= ~NET_PACKETFLAG_COMPRESSION;
 	}
 
-	// set header and send the packet if all things are good
+	// set header and queue the packet if all things are good
 	if(FinalSize >= 0)
 	{
 		FinalSize += NET_PACKETHEADERSIZE;
-		aBuffer[0] = ((pPacket->m_Flags<<4)&0xf0)|((pPacket->m_Ack>>8)&0xf);
-		aBuffer[1] = pPacket->m_Ack&0xff;
-		aBuffer[2] = pPacket->m_NumChunks;
-		net_udp_send(Socket, pAddr, aBuffer, FinalSize);
+		pBuffer[0] = ((pPacket->m_Flags<<4)&0xf0)|((pPacket->m_Ack>>8)&0xf);
+		pBuffer[1] = pPacket->m_Ack&0xff;
+		pBuffer[2] = pPacket->m_NumChunks;
+		QueuePacket(FinalSize);
 
 		// log raw socket data
 		if(ms_DataLogSent)
@@ -149,10 +186,11 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 			int Type = 0;
 			io_write(ms_DataLogSent, &Type, sizeof(Type));
 			io_write(ms_DataLogSent, &FinalSize, sizeof(FinalSize));
-			io_write(ms_DataLogSent, aBuffer, FinalSize);
+			io_write(ms_DataLogSent, pBuffer, FinalSize);
 			io_flush(ms_DataLogSent);
 		}
 	}
+	return FinalSize;
 }
 
 // TODO: rename this function
@@ -180,6 +218,7 @@ int CNetBase::UnpackPacket(unsigned char *pBuffer, int Size, CNetPacketConstruct
 	pPacket->m_Ack = ((pBuffer[0]&0xf)<<8) | pBuffer[1];
 	pPacket->m_NumChunks = pBuffer[2];
 	pPacket->m_DataSize = Size - NET_PACKETHEADERSIZE;
+	pPacket->m_PacketSize = Size;
 
 	if(pPacket->m_Flags&NET_PACKETFLAG_CONNLESS)
 	{
@@ -226,7 +265,28 @@ int CNetBase::UnpackPacket(unsigned char *pBuffer, int Size, CNetPacketConstruct
 }
 
 
-void CNetBase::SendControlMsg(NETSOCKET Socket, NETADDR *pAddr, int Ack, int ControlMsg, const void *pExtra, int ExtraSize)
+NETPACKET *CNetRecvBatch::Fetch(NETSOCKET Socket)
+{
+	if(m_CurrentPacket == m_NumPackets)
+	{
+		for(int i = 0; i < NET_BATCH_SIZE; i++)
+		{
+			m_aPackets[i].data = m_aaBuffers[i];
+			m_aPackets[i].size = NET_MAX_PACKETSIZE;
+		}
+		m_NumPackets = net_udp_recv_batch(Socket, m_aPackets, NET_BATCH_SIZE);
+		m_CurrentPacket = 0;
+		if(m_NumPackets <= 0)
+		{
+			m_NumPackets = 0;
+			return 0;
+		}
+	}
+	return &m_aPackets[m_CurrentPacket++];
+}
+
+
+int CNetBase::SendControlMsg(NETSOCKET Socket, NETADDR *pAddr, int Ack, int ControlMsg, const void *pExtra, int ExtraSize)
 {
 	CNetPacketConstruct Construct;
 	Construct.m_Flags = NET_PACKETFLAG_CONTROL;
@@ -237,7 +297,7 @@ void CNetBase::SendControlMsg(NETSOCKET Socket, NETADDR *pAddr, int Ack, int Con
 	mem_copy(&Construct.m_aChunkData[1], pExtra, ExtraSize);
 
 	// send the control message
-	CNetBase::SendPacket(Socket, pAddr, &Construct);
+	return CNetBase::SendPacket(Socket, pAddr, &Construct);
 }
 
 
@@ -291,6 +351,10 @@ int CNetBase::IsSeqInBackroom(int Seq, int Ack)
 IOHANDLE CNetBase::ms_DataLogSent = 0;
 IOHANDLE CNetBase::ms_DataLogRecv = 0;
 CHuffman CNetBase::ms_Huffman;
+NETSOCKET CNetBase::ms_aSendSockets[NET_BATCH_SIZE];
+NETPACKET CNetBase::ms_aSendPackets[NET_BATCH_SIZE];
+unsigned char CNetBase::ms_aaSendBuffers[NET_BATCH_SIZE][NET_MAX_PACKETSIZE];
+int CNetBase::ms_NumSendPackets = 0;
 
 
 void CNetBase::OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv)
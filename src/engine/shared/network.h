@@ -27,6 +27,7 @@ CURRENT:
 enum
 {
 	NETFLAG_ALLOWSTATELESS=1,
+	NETFLAG_THREADED=2,
 	NETSENDFLAG_VITAL=1,
 	NETSENDFLAG_CONNLESS=2,
 	NETSENDFLAG_FLUSH=4,
@@ -48,7 +49,7 @@ enum
 	NET_MAX_PAYLOAD = NET_MAX_PACKETSIZE-6,
 	NET_MAX_CHUNKHEADERSIZE = 5,
 	NET_PACKETHEADERSIZE = 3,
-	NET_MAX_CLIENTS = 16,
+	NET_MAX_CLIENTS = 128,
 	NET_MAX_CONSOLE_CLIENTS = 4,
 	NET_MAX_SEQUENCE = 1<<10,
 	NET_SEQUENCE_MASK = NET_MAX_SEQUENCE-1,
@@ -77,6 +78,8 @@ enum
 
 	NET_CONN_BUFFERSIZE=1024*128,
 
+	NET_BATCH_SIZE=32, // packets per recvmmsg/sendmmsg
+
 	NET_ENUM_TERMINATOR
 };
 
@@ -125,6 +128,7 @@ public:
 	int m_Ack;
 	int m_NumChunks;
 	int m_DataSize;
+	int m_PacketSize; // on the wire, set when unpacking
 	unsigned char m_aChunkData[NET_MAX_PAYLOAD];
 };
 
@@ -156,10 +160,11 @@ private:
 	NETADDR m_PeerAddr;
 	NETSOCKET m_Socket;
 	NETSTATS m_Stats;
+	int m_ResentChunks;
+	int m_VitalChunks;
 
 	//
 	void Reset();
-	void ResetStats();
 	void SetError(const char *pString);
 	void AckChunks(int Ack);
 
@@ -191,6 +196,12 @@ public:
 	int64 LastRecvTime() const { return m_LastRecvTime; }
 
 	int AckSequence() const { return m_Ack; }
+
+	// traffic of this connection
+	void ResetStats();
+	const NETSTATS *Stats() const { return &m_Stats; }
+	int ResentChunks() const { return m_ResentChunks; }
+	int VitalChunks() const { return m_VitalChunks; }
 };
 
 class CConsoleNetConnection
@@ -215,6 +226,7 @@ public:
 
 	int State() const { return m_State; }
 	NETADDR PeerAddress() const { return m_PeerAddr; }
+	NETSOCKET Socket() const { return m_Socket; }
 	const char *ErrorString() const { return m_aErrorString; }
 
 	void Reset();
@@ -233,7 +245,6 @@ public:
 	int m_CurrentChunk;
 	int m_ClientID;
 	CNetPacketConstruct m_Data;
-	unsigned char m_aBuffer[NET_MAX_PACKETSIZE];
 
 	CNetRecvUnpacker() { Clear(); }
 	void Clear();
@@ -241,6 +252,22 @@ public:
 	int FetchChunk(CNetChunk *pChunk);
 };
 
+// packets read from a socket in one go, handed out one by one
+class CNetRecvBatch
+{
+	NETPACKET m_aPackets[NET_BATCH_SIZE];
+	unsigned char m_aaBuffers[NET_BATCH_SIZE][NET_MAX_PACKETSIZE];
+	int m_NumPackets;
+	int m_CurrentPacket;
+
+public:
+	CNetRecvBatch() { Clear(); }
+	void Clear() { m_NumPackets = 0; m_CurrentPacket = 0; }
+
+	// returns 0 when nothing is waiting on the socket
+	NETPACKET *Fetch(NETSOCKET Socket);
+};
+
 // server side
 class CNetServer
 {
@@ -257,6 +284,8 @@ private:
 	{
 	public:
 		CNetConnection m_Connection;
+		int m_Generation; // counts the connections that used the slot
+		int m_HashNext; // next slot in the same address bucket, -1 ends it
 	};
 
 	struct CBan
@@ -275,10 +304,18 @@ private:
 
 
 	NETSOCKET m_Socket;
-	CSlot m_aSlots[NET_MAX_CLIENTS];
+	CSlot *m_pSlots; // m_MaxClients of them
 	int m_MaxClients;
 	int m_MaxClientsPerIP;
 
+	// the connected slots by address, so a packet does not have to be
+	// compared against every slot
+	enum
+	{
+		SLOT_HASH_SIZE=256,
+	};
+	int m_aSlotHash[SLOT_HASH_SIZE];
+
 	CBan *m_aBans[256];
 	CBan m_BanPool[NET_SERVER_MAXBANS];
 	CBan *m_BanPool_FirstFree;
@@ -289,7 +326,80 @@ private:
 	void *m_UserPtr;
 
 	CNetRecvUnpacker m_RecvUnpacker;
+	CNetRecvBatch m_RecvBatch;
 
+	// threaded mode. the network thread owns the sockets and connections and
+	// talks to the game thread through two lock free queues. the lock is held
+	// by the network thread while it works, the game thread only takes it for
+	// drops and bans
+	enum
+	{
+		EVENT_CHUNK=0,
+		EVENT_NEWCLIENT,
+		EVENT_DELCLIENT,
+
+		RECV_QUEUE_HEADROOM=256*1024, // for chunks, on top of the reserve of the connections
+		SEND_QUEUE_SIZE=1024*1024,
+	};
+
+	struct CEvent
+	{
+		int m_Type;
+		int m_ClientID;
+		int m_Generation;
+		int m_Flags;
+		NETADDR m_Address;
+		int m_DataSize;
+	};
+
+	// the game thread's view of the slots, lags behind the network thread
+	struct CGameSlot
+	{
+		int m_Generation;
+		bool m_Online;
+		NETADDR m_Addr;
+	};
+
+	void *m_pThread;
+	bool m_Threaded;
+	LOCK m_Lock;
+	volatile bool m_StopThread;
+	NETWAIT m_ThreadWait; // the network thread sleeps on this
+	NETWAIT m_RecvWait; // signaled when events were queued for the game thread
+	bool m_EventsPushed;
+	bool m_SendPending;
+	unsigned char *m_pQueueMemory;
+	CLockFreeRingBuffer m_RecvQueue; // network thread -> game thread
+	int m_RecvQueueSize;
+	int m_RecvReserve; // room the connections keep for their events, see NetThread
+	CLockFreeRingBuffer m_SendQueue; // game thread -> network thread
+	bool m_RecvEventPending;
+	CGameSlot *m_pGameSlots;
+
+	void Lock() { if(m_Threaded) lock_wait(m_Lock); }
+	void Unlock() { if(m_Threaded) lock_release(m_Lock); }
+
+	static void NetThread(void *pUser);
+	bool PushEvent(int Type, int ClientID, const NETADDR *pAddr, int Flags, const void *pData, int DataSize);
+	void ProcessSendQueue();
+	void DropFromGame(int ClientID, const char *pReason);
+
+	void OnNewClient(int ClientID);
+	void OnDelClient(int ClientID, const char *pReason);
+
+	// the work itself, done by the thread that owns the sockets
+	int RecvChunk(CNetChunk *pChunk);
+	int SendChunk(CNetChunk *pChunk);
+	int UpdateConnections();
+	void DropConnection(int ClientID, const char *pReason);
+
+	static int SlotHash(const NETADDR *pAddr);
+	void LinkSlot(int ClientID);
+	void UnlinkSlot(int ClientID);
+	int FindSlot(const NETADDR *pAddr);
+
+	int BanAddImpl(NETADDR Addr, int Seconds, const char *pReason);
+	int BanRemoveImpl(NETADDR Addr);
 	void BanRemoveByObject(CBan *pBan);
 
 public:
@@ -314,10 +424,13 @@ public:
 	int BanGet(int Index, CBanInfo *pInfo); // caution, slow
 
 	// status requests
-	NETADDR ClientAddr(int ClientID) const { return m_aSlots[ClientID].m_Connection.PeerAddress(); }
+	NETADDR ClientAddr(int ClientID) const { return m_Threaded ? m_pGameSlots[ClientID].m_Addr : m_pSlots[ClientID].m_Connection.PeerAddress(); }
 	NETSOCKET Socket() const { return m_Socket; }
 	int NetType() { return m_Socket.type; }
 	int MaxClients() const { return m_MaxClients; }
+	bool Threaded() const { return m_Threaded; }
+	void ClientStats(int ClientID, NETSTATS *pStats, int *pResentChunks, int *pVitalChunks);
+	void SetRecvWait(NETWAIT Wait) { m_RecvWait = Wait; }
 
 	//
 	void SetMaxClientsPerIP(int Max);
@@ -374,6 +487,7 @@ public:
 
 	// status requests
 	NETADDR ClientAddr(int ClientID) const { return m_aSlots[ClientID].m_Connection.PeerAddress(); }
+	int Sockets(NETSOCKET *pSockets, int MaxSockets) const; // the listening socket and the connections
 };
 
 
@@ -384,6 +498,7 @@ class CNetClient
 	NETADDR m_ServerAddr;
 	CNetConnection m_Connection;
 	CNetRecvUnpacker m_RecvUnpacker;
+	CNetRecvBatch m_RecvBatch;
 	NETSOCKET m_Socket;
 public:
 	// openness
@@ -419,6 +534,15 @@ class CNetBase
 	static IOHANDLE ms_DataLogSent;
 	static IOHANDLE ms_DataLogRecv;
 	static CHuffman ms_Huffman;
+
+	// packets waiting to be sent, see FlushPackets
+	static NETSOCKET ms_aSendSockets[NET_BATCH_SIZE];
+	static NETPACKET ms_aSendPackets[NET_BATCH_SIZE];
+	static unsigned char ms_aaSendBuffers[NET_BATCH_SIZE][NET_MAX_PACKETSIZE];
+	static int ms_NumSendPackets;
+
+	static unsigned char *NextPacketBuffer(NETSOCKET Socket, const NETADDR *pAddr);
+	static void QueuePacket(int Size);
 public:
 	static void OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv);
 	static void CloseLog();
@@ -426,11 +550,16 @@ public:
 	static int Compress(const void *pData, int DataSize, void *pOutput, int OutputSize);
 	static int Decompress(const void *pData, int DataSize, void *pOutput, int OutputSize);
 
-	static void SendControlMsg(NETSOCKET Socket, NETADDR *pAddr, int Ack, int ControlMsg, const void *pExtra, int ExtraSize);
+	static int SendControlMsg(NETSOCKET Socket, NETADDR *pAddr, int Ack, int ControlMsg, const void *pExtra, int ExtraSize);
 	static void SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize);
-	static void SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket);
+	static int SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket);
 	static int UnpackPacket(unsigned char *pBuffer, int Size, CNetPacketConstruct *pPacket);
 
+	// the send functions only queue the packets, this hands them to the
+	// sockets. also happens when the queue is full
+	static void FlushPackets();
+	static int NumQueuedPackets() { return ms_NumSendPackets; }
+
 	// The backroom is ack-NET_MAX_SEQUENCE/2. Used for knowing if we acked a packet or not
 	static int IsSeqInBackroom(int Seq, int Ack);
 };
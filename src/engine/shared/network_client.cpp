@@ -31,6 +31,7 @@ int CNetClient::Disconnect(const char *pReason)
 {
 	//dbg_msg("netclient", "disconnected. reason=\"%s\"", pReason);
 	m_Connection.Disconnect(pReason);
+	CNetBase::FlushPackets();
 	return 0;
 }
 
@@ -39,6 +40,7 @@ int CNetClient::Update()
 	m_Connection.Update();
 	if(m_Connection.State() == NET_CONNSTATE_ERROR)
 		Disconnect(m_Connection.ErrorString());
+	CNetBase::FlushPackets();
 	return 0;
 }
 
@@ -63,14 +65,14 @@ int CNetClient::Recv(CNetChunk *pChunk)
 			return 1;
 
 		// TODO: empty the recvinfo
-		NETADDR Addr;
-		int Bytes = net_udp_recv(m_Socket, &Addr, m_RecvUnpacker.m_aBuffer, NET_MAX_PACKETSIZE);
+		NETPACKET *pPacket = m_RecvBatch.Fetch(m_Socket);
 
 		// no more packets for now
-		if(Bytes <= 0)
+		if(!pPacket)
 			break;
 
-		if(CNetBase::UnpackPacket(m_RecvUnpacker.m_aBuffer, Bytes, &m_RecvUnpacker.m_Data) == 0)
+		NETADDR Addr = pPacket->addr;
+		if(CNetBase::UnpackPacket((unsigned char *)pPacket->data, pPacket->size, &m_RecvUnpacker.m_Data) == 0)
 		{
 			if(m_RecvUnpacker.m_Data.m_Flags&NET_PACKETFLAG_CONNLESS)
 			{
@@ -117,6 +119,9 @@ int CNetClient::Send(CNetChunk *pChunk)
 		if(pChunk->m_Flags&NETSENDFLAG_FLUSH)
 			m_Connection.Flush();
 	}
+
+	// the client sends little, waiting for a batch would only add latency
+	CNetBase::FlushPackets();
 	return 0;
 }
 
@@ -131,7 +136,9 @@ int CNetClient::State()
 
 int CNetClient::Flush()
 {
-	return m_Connection.Flush();
+	int Result = m_Connection.Flush();
+	CNetBase::FlushPackets();
+	return Result;
 }
 
 int CNetClient::GotProblems()
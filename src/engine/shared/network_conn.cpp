@@ -7,6 +7,8 @@
 void CNetConnection::ResetStats()
 {
 	mem_zero(&m_Stats, sizeof(m_Stats));
+	m_ResentChunks = 0;
+	m_VitalChunks = 0;
 }
 
 void CNetConnection::Reset()
@@ -74,7 +76,12 @@ int CNetConnection::Flush()
 
 	// send of the packets
 	m_Construct.m_Ack = m_Ack;
-	CNetBase::SendPacket(m_Socket, &m_PeerAddr, &m_Construct);
+	int Size = CNetBase::SendPacket(m_Socket, &m_PeerAddr, &m_Construct);
+	if(Size > 0)
+	{
+		m_Stats.sent_packets++;
+		m_Stats.sent_bytes += Size;
+	}
 
 	// update send times
 	m_LastSendTime = time_get();
@@ -121,6 +128,7 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 			pResend->m_FirstSendTime = time_get();
 			pResend->m_LastSendTime = pResend->m_FirstSendTime;
 			mem_copy(pResend->m_pData, pData, DataSize);
+			m_VitalChunks++;
 		}
 		else
 		{
@@ -144,13 +152,19 @@ void CNetConnection::SendControl(int ControlMsg, const void *pExtra, int ExtraSi
 {
 	// send the control message
 	m_LastSendTime = time_get();
-	CNetBase::SendControlMsg(m_Socket, &m_PeerAddr, m_Ack, ControlMsg, pExtra, ExtraSize);
+	int Size = CNetBase::SendControlMsg(m_Socket, &m_PeerAddr, m_Ack, ControlMsg, pExtra, ExtraSize);
+	if(Size > 0)
+	{
+		m_Stats.sent_packets++;
+		m_Stats.sent_bytes += Size;
+	}
 }
 
 void CNetConnection::ResendChunk(CNetChunkResend *pResend)
 {
 	QueueChunkEx(pResend->m_Flags|NET_CHUNKFLAG_RESEND, pResend->m_DataSize, pResend->m_pData, pResend->m_Sequence);
 	pResend->m_LastSendTime = time_get();
+	m_ResentChunks++;
 }
 
 void CNetConnection::Resend()
@@ -166,6 +180,7 @@ int CNetConnection::Connect(NETADDR *pAddr)
 
 	// init connection
 	Reset();
+	ResetStats();
 	m_PeerAddr = *pAddr;
 	mem_zero(m_ErrorString, sizeof(m_ErrorString));
 	m_State = NET_CONNSTATE_CONNECT;
@@ -197,6 +212,9 @@ int CNetConnection::Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr)
 {
 	int64 Now = time_get();
 
+	m_Stats.recv_packets++;
+	m_Stats.recv_bytes += pPacket->m_PacketSize;
+
 	// check if resend is requested
 	if(pPacket->m_Flags&NET_PACKETFLAG_RESEND)
 		Resend();
@@ -135,6 +135,19 @@ int CNetConsole::Update()
 	return 0;
 }
 
+int CNetConsole::Sockets(NETSOCKET *pSockets, int MaxSockets) const
+{
+	int Num = 0;
+	if(Num < MaxSockets)
+		pSockets[Num++] = m_Socket;
+	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS && Num < MaxSockets; i++)
+	{
+		if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_ONLINE)
+			pSockets[Num++] = m_aSlots[i].m_Connection.Socket();
+	}
+	return Num;
+}
+
 int CNetConsole::Recv(char *pLine, int MaxLength, int *pClientID)
 {
 	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
@@ -151,7 +164,7 @@ int CNetConsole::Recv(char *pLine, int MaxLength, int *pClientID)
 
 int CNetConsole::Send(int ClientID, const char *pLine)
 {
-    if (ClientID >= MAX_CLIENTS-MAX_BOTS)
+    if (ClientID >= NET_MAX_CONSOLE_CLIENTS)
         return -1;
 
 	if(m_aSlots[ClientID].m_Connection.State() == NET_CONNSTATE_ONLINE)
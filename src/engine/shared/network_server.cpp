@@ -45,8 +45,18 @@ bool CNetServer::Open(NETADDR BindAddr, int MaxClients, int MaxClientsPerIP, int
 
 	m_MaxClientsPerIP = MaxClientsPerIP;
 
-	for(int i = 0; i < NET_MAX_CLIENTS; i++)
-		m_aSlots[i].m_Connection.Init(m_Socket);
+	// the slots are only as many as the clients that may connect
+	m_pSlots = new CSlot[m_MaxClients];
+	m_pGameSlots = new CGameSlot[m_MaxClients];
+	mem_zero(m_pGameSlots, sizeof(CGameSlot)*m_MaxClients);
+	for(int i = 0; i < m_MaxClients; i++)
+	{
+		m_pSlots[i].m_Connection.Init(m_Socket);
+		m_pSlots[i].m_Generation = 0;
+		m_pSlots[i].m_HashNext = -1;
+	}
+	for(int i = 0; i < SLOT_HASH_SIZE; i++)
+		m_aSlotHash[i] = -1;
 
 	// setup all pointers for bans
 	for(int i = 1; i < NET_SERVER_MAXBANS-1; i++)
@@ -59,6 +69,24 @@ bool CNetServer::Open(NETADDR BindAddr, int MaxClients, int MaxClientsPerIP, int
 	m_BanPool[NET_SERVER_MAXBANS-1].m_pPrev = &m_BanPool[NET_SERVER_MAXBANS-2];
 	m_BanPool_FirstFree = &m_BanPool[0];
 
+	if(Flags&NETFLAG_THREADED)
+	{
+		// the free space of the queue is only counted in one piece, twice the
+		// reserve keeps it reachable wherever the queue wraps
+		int EventSize = sizeof(CEvent)+NET_MAX_PAYLOAD+16;
+		m_RecvReserve = (2*m_MaxClients+1)*EventSize;
+		m_RecvQueueSize = (2*m_RecvReserve+RECV_QUEUE_HEADROOM+7)&~7;
+		m_pQueueMemory = (unsigned char *)mem_alloc(m_RecvQueueSize+SEND_QUEUE_SIZE, 8);
+		m_RecvQueue.Init(m_pQueueMemory, m_RecvQueueSize);
+		m_SendQueue.Init(m_pQueueMemory+m_RecvQueueSize, SEND_QUEUE_SIZE);
+		dbg_assert(m_RecvQueue.Free() >= m_RecvReserve+EventSize, "receive queue too small for the reserve");
+		m_Lock = lock_create();
+		m_ThreadWait = net_wait_create();
+		// the flag has to be set before the network thread starts receiving
+		m_Threaded = true;
+		m_pThread = thread_create(NetThread, this);
+	}
+
 	return true;
 }
 
@@ -73,10 +101,115 @@ int CNetServer::SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT p
 int CNetServer::Close()
 {
 	// TODO: implement me
+	if(m_Threaded)
+	{
+		m_StopThread = true;
+		net_wait_signal(m_ThreadWait);
+		thread_wait(m_pThread);
+		m_pThread = 0;
+		m_Threaded = false;
+		lock_destroy(m_Lock);
+		net_wait_destroy(m_ThreadWait);
+		mem_free(m_pQueueMemory);
+		m_pQueueMemory = 0;
+	}
+	delete [] m_pSlots;
+	m_pSlots = 0;
+	delete [] m_pGameSlots;
+	m_pGameSlots = 0;
 	return 0;
 }
 
+int CNetServer::SlotHash(const NETADDR *pAddr)
+{
+	// with the port, the clients behind one ip go to different buckets
+	int Hash = pAddr->port;
+	for(int i = 0; i < 16; i++)
+		Hash += pAddr->ip[i];
+	return Hash&(SLOT_HASH_SIZE-1);
+}
+
+void CNetServer::LinkSlot(int ClientID)
+{
+	NETADDR Addr = m_pSlots[ClientID].m_Connection.PeerAddress();
+	int Hash = SlotHash(&Addr);
+	m_pSlots[ClientID].m_HashNext = m_aSlotHash[Hash];
+	m_aSlotHash[Hash] = ClientID;
+}
+
+void CNetServer::UnlinkSlot(int ClientID)
+{
+	// has to happen before the connection forgets its address
+	NETADDR Addr = m_pSlots[ClientID].m_Connection.PeerAddress();
+	int *pIndex = &m_aSlotHash[SlotHash(&Addr)];
+	while(*pIndex != -1 && *pIndex != ClientID)
+		pIndex = &m_pSlots[*pIndex].m_HashNext;
+	if(*pIndex == ClientID)
+		*pIndex = m_pSlots[ClientID].m_HashNext;
+	m_pSlots[ClientID].m_HashNext = -1;
+}
+
+int CNetServer::FindSlot(const NETADDR *pAddr)
+{
+	for(int i = m_aSlotHash[SlotHash(pAddr)]; i != -1; i = m_pSlots[i].m_HashNext)
+	{
+		NETADDR PeerAddr = m_pSlots[i].m_Connection.PeerAddress();
+		if(net_addr_comp(&PeerAddr, pAddr) == 0)
+			return i;
+	}
+	return -1;
+}
+
+void CNetServer::OnNewClient(int ClientID)
+{
+	m_pSlots[ClientID].m_Generation++;
+	if(m_Threaded)
+	{
+		NETADDR Addr = m_pSlots[ClientID].m_Connection.PeerAddress();
+		PushEvent(EVENT_NEWCLIENT, ClientID, &Addr, 0, 0, 0);
+	}
+	else if(m_pfnNewClient)
+		m_pfnNewClient(ClientID, m_UserPtr);
+}
+
+void CNetServer::OnDelClient(int ClientID, const char *pReason)
+{
+	if(m_Threaded)
+		PushEvent(EVENT_DELCLIENT, ClientID, 0, 0, pReason, str_length(pReason)+1);
+	else if(m_pfnDelClient)
+		m_pfnDelClient(ClientID, pReason, m_UserPtr);
+}
+
 int CNetServer::Drop(int ClientID, const char *pReason)
+{
+	if(!m_Threaded)
+	{
+		DropConnection(ClientID, pReason);
+		return 0;
+	}
+
+	// the network thread might have lost the connection already, then the
+	// game is told by the queued event, which gets ignored after this
+	CGameSlot *pGameSlot = &m_pGameSlots[ClientID];
+	if(!pGameSlot->m_Online)
+		return 0;
+	pGameSlot->m_Online = false;
+	if(m_pfnDelClient)
+		m_pfnDelClient(ClientID, pReason, m_UserPtr);
+
+	lock_wait(m_Lock);
+	CSlot *pSlot = &m_pSlots[ClientID];
+	if(pSlot->m_Generation == pGameSlot->m_Generation && pSlot->m_Connection.State() != NET_CONNSTATE_OFFLINE)
+	{
+		UnlinkSlot(ClientID);
+		pSlot->m_Connection.Disconnect(pReason);
+		CNetBase::FlushPackets();
+	}
+	lock_release(m_Lock);
+	return 0;
+}
+
+void CNetServer::DropConnection(int ClientID, const char *pReason)
 {
 	// TODO: insert lots of checks here
 	/*NETADDR Addr = ClientAddr(ClientID);
@@ -86,32 +219,37 @@ int CNetServer::Drop(int ClientID, const char *pReason)
 		Addr.ip[0], Addr.ip[1], Addr.ip[2], Addr.ip[3],
 		pReason
 		);*/
-	if(m_pfnDelClient)
-		m_pfnDelClient(ClientID, pReason, m_UserPtr);
+	OnDelClient(ClientID, pReason);
 
-	m_aSlots[ClientID].m_Connection.Disconnect(pReason);
+	if(m_pSlots[ClientID].m_Connection.State() != NET_CONNSTATE_OFFLINE)
+		UnlinkSlot(ClientID);
+	m_pSlots[ClientID].m_Connection.Disconnect(pReason);
 
-	return 0;
+	// get the close message out even if nothing gets pumped anymore
+	CNetBase::FlushPackets();
 }
 
 int CNetServer::BanGet(int Index, CBanInfo *pInfo)
 {
+	Lock();
 	CBan *pBan;
 	for(pBan = m_BanPool_FirstUsed; pBan && Index; pBan = pBan->m_pNext, Index--)
 		{}
 
-	if(!pBan)
-		return 0;
-	*pInfo = pBan->m_Info;
-	return 1;
+	if(pBan)
+		*pInfo = pBan->m_Info;
+	Unlock();
+	return pBan ? 1 : 0;
 }
 
 int CNetServer::BanNum()
 {
 	int Count = 0;
 	CBan *pBan;
+	Lock();
 	for(pBan = m_BanPool_FirstUsed; pBan; pBan = pBan->m_pNext)
 		Count++;
+	Unlock();
 	return Count;
 }
 
@@ -130,6 +268,14 @@ void CNetServer::BanRemoveByObject(CBan *pBan)
 }
 
 int CNetServer::BanRemove(NETADDR Addr)
+{
+	Lock();
+	int Result = BanRemoveImpl(Addr);
+	Unlock();
+	return Result;
+}
+
+int CNetServer::BanRemoveImpl(NETADDR Addr)
 {
 	int IpHash = (Addr.ip[0]+Addr.ip[1]+Addr.ip[2]+Addr.ip[3]+Addr.ip[4]+Addr.ip[5]+Addr.ip[6]+Addr.ip[7]+
 					Addr.ip[8]+Addr.ip[9]+Addr.ip[10]+Addr.ip[11]+Addr.ip[12]+Addr.ip[13]+Addr.ip[14]+Addr.ip[15])&0xff;
@@ -147,6 +293,44 @@ int CNetServer::BanRemove(NETADDR Addr)
 }
 
 int CNetServer::BanAdd(NETADDR Addr, int Seconds, const char *pReason)
+{
+	Lock();
+	int Result = BanAddImpl(Addr, Seconds, pReason);
+	Unlock();
+	if(Result <= 0)
+		return Result;
+
+	// drop banned clients
+	{
+		char Buf[128];
+		NETADDR BanAddr;
+
+		if(Seconds)
+		{
+			int Mins = (Seconds + 59) / 60;
+			if(Mins <= 1)
+				str_format(Buf, sizeof(Buf), "You have been banned for 1 minute (%s)", pReason);
+			else
+				str_format(Buf, sizeof(Buf), "You have been banned for %d minutes (%s)", Mins, pReason);
+		}
+		else
+			str_format(Buf, sizeof(Buf), "You have been banned for life (%s)", pReason);
+
+		Addr.port = 0;
+		for(int i = 0; i < MaxClients(); i++)
+		{
+			BanAddr = ClientAddr(i);
+			BanAddr.port = 0;
+
+			if(net_addr_comp(&Addr, &BanAddr) == 0)
+				Drop(i, Buf);
+		}
+	}
+	return 0;
+}
+
+// -1 when there is no room, 0 when an existing ban was adjusted, 1 for a new ban
+int CNetServer::BanAddImpl(NETADDR Addr, int Seconds, const char *pReason)
 {
 	int IpHash = (Addr.ip[0]+Addr.ip[1]+Addr.ip[2]+Addr.ip[3]+Addr.ip[4]+Addr.ip[5]+Addr.ip[6]+Addr.ip[7]+
 					Addr.ip[8]+Addr.ip[9]+Addr.ip[10]+Addr.ip[11]+Addr.ip[12]+Addr.ip[13]+Addr.ip[14]+Addr.ip[15])&0xff;
@@ -216,42 +400,33 @@ int CNetServer::BanAdd(NETADDR Addr, int Seconds, const char *pReason)
 		}
 	}
 
-	// drop banned clients
-	{
-		char Buf[128];
-		NETADDR BanAddr;
-
-		if(Stamp > -1)
-		{
-			int Mins = (Seconds + 59) / 60;
-			if(Mins <= 1)
-				str_format(Buf, sizeof(Buf), "You have been banned for 1 minute (%s)", pReason);
-			else
-				str_format(Buf, sizeof(Buf), "You have been banned for %d minutes (%s)", Mins, pReason);
-		}
-		else
-			str_format(Buf, sizeof(Buf), "You have been banned for life (%s)", pReason);
+	return 1;
+}
 
-		for(int i = 0; i < MaxClients(); i++)
+int CNetServer::Update()
+{
+	// the network thread does this on its own, it only has to be told
+	// that there is something to send
+	if(m_Threaded)
+	{
+		if(m_SendPending)
 		{
-			BanAddr = m_aSlots[i].m_Connection.PeerAddress();
-			BanAddr.port = 0;
-
-			if(net_addr_comp(&Addr, &BanAddr) == 0)
-				Drop(i, Buf);
+			m_SendPending = false;
+			net_wait_signal(m_ThreadWait);
 		}
+		return 0;
 	}
-	return 0;
+	return UpdateConnections();
 }
 
-int CNetServer::Update()
+int CNetServer::UpdateConnections()
 {
 	int Now = time_timestamp();
 	for(int i = 0; i < MaxClients(); i++)
 	{
-		m_aSlots[i].m_Connection.Update();
-		if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_ERROR)
-			Drop(i, m_aSlots[i].m_Connection.ErrorString());
+		m_pSlots[i].m_Connection.Update();
+		if(m_pSlots[i].m_Connection.State() == NET_CONNSTATE_ERROR)
+			DropConnection(i, m_pSlots[i].m_Connection.ErrorString());
 	}
 
 	// remove expired bans
@@ -261,13 +436,65 @@ int CNetServer::Update()
 		BanRemoveByObject(pBan);
 	}
 
+	// send what was queued since the last update
+	CNetBase::FlushPackets();
 	return 0;
 }
 
+int CNetServer::Recv(CNetChunk *pChunk)
+{
+	if(!m_Threaded)
+		return RecvChunk(pChunk);
+
+	while(1)
+	{
+		// the data of the last chunk was in use until now
+		if(m_RecvEventPending)
+		{
+			m_RecvQueue.Pop();
+			m_RecvEventPending = false;
+		}
+
+		CEvent *pEvent = (CEvent *)m_RecvQueue.Peek(0);
+		if(!pEvent)
+			return 0;
+		m_RecvEventPending = true;
+
+		CGameSlot *pGameSlot = pEvent->m_ClientID >= 0 ? &m_pGameSlots[pEvent->m_ClientID] : 0;
+		if(pEvent->m_Type == EVENT_NEWCLIENT)
+		{
+			pGameSlot->m_Generation = pEvent->m_Generation;
+			pGameSlot->m_Addr = pEvent->m_Address;
+			pGameSlot->m_Online = true;
+			if(m_pfnNewClient)
+				m_pfnNewClient(pEvent->m_ClientID, m_UserPtr);
+		}
+		else if(pEvent->m_Type == EVENT_DELCLIENT)
+		{
+			// unless the game dropped the client itself
+			if(pGameSlot->m_Online && pGameSlot->m_Generation == pEvent->m_Generation)
+			{
+				pGameSlot->m_Online = false;
+				if(m_pfnDelClient)
+					m_pfnDelClient(pEvent->m_ClientID, (const char *)(pEvent+1), m_UserPtr);
+			}
+		}
+		else if(!pGameSlot || (pGameSlot->m_Online && pGameSlot->m_Generation == pEvent->m_Generation))
+		{
+			pChunk->m_ClientID = pEvent->m_ClientID;
+			pChunk->m_Address = pEvent->m_Address;
+			pChunk->m_Flags = pEvent->m_Flags;
+			pChunk->m_DataSize = pEvent->m_DataSize;
+			pChunk->m_pData = pEvent+1;
+			return 1;
+		}
+	}
+}
+
 /*
 	TODO: chopp up this function into smaller working parts
 */
-int CNetServer::Recv(CNetChunk *pChunk)
+int CNetServer::RecvChunk(CNetChunk *pChunk)
 {
 	unsigned Now = time_timestamp();
 
@@ -280,13 +507,17 @@ int CNetServer::Recv(CNetChunk *pChunk)
 			return 1;
 
 		// TODO: empty the recvinfo
-		int Bytes = net_udp_recv(m_Socket, &Addr, m_RecvUnpacker.m_aBuffer, NET_MAX_PACKETSIZE);
+		NETPACKET *pPacket = m_RecvBatch.Fetch(m_Socket);
 
-		// no more packets for now
-		if(Bytes <= 0)
+		// no more packets for now, send the replies in one go
+		if(!pPacket)
+		{
+			CNetBase::FlushPackets();
 			break;
+		}
 
-		if(CNetBase::UnpackPacket(m_RecvUnpacker.m_aBuffer, Bytes, &m_RecvUnpacker.m_Data) == 0)
+		Addr = pPacket->addr;
+		if(CNetBase::UnpackPacket((unsigned char *)pPacket->data, pPacket->size, &m_RecvUnpacker.m_Data) == 0)
 		{
 			CBan *pBan = 0;
 			NETADDR BanAddr = Addr;
@@ -335,19 +566,8 @@ int CNetServer::Recv(CNetChunk *pChunk)
 				// TODO: check size here
 				if(m_RecvUnpacker.m_Data.m_Flags&NET_PACKETFLAG_CONTROL && m_RecvUnpacker.m_Data.m_aChunkData[0] == NET_CTRLMSG_CONNECT)
 				{
-					Found = 0;
-
-					// check if we already got this client
-					for(int i = 0; i < MaxClients(); i++)
-					{
-						NETADDR PeerAddr = m_aSlots[i].m_Connection.PeerAddress();
-						if(m_aSlots[i].m_Connection.State() != NET_CONNSTATE_OFFLINE &&
-							net_addr_comp(&PeerAddr, &Addr) == 0)
-						{
-							Found = 1; // silent ignore.. we got this client already
-							break;
-						}
-					}
+					// check if we already got this client, silent ignore then
+					Found = FindSlot(&Addr) != -1;
 
 					// client that wants to connect
 					if(!Found)
@@ -358,10 +578,10 @@ int CNetServer::Recv(CNetChunk *pChunk)
 						ThisAddr.port = 0;
 						for(int i = 0; i < MaxClients(); ++i)
 						{
-							if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE)
+							if(m_pSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE)
 								continue;
 
-							OtherAddr = m_aSlots[i].m_Connection.PeerAddress();
+							OtherAddr = m_pSlots[i].m_Connection.PeerAddress();
 							OtherAddr.port = 0;
 							if(!net_addr_comp(&ThisAddr, &OtherAddr))
 							{
@@ -377,12 +597,13 @@ int CNetServer::Recv(CNetChunk *pChunk)
 
 						for(int i = 0; i < MaxClients(); i++)
 						{
-							if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE)
+							if(m_pSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE)
 							{
 								Found = 1;
-								m_aSlots[i].m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr);
-								if(m_pfnNewClient)
-									m_pfnNewClient(i, m_UserPtr);
+								m_pSlots[i].m_Connection.ResetStats();
+								m_pSlots[i].m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr);
+								LinkSlot(i);
+								OnNewClient(i);
 								break;
 							}
 						}
@@ -397,17 +618,11 @@ int CNetServer::Recv(CNetChunk *pChunk)
 				else
 				{
 					// normal packet, find matching slot
-					for(int i = 0; i < MaxClients(); i++)
+					int i = FindSlot(&Addr);
+					if(i != -1 && m_pSlots[i].m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr))
 					{
-						NETADDR PeerAddr = m_aSlots[i].m_Connection.PeerAddress();
-						if(net_addr_comp(&PeerAddr, &Addr) == 0)
-						{
-							if(m_aSlots[i].m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr))
-							{
-								if(m_RecvUnpacker.m_Data.m_DataSize)
-									m_RecvUnpacker.Start(&Addr, &m_aSlots[i].m_Connection, i);
-							}
-						}
+						if(m_RecvUnpacker.m_Data.m_DataSize)
+							m_RecvUnpacker.Start(&Addr, &m_pSlots[i].m_Connection, i);
 					}
 				}
 			}
@@ -417,6 +632,42 @@ int CNetServer::Recv(CNetChunk *pChunk)
 }
 
 int CNetServer::Send(CNetChunk *pChunk)
+{
+	if(!m_Threaded)
+		return SendChunk(pChunk);
+
+	int Generation = 0;
+	if(!(pChunk->m_Flags&NETSENDFLAG_CONNLESS))
+	{
+		if(pChunk->m_ClientID < 0 || pChunk->m_ClientID >= MaxClients() || !m_pGameSlots[pChunk->m_ClientID].m_Online)
+			return -1;
+		Generation = m_pGameSlots[pChunk->m_ClientID].m_Generation;
+	}
+
+	if(pChunk->m_DataSize >= NET_MAX_PAYLOAD)
+	{
+		dbg_msg("netserver", "packet payload too big. %d. dropping packet", pChunk->m_DataSize);
+		return -1;
+	}
+
+	// wait for the network thread if it fell behind
+	CEvent *pEvent;
+	while(!(pEvent = (CEvent *)m_SendQueue.Allocate(sizeof(CEvent)+pChunk->m_DataSize)))
+		thread_yield();
+
+	pEvent->m_Type = EVENT_CHUNK;
+	pEvent->m_ClientID = pChunk->m_ClientID;
+	pEvent->m_Generation = Generation;
+	pEvent->m_Flags = pChunk->m_Flags;
+	pEvent->m_Address = pChunk->m_Address;
+	pEvent->m_DataSize = pChunk->m_DataSize;
+	mem_copy(pEvent+1, pChunk->m_pData, pChunk->m_DataSize);
+	m_SendQueue.Commit();
+	m_SendPending = true;
+	return 0;
+}
+
+int CNetServer::SendChunk(CNetChunk *pChunk)
 {
     //H-Client
     if (pChunk->m_ClientID >= MaxClients())
@@ -443,19 +694,102 @@ int CNetServer::Send(CNetChunk *pChunk)
 		if(pChunk->m_Flags&NETSENDFLAG_VITAL)
 			Flags = NET_CHUNKFLAG_VITAL;
 
-		if(m_aSlots[pChunk->m_ClientID].m_Connection.QueueChunk(Flags, pChunk->m_DataSize, pChunk->m_pData) == 0)
+		if(m_pSlots[pChunk->m_ClientID].m_Connection.QueueChunk(Flags, pChunk->m_DataSize, pChunk->m_pData) == 0)
 		{
 			if(pChunk->m_Flags&NETSENDFLAG_FLUSH)
-				m_aSlots[pChunk->m_ClientID].m_Connection.Flush();
+				m_pSlots[pChunk->m_ClientID].m_Connection.Flush();
 		}
 		else
 		{
-			Drop(pChunk->m_ClientID, "Error sending data");
+			DropConnection(pChunk->m_ClientID, "Error sending data");
 		}
 	}
 	return 0;
 }
 
+bool CNetServer::PushEvent(int Type, int ClientID, const NETADDR *pAddr, int Flags, const void *pData, int DataSize)
+{
+	CEvent *pEvent = (CEvent *)m_RecvQueue.Allocate(sizeof(CEvent)+DataSize);
+	dbg_assert(pEvent != 0, "network thread ran out of its event reserve");
+	if(!pEvent)
+		return false;
+
+	pEvent->m_Type = Type;
+	pEvent->m_ClientID = ClientID;
+	pEvent->m_Generation = ClientID >= 0 ? m_pSlots[ClientID].m_Generation : 0;
+	pEvent->m_Flags = Flags;
+	if(pAddr)
+		pEvent->m_Address = *pAddr;
+	else
+		mem_zero(&pEvent->m_Address, sizeof(pEvent->m_Address));
+	pEvent->m_DataSize = DataSize;
+	mem_copy(pEvent+1, pData, DataSize);
+	m_RecvQueue.Commit();
+	m_EventsPushed = true;
+	return true;
+}
+
+void CNetServer::ProcessSendQueue()
+{
+	CEvent *pEvent;
+	while((pEvent = (CEvent *)m_SendQueue.Peek(0)))
+	{
+		// skip chunks for connections that are gone already
+		if(pEvent->m_Flags&NETSENDFLAG_CONNLESS || (pEvent->m_Generation == m_pSlots[pEvent->m_ClientID].m_Generation &&
+			m_pSlots[pEvent->m_ClientID].m_Connection.State() != NET_CONNSTATE_OFFLINE))
+		{
+			CNetChunk Chunk;
+			Chunk.m_ClientID = pEvent->m_ClientID;
+			Chunk.m_Address = pEvent->m_Address;
+			Chunk.m_Flags = pEvent->m_Flags;
+			Chunk.m_DataSize = pEvent->m_DataSize;
+			Chunk.m_pData = pEvent+1;
+			SendChunk(&Chunk);
+		}
+		m_SendQueue.Pop();
+	}
+}
+
+void CNetServer::NetThread(void *pUser)
+{
+	CNetServer *pThis = (CNetServer *)pUser;
+	CNetChunk Chunk;
+
+	// the game may fall behind with reading the events. every connection
+	// keeps room for its drop event, new connections and chunks are only
+	// taken while there is room for them on top of that
+	int RecvReserve = pThis->m_RecvReserve;
+
+	while(!pThis->m_StopThread)
+	{
+		lock_wait(pThis->m_Lock);
+		pThis->ProcessSendQueue();
+		pThis->UpdateConnections();
+		while(pThis->m_RecvQueue.Free() >= RecvReserve && pThis->RecvChunk(&Chunk))
+			pThis->PushEvent(EVENT_CHUNK, Chunk.m_ClientID, &Chunk.m_Address, Chunk.m_Flags, Chunk.m_pData, Chunk.m_DataSize);
+		CNetBase::FlushPackets();
+		lock_release(pThis->m_Lock);
+
+		if(pThis->m_EventsPushed && pThis->m_RecvWait)
+			net_wait_signal(pThis->m_RecvWait);
+		pThis->m_EventsPushed = false;
+
+		// sleep until a packet comes in or the game has something to send,
+		// wake up regularly anyway for resends and timeouts
+		net_wait(pThis->m_ThreadWait, &pThis->m_Socket, 1, time_get()+time_freq()/100);
+	}
+}
+
+void CNetServer::ClientStats(int ClientID, NETSTATS *pStats, int *pResentChunks, int *pVitalChunks)
+{
+	// the network thread counts while it updates the connections
+	Lock();
+	*pStats = *m_pSlots[ClientID].m_Connection.Stats();
+	*pResentChunks = m_pSlots[ClientID].m_Connection.ResentChunks();
+	*pVitalChunks = m_pSlots[ClientID].m_Connection.VitalChunks();
+	Unlock();
+}
+
 void CNetServer::SetMaxClientsPerIP(int Max)
 {
 	// clamp
@@ -105,12 +105,13 @@ int CUnpacker::GetInt()
 	}
 
 	int i;
-	m_pCurrent = CVariableInt::Unpack(m_pCurrent, &i);
-	if(m_pCurrent > m_pEnd)
+	const unsigned char *pNext = CVariableInt::Unpack(m_pCurrent, &i, (int)(m_pEnd - m_pCurrent));
+	if(!pNext)
 	{
 		m_Error = 1;
 		return 0;
 	}
+	m_pCurrent = pNext;
 	return i;
 }
 
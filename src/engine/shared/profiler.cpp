@@ -0,0 +1,94 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <algorithm> // sort
+
+#include <base/math.h>
+
+#include "profiler.h"
+
+CProfiler g_Profiler;
+
+CProfiler::CProfiler()
+{
+	m_NumSections = 0;
+	m_Enabled = false;
+}
+
+void CProfiler::SetEnabled(bool Enabled)
+{
+	if(Enabled && !m_Enabled)
+		Reset();
+	m_Enabled = Enabled;
+}
+
+int CProfiler::Section(const char *pName)
+{
+	for(int i = 0; i < m_NumSections; i++)
+		if(str_comp(m_aSections[i].m_aName, pName) == 0)
+			return i;
+
+	dbg_assert(m_NumSections < MAX_SECTIONS, "too many profiler sections");
+	CSection *pSection = &m_aSections[m_NumSections];
+	str_copy(pSection->m_aName, pName, sizeof(pSection->m_aName));
+	pSection->m_Current = 0;
+	pSection->m_CurrentCalls = 0;
+	pSection->m_NumSamples = 0;
+	return m_NumSections++;
+}
+
+void CProfiler::EndTick()
+{
+	if(!m_Enabled)
+		return;
+
+	int64 Freq = time_freq();
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		CSection *pSection = &m_aSections[i];
+		if(!pSection->m_CurrentCalls)
+			continue;
+
+		int Index = pSection->m_NumSamples%MAX_SAMPLES;
+		pSection->m_aSamples[Index] = (int)(pSection->m_Current*1000000/Freq);
+		pSection->m_aCalls[Index] = pSection->m_CurrentCalls;
+		pSection->m_NumSamples++;
+		pSection->m_Current = 0;
+		pSection->m_CurrentCalls = 0;
+	}
+}
+
+void CProfiler::Reset()
+{
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		m_aSections[i].m_Current = 0;
+		m_aSections[i].m_CurrentCalls = 0;
+		m_aSections[i].m_NumSamples = 0;
+	}
+}
+
+void CProfiler::GetStats(int Section, CStats *pStats) const
+{
+	const CSection *pSection = &m_aSections[Section];
+	int Num = min((int)pSection->m_NumSamples, (int)MAX_SAMPLES);
+	mem_zero(pStats, sizeof(*pStats));
+	pStats->m_NumSamples = Num;
+	if(!Num)
+		return;
+
+	int aSorted[MAX_SAMPLES];
+	int64 Sum = 0, Calls = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		aSorted[i] = pSection->m_aSamples[i];
+		Sum += pSection->m_aSamples[i];
+		Calls += pSection->m_aCalls[i];
+	}
+	std::sort(aSorted, aSorted+Num);
+
+	pStats->m_CallsPerSample = (float)Calls/Num;
+	pStats->m_Avg = (int)(Sum/Num);
+	pStats->m_P50 = aSorted[(Num-1)*50/100];
+	pStats->m_P99 = aSorted[(Num-1)*99/100];
+	pStats->m_Max = aSorted[Num-1];
+}
@@ -0,0 +1,107 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+/*
+	Class: Profiler
+		Named sections that add up the time spent in them during a
+		tick. EndTick turns that into one sample per section that ran,
+		the last samples give the percentiles. While it is disabled a
+		scope costs a flag test.
+*/
+class CProfiler
+{
+public:
+	enum
+	{
+		MAX_SECTIONS=64,
+		MAX_NAME_LENGTH=32,
+		MAX_SAMPLES=512, // about 10 seconds worth of ticks
+	};
+
+	class CStats
+	{
+	public:
+		int m_NumSamples;
+		float m_CallsPerSample;
+		int m_Avg; // microseconds
+		int m_P50;
+		int m_P99;
+		int m_Max;
+	};
+
+private:
+	struct CSection
+	{
+		char m_aName[MAX_NAME_LENGTH];
+		int64 m_Current;
+		int m_CurrentCalls;
+
+		// microseconds, ring of the last MAX_SAMPLES ticks the section ran in
+		int m_aSamples[MAX_SAMPLES];
+		int m_aCalls[MAX_SAMPLES];
+		int m_NumSamples;
+	};
+
+	CSection m_aSections[MAX_SECTIONS];
+	int m_NumSections;
+	bool m_Enabled;
+
+public:
+	CProfiler();
+
+	bool Enabled() const { return m_Enabled; }
+	void SetEnabled(bool Enabled);
+
+	// finds or adds a section, the index stays valid
+	int Section(const char *pName);
+	void Add(int Section, int64 Time)
+	{
+		m_aSections[Section].m_Current += Time;
+		m_aSections[Section].m_CurrentCalls++;
+	}
+
+	void EndTick();
+	void Reset();
+
+	int NumSections() const { return m_NumSections; }
+	const char *Name(int Section) const { return m_aSections[Section].m_aName; }
+	void GetStats(int Section, CStats *pStats) const;
+};
+
+extern CProfiler g_Profiler;
+
+/*
+	Class: Profile scope
+		Adds the time until the end of the scope to a section.
+*/
+class CProfileScope
+{
+	int m_Section;
+	int64 m_Start;
+
+public:
+	CProfileScope(int Section)
+	{
+		m_Section = Section;
+		m_Start = g_Profiler.Enabled() ? time_get() : 0;
+	}
+
+	~CProfileScope()
+	{
+		Stop();
+	}
+
+	// ends the scope early
+	void Stop()
+	{
+		if(m_Start)
+			g_Profiler.Add(m_Section, time_get()-m_Start);
+		m_Start = 0;
+	}
+};
+
+#endif
@@ -87,10 +87,8 @@ enum
 	SERVER_TICK_SPEED=50,
 	SERVER_FLAG_PASSWORD = 0x1,
 
-    //H-Client
-    MAX_BOTS=25,
-	MAX_CLIENTS=16+MAX_BOTS,
-    //
+	// only the upper bound, sv_max_clients sets the slots (NET_MAX_CLIENTS)
+	MAX_CLIENTS=128,
 
 	MAX_INPUT_SIZE=128,
 	MAX_SNAPSHOT_PACKSIZE=900,
@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 
 #include "ringbuffer.h"
@@ -192,3 +193,100 @@ void *CRingBufferBase::Last()
 	return Prev(m_pProduce+1);
 }
 
+
+void CLockFreeRingBuffer::Init(void *pMemory, int Size)
+{
+	dbg_assert((Size&7) == 0, "ring buffer size has to be a multiple of 8");
+	m_pBuffer = (unsigned char *)pMemory;
+	m_Size = Size;
+	m_Read = 0;
+	m_Write = 0;
+	m_NextWrite = 0;
+}
+
+void *CLockFreeRingBuffer::Allocate(int Size)
+{
+	int Need = ItemSize(Size);
+	int Read = m_Read;
+	int Write = m_Write;
+	int Pos = -1;
+
+	// write may never catch up with read, that would look empty
+	if(Write >= Read)
+	{
+		if(Need < m_Size-Write || (Need == m_Size-Write && Read != 0))
+			Pos = Write;
+		else if(Need < Read)
+		{
+			// not enough room at the end, continue at the start
+			*(int *)(m_pBuffer+Write) = WRAP;
+			Pos = 0;
+		}
+	}
+	else if(Need < Read-Write)
+		Pos = Write;
+
+	if(Pos < 0)
+		return 0;
+
+	*(int *)(m_pBuffer+Pos) = Size;
+	m_NextWrite = Pos+Need == m_Size ? 0 : Pos+Need;
+	return m_pBuffer+Pos+HEADER_SIZE;
+}
+
+void CLockFreeRingBuffer::Commit()
+{
+	// the item has to be written before it gets published
+	sync_barrier();
+	m_Write = m_NextWrite;
+}
+
+int CLockFreeRingBuffer::Free() const
+{
+	int Read = m_Read;
+	int Write = m_Write;
+	int Contiguous;
+	if(Write >= Read)
+		Contiguous = max(Read == 0 ? m_Size-Write-1 : m_Size-Write, Read-1);
+	else
+		Contiguous = Read-Write-1;
+	return max(Contiguous-HEADER_SIZE-7, 0);
+}
+
+void *CLockFreeRingBuffer::Peek(int *pSize)
+{
+	int Read = m_Read;
+	if(Read == m_Write)
+		return 0;
+
+	// don't read the item before its publication was seen
+	sync_barrier();
+	int Size = *(int *)(m_pBuffer+Read);
+	if(Size == WRAP)
+	{
+		Read = 0;
+		Size = *(int *)m_pBuffer;
+	}
+	if(pSize)
+		*pSize = Size;
+	return m_pBuffer+Read+HEADER_SIZE;
+}
+
+void CLockFreeRingBuffer::Pop()
+{
+	int Read = m_Read;
+	if(Read == m_Write)
+		return;
+
+	int Size = *(int *)(m_pBuffer+Read);
+	if(Size == WRAP)
+	{
+		Read = 0;
+		Size = *(int *)m_pBuffer;
+	}
+
+	// done with the item before the producer may reuse it
+	sync_barrier();
+	Read += ItemSize(Size);
+	m_Read = Read == m_Size ? 0 : Read;
+}
@@ -65,4 +65,41 @@ public:
 	T *Last() { return (T*)CRingBufferBase::Last(); }
 };
 
+// variable sized items passed from one producer to one consumer thread
+// without locks. items are never split at the end of the buffer
+class CLockFreeRingBuffer
+{
+	enum
+	{
+		HEADER_SIZE=8, // keeps the items 8 byte aligned
+		WRAP=-1, // size of a header that sends the consumer back to the start
+	};
+
+	unsigned char *m_pBuffer;
+	int m_Size;
+
+	volatile int m_Read; // only written by the consumer
+	volatile int m_Write; // only written by the producer
+	int m_NextWrite;
+
+	static int ItemSize(int Size) { return HEADER_SIZE+((Size+7)&~7); }
+
+public:
+	CLockFreeRingBuffer() { m_pBuffer = 0; m_Size = 0; m_Read = 0; m_Write = 0; m_NextWrite = 0; }
+
+	// size has to be a multiple of 8
+	void Init(void *pMemory, int Size);
+
+	// producer side. space for an item, 0 when full. the item only becomes
+	// visible to the consumer on Commit
+	void *Allocate(int Size);
+	void Commit();
+	// largest item that surely fits
+	int Free() const;
+
+	// consumer side. the oldest item, 0 when empty
+	void *Peek(int *pSize);
+	void Pop();
+};
+
 #endif
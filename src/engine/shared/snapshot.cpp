@@ -1,7 +1,8 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "ringbuffer.h"
 #include "snapshot.h"
-#include "compression.h"
+#include "snapshotkernels.h"
 
 // CSnapshot
 
@@ -19,7 +20,7 @@ int CSnapshot::GetItemSize(int Index)
 
 int CSnapshot::GetItemIndex(int Key)
 {
-	// TODO: OPT: this should not be a linear search. very bad
+	// linear, use CSnapshotIndex for repeated lookups
 	for(int i = 0; i < m_NumItems; i++)
 	{
 		if(GetItem(i)->Key() == Key)
@@ -30,17 +31,57 @@ int CSnapshot::GetItemIndex(int Key)
 
 int CSnapshot::Crc()
 {
-	int Crc = 0;
+	if(!m_NumItems)
+		return 0;
+
+	// items are normally stored back to back, then the crc is the sum of all
+	// data with the item keys taken out again
+	unsigned Keys = 0;
+	bool Packed = Offsets()[0] >= 0 && (Offsets()[0]&3) == 0 && (m_DataSize&3) == 0 &&
+		m_DataSize >= Offsets()[m_NumItems-1]+(int)sizeof(CSnapshotItem);
+	for(int i = 0; i < m_NumItems && Packed; i++)
+	{
+		if(i && (Offsets()[i] < Offsets()[i-1]+(int)sizeof(CSnapshotItem) || (Offsets()[i]&3)))
+			Packed = false;
+		Keys += (unsigned)GetItem(i)->Key();
+	}
+
+	if(Packed)
+	{
+		const int *pData = (const int *)(DataStart()+Offsets()[0]);
+		return (int)((unsigned)CSnapshotKernels::Sum(pData, (m_DataSize-Offsets()[0])/4) - Keys);
+	}
 
+	unsigned Crc = 0;
 	for(int i = 0; i < m_NumItems; i++)
 	{
-		CSnapshotItem *pItem = GetItem(i);
 		int Size = GetItemSize(i);
+		if(Size > 0)
+			Crc += (unsigned)CSnapshotKernels::Sum(GetItem(i)->Data(), Size/4);
+	}
+	return (int)Crc;
+}
 
-		for(int b = 0; b < Size/4; b++)
-			Crc += pItem->Data()[b];
+unsigned CSnapshot::Hash(int LocalOffset)
+{
+	// murmur3 over the ints, the snapshot is always a multiple of 4 bytes
+	const unsigned *pData = (const unsigned *)this;
+	int Num = Size()/4;
+	unsigned Hash = (unsigned)Num;
+	for(int i = 0; i < Num; i++)
+	{
+		unsigned k = i == LocalOffset/4 && LocalOffset >= 0 ? 0 : pData[i]*0xcc9e2d51;
+		k = (k<<15)|(k>>17);
+		Hash ^= k*0x1b873593;
+		Hash = (Hash<<13)|(Hash>>19);
+		Hash = Hash*5+0xe6546b64;
 	}
-	return Crc;
+	Hash ^= Hash>>16;
+	Hash *= 0x85ebca6b;
+	Hash ^= Hash>>13;
+	Hash *= 0xc2b2ae35;
+	Hash ^= Hash>>16;
+	return Hash;
 }
 
 void CSnapshot::DebugDump()
@@ -57,86 +98,62 @@ void CSnapshot::DebugDump()
 }
 
 
-// CSnapshotDelta
+// CSnapshotIndex
 
-struct CItemList
+void CSnapshotIndex::Clear()
 {
-	int m_Num;
-	int m_aKeys[64];
-	int m_aIndex[64];
-};
+	mem_zero(m_aIndices, sizeof(m_aIndices));
+	m_NumItems = 0;
+	m_pFallback = 0;
+}
 
-enum
+bool CSnapshotIndex::Add(int Key, int Index)
 {
-	HASHLIST_SIZE = 256,
-};
+	if(m_NumItems >= HASH_SIZE/2)
+		return false;
+
+	// linear probing, the first item added with a key is the one found
+	unsigned Slot = Hash(Key);
+	while(m_aIndices[Slot])
+		Slot = (Slot+1)&(HASH_SIZE-1);
+	m_aKeys[Slot] = Key;
+	m_aIndices[Slot] = Index+1;
+	m_NumItems++;
+	return true;
+}
 
-static void GenerateHash(CItemList *pHashlist, CSnapshot *pSnapshot)
+void CSnapshotIndex::Build(CSnapshot *pSnap)
 {
-	for(int i = 0; i < HASHLIST_SIZE; i++)
-		pHashlist[i].m_Num = 0;
-
-	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	Clear();
+	for(int i = 0; i < pSnap->NumItems(); i++)
 	{
-		int Key = pSnapshot->GetItem(i)->Key();
-		int HashID = ((Key>>12)&0xf0) | (Key&0xf);
-		if(pHashlist[HashID].m_Num != 64)
+		if(!Add(pSnap->GetItem(i)->Key(), i))
 		{
-			pHashlist[HashID].m_aIndex[pHashlist[HashID].m_Num] = i;
-			pHashlist[HashID].m_aKeys[pHashlist[HashID].m_Num] = Key;
-			pHashlist[HashID].m_Num++;
+			// more items than a builder creates, only possible with foreign data
+			m_pFallback = pSnap;
+			return;
 		}
 	}
 }
 
-static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
+int CSnapshotIndex::GetItemIndex(int Key) const
 {
-		int HashID = ((Key>>12)&0xf0) | (Key&0xf);
-		for(int i = 0; i < pHashlist[HashID].m_Num; i++)
-		{
-			if(pHashlist[HashID].m_aKeys[i] == Key)
-				return pHashlist[HashID].m_aIndex[i];
-	}
-
-	return -1;
-}
+	if(m_pFallback)
+		return m_pFallback->GetItemIndex(Key);
 
-static int DiffItem(int *pPast, int *pCurrent, int *pOut, int Size)
-{
-	int Needed = 0;
-	while(Size)
+	for(unsigned Slot = Hash(Key); m_aIndices[Slot]; Slot = (Slot+1)&(HASH_SIZE-1))
 	{
-		*pOut = *pCurrent-*pPast;
-		Needed |= *pOut;
-		pOut++;
-		pPast++;
-		pCurrent++;
-		Size--;
+		if(m_aKeys[Slot] == Key)
+			return m_aIndices[Slot]-1;
 	}
-
-	return Needed;
+	return -1;
 }
 
+// CSnapshotDelta
+
 void CSnapshotDelta::UndiffItem(int *pPast, int *pDiff, int *pOut, int Size)
 {
-	while(Size)
-	{
-		*pOut = *pPast+*pDiff;
-
-		if(*pDiff == 0)
-			m_aSnapshotDataRate[m_SnapshotCurrent] += 1;
-		else
-		{
-			unsigned char aBuf[16];
-			unsigned char *pEnd = CVariableInt::Pack(aBuf, *pDiff);
-			m_aSnapshotDataRate[m_SnapshotCurrent] += (int)(pEnd - (unsigned char*)aBuf) * 8;
-		}
-
-		pOut++;
-		pPast++;
-		pDiff++;
-		Size--;
-	}
+	m_aSnapshotDataRate[m_SnapshotCurrent] += CSnapshotKernels::Undiff(pPast, pDiff, pOut, Size);
 }
 
 CSnapshotDelta::CSnapshotDelta()
@@ -174,14 +191,14 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 	pDelta->m_NumUpdateItems = 0;
 	pDelta->m_NumTempItems = 0;
 
-	CItemList Hashlist[HASHLIST_SIZE];
-	GenerateHash(Hashlist, pTo);
+	CSnapshotIndex Index;
+	Index.Build(pTo);
 
 	// pack deleted stuff
 	for(i = 0; i < pFrom->NumItems(); i++)
 	{
 		pFromItem = pFrom->GetItem(i);
-		if(GetItemIndexHashed(pFromItem->Key(), Hashlist) == -1)
+		if(Index.GetItemIndex(pFromItem->Key()) == -1)
 		{
 			// deleted
 			pDelta->m_NumDeletedItems++;
@@ -190,15 +207,15 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 		}
 	}
 
-	GenerateHash(Hashlist, pFrom);
+	Index.Build(pFrom);
 	int aPastIndecies[1024];
 
 	// fetch previous indices
 	// we do this as a separate pass because it helps the cache
 	for(i = 0; i < pTo->NumItems(); i++)
 	{
-		pCurItem = pTo->GetItem(i); // O(1) .. O(n)
-		aPastIndecies[i] = GetItemIndexHashed(pCurItem->Key(), Hashlist); // O(n) .. O(n^n)
+		pCurItem = pTo->GetItem(i);
+		aPastIndecies[i] = Index.GetItemIndex(pCurItem->Key());
 	}
 
 	for(i = 0; i < pTo->NumItems(); i++)
@@ -217,7 +234,7 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 			if(m_aItemSizes[pCurItem->Type()])
 				pItemDataDst = pData+2;
 
-			if(DiffItem((int*)pPastItem->Data(), (int*)pCurItem->Data(), pItemDataDst, ItemSize/4))
+			if(CSnapshotKernels::Diff((int*)pPastItem->Data(), (int*)pCurItem->Data(), pItemDataDst, ItemSize/4))
 			{
 
 				*pData++ = pCurItem->Type();
@@ -289,6 +306,8 @@ int CSnapshotDelta::UnpackDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pSrcData
 	int FromIndex;
 	int *pNewData;
 
+	CSnapshotIndex Index;
+	Index.Build(pFrom);
 	Builder.Init();
 
 	// unpack deleted stuff
@@ -351,7 +370,7 @@ int CSnapshotDelta::UnpackDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pSrcData
 
 		//if(range_check(pEnd, pNewData, ItemSize)) return -4;
 
-		FromIndex = pFrom->GetItemIndex(Key);
+		FromIndex = Index.GetItemIndex(Key);
 		if(FromIndex != -1)
 		{
 			// we got an update so we need pTo apply the diff
@@ -375,10 +394,118 @@ int CSnapshotDelta::UnpackDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pSrcData
 
 // CSnapshotStorage
 
+class CSnapshotArena : public CRingBufferBase
+{
+	int m_Size;
+
+public:
+	static CSnapshotArena *Create(int Size)
+	{
+		CSnapshotArena *pArena = (CSnapshotArena *)mem_alloc(sizeof(CSnapshotArena)+Size, 1);
+		pArena->m_Size = Size;
+		pArena->Reset();
+		return pArena;
+	}
+
+	void Reset() { Init(this+1, m_Size, 0); }
+	int Size() const { return m_Size; }
+	bool Empty() { return First() == 0; }
+
+	void *Allocate(int Size) { return CRingBufferBase::Allocate(Size); }
+	int PopFirst() { return CRingBufferBase::PopFirst(); }
+	void *First() { return CRingBufferBase::First(); }
+};
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = 0;
 	m_pLast = 0;
+	m_pArena = 0;
+	m_pRetiredArena = 0;
+	mem_zero(m_apTickTable, sizeof(m_apTickTable));
+	m_NumHolders = 0;
+	m_UsedSize = 0;
+	m_ReservedSize = 0;
+	m_NumOverflows = 0;
+}
+
+void CSnapshotStorage::Grow(int Size)
+{
+	int NewSize = m_pArena ? m_pArena->Size()*2 : (int)ARENA_MIN_SIZE;
+	while(NewSize < Size*4)
+		NewSize *= 2;
+
+	if(m_pArena)
+	{
+		if(m_pArena->Empty())
+		{
+			m_ReservedSize -= m_pArena->Size();
+			mem_free(m_pArena);
+		}
+		else
+			m_pRetiredArena = m_pArena;
+	}
+
+	m_pArena = CSnapshotArena::Create(NewSize);
+	m_ReservedSize += NewSize;
+}
+
+CSnapshotStorage::CHolder *CSnapshotStorage::AllocHolder(int Size)
+{
+	if(!m_pArena)
+		Grow(Size);
+
+	CHolder *pHolder = (CHolder *)m_pArena->Allocate(Size);
+	if(!pHolder && !m_pRetiredArena)
+	{
+		// the history outgrew the ring, move on to a bigger one
+		Grow(Size);
+		pHolder = (CHolder *)m_pArena->Allocate(Size);
+	}
+
+	if(pHolder)
+		pHolder->m_pArena = m_pArena;
+	else
+	{
+		// still waiting for the old ring to drain
+		pHolder = (CHolder *)mem_alloc(Size, 1);
+		pHolder->m_pArena = 0;
+		m_ReservedSize += Size;
+		m_NumOverflows++;
+	}
+
+	pHolder->m_AllocSize = Size;
+	m_UsedSize += Size;
+	m_NumHolders++;
+	return pHolder;
+}
+
+void CSnapshotStorage::FreeHolder(CHolder *pHolder)
+{
+	if(m_apTickTable[pHolder->m_Tick&TICK_TABLE_MASK] == pHolder)
+		m_apTickTable[pHolder->m_Tick&TICK_TABLE_MASK] = 0;
+
+	m_UsedSize -= pHolder->m_AllocSize;
+	m_NumHolders--;
+
+	CSnapshotArena *pArena = pHolder->m_pArena;
+	if(!pArena)
+	{
+		m_ReservedSize -= pHolder->m_AllocSize;
+		mem_free(pHolder);
+		return;
+	}
+
+	// holders leave in the order they came, so this is always the oldest one of its ring
+	dbg_assert(pArena->First() == pHolder, "snapshot holders freed out of order");
+	pArena->PopFirst();
+
+	if(pArena == m_pRetiredArena && pArena->Empty())
+	{
+		m_ReservedSize -= pArena->Size();
+		mem_free(pArena);
+		m_pRetiredArena = 0;
+	}
 }
 
 void CSnapshotStorage::PurgeAll()
@@ -389,10 +516,14 @@ void CSnapshotStorage::PurgeAll()
 	while(pHolder)
 	{
 		pNext = pHolder->m_pNext;
-		mem_free(pHolder);
+		FreeHolder(pHolder);
 		pHolder = pNext;
 	}
 
+	// start over at the beginning of the ring, the memory is kept for the next snapshots
+	if(m_pArena)
+		m_pArena->Reset();
+
 	// no more snapshots in storage
 	m_pFirst = 0;
 	m_pLast = 0;
@@ -408,7 +539,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 		pNext = pHolder->m_pNext;
 		if(pHolder->m_Tick >= Tick)
 			return; // no more to remove
-		mem_free(pHolder);
+		FreeHolder(pHolder);
 
 		// did we come to the end of the list?
 		if (!pNext)
@@ -430,10 +561,13 @@ void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, i
 	// allocate memory for holder + snapshot_data
 	int TotalSize = sizeof(CHolder)+DataSize;
 
+	// snapshots with an alternative are the ones items get looked up in. the
+	// index has a pointer, so it starts at the next pointer aligned offset
+	int IndexOffset = (DataSize+sizeof(void*)-1)&~(sizeof(void*)-1);
 	if(CreateAlt)
-		TotalSize += DataSize;
+		TotalSize += IndexOffset-DataSize+sizeof(CSnapshotIndex)+DataSize;
 
-	CHolder *pHolder = (CHolder *)mem_alloc(TotalSize, 1);
+	CHolder *pHolder = AllocHolder(TotalSize);
 
 	// set data
 	pHolder->m_Tick = Tick;
@@ -441,14 +575,21 @@ void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, i
 	pHolder->m_SnapSize = DataSize;
 	pHolder->m_pSnap = (CSnapshot*)(pHolder+1);
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
+	pHolder->m_Hash = 0; // only set by the server when sv_snap_cache is on
+	pHolder->m_LocalOffset = -1;
 
 	if(CreateAlt) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = (CSnapshot*)(((char *)pHolder->m_pSnap) + DataSize);
+		pHolder->m_pIndex = (CSnapshotIndex*)(((char *)pHolder->m_pSnap) + IndexOffset);
+		pHolder->m_pIndex->Build(pHolder->m_pSnap);
+		pHolder->m_pAltSnap = (CSnapshot*)(pHolder->m_pIndex+1);
 		mem_copy(pHolder->m_pAltSnap, pData, DataSize);
 	}
 	else
+	{
 		pHolder->m_pAltSnap = 0;
+		pHolder->m_pIndex = 0;
+	}
 
 
 	// link
@@ -459,29 +600,41 @@ void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, i
 	else
 		m_pFirst = pHolder;
 	m_pLast = pHolder;
+
+	m_apTickTable[Tick&TICK_TABLE_MASK] = pHolder;
 }
 
-int CSnapshotStorage::Get(int Tick, int64 *pTagtime, CSnapshot **ppData, CSnapshot **ppAltData)
+CSnapshotStorage::CHolder *CSnapshotStorage::Find(int Tick)
 {
-	CHolder *pHolder = m_pFirst;
+	CHolder *pHolder = m_apTickTable[Tick&TICK_TABLE_MASK];
+	if(pHolder && pHolder->m_Tick == Tick)
+		return pHolder;
 
-	while(pHolder)
+	// only a history longer than the table can have older snapshots that got pushed out of it
+	if(m_pFirst && m_pLast->m_Tick - m_pFirst->m_Tick >= TICK_TABLE_SIZE)
 	{
-		if(pHolder->m_Tick == Tick)
+		for(pHolder = m_pFirst; pHolder; pHolder = pHolder->m_pNext)
 		{
-			if(pTagtime)
-				*pTagtime = pHolder->m_Tagtime;
-			if(ppData)
-				*ppData = pHolder->m_pSnap;
-			if(ppAltData)
-				*ppData = pHolder->m_pAltSnap;
-			return pHolder->m_SnapSize;
+			if(pHolder->m_Tick == Tick)
+				return pHolder;
 		}
-
-		pHolder = pHolder->m_pNext;
 	}
+	return 0;
+}
 
-	return -1;
+int CSnapshotStorage::Get(int Tick, int64 *pTagtime, CSnapshot **ppData, CSnapshot **ppAltData)
+{
+	CHolder *pHolder = Find(Tick);
+	if(!pHolder)
+		return -1;
+
+	if(pTagtime)
+		*pTagtime = pHolder->m_Tagtime;
+	if(ppData)
+		*ppData = pHolder->m_pSnap;
+	if(ppAltData)
+		*ppAltData = pHolder->m_pAltSnap;
+	return pHolder->m_SnapSize;
 }
 
 // CSnapshotBuilder
@@ -490,6 +643,14 @@ void CSnapshotBuilder::Init()
 {
 	m_DataSize = 0;
 	m_NumItems = 0;
+	m_LocalOffset = -1;
+	m_Index.Clear();
+}
+
+void CSnapshotBuilder::SetLocal(int *pValue)
+{
+	dbg_assert((char *)pValue >= m_aData && (char *)pValue < m_aData+m_DataSize, "local value outside of the snapshot");
+	m_LocalOffset = (char *)pValue-m_aData;
 }
 
 CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
@@ -499,13 +660,10 @@ CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 
 int *CSnapshotBuilder::GetItemData(int Key)
 {
-	int i;
-	for(i = 0; i < m_NumItems; i++)
-	{
-		if(GetItem(i)->Key() == Key)
-			return (int *)GetItem(i)->Data();
-	}
-	return 0;
+	int Index = m_Index.GetItemIndex(Key);
+	if(Index == -1)
+		return 0;
+	return (int *)GetItem(Index)->Data();
 }
 
 int CSnapshotBuilder::Finish(void *SpnapData)
@@ -534,6 +692,7 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 
 	mem_zero(pObj, sizeof(CSnapshotItem) + Size);
 	pObj->m_TypeAndID = (Type<<16)|ID;
+	m_Index.Add(pObj->m_TypeAndID, m_NumItems);
 	m_aOffsets[m_NumItems] = m_DataSize;
 	m_DataSize += sizeof(CSnapshotItem) + Size;
 	m_NumItems++;
@@ -40,11 +40,37 @@ public:
 	int GetItemSize(int Index);
 	int GetItemIndex(int Key);
 
+	int Size() const { return sizeof(CSnapshot)+m_NumItems*sizeof(int)+m_DataSize; }
 	int Crc();
+	unsigned Hash(int LocalOffset=-1); // of the whole snapshot, unlike the crc it changes with any byte. the int at LocalOffset counts as 0
 	void DebugDump();
 };
 
 
+// CSnapshotIndex
+
+class CSnapshotIndex
+{
+	enum
+	{
+		HASH_SIZE=2048, // power of two, twice the items a builder can hold
+	};
+
+	int m_aKeys[HASH_SIZE];
+	short m_aIndices[HASH_SIZE]; // item index+1, 0 marks a free slot
+	int m_NumItems;
+	CSnapshot *m_pFallback;
+
+	static unsigned Hash(int Key) { return ((unsigned)Key*2654435761u)>>21; }
+
+public:
+	void Clear();
+	bool Add(int Key, int Index);
+	void Build(CSnapshot *pSnap);
+	int GetItemIndex(int Key) const;
+};
+
+
 // CSnapshotDelta
 
 class CSnapshotDelta
@@ -97,8 +123,22 @@ public:
 		int m_SnapSize;
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+		CSnapshotIndex *m_pIndex;
+		unsigned m_Hash;
+		int m_LocalOffset;
+
+		class CSnapshotArena *m_pArena; // 0 when it had to be allocated on its own
+		int m_AllocSize;
 	};
 
+	enum
+	{
+		// power of two, has to cover the history window in ticks
+		TICK_TABLE_SIZE=256,
+		TICK_TABLE_MASK=TICK_TABLE_SIZE-1,
+
+		ARENA_MIN_SIZE=64*1024,
+	};
 
 	CHolder *m_pFirst;
 	CHolder *m_pLast;
@@ -108,6 +148,29 @@ public:
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64 Tagtime, int DataSize, void *pData, int CreateAlt);
 	int Get(int Tick, int64 *Tagtime, CSnapshot **pData, CSnapshot **ppAltData);
+	CHolder *Find(int Tick);
+
+	int NumSnapshots() const { return m_NumHolders; }
+	int UsedMemory() const { return m_UsedSize; }
+	int ReservedMemory() const { return m_ReservedSize; }
+	int NumOverflows() const { return m_NumOverflows; }
+
+private:
+	// holders are added in tick order and purged from the front, so they live in a ring
+	// that only grows when the history does not fit. the old ring stays until it drained
+	class CSnapshotArena *m_pArena;
+	class CSnapshotArena *m_pRetiredArena;
+
+	CHolder *m_apTickTable[TICK_TABLE_SIZE];
+
+	int m_NumHolders;
+	int m_UsedSize;
+	int m_ReservedSize;
+	int m_NumOverflows;
+
+	CHolder *AllocHolder(int Size);
+	void FreeHolder(CHolder *pHolder);
+	void Grow(int Size);
 };
 
 class CSnapshotBuilder
@@ -122,12 +185,20 @@ class CSnapshotBuilder
 
 	int m_aOffsets[MAX_ITEMS];
 	int m_NumItems;
+	int m_LocalOffset;
+
+	CSnapshotIndex m_Index;
 
 public:
 	void Init();
 
 	void *NewItem(int Type, int ID, int Size);
 
+	// the one int that only this client has, like the local flag of its player
+	void SetLocal(int *pValue);
+	// where that int is in the finished snapshot, -1 if there is none
+	int LocalOffset() const { return m_LocalOffset < 0 ? -1 : (int)sizeof(CSnapshot)+m_NumItems*(int)sizeof(int)+m_LocalOffset; }
+
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
 
@@ -0,0 +1,416 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+
+#include "compression.h"
+#include "snapshotkernels.h"
+
+#if defined(CONF_ARCH_IA32) || defined(CONF_ARCH_AMD64)
+	#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+		#define SNAPKERNELS_X86 1
+		#define TARGET_SSE2 __attribute__((target("sse2")))
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#elif defined(_MSC_VER) && _MSC_VER >= 1800
+		#define SNAPKERNELS_X86 1
+		#define TARGET_SSE2
+		#define TARGET_AVX2
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined(SNAPKERNELS_X86)
+	#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define SNAPKERNELS_NEON 1
+	#include <arm_neon.h>
+#endif
+
+// scalar reference
+
+static int DiffScalar(const int *pPast, const int *pCurrent, int *pOut, int Num)
+{
+	int Needed = 0;
+	while(Num)
+	{
+		*pOut = *pCurrent-*pPast;
+		Needed |= *pOut;
+		pOut++;
+		pPast++;
+		pCurrent++;
+		Num--;
+	}
+
+	return Needed;
+}
+
+static int UndiffScalar(const int *pPast, const int *pDiff, int *pOut, int Num)
+{
+	int Bits = 0;
+	while(Num)
+	{
+		*pOut = *pPast+*pDiff;
+
+		if(*pDiff == 0)
+			Bits += 1;
+		else
+		{
+			unsigned char aBuf[16];
+			unsigned char *pEnd = CVariableInt::Pack(aBuf, *pDiff);
+			Bits += (int)(pEnd - (unsigned char*)aBuf) * 8;
+		}
+
+		pOut++;
+		pPast++;
+		pDiff++;
+		Num--;
+	}
+	return Bits;
+}
+
+static int SumScalar(const int *pData, int Num)
+{
+	unsigned Sum = 0;
+	for(int i = 0; i < Num; i++)
+		Sum += (unsigned)pData[i];
+	return (int)Sum;
+}
+
+// the thresholds where a variable int needs another byte, see CVariableInt::Pack
+enum
+{
+	VARINT_1=(1<<6)-1,
+	VARINT_2=(1<<13)-1,
+	VARINT_3=(1<<20)-1,
+	VARINT_4=(1<<27)-1,
+};
+
+static inline int DiffBits(int Diff)
+{
+	if(Diff == 0)
+		return 1;
+	int Abs = Diff^(Diff>>31);
+	return 8*(1 + (Abs > VARINT_1) + (Abs > VARINT_2) + (Abs > VARINT_3) + (Abs > VARINT_4));
+}
+
+#if defined(SNAPKERNELS_X86)
+
+TARGET_SSE2 static inline int HorizontalSum(__m128i Sum)
+{
+	Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(Sum);
+}
+
+TARGET_SSE2 static int DiffSSE2(const int *pPast, const int *pCurrent, int *pOut, int Num)
+{
+	// most items don't change from snap to snap, find that out without writing anything
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+	{
+		__m128i Equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(pPast+i)), _mm_loadu_si128((const __m128i *)(pCurrent+i)));
+		if(_mm_movemask_epi8(Equal) != 0xffff)
+			break;
+	}
+	if(i+4 > Num)
+	{
+		while(i < Num && pPast[i] == pCurrent[i])
+			i++;
+		if(i == Num)
+			return 0;
+	}
+
+	for(i = 0; i+4 <= Num; i += 4)
+	{
+		__m128i Past = _mm_loadu_si128((const __m128i *)(pPast+i));
+		__m128i Current = _mm_loadu_si128((const __m128i *)(pCurrent+i));
+		_mm_storeu_si128((__m128i *)(pOut+i), _mm_sub_epi32(Current, Past));
+	}
+	for(; i < Num; i++)
+		pOut[i] = pCurrent[i]-pPast[i];
+	return 1;
+}
+
+TARGET_SSE2 static int UndiffSSE2(const int *pPast, const int *pDiff, int *pOut, int Num)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i Varint1 = _mm_set1_epi32(VARINT_1);
+	const __m128i Varint2 = _mm_set1_epi32(VARINT_2);
+	const __m128i Varint3 = _mm_set1_epi32(VARINT_3);
+	const __m128i Varint4 = _mm_set1_epi32(VARINT_4);
+	__m128i Zeros = Zero;
+	__m128i Extra = Zero;
+
+	// comparisons give -1 for true, so subtracting them counts
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+	{
+		__m128i Diff = _mm_loadu_si128((const __m128i *)(pDiff+i));
+		_mm_storeu_si128((__m128i *)(pOut+i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(pPast+i)), Diff));
+
+		__m128i Abs = _mm_xor_si128(Diff, _mm_srai_epi32(Diff, 31));
+		Zeros = _mm_sub_epi32(Zeros, _mm_cmpeq_epi32(Diff, Zero));
+		Extra = _mm_sub_epi32(Extra, _mm_cmpgt_epi32(Abs, Varint1));
+		Extra = _mm_sub_epi32(Extra, _mm_cmpgt_epi32(Abs, Varint2));
+		Extra = _mm_sub_epi32(Extra, _mm_cmpgt_epi32(Abs, Varint3));
+		Extra = _mm_sub_epi32(Extra, _mm_cmpgt_epi32(Abs, Varint4));
+	}
+
+	int Bits = 8*i - 7*HorizontalSum(Zeros) + 8*HorizontalSum(Extra);
+	for(; i < Num; i++)
+	{
+		pOut[i] = pPast[i]+pDiff[i];
+		Bits += DiffBits(pDiff[i]);
+	}
+	return Bits;
+}
+
+TARGET_SSE2 static int SumSSE2(const int *pData, int Num)
+{
+	__m128i Sum = _mm_setzero_si128();
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+		Sum = _mm_add_epi32(Sum, _mm_loadu_si128((const __m128i *)(pData+i)));
+
+	unsigned Result = (unsigned)HorizontalSum(Sum);
+	for(; i < Num; i++)
+		Result += (unsigned)pData[i];
+	return (int)Result;
+}
+
+TARGET_AVX2 static inline int HorizontalSum256(__m256i Sum)
+{
+	return HorizontalSum(_mm_add_epi32(_mm256_castsi256_si128(Sum), _mm256_extracti128_si256(Sum, 1)));
+}
+
+TARGET_AVX2 static int DiffAVX2(const int *pPast, const int *pCurrent, int *pOut, int Num)
+{
+	int i = 0;
+	for(; i+8 <= Num; i += 8)
+	{
+		__m256i Equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(pPast+i)), _mm256_loadu_si256((const __m256i *)(pCurrent+i)));
+		if(_mm256_movemask_epi8(Equal) != -1)
+			break;
+	}
+	if(i+8 > Num)
+	{
+		while(i < Num && pPast[i] == pCurrent[i])
+			i++;
+		if(i == Num)
+			return 0;
+	}
+
+	for(i = 0; i+8 <= Num; i += 8)
+	{
+		__m256i Past = _mm256_loadu_si256((const __m256i *)(pPast+i));
+		__m256i Current = _mm256_loadu_si256((const __m256i *)(pCurrent+i));
+		_mm256_storeu_si256((__m256i *)(pOut+i), _mm256_sub_epi32(Current, Past));
+	}
+	for(; i < Num; i++)
+		pOut[i] = pCurrent[i]-pPast[i];
+	return 1;
+}
+
+TARGET_AVX2 static int UndiffAVX2(const int *pPast, const int *pDiff, int *pOut, int Num)
+{
+	const __m256i Zero = _mm256_setzero_si256();
+	const __m256i Varint1 = _mm256_set1_epi32(VARINT_1);
+	const __m256i Varint2 = _mm256_set1_epi32(VARINT_2);
+	const __m256i Varint3 = _mm256_set1_epi32(VARINT_3);
+	const __m256i Varint4 = _mm256_set1_epi32(VARINT_4);
+	__m256i Zeros = Zero;
+	__m256i Extra = Zero;
+
+	int i = 0;
+	for(; i+8 <= Num; i += 8)
+	{
+		__m256i Diff = _mm256_loadu_si256((const __m256i *)(pDiff+i));
+		_mm256_storeu_si256((__m256i *)(pOut+i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(pPast+i)), Diff));
+
+		__m256i Abs = _mm256_xor_si256(Diff, _mm256_srai_epi32(Diff, 31));
+		Zeros = _mm256_sub_epi32(Zeros, _mm256_cmpeq_epi32(Diff, Zero));
+		Extra = _mm256_sub_epi32(Extra, _mm256_cmpgt_epi32(Abs, Varint1));
+		Extra = _mm256_sub_epi32(Extra, _mm256_cmpgt_epi32(Abs, Varint2));
+		Extra = _mm256_sub_epi32(Extra, _mm256_cmpgt_epi32(Abs, Varint3));
+		Extra = _mm256_sub_epi32(Extra, _mm256_cmpgt_epi32(Abs, Varint4));
+	}
+
+	int Bits = 8*i - 7*HorizontalSum256(Zeros) + 8*HorizontalSum256(Extra);
+	for(; i < Num; i++)
+	{
+		pOut[i] = pPast[i]+pDiff[i];
+		Bits += DiffBits(pDiff[i]);
+	}
+	return Bits;
+}
+
+TARGET_AVX2 static int SumAVX2(const int *pData, int Num)
+{
+	__m256i Sum = _mm256_setzero_si256();
+	int i = 0;
+	for(; i+8 <= Num; i += 8)
+		Sum = _mm256_add_epi32(Sum, _mm256_loadu_si256((const __m256i *)(pData+i)));
+
+	unsigned Result = (unsigned)HorizontalSum256(Sum);
+	for(; i < Num; i++)
+		Result += (unsigned)pData[i];
+	return (int)Result;
+}
+
+static void CpuFeatures(bool *pSSE2, bool *pAVX2)
+{
+#if defined(_MSC_VER)
+	int aInfo[4];
+	__cpuid(aInfo, 0);
+	int MaxLeaf = aInfo[0];
+	__cpuid(aInfo, 1);
+	*pSSE2 = (aInfo[3]&(1<<26)) != 0;
+	bool OsAVX = (aInfo[2]&(1<<27)) && (aInfo[2]&(1<<28)) && (_xgetbv(0)&6) == 6;
+	*pAVX2 = false;
+	if(OsAVX && MaxLeaf >= 7)
+	{
+		__cpuidex(aInfo, 7, 0);
+		*pAVX2 = (aInfo[1]&(1<<5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	*pSSE2 = __builtin_cpu_supports("sse2");
+	*pAVX2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+#if defined(SNAPKERNELS_NEON)
+
+static inline int HorizontalSum(int32x4_t Sum)
+{
+	return vgetq_lane_s32(Sum, 0) + vgetq_lane_s32(Sum, 1) + vgetq_lane_s32(Sum, 2) + vgetq_lane_s32(Sum, 3);
+}
+
+static int DiffNEON(const int *pPast, const int *pCurrent, int *pOut, int Num)
+{
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+	{
+		uint32x4_t Equal = vceqq_s32(vld1q_s32(pPast+i), vld1q_s32(pCurrent+i));
+		uint32x2_t Both = vand_u32(vget_low_u32(Equal), vget_high_u32(Equal));
+		if((vget_lane_u32(Both, 0)&vget_lane_u32(Both, 1)) != 0xffffffffu)
+			break;
+	}
+	if(i+4 > Num)
+	{
+		while(i < Num && pPast[i] == pCurrent[i])
+			i++;
+		if(i == Num)
+			return 0;
+	}
+
+	for(i = 0; i+4 <= Num; i += 4)
+		vst1q_s32(pOut+i, vsubq_s32(vld1q_s32(pCurrent+i), vld1q_s32(pPast+i)));
+	for(; i < Num; i++)
+		pOut[i] = pCurrent[i]-pPast[i];
+	return 1;
+}
+
+static int UndiffNEON(const int *pPast, const int *pDiff, int *pOut, int Num)
+{
+	const int32x4_t Zero = vdupq_n_s32(0);
+	const int32x4_t Varint1 = vdupq_n_s32(VARINT_1);
+	const int32x4_t Varint2 = vdupq_n_s32(VARINT_2);
+	const int32x4_t Varint3 = vdupq_n_s32(VARINT_3);
+	const int32x4_t Varint4 = vdupq_n_s32(VARINT_4);
+	int32x4_t Zeros = Zero;
+	int32x4_t Extra = Zero;
+
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+	{
+		int32x4_t Diff = vld1q_s32(pDiff+i);
+		vst1q_s32(pOut+i, vaddq_s32(vld1q_s32(pPast+i), Diff));
+
+		int32x4_t Abs = veorq_s32(Diff, vshrq_n_s32(Diff, 31));
+		Zeros = vsubq_s32(Zeros, vreinterpretq_s32_u32(vceqq_s32(Diff, Zero)));
+		Extra = vsubq_s32(Extra, vreinterpretq_s32_u32(vcgtq_s32(Abs, Varint1)));
+		Extra = vsubq_s32(Extra, vreinterpretq_s32_u32(vcgtq_s32(Abs, Varint2)));
+		Extra = vsubq_s32(Extra, vreinterpretq_s32_u32(vcgtq_s32(Abs, Varint3)));
+		Extra = vsubq_s32(Extra, vreinterpretq_s32_u32(vcgtq_s32(Abs, Varint4)));
+	}
+
+	int Bits = 8*i - 7*HorizontalSum(Zeros) + 8*HorizontalSum(Extra);
+	for(; i < Num; i++)
+	{
+		pOut[i] = pPast[i]+pDiff[i];
+		Bits += DiffBits(pDiff[i]);
+	}
+	return Bits;
+}
+
+static int SumNEON(const int *pData, int Num)
+{
+	int32x4_t Sum = vdupq_n_s32(0);
+	int i = 0;
+	for(; i+4 <= Num; i += 4)
+		Sum = vaddq_s32(Sum, vld1q_s32(pData+i));
+
+	unsigned Result = (unsigned)HorizontalSum(Sum);
+	for(; i < Num; i++)
+		Result += (unsigned)pData[i];
+	return (int)Result;
+}
+
+#endif
+
+static const CSnapshotKernels::CKernels s_aKernels[CSnapshotKernels::NUM_KERNELS] = {
+	{"scalar", DiffScalar, UndiffScalar, SumScalar},
+#if defined(SNAPKERNELS_X86)
+	{"sse2", DiffSSE2, UndiffSSE2, SumSSE2},
+	{"avx2", DiffAVX2, UndiffAVX2, SumAVX2},
+#else
+	{"sse2", 0, 0, 0},
+	{"avx2", 0, 0, 0},
+#endif
+#if defined(SNAPKERNELS_NEON)
+	{"neon", DiffNEON, UndiffNEON, SumNEON},
+#else
+	{"neon", 0, 0, 0},
+#endif
+};
+
+const CSnapshotKernels::CKernels *CSnapshotKernels::ms_pActive = CSnapshotKernels::Detect();
+
+const CSnapshotKernels::CKernels *CSnapshotKernels::Get(int Kernels)
+{
+	if(Kernels < 0 || Kernels >= NUM_KERNELS || !s_aKernels[Kernels].m_pfnDiff)
+		return 0;
+
+#if defined(SNAPKERNELS_X86)
+	bool SSE2, AVX2;
+	CpuFeatures(&SSE2, &AVX2);
+	if((Kernels == KERNELS_SSE2 && !SSE2) || (Kernels == KERNELS_AVX2 && !AVX2))
+		return 0;
+#endif
+	return &s_aKernels[Kernels];
+}
+
+bool CSnapshotKernels::Select(int Kernels)
+{
+	const CKernels *pKernels = Get(Kernels);
+	if(!pKernels)
+		return false;
+	ms_pActive = pKernels;
+	return true;
+}
+
+const CSnapshotKernels::CKernels *CSnapshotKernels::Detect()
+{
+	static const int s_aPreferred[] = {KERNELS_AVX2, KERNELS_SSE2, KERNELS_NEON};
+	for(unsigned i = 0; i < sizeof(s_aPreferred)/sizeof(s_aPreferred[0]); i++)
+	{
+		const CKernels *pKernels = Get(s_aPreferred[i]);
+		if(pKernels)
+			return pKernels;
+	}
+	return &s_aKernels[KERNELS_SCALAR];
+}
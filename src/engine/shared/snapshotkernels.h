@@ -0,0 +1,51 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_SNAPSHOTKERNELS_H
+#define ENGINE_SHARED_SNAPSHOTKERNELS_H
+
+/*
+	Class: Snapshot kernels
+		The int loops of the snapshot delta code. The scalar versions are
+		the reference, vectorized ones are picked at runtime depending on
+		what the cpu supports and have to give the exact same results.
+*/
+class CSnapshotKernels
+{
+public:
+	enum
+	{
+		KERNELS_SCALAR=0,
+		KERNELS_SSE2,
+		KERNELS_AVX2,
+		KERNELS_NEON,
+		NUM_KERNELS
+	};
+
+	struct CKernels
+	{
+		const char *m_pName;
+
+		// pOut = pCurrent-pPast, returns 0 when nothing changed (pOut is undefined then)
+		int (*m_pfnDiff)(const int *pPast, const int *pCurrent, int *pOut, int Num);
+
+		// pOut = pPast+pDiff, returns the size of the diff as variable ints in bits (1 for a zero)
+		int (*m_pfnUndiff)(const int *pPast, const int *pDiff, int *pOut, int Num);
+
+		// wrapping sum of all ints
+		int (*m_pfnSum)(const int *pData, int Num);
+	};
+
+	static const CKernels *Get(int Kernels); // 0 when not available on this cpu
+	static const CKernels *Active() { return ms_pActive; }
+	static bool Select(int Kernels);
+
+	static int Diff(const int *pPast, const int *pCurrent, int *pOut, int Num) { return ms_pActive->m_pfnDiff(pPast, pCurrent, pOut, Num); }
+	static int Undiff(const int *pPast, const int *pDiff, int *pOut, int Num) { return ms_pActive->m_pfnUndiff(pPast, pDiff, pOut, Num); }
+	static int Sum(const int *pData, int Num) { return ms_pActive->m_pfnSum(pData, Num); }
+
+private:
+	static const CKernels *Detect();
+	static const CKernels *ms_pActive;
+};
+
+#endif
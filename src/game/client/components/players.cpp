@@ -939,8 +939,118 @@ void CPlayers::RenderPlayer(
 	m_pClient->m_aClients[pInfo.m_ClientID].m_LastPos = Position;
 }
 
+void CPlayers::RenderNpc(const CNetObj_Npc *pPrev, const CNetObj_Npc *pCur)
+{
+	// the skin goes with the kind, there is no client info behind them
+	static const char *s_apSkins[] = { "x_teeper", "x_zombitee", "x_skeletee", "x_spidertee", "x_teecow", "x_teepig" };
+	int Skin = m_pClient->m_pSkins->Find(s_apSkins[clamp(pCur->m_Type-TEAM_ENEMY_TEEPER, 0, 5)]);
+	if(Skin == -1)
+		Skin = max(0, m_pClient->m_pSkins->Find("default"));
+
+	CTeeRenderInfo RenderInfo;
+	RenderInfo.m_Texture = m_pClient->m_pSkins->Get(Skin)->m_OrgTexture;
+	RenderInfo.m_Size = 64.0f;
+
+	float IntraTick = Client()->IntraGameTick();
+	float Angle = mix((float)pPrev->m_Angle, (float)pCur->m_Angle, IntraTick)/256.0f;
+	vec2 Direction = GetDirection((int)(Angle*256.0f));
+	vec2 Position = mix(vec2(pPrev->m_X, pPrev->m_Y), vec2(pCur->m_X, pCur->m_Y), IntraTick);
+	vec2 Vel = mix(vec2(pPrev->m_VelX/256.0f, pPrev->m_VelY/256.0f), vec2(pCur->m_VelX/256.0f, pCur->m_VelY/256.0f), IntraTick);
+	RenderInfo.m_GotAirJump = pCur->m_Jumped&2?0:1;
+
+	bool Stationary = pCur->m_VelX <= 1 && pCur->m_VelX >= -1;
+	bool InAir = !Collision()->CheckPoint(pCur->m_X, pCur->m_Y+16);
+	bool WantOtherDir = (pCur->m_Direction == -1 && Vel.x > 0) || (pCur->m_Direction == 1 && Vel.x < 0);
+
+	// evaluate animation
+	float WalkTime = fmod(absolute(Position.x), 100.0f)/100.0f;
+	CAnimState State;
+	State.Set(&g_pData->m_aAnimations[ANIM_BASE], 0);
+
+	if(InAir)
+		State.Add(&g_pData->m_aAnimations[ANIM_INAIR], 0, 1.0f);
+	else if(Stationary)
+		State.Add(&g_pData->m_aAnimations[ANIM_IDLE], 0, 1.0f);
+	else if(!WantOtherDir)
+		State.Add(&g_pData->m_aAnimations[ANIM_WALK], WalkTime, 1.0f);
+
+	if(pCur->m_Weapon == WEAPON_HAMMER)
+	{
+		float ct = (Client()->PrevGameTick()-pCur->m_AttackTick)/(float)SERVER_TICK_SPEED + Client()->GameTickTime();
+		State.Add(&g_pData->m_aAnimations[ANIM_HAMMER_SWING], clamp(ct*5.0f,0.0f,1.0f), 1.0f);
+	}
+
+	// draw the weapon, the teeper holds its tnt block like a player would
+	if(pCur->m_Weapon >= NUM_WEAPONS)
+	{
+		if(Layers()->MineTeeLayer())
+		{
+			Graphics()->TextureSet(m_pClient->m_pMapimages->Get(Layers()->MineTeeLayer()->m_Image));
+			vec2 p = Position + vec2(State.GetAttach()->m_X, State.GetAttach()->m_Y);
+			p.y -= 16.0f;
+			if(Direction.x < 0)
+				p.x -= 46.0f;
+			else
+				p.x += 12.0f;
+			RenderTools()->RenderTile(pCur->m_Weapon-NUM_WEAPONS, p, 32.0f, 1.0f, 0.0f);
+		}
+	}
+	else
+	{
+		Graphics()->TextureSet(g_pData->m_aImages[IMAGE_GAME].m_Id);
+		Graphics()->QuadsBegin();
+		Graphics()->QuadsSetRotation(State.GetAttach()->m_Angle*pi*2+Angle);
+
+		int iw = clamp(pCur->m_Weapon, 0, NUM_WEAPONS-1);
+		RenderTools()->SelectSprite(g_pData->m_Weapons.m_aId[iw].m_pSpriteBody, Direction.x < 0 ? SPRITE_FLAG_FLIP_Y : 0);
+
+		vec2 p;
+		if(pCur->m_Weapon == WEAPON_HAMMER)
+		{
+			p = Position + vec2(State.GetAttach()->m_X, State.GetAttach()->m_Y);
+			p.y += g_pData->m_Weapons.m_aId[iw].m_Offsety;
+			if(Direction.x < 0)
+			{
+				Graphics()->QuadsSetRotation(-pi/2-State.GetAttach()->m_Angle*pi*2);
+				p.x -= g_pData->m_Weapons.m_aId[iw].m_Offsetx;
+			}
+			else
+				Graphics()->QuadsSetRotation(-pi/2+State.GetAttach()->m_Angle*pi*2);
+		}
+		else
+		{
+			float Recoil = 0.0f;
+			float a = (Client()->GameTick()-pCur->m_AttackTick+IntraTick)/5.0f;
+			if(a < 1)
+				Recoil = sinf(a*pi);
+			p = Position + Direction * g_pData->m_Weapons.m_aId[iw].m_Offsetx - Direction*Recoil*10.0f;
+			p.y += g_pData->m_Weapons.m_aId[iw].m_Offsety;
+		}
+		RenderTools()->DrawSprite(p.x, p.y, g_pData->m_Weapons.m_aId[iw].m_VisualSize);
+		Graphics()->QuadsEnd();
+
+		if(pCur->m_Weapon == WEAPON_GRENADE)
+			RenderHand(&RenderInfo, p, Direction, -pi/2, vec2(-4, 7));
+	}
+
+	RenderTools()->RenderTee(&State, &RenderInfo, pCur->m_Emote, Direction, Position);
+}
+
 void CPlayers::OnRender()
 {
+	// the monsters and animals go behind the players
+	int NumItems = Client()->SnapNumItems(IClient::SNAP_CURRENT);
+	for(int i = 0; i < NumItems; i++)
+	{
+		IClient::CSnapItem Item;
+		const void *pData = Client()->SnapGetItem(IClient::SNAP_CURRENT, i, &Item);
+		if(Item.m_Type != NETOBJTYPE_NPC)
+			continue;
+
+		const void *pPrev = Client()->SnapFindItem(IClient::SNAP_PREV, Item.m_Type, Item.m_ID);
+		RenderNpc(pPrev ? (const CNetObj_Npc *)pPrev : (const CNetObj_Npc *)pData, (const CNetObj_Npc *)pData);
+	}
+
 	// render other players in two passes, first pass we render the other, second pass we render our self
 	for(int p = 0; p < 4; p++)
 	{
@@ -22,6 +22,7 @@ class CPlayers : public CComponent
 		const CNetObj_PlayerInfo *pPrevInfo,
 		const CNetObj_PlayerInfo *pPlayerInfo
 	);
+	void RenderNpc(const CNetObj_Npc *pPrev, const CNetObj_Npc *pCur);
 
     //H-Client
     struct PLAYERSTATE
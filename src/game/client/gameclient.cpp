@@ -606,6 +606,36 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker)
 		m_Tuning = NewTuning;
 		return;
 	}
+    else if(MsgId == NETMSGTYPE_SV_TILECHANGEBATCH)
+    {
+        // runs of tile changes, see CGameContext::FlushTileChanges
+        int Width = Collision()->GetWidth();
+        int Height = Collision()->GetHeight();
+        int NumRuns = pUnpacker->GetInt();
+        int Key = 0;
+        for (int r=0; r<NumRuns; r++)
+        {
+            Key += pUnpacker->GetInt();
+            int Length = pUnpacker->GetInt();
+            int Value = pUnpacker->GetInt();
+            if (pUnpacker->Error() || Key < 0 || Length < 0 || Key+Length > Width*Height*3)
+                return;
+
+            for (int i=0; i<Length; i++, Key++)
+            {
+                int State = Key/(Width*Height);
+                vec2 Pos = vec2(Key%Width, (Key/Width)%Height);
+                if (Value == 0)
+                {
+                    Layers()->DestroyTile(Pos);
+                    m_pEffects->BlockDestroy(vec2(Pos.x*32.0f, Pos.y*32.0f));
+                }
+                else
+                    Layers()->CreateTile(Pos, (Value&511)-1, Value>>9, State);
+            }
+        }
+        return;
+    }
     else if(MsgId == NETMSGTYPE_SV_TILECHANGEEXT)
     {
         CServerInfo sInfo;
@@ -13,7 +13,6 @@
 #include <game/collision.h>
 
 #include <game/server/entities/pickup.h> //H-Client
-#include <deque>
 
 CCollision::CCollision()
 {
@@ -25,6 +24,8 @@ CCollision::CCollision()
     m_pMineTeeTiles = 0x0;
     m_pSecBlocks = 0x0;
 	m_pFront = 0x0;
+	m_pfnTileChanged = 0;
+	m_pTileChangedUserData = 0;
 }
 
 void CCollision::Init(class CLayers *pLayers)
@@ -336,19 +337,11 @@ int CCollision::DestroyTile(vec2 Pos)
     int Index = static_cast<int>(Pos.y*m_Width+Pos.x);
     m_pTiles[Index].m_Flags = 0x0;
     m_pTiles[Index].m_Index = 0;
+    if (m_pfnTileChanged)
+        m_pfnTileChanged(static_cast<int>(Pos.x), static_cast<int>(Pos.y), m_pTileChangedUserData);
 
     //Buffer it
-    CNetMsg_Sv_TileChangeExt TileChange;
-    TileChange.m_Index = -1;
-    TileChange.m_Size = -1;
-    TileChange.m_Act = TILE_DESTROY;
-    TileChange.m_X = static_cast<int>(Pos.x);
-    TileChange.m_Y = static_cast<int>(Pos.y);
-    TileChange.m_ITile = 0;
-    TileChange.m_State = 0;
-
-    if (!CheckTileChangeBuffer(TileChange))
-        m_pLayers->m_BuffNetTileChange.push_back(TileChange);
+    StoreTileDiff(static_cast<int>(Pos.x), static_cast<int>(Pos.y), 0, TILE_DESTROY, 0, 0);
 
     return LIndex;
 }
@@ -389,51 +382,22 @@ void CCollision::CreateTile(vec2 Pos, int ITile, int Type, int State)
     int Index = Pos.y*m_pLayers->MineTeeLayer()->m_Width+Pos.x;
     m_pTiles[Index].m_Flags = 0x0;
     m_pTiles[Index].m_Index = Type;
+    if (m_pfnTileChanged)
+        m_pfnTileChanged(static_cast<int>(Pos.x), static_cast<int>(Pos.y), m_pTileChangedUserData);
 
     //Buffer it
-    CNetMsg_Sv_TileChangeExt TileChange;
-    TileChange.m_Size = -1;
-    TileChange.m_Index = -1;
-    TileChange.m_Act = TILE_CREATE;
-    TileChange.m_X = static_cast<int>(Pos.x);
-    TileChange.m_Y = static_cast<int>(Pos.y);
-    TileChange.m_ITile = ITile;
-    if (Type&CCollision::COLFLAG_SOLID)
-        TileChange.m_Col = 1;
-    else
-        TileChange.m_Col = 0;
-
-    TileChange.m_State = State;
-
-    if (!CheckTileChangeBuffer(TileChange))
-        m_pLayers->m_BuffNetTileChange.push_back(TileChange);
+    StoreTileDiff(static_cast<int>(Pos.x), static_cast<int>(Pos.y), State, TILE_CREATE, ITile, (Type&CCollision::COLFLAG_SOLID)?1:0);
 }
 
-bool CCollision::CheckTileChangeBuffer(CNetMsg_Sv_TileChangeExt tile)
+void CCollision::StoreTileDiff(int x, int y, int State, int Act, int ITile, int Col)
 {
-    bool delNetTile=false;
-    bool found=false;
-    std::deque<CNetMsg_Sv_TileChangeExt>::iterator it = m_pLayers->m_BuffNetTileChange.begin();
-    while(it != m_pLayers->m_BuffNetTileChange.end())
+    // a tile that was changed before and is back like in the map needs no diff anymore
+    if (m_pLayers->m_TileDiffs.Set(x, y, State, Act, ITile, Col))
     {
-        CNetMsg_Sv_TileChangeExt *TileExt = static_cast<CNetMsg_Sv_TileChangeExt*>(&(*it));
-        if (TileExt->m_X == tile.m_X && TileExt->m_Y == tile.m_Y && TileExt->m_State == tile.m_State)
-        {
-            m_pLayers->m_BuffNetTileChange.erase(it);
-
-            int index=tile.m_Y*m_Width+tile.m_X;
-            if (tile.m_Act == TILE_CREATE && m_pLayers->MineTeeOrigin()[index].m_Index == tile.m_ITile)
-                return true;
-            else if (tile.m_Act == TILE_DESTROY && m_pLayers->MineTeeOrigin()[index].m_Index == 0)
-                return true;
-
-            return false;
-        }
-        else
-            it++;
+        int Origin = m_pLayers->MineTeeOrigin()[y*m_Width+x].m_Index;
+        if ((Act == TILE_CREATE && Origin == ITile) || (Act == TILE_DESTROY && Origin == 0))
+            m_pLayers->m_TileDiffs.Remove(x, y, State);
     }
-
-    return false;
 }
 
 int CCollision::GetMineTeeBlockAt(int x, int y)
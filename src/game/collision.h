@@ -20,7 +20,14 @@ class CCollision
 	bool IsTileSolid(int x, int y, bool nocoll);
 	int GetTile(int x, int y);
 
-	bool CheckTileChangeBuffer(CNetMsg_Sv_TileChangeExt tile); //H-Client
+	void StoreTileDiff(int x, int y, int State, int Act, int ITile, int Col); //H-Client
+
+public:
+	typedef void (*FTileChanged)(int x, int y, void *pUserData);
+
+private:
+	FTileChanged m_pfnTileChanged;
+	void *m_pTileChangedUserData;
 
 public:
     int *m_pSecBlocks; //H-Client
@@ -56,6 +63,9 @@ public:
 	bool TileExistsNext(int Index);
 	int IsThrough(int x, int y);
 	int GetMineTeeBlockAt(int x, int y);
+
+	// called after DestroyTile and CreateTile changed a tile
+	void SetTileChangedCallback(FTileChanged pfnCallback, void *pUserData) { m_pfnTileChanged = pfnCallback; m_pTileChangedUserData = pUserData; }
 };
 
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *Ox, int *Oy); //H-Client: DDRace
@@ -26,7 +26,7 @@ CLayers::CLayers()
 
 void CLayers::Init(class IKernel *pKernel)
 {
-    m_BuffNetTileChange.clear(); //H-Client
+    m_TileDiffs.Init(0, 0); //H-Client
 
     //TODO: Need be change to free memory
 	m_pGameGroup = 0;
@@ -71,6 +71,7 @@ void CLayers::Init(class IKernel *pKernel)
 					m_pMineTeeOrigin = static_cast<CTile*>(mem_alloc(memSize, 1));
 					CTile *pMTiles = (CTile *)m_pMap->GetData(m_pMineTeeLayer->m_Data);
 					mem_copy(m_pMineTeeOrigin, pMTiles, memSize);
+					m_TileDiffs.Init(m_pMineTeeLayer->m_Width, m_pMineTeeLayer->m_Height);
 				}
                 else if(!m_pMineTeeLights && str_comp_nocase(layerName, "mt-light") == 0)
                 {
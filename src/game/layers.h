@@ -8,7 +8,7 @@
 #include <base/math.h>
 #include <base/vmath.h>
 #include <game/generated/protocol.h>
-#include <deque>
+#include <game/tilediff.h>
 
 class CLayers
 {
@@ -38,7 +38,7 @@ public:
 	CMapItemLayer *GetLayer(int Index) const;
 
     //H-Client
-    std::deque<CNetMsg_Sv_TileChangeExt> m_BuffNetTileChange;
+    CTileDiffStore m_TileDiffs; // changes since the map loaded, for the clients that join later
     CMapItemLayerTilemap *Lights() const { return m_pMineTeeLights; };
     CTile *TileLights() const { return m_pMineTeeLightsTiles; };
     CMapItemLayerTilemap *MineTeeLayer() const { return m_pMineTeeLayer; };
@@ -1,16 +0,0 @@
-/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
-/* If you are missing that file, acquire a complete release at teeworlds.com.                */
-#ifndef GAME_SERVER_PLAYER_H
-#define GAME_SERVER_PLAYER_H
-
-// this include should perhaps be removed
-#include "entities/character.h"
-#include "gamecontext.h"
-#include "player.h"
-
-// bot object
-class CBot : public CPlayer
-{
-public:
-
-}
@@ -0,0 +1,38 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_CLIENTMASK_H
+#define GAME_SERVER_CLIENTMASK_H
+
+#include <engine/shared/protocol.h>
+
+// one bit per client id, the ids go past what fits into an int
+class CClientMask
+{
+	enum
+	{
+		NUM_WORDS=(MAX_CLIENTS+31)/32,
+	};
+
+	unsigned m_aWords[NUM_WORDS];
+
+public:
+	void Clear() { for(int i = 0; i < NUM_WORDS; i++) m_aWords[i] = 0; }
+	void SetAll() { for(int i = 0; i < NUM_WORDS; i++) m_aWords[i] = ~0u; }
+	void Set(int ClientID) { m_aWords[ClientID>>5] |= 1u<<(ClientID&31); }
+	void Unset(int ClientID) { m_aWords[ClientID>>5] &= ~(1u<<(ClientID&31)); }
+	bool IsSet(int ClientID) const { return (m_aWords[ClientID>>5]&(1u<<(ClientID&31))) != 0; }
+
+	CClientMask &operator|=(const CClientMask &Other)
+	{
+		for(int i = 0; i < NUM_WORDS; i++)
+			m_aWords[i] |= Other.m_aWords[i];
+		return *this;
+	}
+};
+
+inline CClientMask CmaskAll() { CClientMask Mask; Mask.SetAll(); return Mask; }
+inline CClientMask CmaskOne(int ClientID) { CClientMask Mask; Mask.Clear(); Mask.Set(ClientID); return Mask; }
+inline CClientMask CmaskAllExceptOne(int ClientID) { CClientMask Mask; Mask.SetAll(); Mask.Unset(ClientID); return Mask; }
+inline bool CmaskIsSet(const CClientMask &Mask, int ClientID) { return Mask.IsSet(ClientID); }
+
+#endif
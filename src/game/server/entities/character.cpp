@@ -3,6 +3,7 @@
 #include <new>
 #include <engine/serverbrowser.h> //H-Client
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <game/server/gamecontext.h>
 #include <game/mapitems.h>
 #include <game/layers.h>
@@ -11,6 +12,7 @@
 #include "laser.h"
 #include "projectile.h"
 #include "pickup.h"
+#include "npc.h"
 
 //input count
 struct CInputCount
@@ -49,17 +51,6 @@ CCharacter::CCharacter(CGameWorld *pWorld)
 	m_Health = 0;
 	m_Armor = 0;
 
-    m_BotDir = 1;
-    m_BotLastPos = m_Pos;
-    m_BotLastStuckTime = 0.0f;
-    m_BotStuckCount = 0;
-    m_BotTimePlayerFound = Server()->Tick();
-    m_BotTimeGrounded = Server()->Tick();
-    m_BotTimeLastOption = Server()->Tick();
-    m_BotTimeLastDamage = 0.0f;
-    m_BotClientIDFix = -1;
-    m_BotTimeLastSound = Server()->Tick();
-
     //H-Client
     m_NeedSendInventory = true;
 	TimerFluidDamage = Server()->Tick();
@@ -92,7 +83,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	m_QueuedWeapon = -1;
 
 	m_pPlayer = pPlayer;
-	m_Pos = Pos;
+	SetPos(Pos);
 
 	m_Core.Reset();
 	m_Core.Init(&GameServer()->m_World.m_Core, GameServer()->Collision());
@@ -222,6 +213,26 @@ void CCharacter::HandleNinja()
 
 				aEnts[i]->TakeDamage(vec2(0, -10.0f), g_pData->m_Weapons.m_Ninja.m_pBase->m_Damage, m_pPlayer->GetCID(), WEAPON_NINJA);
 			}
+
+			CNpc *apNpcs[MAX_CLIENTS];
+			Num = GameServer()->m_World.FindEntities(Center, Radius, (CEntity**)apNpcs, MAX_CLIENTS, CGameWorld::ENTTYPE_NPC);
+			for (int i = 0; i < Num; ++i)
+			{
+				bool bAlreadyHit = false;
+				for (int j = 0; j < m_NumObjectsHit; j++)
+				{
+					if (m_apHitObjects[j] == apNpcs[i])
+						bAlreadyHit = true;
+				}
+				if (bAlreadyHit || distance(apNpcs[i]->m_Pos, m_Pos) > (m_ProximityRadius * 2.0f))
+					continue;
+
+				GameServer()->CreateSound(apNpcs[i]->m_Pos, SOUND_NINJA_HIT);
+				if(m_NumObjectsHit < 10)
+					m_apHitObjects[m_NumObjectsHit++] = apNpcs[i];
+
+				apNpcs[i]->TakeDamage(vec2(0, -10.0f), g_pData->m_Weapons.m_Ninja.m_pBase->m_Damage, m_pPlayer->GetCID(), WEAPON_NINJA);
+			}
 		}
 
 		return;
@@ -360,16 +371,7 @@ void CCharacter::Construct()
             if (pMTTiles[Index].m_Index != 0 || pMTBGTiles[Index].m_Index == ActiveBlock)
                 return;
 
-            CNetMsg_Sv_TileChangeExt TileInfo;
-            TileInfo.m_Index = -1;
-            TileInfo.m_Size = -1;
-            TileInfo.m_X = TilePos.x;
-            TileInfo.m_Y = TilePos.y;
-            TileInfo.m_ITile = (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock;
-            TileInfo.m_Act = TILE_CREATE;
-            TileInfo.m_State = 1;
-
-            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+            GameServer()->SendTileChange(TilePos.x, TilePos.y, TILE_CREATE, (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock, 0, 1);
             GameServer()->Collision()->CreateTile(vec2(TilePos.x*32, TilePos.y*32), (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock, 0, 1);
             GameServer()->CreateSound(m_Pos, SOUND_DESTROY_BLOCK);
 
@@ -387,17 +389,7 @@ void CCharacter::Construct()
             if (pMTTiles[Index].m_Index != 0 || pMTFGTiles[Index].m_Index == ActiveBlock)
                 return;
 
-            CNetMsg_Sv_TileChangeExt TileInfo;
-            TileInfo.m_Index = -1;
-            TileInfo.m_Size = -1;
-            TileInfo.m_X = TilePos.x;
-            TileInfo.m_Y = TilePos.y;
-            TileInfo.m_ITile = (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock;
-            TileInfo.m_Col = false;
-            TileInfo.m_Act = TILE_CREATE;
-            TileInfo.m_State = 2;
-
-            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+            GameServer()->SendTileChange(TilePos.x, TilePos.y, TILE_CREATE, (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock, 0, 2);
             GameServer()->Collision()->CreateTile(vec2(TilePos.x*32, TilePos.y*32), (m_ActiveWeapon == WEAPON_HAMMER)?0:ActiveBlock, 0, 1);
             GameServer()->CreateSound(m_Pos, SOUND_DESTROY_BLOCK);
 
@@ -430,12 +422,9 @@ void CCharacter::Construct()
             TileInfo.m_State = 0;
 
             //Check player stuck
-            for (int i=0; i<MAX_CLIENTS; i++)
+            for (int i=0; i<GameServer()->m_NumPlayerIDs; i++)
             {
-                if (!GameServer()->m_apPlayers[i])
-                    continue;
-
-                CCharacter *pChar = GameServer()->m_apPlayers[i]->GetCharacter();
+                CCharacter *pChar = GameServer()->m_apPlayers[GameServer()->m_aPlayerIDs[i]]->GetCharacter();
                 if (!pChar || !pChar->IsAlive())
                     continue;
 
@@ -479,7 +468,7 @@ void CCharacter::Construct()
 
             if (distance(m_Pos, finishPosPost) >= 42.0f)
             {
-                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                GameServer()->SendTileChange(TileInfo.m_X, TileInfo.m_Y, TileInfo.m_Act, TileInfo.m_ITile, TileInfo.m_Col, TileInfo.m_State);
                 if (ActiveBlock == BLOCK_SEEDM)
                     GameServer()->Collision()->CreateTile(finishPosPost, BLOCK_SEED1, 0, 0);
                 else
@@ -577,7 +566,7 @@ void CCharacter::FireWeapon()
                     if (GameServer()->Collision()->GetCollisionAt(finishPosPost.x, finishPosPost.y) == CCollision::COLFLAG_SOLID)
                     {
                         int Index = (int)(finishPosPost.x/32) + (int)(finishPosPost.y/32) * GameServer()->Collision()->GetWidth();
-                        if (str_comp_nocase(GameServer()->GameType(), "MineTee") == 0 && GetPlayer()->GetCID() < MAX_CLIENTS-MAX_BOTS && GameServer()->Collision()->m_pSecBlocks[Index] != -1 && GameServer()->Collision()->m_pSecBlocks[Index] != GetPlayer()->GetCID())
+                        if (str_comp_nocase(GameServer()->GameType(), "MineTee") == 0 && GameServer()->Collision()->m_pSecBlocks[Index] != -1 && GameServer()->Collision()->m_pSecBlocks[Index] != GetPlayer()->GetCID())
                         {
                             char aBuf[128];
                             str_format(aBuf, sizeof(aBuf), "** You can't detroy this block... contact with '%s' or wait until he leaves.", Server()->ClientName(GameServer()->Collision()->m_pSecBlocks[Index]));
@@ -588,14 +577,9 @@ void CCharacter::FireWeapon()
                             int TIndex = -1;
                             if ((TIndex = GameServer()->Collision()->DestroyTile(finishPosPost)) > 0)
                             {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = static_cast<int>(finishPosPost.x/32.0f);
-                                TileInfo.m_Y = static_cast<int>(finishPosPost.y/32.0f);
-                                TileInfo.m_Act = TILE_DESTROY;
                                 GameServer()->CreateSound(m_Pos, SOUND_DESTROY_BLOCK);
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                                ivec2 TilePos(static_cast<int>(finishPosPost.x/32.0f), static_cast<int>(finishPosPost.y/32.0f));
+                                GameServer()->SendTileChange(TilePos.x, TilePos.y, TILE_DESTROY, 0, 0, 0);
 
                                 if (str_comp_nocase(GameServer()->GameType(), "MineTee") == 0)
                                 {
@@ -622,7 +606,7 @@ void CCharacter::FireWeapon()
                                             TIndex = BLOCK_DIAMANTEP;
 
                                         CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, TIndex);
-                                        pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
+                                        pPickup->SetPos(vec2(TilePos.x*32.0f + 8.0f, TilePos.y*32.0f + 8.0f));
                                     }
                                 }
                             }
@@ -662,6 +646,32 @@ void CCharacter::FireWeapon()
                 Hits++;
             }
 
+            CNpc *apNpcs[MAX_CLIENTS];
+            Num = GameServer()->m_World.FindEntities(ProjStartPos, m_ProximityRadius*0.5f, (CEntity**)apNpcs,
+                                                        MAX_CLIENTS, CGameWorld::ENTTYPE_NPC);
+
+            for (int i = 0; i < Num; ++i)
+            {
+                CNpc *pTarget = apNpcs[i];
+                if (GameServer()->Collision()->IntersectLine(ProjStartPos, pTarget->m_Pos, NULL, NULL))
+                    continue;
+
+                if(length(pTarget->m_Pos-ProjStartPos) > 0.0f)
+                    GameServer()->CreateHammerHit(pTarget->m_Pos-normalize(pTarget->m_Pos-ProjStartPos)*m_ProximityRadius*0.5f);
+                else
+                    GameServer()->CreateHammerHit(ProjStartPos);
+
+                vec2 Dir;
+                if (length(pTarget->m_Pos - m_Pos) > 0.0f)
+                    Dir = normalize(pTarget->m_Pos - m_Pos);
+                else
+                    Dir = vec2(0.f, -1.f);
+
+                pTarget->TakeDamage(vec2(0.f, -1.f) + normalize(Dir + vec2(0.f, -1.1f)) * 10.0f, g_pData->m_Weapons.m_Hammer.m_pBase->m_Damage,
+                    m_pPlayer->GetCID(), m_ActiveWeapon);
+                Hits++;
+            }
+
 
             // if we Hit anything, we have to wait for the reload
             if(Hits)
@@ -900,10 +910,6 @@ void CCharacter::ResetInput()
 
 void CCharacter::Tick()
 {
-	//BotsIA
-	if (m_pPlayer->GetTeam() > TEAM_BLUE)
-        BotIA();
-
 	if(m_pPlayer->m_ForceBalanced)
 	{
 		char Buf[128];
@@ -985,7 +991,7 @@ void CCharacter::TickDefered()
 	bool StuckAfterMove = GameServer()->Collision()->TestBox(m_Core.m_Pos, vec2(28.0f, 28.0f));
 	m_Core.Quantize();
 	bool StuckAfterQuant = GameServer()->Collision()->TestBox(m_Core.m_Pos, vec2(28.0f, 28.0f));
-	m_Pos = m_Core.m_Pos;
+	SetPos(m_Core.m_Pos);
 
 	if(!StuckBefore && (StuckAfterMove || StuckAfterQuant))
 	{
@@ -1014,7 +1020,7 @@ void CCharacter::TickDefered()
 	}
 
 	int Events = m_Core.m_TriggeredEvents;
-	int Mask = CmaskAllExceptOne(m_pPlayer->GetCID());
+	CClientMask Mask = CmaskAllExceptOne(m_pPlayer->GetCID());
 
 	if(Events&COREEVENT_GROUND_JUMP) GameServer()->CreateSound(m_Pos, SOUND_PLAYER_JUMP, Mask);
 
@@ -1025,8 +1031,7 @@ void CCharacter::TickDefered()
 
 	if(m_pPlayer->GetTeam() == TEAM_SPECTATORS)
 	{
-		m_Pos.x = m_Input.m_TargetX;
-		m_Pos.y = m_Input.m_TargetY;
+		SetPos(vec2(m_Input.m_TargetX, m_Input.m_TargetY));
 	}
 
 	// update the m_SendCore if needed
@@ -1046,12 +1051,6 @@ void CCharacter::TickDefered()
 			m_ReckoningCore = m_Core;
 		}
 	}
-
-	//H-Client: Check Hook State
-    int plHooked = m_Core.m_HookedPlayer;
-	if (plHooked >= MAX_CLIENTS-MAX_BOTS && plHooked < MAX_CLIENTS && GameServer()->m_apPlayers[plHooked] &&
-     (GameServer()->m_apPlayers[plHooked]->GetTeam() == TEAM_ANIMAL_TEECOW || GameServer()->m_apPlayers[plHooked]->GetTeam() == TEAM_ANIMAL_TEEPIG))
-	    m_Core.m_HookTick = 0;
 }
 
 bool CCharacter::IncreaseHealth(int Amount)
@@ -1072,12 +1071,14 @@ bool CCharacter::IncreaseArmor(int Amount)
 
 void CCharacter::Die(int Killer, int Weapon)
 {
+	// the npcs don't have a player, nobody scores and the kill message shows it as a suicide
+	CPlayer *pKiller = Killer >= 0 ? GameServer()->m_apPlayers[Killer] : 0;
+	if(Killer < 0)
+		Killer = m_pPlayer->GetCID();
+
 	// we got to wait 0.5 secs before respawning
-	if (m_pPlayer->GetTeam() > TEAM_BLUE)
-        m_pPlayer->m_RespawnTick = Server()->Tick()+Server()->TickSpeed()*20;
-	else
-        m_pPlayer->m_RespawnTick = Server()->Tick()+Server()->TickSpeed()/2;
-	int ModeSpecial = GameServer()->m_pController->OnCharacterDeath(this, GameServer()->m_apPlayers[Killer], Weapon);
+	m_pPlayer->m_RespawnTick = Server()->Tick()+Server()->TickSpeed()/2;
+	int ModeSpecial = GameServer()->m_pController->OnCharacterDeath(this, pKiller, Weapon);
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "kill killer='%d:%s' victim='%d:%s' weapon=%d special=%d",
@@ -1086,7 +1087,7 @@ void CCharacter::Die(int Killer, int Weapon)
 	GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "game", aBuf);
 
 	// send the kill message
-	if (Weapon != WEAPON_WORLD && m_pPlayer->GetTeam() <= TEAM_BLUE)
+	if (Weapon != WEAPON_WORLD)
 	{
         CNetMsg_Sv_KillMsg Msg;
         Msg.m_Killer = Killer;
@@ -1107,7 +1108,7 @@ void CCharacter::Die(int Killer, int Weapon)
 	GameServer()->m_World.m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
 	GameServer()->CreateDeath(m_Pos, m_pPlayer->GetCID());
 
-	if ((str_find_nocase(GameServer()->GameType(), "minetee") || str_find_nocase(GameServer()->GameType(), "CTF-BREAK"))  && m_pPlayer->GetTeam() <= TEAM_BLUE)
+	if (str_find_nocase(GameServer()->GameType(), "minetee") || str_find_nocase(GameServer()->GameType(), "CTF-BREAK"))
 	    GameServer()->CreateTombstone(m_Pos);
 }
 
@@ -1115,12 +1116,9 @@ bool CCharacter::TakeDamage(vec2 Force, int Dmg, int From, int Weapon)
 {
 	m_Core.m_Vel += Force;
 
-	if(GameServer()->m_pController->IsFriendlyFire(m_pPlayer->GetCID(), From) && !g_Config.m_SvTeamdamage)
+	if(From >= 0 && GameServer()->m_pController->IsFriendlyFire(m_pPlayer->GetCID(), From) && !g_Config.m_SvTeamdamage)
 		return false;
 
-    if (m_pPlayer->GetCID() >= MAX_CLIENTS-MAX_BOTS)
-        m_BotTimeLastDamage = Server()->Tick();
-
 	// m_pPlayer only inflicts half damage on self
 	if(From == m_pPlayer->GetCID())
 		Dmg = max(1, Dmg/2);
@@ -1169,11 +1167,12 @@ bool CCharacter::TakeDamage(vec2 Force, int Dmg, int From, int Weapon)
 	// do damage Hit sound
 	if(From >= 0 && From != m_pPlayer->GetCID() && GameServer()->m_apPlayers[From])
 	{
-		int Mask = CmaskOne(From);
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		CClientMask Mask = CmaskOne(From);
+		for(int i = 0; i < GameServer()->m_NumPlayerIDs; i++)
 		{
-			if(GameServer()->m_apPlayers[i] && GameServer()->m_apPlayers[i]->GetTeam() == TEAM_SPECTATORS && GameServer()->m_apPlayers[i]->m_SpectatorID == From)
-				Mask |= CmaskOne(i);
+			CPlayer *pPlayer = GameServer()->m_apPlayers[GameServer()->m_aPlayerIDs[i]];
+			if(pPlayer->GetTeam() == TEAM_SPECTATORS && pPlayer->m_SpectatorID == From)
+				Mask |= CmaskOne(pPlayer->GetCID());
 		}
 
 		GameServer()->CreateSound(GameServer()->m_apPlayers[From]->m_ViewPos, SOUND_HIT, Mask);
@@ -1198,13 +1197,10 @@ bool CCharacter::TakeDamage(vec2 Force, int Dmg, int From, int Weapon)
 		return false;
 	}
 
-    if (m_pPlayer->GetTeam() <= TEAM_BLUE)
-    {
-        if (Dmg > 2)
-            GameServer()->CreateSound(m_Pos, SOUND_PLAYER_PAIN_LONG);
-        else
-            GameServer()->CreateSound(m_Pos, SOUND_PLAYER_PAIN_SHORT);
-    }
+	if (Dmg > 2)
+		GameServer()->CreateSound(m_Pos, SOUND_PLAYER_PAIN_LONG);
+	else
+		GameServer()->CreateSound(m_Pos, SOUND_PLAYER_PAIN_SHORT);
 
 	m_EmoteType = EMOTE_PAIN;
 	m_EmoteStop = Server()->Tick() + 500 * Server()->TickSpeed() / 1000;
@@ -1217,12 +1213,7 @@ void CCharacter::Snap(int SnappingClient)
 	if(NetworkClipped(SnappingClient))
 		return;
 
-    //H-Client
-    if ((g_Config.m_SvMonsters == 0 && m_pPlayer->GetTeam() >= TEAM_ENEMY_TEEPER && m_pPlayer->GetTeam() <= TEAM_ENEMY_SPIDERTEE) ||
-        (g_Config.m_SvAnimals == 0 && m_pPlayer->GetTeam() >= TEAM_ANIMAL_TEECOW && m_pPlayer->GetTeam() <= TEAM_ANIMAL_TEEPIG))
-        return;
-
-	CNetObj_Character *pCharacter = static_cast<CNetObj_Character *>(Server()->SnapNewItem(NETOBJTYPE_CHARACTER, m_pPlayer->GetCID(), sizeof(CNetObj_Character)));
+	CNetObj_Character *pCharacter = static_cast<CNetObj_Character *>(GameServer()->SnapNewItem(NETOBJTYPE_CHARACTER, m_pPlayer->GetCID(), sizeof(CNetObj_Character), CSnapMaster::CLIP_VIEW, m_Pos));
 	if(!pCharacter)
 		return;
 
@@ -1283,36 +1274,42 @@ void CCharacter::Snap(int SnappingClient)
 	pCharacter->m_PlayerFlags = GetPlayer()->m_PlayerFlags;
 
 	//H-Client: Send Inventory
-	if(m_pPlayer->GetCID() == SnappingClient && m_NeedSendInventory && str_find_nocase(GameServer()->GameType(), "minetee"))
-	{
-        CNetObj_Inventory *pClientInventory = static_cast<CNetObj_Inventory *>(Server()->SnapNewItem(NETOBJTYPE_INVENTORY, m_pPlayer->GetCID(), sizeof(CNetObj_Inventory)));
-        if(!pClientInventory)
-            return;
-
-        //TODO: Ugly
-        pClientInventory->m_Item1 = m_Inventory.m_Items[0];
-        pClientInventory->m_Item2 = m_Inventory.m_Items[1];
-        pClientInventory->m_Item3 = m_Inventory.m_Items[2];
-        pClientInventory->m_Item4 = m_Inventory.m_Items[3];
-        pClientInventory->m_Item5 = m_Inventory.m_Items[4];
-        pClientInventory->m_Item6 = m_Inventory.m_Items[5];
-        pClientInventory->m_Item7 = m_Inventory.m_Items[6];
-        pClientInventory->m_Item8 = m_Inventory.m_Items[7];
-        pClientInventory->m_Item9 = m_Inventory.m_Items[8];
-
-        pClientInventory->m_Ammo1 = GetCurrentAmmo(pClientInventory->m_Item1);
-        pClientInventory->m_Ammo2 = GetCurrentAmmo(pClientInventory->m_Item2);
-        pClientInventory->m_Ammo3 = GetCurrentAmmo(pClientInventory->m_Item3);
-        pClientInventory->m_Ammo4 = GetCurrentAmmo(pClientInventory->m_Item4);
-        pClientInventory->m_Ammo5 = GetCurrentAmmo(pClientInventory->m_Item5);
-        pClientInventory->m_Ammo6 = GetCurrentAmmo(pClientInventory->m_Item6);
-        pClientInventory->m_Ammo7 = GetCurrentAmmo(pClientInventory->m_Item7);
-        pClientInventory->m_Ammo8 = GetCurrentAmmo(pClientInventory->m_Item8);
-        pClientInventory->m_Ammo9 = GetCurrentAmmo(pClientInventory->m_Item9);
-
-        pClientInventory->m_Selected = m_Inventory.m_Selected;
-        m_NeedSendInventory = false;
-	}
+	if(m_pPlayer->GetCID() == SnappingClient)
+		SnapInventory();
+}
+
+void CCharacter::SnapInventory()
+{
+	if(!m_NeedSendInventory || !str_find_nocase(GameServer()->GameType(), "minetee"))
+		return;
+
+	CNetObj_Inventory *pClientInventory = static_cast<CNetObj_Inventory *>(Server()->SnapNewItem(NETOBJTYPE_INVENTORY, m_pPlayer->GetCID(), sizeof(CNetObj_Inventory)));
+	if(!pClientInventory)
+		return;
+
+	//TODO: Ugly
+	pClientInventory->m_Item1 = m_Inventory.m_Items[0];
+	pClientInventory->m_Item2 = m_Inventory.m_Items[1];
+	pClientInventory->m_Item3 = m_Inventory.m_Items[2];
+	pClientInventory->m_Item4 = m_Inventory.m_Items[3];
+	pClientInventory->m_Item5 = m_Inventory.m_Items[4];
+	pClientInventory->m_Item6 = m_Inventory.m_Items[5];
+	pClientInventory->m_Item7 = m_Inventory.m_Items[6];
+	pClientInventory->m_Item8 = m_Inventory.m_Items[7];
+	pClientInventory->m_Item9 = m_Inventory.m_Items[8];
+
+	pClientInventory->m_Ammo1 = GetCurrentAmmo(pClientInventory->m_Item1);
+	pClientInventory->m_Ammo2 = GetCurrentAmmo(pClientInventory->m_Item2);
+	pClientInventory->m_Ammo3 = GetCurrentAmmo(pClientInventory->m_Item3);
+	pClientInventory->m_Ammo4 = GetCurrentAmmo(pClientInventory->m_Item4);
+	pClientInventory->m_Ammo5 = GetCurrentAmmo(pClientInventory->m_Item5);
+	pClientInventory->m_Ammo6 = GetCurrentAmmo(pClientInventory->m_Item6);
+	pClientInventory->m_Ammo7 = GetCurrentAmmo(pClientInventory->m_Item7);
+	pClientInventory->m_Ammo8 = GetCurrentAmmo(pClientInventory->m_Item8);
+	pClientInventory->m_Ammo9 = GetCurrentAmmo(pClientInventory->m_Item9);
+
+	pClientInventory->m_Selected = m_Inventory.m_Selected;
+	m_NeedSendInventory = false;
 }
 
 //H-Client
@@ -1386,264 +1383,6 @@ bool CCharacter::IsInventoryFull()
     return true;
 }
 
-void CCharacter::BotIA()
-{
-    //Control spawn bots
-    int Time = -1;
-    Time = (Server()->Tick()-GameServer()->m_pController->GetRoundStartTick()) / (float)Server()->TickSpeed();
-    bool MineTeeIsDay = (static_cast<int>(Time/300)%2)?false:true;
-    if (300 < 0)
-        MineTeeIsDay = true;
-
-    if (IsAlive() && (!MineTeeIsDay && m_pPlayer->GetTeam() >= TEAM_ENEMY_TEEPER && m_pPlayer->GetTeam() <= TEAM_ENEMY_SPIDERTEE))
-    {
-        CTile *pMTLTiles = GameServer()->Layers()->TileLights();
-        int Index = static_cast<int>(m_Pos.y/32)*GameServer()->Layers()->Lights()->m_Width+static_cast<int>(m_Pos.x/32);
-
-        if (pMTLTiles[Index].m_Index == 0)
-            Die(m_pPlayer->GetCID(), WEAPON_WORLD);
-
-        return;
-    }
-    else if (MineTeeIsDay && m_pPlayer->GetTeam() >= TEAM_ANIMAL_TEECOW && m_pPlayer->GetTeam() <= TEAM_ANIMAL_TEEPIG)
-    {
-        Die(m_pPlayer->GetCID(), WEAPON_WORLD);
-        return;
-    }
-
-    //Sounds
-    if (Server()->Tick() - m_BotTimeLastSound > Server()->TickSpeed()*5.0f)
-    {
-        if (m_pPlayer->GetTeam() == TEAM_ANIMAL_TEECOW)
-            GameServer()->CreateSound(m_Pos, SOUND_ANIMAL_TEECOW);
-        else if (m_pPlayer->GetTeam() == TEAM_ENEMY_ZOMBITEE)
-            GameServer()->CreateSound(m_Pos, SOUND_ENEMY_ZOMBITEE);
-        m_BotTimeLastSound = Server()->Tick();
-    }
-
-    //Run actions
-    if (m_pPlayer->GetTeam() == TEAM_ENEMY_TEEPER && (Server()->Tick() - m_BotTimePlayerFound > Server()->TickSpeed()*0.35f || Server()->Tick()-m_BotTimeGrounded > Server()->TickSpeed()*4))
-    {
-
-        Die(m_pPlayer->GetCID(), WEAPON_WORLD);
-        GameServer()->CreateExplosion(m_Pos, m_pPlayer->GetCID(), WEAPON_WORLD, false);
-        GameServer()->CreateSound(m_Pos, SOUND_GRENADE_EXPLODE);
-        return;
-    }
-    else if (m_pPlayer->GetTeam() == TEAM_ENEMY_ZOMBITEE)
-    {
-        if (Server()->Tick()-m_BotTimeGrounded > Server()->TickSpeed()*4)
-        {
-            Die(m_pPlayer->GetCID(), WEAPON_WORLD);
-            return;
-        }
-        if (m_BotClientIDFix != -1)
-        {
-            CCharacter *pChar =  GameServer()->m_apPlayers[m_BotClientIDFix]->GetCharacter();
-            if (!pChar)
-            {
-                m_BotClientIDFix = -1;
-                return;
-            }
-
-            vec2 DirHit = vec2(0.f, -1.f);
-            if (length(pChar->m_Pos - m_Pos) > 0.0f)
-                vec2 DirHit = normalize(pChar->m_Pos - m_Pos);
-            pChar->TakeDamage(vec2(0.f, -1.f) + normalize(DirHit + vec2(0.f, -1.1f)) * 10.0f, 3, m_pPlayer->GetCID(), WEAPON_WORLD);
-            GameServer()->CreateHammerHit(m_Pos);
-            GameServer()->CreateSound(m_Pos, SOUND_HIT);
-            m_BotDir = 0;
-
-            m_BotClientIDFix = -1;
-            return;
-        }
-    }
-    else if (m_pPlayer->GetTeam() == TEAM_ENEMY_SKELETEE)
-    {
-        if (Server()->Tick()-m_BotTimeGrounded > Server()->TickSpeed()*4)
-        {
-            Die(m_pPlayer->GetCID(), WEAPON_WORLD);
-            return;
-        }
-        if (m_BotClientIDFix != -1)
-        {
-            CCharacter *pChar =  GameServer()->m_apPlayers[m_BotClientIDFix]->GetCharacter();
-            if (!pChar)
-            {
-                m_BotClientIDFix = -1;
-                return;
-            }
-
-            m_LatestInput.m_Fire = 1;
-            m_LatestPrevInput.m_Fire = 1;
-            m_Input.m_Fire = 1;
-            m_BotDir = 0;
-
-            m_BotClientIDFix = -1;
-            return;
-        }
-    }
-
-    //Clean m_Input
-	m_Input.m_Hook = 0;
-	m_Input.m_Fire = 0;
-	m_Input.m_Jump = 0;
-
-    //Interact with users
-    bool PlayerClose = false;
-    bool PlayerFound = false;
-    float LessDist = 500.0f;
-
-    m_BotClientIDFix = -1;
-	for (int i=0; i<MAX_CLIENTS-MAX_BOTS; i++)
-	{
-	    CPlayer *pPlayer = GameServer()->m_apPlayers[i];
-	    if (!pPlayer || !pPlayer->GetCharacter())
-            continue;
-
-        int Dist = distance(pPlayer->GetCharacter()->m_Pos, m_Pos);
-        if (Dist < LessDist)
-            LessDist = Dist;
-        else
-            continue;
-
-	    if (Dist < 450.0f)
-        {
-            if (Dist > 120.0f)
-            {
-                vec2 DirPlayer = normalize(pPlayer->GetCharacter()->m_Pos - m_Pos);
-
-                bool isHooked = false;
-                for (int e=0; e<MAX_CLIENTS-MAX_BOTS; e++)
-                {
-                    if (!GameServer()->m_apPlayers[e] || !GameServer()->m_apPlayers[e]->GetCharacter())
-                        continue;
-
-                    int HookedPL = GameServer()->m_apPlayers[e]->GetCharacter()->GetCore()->m_HookedPlayer;
-                    if (HookedPL < 0 || HookedPL != m_pPlayer->GetCID() || !GameServer()->m_apPlayers[HookedPL])
-                        continue;
-
-                    if (GameServer()->m_apPlayers[HookedPL]->GetTeam() == TEAM_ANIMAL_TEECOW || GameServer()->m_apPlayers[HookedPL]->GetTeam() == TEAM_ANIMAL_TEEPIG)
-                    {
-                        isHooked = true;
-                        break;
-                    }
-                }
-
-                if (m_pPlayer->GetTeam() == TEAM_ANIMAL_TEECOW || m_pPlayer->GetTeam() == TEAM_ANIMAL_TEEPIG)
-                    m_BotDir = 0;
-                else if (m_pPlayer->GetTeam() == TEAM_ENEMY_SKELETEE)
-                {
-                    m_BotDir = 0;
-                    m_BotClientIDFix = pPlayer->GetCID();
-                }
-                else
-                {
-                    if (DirPlayer.x < 0)
-                        m_BotDir = -1;
-                    else
-                        m_BotDir = 1;
-                }
-            }
-            else
-            {
-                PlayerClose = true;
-
-                if (m_pPlayer->GetTeam() == TEAM_ENEMY_TEEPER)
-                    m_BotDir = 0;
-                else if (m_pPlayer->GetTeam() == TEAM_ENEMY_ZOMBITEE && Dist < 32.0f)
-                {
-                    m_BotDir = 0;
-                    m_BotClientIDFix = pPlayer->GetCID();
-                }
-            }
-
-
-            m_Input.m_TargetX = static_cast<int>(pPlayer->GetCharacter()->m_Pos.x - m_Pos.x);
-            m_Input.m_TargetY = static_cast<int>(pPlayer->GetCharacter()->m_Pos.y - m_Pos.y);
-
-            PlayerFound = true;
-        }
-	}
-
-    //Fix target
-    if (!PlayerFound)
-    {
-        m_Input.m_TargetX = m_BotDir;
-        m_Input.m_TargetY = 0;
-    }
-
-    //Random Actions to animals
-	if (m_pPlayer->GetTeam() == TEAM_ANIMAL_TEECOW || m_pPlayer->GetTeam() == TEAM_ANIMAL_TEEPIG)
-	{
-        if (Server()->Tick()-m_BotTimeLastOption > Server()->TickSpeed()*10.0f)
-        {
-            int Action = rand()%3;
-            if (Action == 0)
-                m_BotDir = -1;
-            else if (Action == 1)
-                m_BotDir = 1;
-            else if (Action == 2)
-                m_BotDir = 0;
-
-            m_BotTimeLastOption = Server()->Tick();
-        }
-	}
-
-    //Interact with the envirionment
-    if (distance(m_Pos, m_BotLastPos) < 0.5f || abs(m_Pos.x-m_BotLastPos.x) < 8)
-    {
-        if (Server()->Tick() - m_BotLastStuckTime > Server()->TickSpeed()*0.5f)
-        {
-            m_BotStuckCount++;
-            if (m_BotStuckCount == 15)
-            {
-                if (abs(m_Pos.x-m_BotLastPos.x) < 2.0f)
-                {
-                    if (abs(m_Pos.y-m_BotLastPos.y) > 10)
-                        m_Input.m_Jump = 1;
-                    else
-                    {
-                        m_Input.m_Jump = 1;
-                    }
-                }
-
-                m_BotStuckCount = 0;
-                m_BotLastStuckTime = Server()->Tick();
-            }
-
-        }
-
-        if (!PlayerClose)
-            m_Input.m_Jump = 1;
-    }
-
-    //Fix Stuck
-    if (IsGrounded())
-        m_BotTimeGrounded = Server()->Tick();
-
-    //Falls
-    if (m_pPlayer->GetTeam() != TEAM_ENEMY_ZOMBITEE && m_pPlayer->GetTeam() != TEAM_ANIMAL_TEECOW  && m_pPlayer->GetTeam() != TEAM_ANIMAL_TEEPIG && PlayerFound && m_Core.m_Vel.y < 0.0f)
-        m_Input.m_Jump = 1;
-
-    //Limits
-    int tx = m_Pos.x+m_BotDir*45.0f;
-    if (tx < 0 || tx >= GameServer()->Collision()->GetWidth()*32.0f)
-        m_BotDir *= -1;
-
-    //Delay of actions
-    if (!PlayerClose)
-        m_BotTimePlayerFound = Server()->Tick();
-
-    //Set data
-    m_Input.m_Direction = m_BotDir;
-	m_Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
-
-	m_LatestPrevInput = m_LatestInput = m_Input;
-
-	m_BotLastPos = m_Pos;
-}
-
 int CCharacter::GetCurrentAmmo(int wid)
 {
     if (wid < 0 || wid >= NUM_WEAPONS+NUM_BLOCKS)
@@ -1678,8 +1417,7 @@ void CCharacter::DropItem(int ItemID)
                 m_Inventory.m_Items[ItemID] = NUM_WEAPONS+NUM_BLOCKS;
                 m_aBlocks[Index-NUM_WEAPONS].m_Got = false;
                 CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_DROPITEM, Index-NUM_WEAPONS);
-                pPickup->m_Pos = m_Pos;
-                pPickup->m_Pos.y -= 18.0f;
+                pPickup->SetPos(vec2(m_Pos.x, m_Pos.y-18.0f));
                 pPickup->m_Vel = vec2(Direction.x*5.0f, -5);
                 pPickup->m_Amount = m_aBlocks[Index-NUM_WEAPONS].m_Amount;
                 pPickup->m_Owner = m_pPlayer->GetCID();
@@ -31,6 +31,7 @@ public:
 	virtual void Tick();
 	virtual void TickDefered();
 	virtual void Snap(int SnappingClient);
+	void SnapInventory();
 
 	bool IsGrounded();
 
@@ -87,19 +88,6 @@ public:
 
     int GetCurrentAmmo(int wid);
 
-	//Bot
-	vec2 m_BotLastPos;
-    int m_BotDir;
-    int m_BotStuckCount;
-    int m_BotClientIDFix;
-    float m_BotLastStuckTime;
-    float m_BotTimePlayerFound;
-    float m_BotTimeGrounded;
-    float m_BotTimeLastOption;
-    float m_BotTimeLastDamage;
-    float m_BotTimeLastSound;
-	//
-
 private:
 	// player controlling this character
 	class CPlayer *m_pPlayer;
@@ -169,7 +157,6 @@ private:
 	float TimerFluidDamage;
 	bool inWater;
 	void Construct();
-	void BotIA();
 	//
 
 };
@@ -3,6 +3,8 @@
 #include <game/server/gamecontext.h>
 #include "flag.h"
 
+MACRO_ALLOC_POOL_IMPL(CFlag, 2)
+
 CFlag::CFlag(CGameWorld *pGameWorld, int Team)
 : CEntity(pGameWorld, CGameWorld::ENTTYPE_FLAG)
 {
@@ -18,7 +20,7 @@ void CFlag::Reset()
 {
 	m_pCarryingCharacter = NULL;
 	m_AtStand = 1;
-	m_Pos = m_StandPos;
+	SetPos(m_StandPos);
 	m_Vel = vec2(0,0);
 	m_GrabTick = 0;
 }
@@ -28,7 +30,7 @@ void CFlag::Snap(int SnappingClient)
 	if(NetworkClipped(SnappingClient))
 		return;
 
-	CNetObj_Flag *pFlag = (CNetObj_Flag *)Server()->SnapNewItem(NETOBJTYPE_FLAG, m_Team, sizeof(CNetObj_Flag));
+	CNetObj_Flag *pFlag = (CNetObj_Flag *)GameServer()->SnapNewItem(NETOBJTYPE_FLAG, m_Team, sizeof(CNetObj_Flag), CSnapMaster::CLIP_VIEW, m_Pos);
 	if(!pFlag)
 		return;
 
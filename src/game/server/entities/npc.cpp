@@ -0,0 +1,528 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/shared/config.h>
+#include <game/generated/server_data.h>
+#include <game/server/gamecontext.h>
+#include <game/mapitems.h>
+
+#include "character.h"
+#include "projectile.h"
+#include "npc.h"
+
+// a whole minetee map full of them
+MACRO_ALLOC_POOL_IMPL(CNpc, 1024)
+
+CNpc::CNpc(CGameWorld *pWorld, int Type, vec2 Pos)
+: CEntity(pWorld, CGameWorld::ENTTYPE_NPC)
+{
+	m_ProximityRadius = ms_PhysSize;
+	m_Type = Type;
+	m_Health = 10;
+	m_AttackTick = 0;
+	m_ReloadTimer = 0;
+	m_EmoteType = EMOTE_NORMAL;
+	m_EmoteStop = -1;
+	m_DamageTakenTick = 0;
+	m_FluidTick = Server()->Tick();
+	m_InWater = false;
+
+	switch(m_Type)
+	{
+	case TEAM_ENEMY_TEEPER: m_Weapon = NUM_WEAPONS+BLOCK_TNT; break;
+	case TEAM_ENEMY_SKELETEE: m_Weapon = WEAPON_GRENADE; break;
+	default: m_Weapon = WEAPON_HAMMER;
+	}
+
+	m_Direction = 1;
+	m_Jump = 0;
+	m_Target = vec2(m_Direction, 0);
+	m_TargetID = -1;
+	m_LastPos = Pos;
+	m_StuckCount = 0;
+	m_LastStuckTick = 0;
+	m_PlayerFoundTick = Server()->Tick();
+	m_GroundedTick = Server()->Tick();
+	m_LastOptionTick = Server()->Tick();
+	m_Seed = (unsigned)GameServer()->m_NumNpcsSpawned++;
+	m_LastSoundTick = Server()->Tick();
+	m_PathLength = 0;
+	m_PathPos = 0;
+	m_PathGoal = -1;
+	m_PathRevision = -1;
+	m_PathTick = 0;
+	m_Action = ACTION_NONE;
+	m_ActionVictim = -1;
+	m_ActionSound = -1;
+
+	// they bump into the players but nobody can hook them, the
+	// world core only knows about the clients
+	m_Core.Reset();
+	m_Core.Init(&GameServer()->m_World.m_Core, GameServer()->Collision());
+	m_Core.m_Pos = Pos;
+	SetPos(Pos);
+
+	GameWorld()->InsertEntity(this);
+	GameServer()->CreatePlayerSpawn(Pos);
+}
+
+void CNpc::Reset()
+{
+	GameServer()->m_World.DestroyEntity(this);
+}
+
+bool CNpc::IsGrounded()
+{
+	if(GameServer()->Collision()->CheckPoint(m_Pos.x+m_ProximityRadius/2, m_Pos.y+m_ProximityRadius/2+5))
+		return true;
+	if(GameServer()->Collision()->CheckPoint(m_Pos.x-m_ProximityRadius/2, m_Pos.y+m_ProximityRadius/2+5))
+		return true;
+	return false;
+}
+
+void CNpc::GatherTargets(CGameContext *pGameServer, CTargets *pTargets)
+{
+	pTargets->m_Num = 0;
+	for(int i = 0; i < pGameServer->m_NumPlayerIDs; i++)
+	{
+		int ClientID = pGameServer->m_aPlayerIDs[i];
+		CCharacter *pChr = pGameServer->m_apPlayers[ClientID]->GetCharacter();
+		if(!pChr || !pChr->IsAlive())
+			continue;
+		pTargets->m_apChars[pTargets->m_Num] = pChr;
+		pTargets->m_aClientIDs[pTargets->m_Num] = ClientID;
+		pTargets->m_Num++;
+	}
+
+	// every 300 seconds the monsters and the animals take turns
+	int Time = (pGameServer->Server()->Tick()-pGameServer->m_pController->GetRoundStartTick()) / pGameServer->Server()->TickSpeed();
+	pTargets->m_IsDay = (Time/300)%2 == 0;
+}
+
+void CNpc::Attack(CCharacter *pChr)
+{
+	vec2 Dir = vec2(0.f, -1.f);
+	if(length(pChr->m_Pos - m_Pos) > 0.0f)
+		Dir = normalize(pChr->m_Pos - m_Pos);
+
+	m_AttackTick = Server()->Tick();
+	if(m_Type == TEAM_ENEMY_SKELETEE)
+	{
+		if(m_ReloadTimer)
+			return;
+
+		vec2 ProjStartPos = m_Pos+Dir*m_ProximityRadius*0.75f;
+		new CProjectile(GameWorld(), WEAPON_GRENADE, -1, ProjStartPos, Dir,
+			(int)(Server()->TickSpeed()*GameServer()->Tuning()->m_GrenadeLifetime),
+			1, true, 0, SOUND_GRENADE_EXPLODE, WEAPON_GRENADE);
+		GameServer()->CreateSound(m_Pos, SOUND_GRENADE_FIRE);
+		m_ReloadTimer = g_pData->m_Weapons.m_aId[WEAPON_GRENADE].m_Firedelay * Server()->TickSpeed() / 1000;
+	}
+	else
+	{
+		pChr->TakeDamage(vec2(0.f, -1.f) + normalize(Dir + vec2(0.f, -1.1f)) * 10.0f, 3, -1, WEAPON_WORLD);
+		GameServer()->CreateHammerHit(m_Pos);
+		GameServer()->CreateSound(m_Pos, SOUND_HIT);
+	}
+}
+
+bool CNpc::FollowPath(vec2 Goal, int Search)
+{
+	CNavGraph *pGraph = &GameServer()->m_NavGraph;
+	if(!pGraph->NumNodes())
+		return false;
+
+	// jumping players count where they will land
+	int GoalCell = pGraph->StandingCell(Goal, 8);
+	if(GoalCell < 0)
+		return false;
+
+	// only plan from the ground, in the air the last step is kept
+	bool Grounded = IsGrounded();
+	int Cell = Grounded ? pGraph->StandingCell(m_Pos, 1) : -1;
+	if(Cell >= 0)
+	{
+		if(m_PathPos < m_PathLength && m_aPath[m_PathPos] == Cell)
+			m_PathPos++;
+
+		bool Replan = m_PathRevision != pGraph->Revision() || m_PathGoal != GoalCell || m_PathPos >= m_PathLength ||
+			!pGraph->FindEdge(Cell, m_aPath[m_PathPos]);
+		if(Replan && Server()->Tick()-m_PathTick >= Server()->TickSpeed()/5)
+		{
+			m_PathLength = pGraph->FindPath(Cell, GoalCell, m_aPath, MAX_PATH, Search);
+			m_PathPos = 0;
+			m_PathGoal = GoalCell;
+			m_PathRevision = pGraph->Revision();
+			m_PathTick = Server()->Tick();
+		}
+	}
+	if(m_PathPos >= m_PathLength)
+		return false;
+
+	int Next = m_aPath[m_PathPos];
+	float dx = pGraph->CellCenter(Next).x - m_Pos.x;
+	m_Direction = dx < -4.0f ? -1 : dx > 4.0f ? 1 : 0;
+
+	const CNavGraph::CEdge *pEdge = Cell >= 0 ? pGraph->FindEdge(Cell, Next) : 0;
+	if(pEdge && pEdge->m_Type == CNavGraph::EDGE_JUMP)
+		m_Jump = 1;
+	return true;
+}
+
+int CNpc::ThinkJob(void *pUser)
+{
+	CThinkJob *pJob = (CThinkJob *)pUser;
+	for(int i = 0; i < pJob->m_Num; i++)
+		pJob->m_apNpcs[i]->Think(pJob->m_pTargets, pJob->m_Search);
+	return 0;
+}
+
+void CNpc::UpdateAll(CGameContext *pGameServer, CNpc **apNpcs, int Num, const CTargets *pTargets)
+{
+	// the threads live as long as the server, the game context does not
+	static CJobPool s_JobPool;
+	static CThinkJob s_aJobs[CNavGraph::MAX_SEARCHES];
+	if(s_JobPool.NumThreads() < g_Config.m_SvNpcThreads)
+		s_JobPool.Init(g_Config.m_SvNpcThreads-s_JobPool.NumThreads());
+
+	// a contiguous share each, the tick thread takes the first one
+	int NumJobs = clamp(min(g_Config.m_SvNpcThreads+1, Num/64), 1, (int)CNavGraph::MAX_SEARCHES);
+	pGameServer->m_NavGraph.Update();
+	pGameServer->m_NavGraph.PrepareSearches(NumJobs);
+
+	int Per = (Num+NumJobs-1)/NumJobs;
+	for(int j = 0; j < NumJobs; j++)
+	{
+		CThinkJob *pJob = &s_aJobs[j];
+		pJob->m_apNpcs = apNpcs+j*Per;
+		pJob->m_Num = clamp(Num-j*Per, 0, Per);
+		pJob->m_pTargets = pTargets;
+		pJob->m_Search = j;
+		if(j > 0)
+			s_JobPool.Add(&pJob->m_Job, ThinkJob, pJob);
+	}
+	ThinkJob(&s_aJobs[0]);
+	for(int j = 1; j < NumJobs; j++)
+		while(s_aJobs[j].m_Job.Status() != CJob::STATE_DONE)
+			thread_yield();
+	sync_barrier(); // don't act on the decisions before the workers finished writing them
+
+	for(int i = 0; i < Num; i++)
+		apNpcs[i]->Act();
+}
+
+void CNpc::Act()
+{
+	int Action = m_Action;
+	m_Action = ACTION_NONE;
+
+	// an explosion before might have taken it already
+	if(m_MarkedForDestroy)
+		return;
+
+	if(m_ActionSound >= 0)
+		GameServer()->CreateSound(m_Pos, m_ActionSound);
+	m_ActionSound = -1;
+
+	if(Action == ACTION_DIE)
+		Die(-1, WEAPON_WORLD);
+	else if(Action == ACTION_EXPLODE)
+	{
+		vec2 Pos = m_Pos;
+		Die(-1, WEAPON_WORLD);
+		GameServer()->CreateExplosion(Pos, -1, WEAPON_WORLD, false);
+		GameServer()->CreateSound(Pos, SOUND_GRENADE_EXPLODE);
+	}
+	else if(Action == ACTION_ATTACK)
+	{
+		CCharacter *pChr = GameServer()->GetPlayerChar(m_ActionVictim);
+		if(pChr && pChr->IsAlive())
+			Attack(pChr);
+	}
+}
+
+void CNpc::Think(const CTargets *pTargets, int Search)
+{
+	// only the npc itself changes in here, the rest waits for Act
+	m_Action = ACTION_NONE;
+	m_ActionSound = -1;
+	if(m_MarkedForDestroy)
+		return;
+
+	// the monsters only last in the dark and the animals in the light
+	if(IsMonster() && !pTargets->m_IsDay)
+	{
+		CMapItemLayerTilemap *pLights = GameServer()->Layers()->Lights();
+		CTile *pLightTiles = GameServer()->Layers()->TileLights();
+		if(pLights && pLightTiles)
+		{
+			int x = clamp((int)(m_Pos.x/32), 0, pLights->m_Width-1);
+			int y = clamp((int)(m_Pos.y/32), 0, pLights->m_Height-1);
+			if(pLightTiles[y*pLights->m_Width+x].m_Index == 0)
+				m_Action = ACTION_DIE;
+		}
+		return;
+	}
+	else if(IsAnimal() && pTargets->m_IsDay)
+	{
+		m_Action = ACTION_DIE;
+		return;
+	}
+
+	if(Server()->Tick() - m_LastSoundTick > Server()->TickSpeed()*5)
+	{
+		if(m_Type == TEAM_ANIMAL_TEECOW)
+			m_ActionSound = SOUND_ANIMAL_TEECOW;
+		else if(m_Type == TEAM_ENEMY_ZOMBITEE)
+			m_ActionSound = SOUND_ENEMY_ZOMBITEE;
+		m_LastSoundTick = Server()->Tick();
+	}
+
+	// monsters that are stuck in the air for too long give up
+	bool Stuck = Server()->Tick()-m_GroundedTick > Server()->TickSpeed()*4;
+	if(m_Type == TEAM_ENEMY_TEEPER && (Stuck || Server()->Tick() - m_PlayerFoundTick > Server()->TickSpeed()*0.35f))
+	{
+		m_Action = ACTION_EXPLODE;
+		return;
+	}
+	else if(m_Type == TEAM_ENEMY_ZOMBITEE || m_Type == TEAM_ENEMY_SKELETEE)
+	{
+		if(Stuck)
+		{
+			m_Action = ACTION_DIE;
+			return;
+		}
+		if(m_TargetID != -1)
+		{
+			// the targets are the living characters of this tick
+			for(int i = 0; i < pTargets->m_Num; i++)
+				if(pTargets->m_aClientIDs[i] == m_TargetID)
+				{
+					m_Action = ACTION_ATTACK;
+					m_ActionVictim = m_TargetID;
+					m_Direction = 0;
+				}
+			m_TargetID = -1;
+			return;
+		}
+	}
+
+	m_Jump = 0;
+
+	// go for the closest player
+	bool PlayerClose = false;
+	bool PlayerFound = false;
+	CCharacter *pChase = 0;
+	float LessDist = 500.0f;
+	for(int i = 0; i < pTargets->m_Num; i++)
+	{
+		CCharacter *pChr = pTargets->m_apChars[i];
+		int Dist = distance(pChr->m_Pos, m_Pos);
+		if(Dist >= LessDist)
+			continue;
+		LessDist = Dist;
+
+		if(Dist >= 450)
+			continue;
+		pChase = 0;
+
+		if(Dist > 120)
+		{
+			if(IsAnimal())
+				m_Direction = 0;
+			else if(m_Type == TEAM_ENEMY_SKELETEE)
+			{
+				m_Direction = 0;
+				m_TargetID = pTargets->m_aClientIDs[i];
+			}
+			else
+			{
+				m_Direction = pChr->m_Pos.x < m_Pos.x ? -1 : 1;
+				pChase = pChr;
+			}
+		}
+		else
+		{
+			PlayerClose = true;
+			if(m_Type == TEAM_ENEMY_TEEPER)
+				m_Direction = 0;
+			else if(m_Type == TEAM_ENEMY_ZOMBITEE && Dist < 32)
+			{
+				m_Direction = 0;
+				m_TargetID = pTargets->m_aClientIDs[i];
+			}
+			else if(m_Type == TEAM_ENEMY_ZOMBITEE)
+				pChase = pChr;
+		}
+
+		m_Target = pChr->m_Pos - m_Pos;
+		PlayerFound = true;
+	}
+
+	if(!PlayerFound)
+		m_Target = vec2(m_Direction, 0);
+
+	// the animals wander around, rand() would depend on the order the threads run in
+	if(IsAnimal() && Server()->Tick()-m_LastOptionTick > Server()->TickSpeed()*10)
+	{
+		unsigned Hash = m_Seed*2654435761u ^ (unsigned)Server()->Tick()*40503u;
+		m_Direction = (int)((Hash>>16)%3) - 1;
+		m_LastOptionTick = Server()->Tick();
+	}
+
+	// the way around what is in the way if the nav graph knows one, guessing if not
+	bool OnPath = pChase && FollowPath(pChase->m_Pos, Search);
+	if(!OnPath && (distance(m_Pos, m_LastPos) < 0.5f || absolute(m_Pos.x-m_LastPos.x) < 8))
+	{
+		if(Server()->Tick() - m_LastStuckTick > Server()->TickSpeed()/2)
+		{
+			m_StuckCount++;
+			if(m_StuckCount == 15)
+			{
+				m_Jump = 1;
+				m_StuckCount = 0;
+				m_LastStuckTick = Server()->Tick();
+			}
+		}
+
+		if(!PlayerClose)
+			m_Jump = 1;
+	}
+
+	if(IsGrounded())
+		m_GroundedTick = Server()->Tick();
+
+	// keep up with players that jump
+	if(!OnPath && m_Type != TEAM_ENEMY_ZOMBITEE && !IsAnimal() && PlayerFound && m_Core.m_Vel.y < 0.0f)
+		m_Jump = 1;
+
+	// turn around at the end of the map
+	int tx = m_Pos.x+m_Direction*45.0f;
+	if(tx < 0 || tx >= GameServer()->Collision()->GetWidth()*32.0f)
+		m_Direction *= -1;
+
+	if(!PlayerClose)
+		m_PlayerFoundTick = Server()->Tick();
+
+	m_LastPos = m_Pos;
+}
+
+void CNpc::Tick()
+{
+	if(m_ReloadTimer > 0)
+		m_ReloadTimer--;
+
+	mem_zero(&m_Core.m_Input, sizeof(m_Core.m_Input));
+	m_Core.m_Input.m_Direction = m_Direction;
+	m_Core.m_Input.m_TargetX = (int)m_Target.x;
+	m_Core.m_Input.m_TargetY = (int)m_Target.y;
+	m_Core.m_Input.m_Jump = m_Jump;
+	m_Core.m_Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
+	m_Core.Tick(true);
+
+	// lava burns them and they drown like the players do
+	int BlockID = GameServer()->Collision()->GetMineTeeBlockAt(m_Pos.x+m_ProximityRadius/3.f, m_Pos.y-m_ProximityRadius/3.f);
+	bool InWater = BlockID >= BLOCK_UNDEF82 && BlockID <= BLOCK_AGUA;
+	if(BlockID >= BLOCK_UNDEF104 && BlockID <= BLOCK_LAVA && Server()->Tick() - m_FluidTick >= Server()->TickSpeed()/2)
+	{
+		m_FluidTick = Server()->Tick();
+		if(!TakeDamage(vec2(0.0f, -1.0f), 1, -1, WEAPON_WORLD))
+			return;
+	}
+	else if(InWater != m_InWater && Server()->Tick() - m_FluidTick >= (InWater ? Server()->TickSpeed()*8 : 0))
+	{
+		m_InWater = InWater;
+		m_FluidTick = Server()->Tick();
+	}
+	else if(m_InWater && Server()->Tick() - m_FluidTick >= Server()->TickSpeed()*2)
+	{
+		m_FluidTick = Server()->Tick();
+		if(!TakeDamage(vec2(0.0f, -1.0f), 1, -1, WEAPON_WORLD))
+			return;
+	}
+
+	// handle death-tiles and leaving gamelayer
+	if(GameServer()->Collision()->GetCollisionAt(m_Pos.x+m_ProximityRadius/3.f, m_Pos.y-m_ProximityRadius/3.f)&CCollision::COLFLAG_DEATH ||
+		GameServer()->Collision()->GetCollisionAt(m_Pos.x+m_ProximityRadius/3.f, m_Pos.y+m_ProximityRadius/3.f)&CCollision::COLFLAG_DEATH ||
+		GameServer()->Collision()->GetCollisionAt(m_Pos.x-m_ProximityRadius/3.f, m_Pos.y-m_ProximityRadius/3.f)&CCollision::COLFLAG_DEATH ||
+		GameServer()->Collision()->GetCollisionAt(m_Pos.x-m_ProximityRadius/3.f, m_Pos.y+m_ProximityRadius/3.f)&CCollision::COLFLAG_DEATH ||
+		GameLayerClipped(m_Pos))
+	{
+		Die(-1, WEAPON_WORLD);
+	}
+}
+
+void CNpc::TickDefered()
+{
+	m_Core.Move();
+	m_Core.Quantize();
+	SetPos(m_Core.m_Pos);
+}
+
+bool CNpc::TakeDamage(vec2 Force, int Dmg, int From, int Weapon)
+{
+	m_Core.m_Vel += Force;
+
+	if(Server()->Tick() < m_DamageTakenTick+25)
+		GameServer()->CreateDamageInd(m_Pos, 0.25f, Dmg);
+	else
+		GameServer()->CreateDamageInd(m_Pos, 0, Dmg);
+	m_DamageTakenTick = Server()->Tick();
+	m_Health -= Dmg;
+
+	CCharacter *pKillerChr = GameServer()->GetPlayerChar(From);
+	if(pKillerChr)
+		GameServer()->CreateSound(pKillerChr->m_Pos, SOUND_HIT, CmaskOne(From));
+
+	if(m_Health <= 0)
+	{
+		Die(From, Weapon);
+
+		// set attacker's face to happy (taunt!)
+		if(pKillerChr)
+			pKillerChr->SetEmote(EMOTE_HAPPY, Server()->Tick() + Server()->TickSpeed());
+		return false;
+	}
+
+	m_EmoteType = EMOTE_PAIN;
+	m_EmoteStop = Server()->Tick() + 500 * Server()->TickSpeed() / 1000;
+	return true;
+}
+
+void CNpc::Die(int Killer, int Weapon)
+{
+	if(m_MarkedForDestroy)
+		return;
+
+	CPlayer *pKiller = Killer >= 0 && Killer < MAX_CLIENTS ? GameServer()->m_apPlayers[Killer] : 0;
+	GameServer()->m_pController->OnNpcDeath(this, pKiller, Weapon);
+
+	GameServer()->CreateSound(m_Pos, SOUND_PLAYER_DIE);
+	GameServer()->CreateDeath(m_Pos, -1);
+	GameServer()->m_World.DestroyEntity(this);
+}
+
+void CNpc::Snap(int SnappingClient)
+{
+	if(NetworkClipped(SnappingClient))
+		return;
+
+	CNetObj_Npc *pNpc = static_cast<CNetObj_Npc *>(GameServer()->SnapNewItem(NETOBJTYPE_NPC, m_ID, sizeof(CNetObj_Npc), CSnapMaster::CLIP_VIEW, m_Pos));
+	if(!pNpc)
+		return;
+
+	// no dead reckoning, the clients only interpolate them
+	m_Core.Write(pNpc);
+	pNpc->m_Tick = 0;
+
+	if(m_EmoteStop < Server()->Tick())
+	{
+		m_EmoteType = EMOTE_NORMAL;
+		m_EmoteStop = -1;
+	}
+
+	pNpc->m_Type = m_Type;
+	pNpc->m_Health = clamp(m_Health, 0, 10);
+	pNpc->m_Weapon = m_Weapon;
+	pNpc->m_Emote = m_EmoteType;
+	pNpc->m_AttackTick = m_AttackTick;
+}
@@ -0,0 +1,129 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_ENTITIES_NPC_H
+#define GAME_SERVER_ENTITIES_NPC_H
+
+#include <game/server/entity.h>
+#include <game/generated/protocol.h>
+
+#include <engine/shared/jobs.h>
+#include <game/gamecore.h>
+
+/*
+	Class: NPC
+		A monster or animal. Moves like a character but has no player
+		and no client id, so any number of them fits next to the
+		players. The ai runs for all of them at once from the
+		controller, see UpdateAll.
+*/
+class CNpc : public CEntity
+{
+	MACRO_ALLOC_POOL()
+
+public:
+	static const int ms_PhysSize = 28;
+
+	enum
+	{
+		MAX_PATH=32,
+
+		// what Think decided to do to the world, Act does it
+		ACTION_NONE=0,
+		ACTION_DIE,
+		ACTION_EXPLODE,
+		ACTION_ATTACK,
+	};
+
+	// what the ai looks at, gathered once per tick for all npcs
+	class CTargets
+	{
+	public:
+		class CCharacter *m_apChars[MAX_CLIENTS];
+		int m_aClientIDs[MAX_CLIENTS];
+		int m_Num;
+		bool m_IsDay;
+	};
+
+	CNpc(CGameWorld *pWorld, int Type, vec2 Pos);
+
+	virtual void Reset();
+	virtual void Tick();
+	virtual void TickDefered();
+	virtual void Snap(int SnappingClient);
+
+	/*
+		Function: UpdateAll
+			Runs the ai of the npcs. Each one thinks on its own,
+			spread over sv_npc_threads workers, with the world only
+			read. What they do to it happens after that, one by one
+			in list order, so the outcome is the same with any number
+			of threads.
+	*/
+	static void UpdateAll(class CGameContext *pGameServer, CNpc **apNpcs, int Num, const CTargets *pTargets);
+	bool TakeDamage(vec2 Force, int Dmg, int From, int Weapon);
+	void Die(int Killer, int Weapon);
+
+	int GetType() const { return m_Type; }
+	bool IsMonster() const { return m_Type >= TEAM_ENEMY_TEEPER && m_Type <= TEAM_ENEMY_SPIDERTEE; }
+	bool IsAnimal() const { return m_Type >= TEAM_ANIMAL_TEECOW && m_Type <= TEAM_ANIMAL_TEEPIG; }
+	bool IsGrounded();
+
+	static void GatherTargets(class CGameContext *pGameServer, CTargets *pTargets);
+
+private:
+	CCharacterCore m_Core;
+	int m_Type; // TEAM_ENEMY_* or TEAM_ANIMAL_*
+	int m_Health;
+	int m_Weapon;
+	int m_AttackTick;
+	int m_ReloadTimer;
+	int m_EmoteType;
+	int m_EmoteStop;
+	int m_DamageTakenTick;
+	int m_FluidTick;
+	bool m_InWater;
+
+	// ai
+	int m_Direction;
+	int m_Jump;
+	vec2 m_Target;
+	int m_TargetID; // player to attack next tick, -1 for none
+	vec2 m_LastPos;
+	int m_StuckCount;
+	int m_LastStuckTick;
+	int m_PlayerFoundTick;
+	int m_GroundedTick;
+	int m_LastOptionTick;
+	unsigned m_Seed;
+	int m_LastSoundTick;
+
+	// the decision of the last Think
+	int m_Action;
+	int m_ActionVictim;
+	int m_ActionSound;
+
+	// the way to the player that is chased, cells of the nav graph
+	int m_aPath[MAX_PATH];
+	int m_PathLength;
+	int m_PathPos;
+	int m_PathGoal;
+	int m_PathRevision;
+	int m_PathTick;
+
+	void Think(const CTargets *pTargets, int Search);
+	void Act();
+	void Attack(class CCharacter *pChr);
+	bool FollowPath(vec2 Goal, int Search);
+
+	struct CThinkJob
+	{
+		CJob m_Job;
+		CNpc **m_apNpcs;
+		int m_Num;
+		const CTargets *m_pTargets;
+		int m_Search;
+	};
+	static int ThinkJob(void *pUser);
+};
+
+#endif
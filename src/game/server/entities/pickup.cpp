@@ -4,6 +4,9 @@
 #include <game/server/gamecontext.h>
 #include "pickup.h"
 
+// minetee drops a pickup for every broken block, when they run out the oldest drop goes
+MACRO_ALLOC_POOL_IMPL(CPickup, 2048)
+
 CPickup::CPickup(CGameWorld *pGameWorld, int Type, int SubType)
 : CEntity(pGameWorld, CGameWorld::ENTTYPE_PICKUP)
 {
@@ -26,6 +29,24 @@ CPickup::CPickup(CGameWorld *pGameWorld, int Type, int SubType)
 	Reset();
 
 	GameWorld()->InsertEntity(this);
+
+	// make room for the next one, the drops expire anyway
+	if(ms_Pool.Full())
+		RecycleOldest();
+}
+
+void CPickup::RecycleOldest()
+{
+	CPickup *pOldest = 0;
+	for(CPickup *p = (CPickup *)GameWorld()->FindFirst(CGameWorld::ENTTYPE_PICKUP); p; p = (CPickup *)p->TypeNext())
+		if(p != this && p->m_DestroyTick != -1 && !p->m_MarkedForDestroy)
+			pOldest = p;
+
+	if(pOldest)
+	{
+		GameWorld()->DestroyEntity(pOldest);
+		ms_Pool.m_NumRecycled++;
+	}
 }
 
 void CPickup::Reset()
@@ -67,7 +88,9 @@ void CPickup::Tick()
 	CCharacter *pChr = 0x0;
 	if (m_Type == POWERUP_DROPITEM)
 	{
-        GameServer()->Collision()->MoveBox(&m_Pos, &m_Vel, vec2(32.0f, 32.0f), 0.5f);
+        vec2 Pos = m_Pos;
+        GameServer()->Collision()->MoveBox(&Pos, &m_Vel, vec2(32.0f, 32.0f), 0.5f);
+        SetPos(Pos);
         m_Vel.y += GameServer()->m_World.m_Core.m_Tuning.m_Gravity;
         m_Vel.x += (m_Vel.x < 0.0f)?0.05f:-0.05f;
 
@@ -219,7 +242,7 @@ void CPickup::Snap(int SnappingClient)
 	if(m_SpawnTick != -1 || NetworkClipped(SnappingClient))
 		return;
 
-	CNetObj_Pickup *pP = static_cast<CNetObj_Pickup *>(Server()->SnapNewItem(NETOBJTYPE_PICKUP, m_ID, sizeof(CNetObj_Pickup)));
+	CNetObj_Pickup *pP = static_cast<CNetObj_Pickup *>(GameServer()->SnapNewItem(NETOBJTYPE_PICKUP, m_ID, sizeof(CNetObj_Pickup), CSnapMaster::CLIP_VIEW, m_Pos));
 	if(!pP)
 		return;
 
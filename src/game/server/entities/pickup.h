@@ -9,6 +9,8 @@ const int PickupPhysSize = 14;
 
 class CPickup : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 public:
 	CPickup(CGameWorld *pGameWorld, int Type, int SubType = 0);
 
@@ -26,6 +28,8 @@ private:
 	int m_SpawnTick;
 	int m_DestroyTick;  //H-Client
 	float m_TimerOwnerTake; //H-Client
+
+	void RecycleOldest();
 };
 
 #endif
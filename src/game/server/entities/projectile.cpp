@@ -3,13 +3,17 @@
 #include <game/generated/protocol.h>
 #include <game/server/gamecontext.h>
 #include "projectile.h"
+#include "npc.h"
+
+// every player and bot firing grenades and shotguns at once
+MACRO_ALLOC_POOL_IMPL(CProjectile, 1024)
 
 CProjectile::CProjectile(CGameWorld *pGameWorld, int Type, int Owner, vec2 Pos, vec2 Dir, int Span,
 		int Damage, bool Explosive, float Force, int SoundImpact, int Weapon)
 : CEntity(pGameWorld, CGameWorld::ENTTYPE_PROJECTILE)
 {
 	m_Type = Type;
-	m_Pos = Pos;
+	SetPos(Pos);
 	m_Direction = Dir;
 	m_LifeSpan = Span;
 	m_Owner = Owner;
@@ -64,10 +68,14 @@ void CProjectile::Tick()
 	int Collide = GameServer()->Collision()->IntersectLine(PrevPos, CurPos, &CurPos, 0);
 	CCharacter *OwnerChar = GameServer()->GetPlayerChar(m_Owner);
 	CCharacter *TargetChr = GameServer()->m_World.IntersectCharacter(PrevPos, CurPos, 6.0f, CurPos, OwnerChar);
+	// the npcs don't shoot each other
+	CNpc *TargetNpc = 0;
+	if(m_Owner >= 0)
+		TargetNpc = (CNpc *)GameServer()->m_World.IntersectEntity(PrevPos, CurPos, 6.0f, CurPos, 0, CGameWorld::ENTTYPE_NPC);
 
 	m_LifeSpan--;
 
-	if(TargetChr || Collide || m_LifeSpan < 0 || GameLayerClipped(CurPos))
+	if(TargetChr || TargetNpc || Collide || m_LifeSpan < 0 || GameLayerClipped(CurPos))
 	{
 		if(m_LifeSpan >= 0 || m_Weapon == WEAPON_GRENADE)
 			GameServer()->CreateSound(CurPos, m_SoundImpact);
@@ -75,6 +83,9 @@ void CProjectile::Tick()
 		if(m_Explosive)
 			GameServer()->CreateExplosion(CurPos, m_Owner, m_Weapon, false);
 
+		// the npc was checked on what is left up to the character, it's closer
+		else if(TargetNpc)
+			TargetNpc->TakeDamage(m_Direction * max(0.001f, m_Force), m_Damage, m_Owner, m_Weapon);
 		else if(TargetChr)
 			TargetChr->TakeDamage(m_Direction * max(0.001f, m_Force), m_Damage, m_Owner, m_Weapon);
 
@@ -82,13 +93,7 @@ void CProjectile::Tick()
         {
             if (GameServer()->Collision()->GetMineTeeBlockAt(CurPos.x+m_Direction.x*8.0f, CurPos.y+m_Direction.y*8.0f) == BLOCK_TNT)
             {
-                CNetMsg_Sv_TileChangeExt TileInfo;
-                TileInfo.m_Size = -1;
-                TileInfo.m_Index = -1;
-                TileInfo.m_X = static_cast<int>(CurPos.x/32.0f);
-                TileInfo.m_Y = static_cast<int>(CurPos.y/32.0f);
-                TileInfo.m_Act = TILE_DESTROY;
-                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                GameServer()->SendTileChange(static_cast<int>(CurPos.x/32.0f), static_cast<int>(CurPos.y/32.0f), TILE_DESTROY, 0, 0, 0);
 
                 GameServer()->CreateExplosion(CurPos, m_Owner, WEAPON_WORLD, false);
                 GameServer()->CreateSound(CurPos, SOUND_GRENADE_EXPLODE);
@@ -112,11 +117,12 @@ void CProjectile::FillInfo(CNetObj_Projectile *pProj)
 void CProjectile::Snap(int SnappingClient)
 {
 	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+	vec2 CurPos = GetPos(Ct);
 
-	if(NetworkClipped(SnappingClient, GetPos(Ct)))
+	if(NetworkClipped(SnappingClient, CurPos))
 		return;
 
-	CNetObj_Projectile *pProj = static_cast<CNetObj_Projectile *>(Server()->SnapNewItem(NETOBJTYPE_PROJECTILE, m_ID, sizeof(CNetObj_Projectile)));
+	CNetObj_Projectile *pProj = static_cast<CNetObj_Projectile *>(GameServer()->SnapNewItem(NETOBJTYPE_PROJECTILE, m_ID, sizeof(CNetObj_Projectile), CSnapMaster::CLIP_VIEW, CurPos));
 	if(pProj)
 		FillInfo(pProj);
 }
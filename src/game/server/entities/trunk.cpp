@@ -1,5 +1,7 @@
 #include "trunk.h"
 
+MACRO_ALLOC_POOL_IMPL(CTrunk, 64)
+
 CTrunk::CTrunk(CGameWorld *pWorld, int Type)
 : CEntity(pWorld, CGameWorld::ENTTYPE_TRUNK)
 {
@@ -19,6 +21,7 @@ CTrunk::CTrunk(CGameWorld *pWorld, int Type)
 void CTrunk::Destroy()
 {
     mem_free(m_pItems);
+    delete this;
 }
 
 void CTrunk::Reset()
@@ -15,6 +15,8 @@ enum
 
 class CTrunk : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 private:
     int m_MaxItems;
     int m_Type;
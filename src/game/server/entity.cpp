@@ -4,6 +4,65 @@
 #include "entity.h"
 #include "gamecontext.h"
 
+//////////////////////////////////////////////////
+// Entity pool
+//////////////////////////////////////////////////
+CEntityPool *CEntityPool::ms_pFirst = 0;
+
+CEntityPool::CEntityPool(const char *pName, int Size, int Capacity, char *pData, int *pFreeList)
+{
+	m_pName = pName;
+	m_Size = Size;
+	m_Capacity = Capacity;
+	m_pData = pData;
+	m_pFreeList = pFreeList;
+
+	// hand out the lowest slots first
+	m_NumFree = Capacity;
+	for(int i = 0; i < Capacity; i++)
+		m_pFreeList[i] = Capacity-1-i;
+
+	m_Peak = 0;
+	m_NumHeap = 0;
+	m_NumOverflows = 0;
+	m_NumRecycled = 0;
+
+	m_pNext = ms_pFirst;
+	ms_pFirst = this;
+}
+
+void *CEntityPool::Alloc()
+{
+	void *p;
+	if(m_NumFree)
+	{
+		p = m_pData + m_pFreeList[--m_NumFree]*m_Size;
+		m_Peak = max(m_Peak, Used());
+	}
+	else
+	{
+		p = mem_alloc(m_Size, 1);
+		m_NumHeap++;
+		m_NumOverflows++;
+	}
+	mem_zero(p, m_Size);
+	return p;
+}
+
+void CEntityPool::Free(void *p)
+{
+	if((char *)p < m_pData || (char *)p >= m_pData + m_Capacity*m_Size)
+	{
+		mem_free(p);
+		m_NumHeap--;
+		return;
+	}
+
+	int Offset = (int)((char *)p - m_pData);
+	dbg_assert(Offset%m_Size == 0 && m_NumFree < m_Capacity, "not from this pool");
+	m_pFreeList[m_NumFree++] = Offset/m_Size;
+}
+
 //////////////////////////////////////////////////
 // Entity
 //////////////////////////////////////////////////
@@ -20,6 +79,10 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType)
 
 	m_pPrevTypeEntity = 0;
 	m_pNextTypeEntity = 0;
+	m_pPrevCellEntity = 0;
+	m_pNextCellEntity = 0;
+	m_GridCell = -1;
+	m_InsertOrder = 0;
 }
 
 CEntity::~CEntity()
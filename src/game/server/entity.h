@@ -50,6 +50,65 @@
 		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
 	}
 
+/*
+	Class: Entity pool
+		Fixed number of slots for one entity type with a free list,
+		so the short lived entities don't go through the heap. When
+		all slots are taken it falls back to the heap and counts it.
+*/
+class CEntityPool
+{
+	const char *m_pName;
+	int m_Size;
+	int m_Capacity;
+	char *m_pData;
+	int *m_pFreeList;
+	int m_NumFree;
+
+	CEntityPool *m_pNext;
+	static CEntityPool *ms_pFirst;
+
+public:
+	CEntityPool(const char *pName, int Size, int Capacity, char *pData, int *pFreeList);
+
+	void *Alloc();
+	void Free(void *p);
+
+	bool Full() const { return m_NumFree == 0; }
+	int Capacity() const { return m_Capacity; }
+	int Used() const { return m_Capacity-m_NumFree; }
+
+	const char *Name() const { return m_pName; }
+	CEntityPool *Next() const { return m_pNext; }
+	static CEntityPool *First() { return ms_pFirst; }
+
+	int m_Peak;
+	int m_NumHeap; // currently allocated from the heap because the pool was full
+	int m_NumOverflows;
+	int m_NumRecycled; // made room by removing an older entity
+};
+
+#define MACRO_ALLOC_POOL() \
+	public: \
+	void *operator new(size_t Size); \
+	void operator delete(void *p); \
+	static CEntityPool ms_Pool; \
+	private:
+
+#define MACRO_ALLOC_POOL_IMPL(POOLTYPE, PoolSize) \
+	static char ms_PoolData##POOLTYPE[PoolSize][sizeof(POOLTYPE)] = {{0}}; \
+	static int ms_PoolFreeList##POOLTYPE[PoolSize]; \
+	CEntityPool POOLTYPE::ms_Pool(#POOLTYPE, sizeof(POOLTYPE), PoolSize, ms_PoolData##POOLTYPE[0], ms_PoolFreeList##POOLTYPE); \
+	void *POOLTYPE::operator new(size_t Size) \
+	{ \
+		dbg_assert(sizeof(POOLTYPE) == Size, "size error"); \
+		return ms_Pool.Alloc(); \
+	} \
+	void POOLTYPE::operator delete(void *p) \
+	{ \
+		ms_Pool.Free(p); \
+	}
+
 /*
 	Class: Entity
 		Basic entity class.
@@ -62,6 +121,12 @@ class CEntity
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
 
+	// grid cell the entity is linked into, -1 if it is not in the world
+	CEntity *m_pPrevCellEntity;
+	CEntity *m_pNextCellEntity;
+	int m_GridCell;
+	int64 m_InsertOrder;
+
 	class CGameWorld *m_pGameWorld;
 protected:
 	bool m_MarkedForDestroy;
@@ -137,6 +202,20 @@ public:
 
 	bool GameLayerClipped(vec2 CheckPos);
 
+	/*
+		Function: set_pos
+			Moves the entity and keeps the world grid up to date.
+
+		Arguments:
+			pos - The new position.
+	*/
+	void SetPos(vec2 Pos)
+	{
+		m_Pos = Pos;
+		if(m_GridCell != -1)
+			m_pGameWorld->UpdateEntityCell(this);
+	}
+
 	/*
 		Variable: proximity_radius
 			Contains the physical size of the entity.
@@ -145,7 +224,8 @@ public:
 
 	/*
 		Variable: pos
-			Contains the current posititon of the entity.
+			Contains the current posititon of the entity. Only read
+			it, moving the entity goes through SetPos.
 	*/
 	vec2 m_Pos;
 };
@@ -17,7 +17,7 @@ void CEventHandler::SetGameServer(CGameContext *pGameServer)
 	m_pGameServer = pGameServer;
 }
 
-void *CEventHandler::Create(int Type, int Size, int Mask)
+void *CEventHandler::Create(int Type, int Size, const CClientMask &Mask)
 {
 	if(m_NumEvents == MAX_EVENTS)
 		return 0;
@@ -49,7 +49,7 @@ void CEventHandler::Snap(int SnappingClient)
 			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
 			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < 1500.0f)
 			{
-				void *d = GameServer()->Server()->SnapNewItem(m_aTypes[i], i, m_aSizes[i]);
+				void *d = GameServer()->SnapNewItem(m_aTypes[i], i, m_aSizes[i], CSnapMaster::CLIP_EVENT, vec2(ev->m_X, ev->m_Y), m_aClientMasks[i]);
 				if(d)
 					mem_copy(d, &m_aData[m_aOffsets[i]], m_aSizes[i]);
 			}
@@ -1,8 +1,10 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <new>
+#include <algorithm> // stable_sort
 #include <base/math.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/map.h>
 #include <engine/console.h>
 #include "gamecontext.h"
@@ -10,6 +12,7 @@
 #include <game/collision.h>
 #include <game/gamecore.h>
 #include <game/server/entities/pickup.h> //H-Client
+#include <game/server/entities/npc.h>
 #include "gamemodes/dm.h"
 #include "gamemodes/tdm.h"
 #include "gamemodes/ctf.h"
@@ -29,12 +32,17 @@ void CGameContext::Construct(int Resetting)
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_apPlayers[i] = 0;
+	m_NumPlayerIDs = 0;
 
 	m_pController = 0;
 	m_VoteCloseTime = 0;
 	m_pVoteOptionFirst = 0;
 	m_pVoteOptionLast = 0;
 	m_NumVoteOptions = 0;
+	m_pTileChanges = 0;
+	m_NumTileChanges = 0;
+	m_TileChangeCapacity = 0;
+	m_NumNpcsSpawned = 0;
 
 	if(Resetting==NO_RESET)
 		m_pVoteOptionHeap = new CHeap();
@@ -56,6 +64,8 @@ CGameContext::~CGameContext()
 		delete m_apPlayers[i];
 	if(!m_Resetting)
 		delete m_pVoteOptionHeap;
+	if(m_pTileChanges)
+		mem_free(m_pTileChanges);
 }
 
 void CGameContext::Clear()
@@ -79,6 +89,28 @@ void CGameContext::Clear()
 }
 
 
+void CGameContext::AddPlayerID(int ClientID)
+{
+	// keep them sorted, the players get ticked and snapped in id order
+	int i = m_NumPlayerIDs++;
+	for(; i > 0 && m_aPlayerIDs[i-1] > ClientID; i--)
+		m_aPlayerIDs[i] = m_aPlayerIDs[i-1];
+	m_aPlayerIDs[i] = ClientID;
+}
+
+void CGameContext::RemovePlayerID(int ClientID)
+{
+	for(int i = 0; i < m_NumPlayerIDs; i++)
+	{
+		if(m_aPlayerIDs[i] == ClientID)
+		{
+			mem_move(&m_aPlayerIDs[i], &m_aPlayerIDs[i+1], (m_NumPlayerIDs-i-1)*sizeof(int));
+			m_NumPlayerIDs--;
+			return;
+		}
+	}
+}
+
 class CCharacter *CGameContext::GetPlayerChar(int ClientID)
 {
 	if(ClientID < 0 || ClientID >= MAX_CLIENTS || !m_apPlayers[ClientID])
@@ -86,6 +118,13 @@ class CCharacter *CGameContext::GetPlayerChar(int ClientID)
 	return m_apPlayers[ClientID]->GetCharacter();
 }
 
+void *CGameContext::SnapNewItem(int Type, int ID, int Size, int Clip, vec2 Pos, const CClientMask &Mask)
+{
+	if(m_SnapMaster.Building())
+		return m_SnapMaster.NewItem(Type, ID, Size, Clip, Pos, Mask);
+	return Server()->SnapNewItem(Type, ID, Size);
+}
+
 void CGameContext::CreateDamageInd(vec2 Pos, float Angle, int Amount)
 {
 	float a = 3 * 3.14159f / 2 + Angle;
@@ -147,13 +186,32 @@ void CGameContext::CreateExplosion(vec2 Pos, int Owner, int Weapon, bool NoDamag
 				apEnts[i]->TakeDamage(ForceDir*Dmg*2, (int)Dmg, Owner, Weapon);
 		}
 
+		// the npcs don't blow each other up
+		if(Owner >= 0)
+		{
+			CNpc *apNpcs[256];
+			Num = m_World.FindEntities(Pos, Radius, (CEntity**)apNpcs, 256, CGameWorld::ENTTYPE_NPC);
+			for(int i = 0; i < Num; i++)
+			{
+				vec2 Diff = apNpcs[i]->m_Pos - Pos;
+				vec2 ForceDir(0,1);
+				float l = length(Diff);
+				if(l)
+					ForceDir = normalize(Diff);
+				l = 1-clamp((l-InnerRadius)/(Radius-InnerRadius), 0.0f, 1.0f);
+				float Dmg = 6 * l;
+				if((int)Dmg)
+					apNpcs[i]->TakeDamage(ForceDir*Dmg*2, (int)Dmg, Owner, Weapon);
+			}
+		}
+
 		//Destroy Map
         if (str_comp_nocase(GameType(), "MineTee") == 0 || str_comp_nocase(GameType(), "CTF-BREAK") == 0)
         {
             vec2 ColTilePos = Pos;
 
             int Index = (int)(ColTilePos.x/32) + (int)(ColTilePos.y/32) * Collision()->GetWidth();
-            if (Owner < MAX_CLIENTS-MAX_BOTS && Collision()->m_pSecBlocks[Index] != -1 && Collision()->m_pSecBlocks[Index] != Owner)
+            if (Owner >= 0 && Collision()->m_pSecBlocks[Index] != -1 && Collision()->m_pSecBlocks[Index] != Owner)
             {
                 char aBuf[128];
                 str_format(aBuf, sizeof(aBuf), "** You can't detroy this block... contact with '%s' or wait until he leaves.", Server()->ClientName(Collision()->m_pSecBlocks[Index]));
@@ -190,13 +248,8 @@ void CGameContext::CreateExplosion(vec2 Pos, int Owner, int Weapon, bool NoDamag
                     int TIndex = Collision()->DestroyTile(finishPosPost);
                     if (TIndex > 0)
                     {
-                        CNetMsg_Sv_TileChangeExt TileInfo;
-                        TileInfo.m_Size = -1;
-                        TileInfo.m_Index = -1;
-                        TileInfo.m_X = static_cast<int>(finishPosPost.x/32.0f);
-                        TileInfo.m_Y = static_cast<int>(finishPosPost.y/32.0f);
-                        TileInfo.m_Act = TILE_DESTROY;
-                        Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                        ivec2 TilePos(static_cast<int>(finishPosPost.x/32.0f), static_cast<int>(finishPosPost.y/32.0f));
+                        SendTileChange(TilePos.x, TilePos.y, TILE_DESTROY, 0, 0, 0);
 
                         if (str_comp_nocase(GameType(), "MineTee") == 0)
                         {
@@ -223,7 +276,7 @@ void CGameContext::CreateExplosion(vec2 Pos, int Owner, int Weapon, bool NoDamag
                                     TIndex = BLOCK_DIAMANTEP;
 
                                 CPickup *pPickup = new CPickup(&m_World, POWERUP_BLOCK, TIndex);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
+                                pPickup->SetPos(vec2(TilePos.x*32.0f + 8.0f, TilePos.y*32.0f + 8.0f));
                             }
                         }
 
@@ -270,7 +323,7 @@ void CGameContext::CreateDeath(vec2 Pos, int ClientID)
 	}
 }
 
-void CGameContext::CreateSound(vec2 Pos, int Sound, int Mask)
+void CGameContext::CreateSound(vec2 Pos, int Sound, const CClientMask &Mask)
 {
 	if (Sound < 0)
 		return;
@@ -347,7 +400,7 @@ void CGameContext::SendChat(int ChatterClientID, int Team, const char *pText)
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
 
 		// send to the clients
-		for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
 			if(m_apPlayers[i] && m_apPlayers[i]->GetTeam() == Team)
 				Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
@@ -378,6 +431,116 @@ void CGameContext::SendBroadcast(const char *pText, int ClientID)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
 }
 
+void CGameContext::SendTileChange(int x, int y, int Act, int ITile, int Col, int State)
+{
+	if(!g_Config.m_SvTileBatches)
+	{
+		CNetMsg_Sv_TileChangeExt TileInfo;
+		TileInfo.m_Size = -1;
+		TileInfo.m_Index = -1;
+		TileInfo.m_X = x;
+		TileInfo.m_Y = y;
+		TileInfo.m_ITile = ITile;
+		TileInfo.m_State = State;
+		TileInfo.m_Col = Col;
+		TileInfo.m_Act = Act;
+		Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+		return;
+	}
+
+	if(x < 0 || x >= Collision()->GetWidth() || y < 0 || y >= Collision()->GetHeight() || State < 0 || State > 2)
+		return;
+
+	if(m_NumTileChanges == m_TileChangeCapacity)
+	{
+		int Capacity = max(256, m_TileChangeCapacity*2);
+		CTileChange *pTileChanges = (CTileChange *)mem_alloc(Capacity*sizeof(CTileChange), 1);
+		if(m_pTileChanges)
+		{
+			mem_copy(pTileChanges, m_pTileChanges, m_NumTileChanges*sizeof(CTileChange));
+			mem_free(m_pTileChanges);
+		}
+		m_pTileChanges = pTileChanges;
+		m_TileChangeCapacity = Capacity;
+	}
+
+	CTileChange *pChange = &m_pTileChanges[m_NumTileChanges++];
+	pChange->m_Key = (State*Collision()->GetHeight()+y)*Collision()->GetWidth()+x;
+	pChange->m_Value = Act == TILE_CREATE ? (ITile+1)|((Col ? 1 : 0)<<9) : 0;
+}
+
+void CGameContext::FlushTileChanges()
+{
+	if(!m_NumTileChanges)
+		return;
+
+	// in map order, only the last change of a tile counts
+	std::stable_sort(m_pTileChanges, m_pTileChanges+m_NumTileChanges);
+	int Num = 0;
+	for(int i = 0; i < m_NumTileChanges; i++)
+	{
+		if(i+1 < m_NumTileChanges && m_pTileChanges[i+1].m_Key == m_pTileChanges[i].m_Key)
+			continue;
+		m_pTileChanges[Num++] = m_pTileChanges[i];
+	}
+	m_NumTileChanges = 0;
+
+	// runs of the same change on consecutive tiles, each as the distance
+	// from the end of the last run, the length and the value
+	enum
+	{
+		MAX_BATCH_SIZE=1024,
+	};
+	CPacker Runs;
+	Runs.Reset();
+	int NumRuns = 0;
+	int LastEnd = 0;
+	for(int i = 0; i < Num;)
+	{
+		int Length = 1;
+		while(i+Length < Num && m_pTileChanges[i+Length].m_Key == m_pTileChanges[i].m_Key+Length && m_pTileChanges[i+Length].m_Value == m_pTileChanges[i].m_Value)
+			Length++;
+
+		Runs.AddInt(m_pTileChanges[i].m_Key-LastEnd);
+		Runs.AddInt(Length);
+		Runs.AddInt(m_pTileChanges[i].m_Value);
+		NumRuns++;
+		LastEnd = m_pTileChanges[i].m_Key+Length;
+		i += Length;
+
+		// a message stays in one chunk, the next starts over from the beginning of the map
+		if(Runs.Size() >= MAX_BATCH_SIZE || i == Num)
+		{
+			CMsgPacker Msg(NETMSGTYPE_SV_TILECHANGEBATCH);
+			Msg.AddInt(NumRuns);
+			Msg.AddRaw(Runs.Data(), Runs.Size());
+			Server()->SendMsg(&Msg, MSGFLAG_VITAL, -1);
+
+			Runs.Reset();
+			NumRuns = 0;
+			LastEnd = 0;
+		}
+	}
+}
+
+void CGameContext::CompactTileDiffs(int JoiningID)
+{
+	// the slot indices change, nobody may be in the middle of the download
+	for(int i = 0; i < m_NumPlayerIDs; i++)
+	{
+		CPlayer *pPlayer = m_apPlayers[m_aPlayerIDs[i]];
+		if(m_aPlayerIDs[i] == JoiningID || pPlayer->m_MineTeeSync)
+			continue;
+
+		// a client that stopped asking must not hold the slots forever, it gets no more of the old ones
+		if(Server()->Tick()-pPlayer->m_MineTeeSyncTick < Server()->TickSpeed()*g_Config.m_SvTileSyncTimeout)
+			return;
+		pPlayer->m_MineTeeSync = true;
+		pPlayer->m_MineTeeSyncSize = 0;
+	}
+	Layers()->m_TileDiffs.Compact();
+}
+
 //
 void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char *pReason)
 {
@@ -490,17 +653,27 @@ void CGameContext::OnTick()
 	m_World.Tick();
 
 	//if(world.paused) // make sure that the game object always updates
-	m_pController->Tick();
+	{
+		static int s_ProfileController = g_Profiler.Section("controller");
+		CProfileScope Scope(s_ProfileController);
+		m_pController->Tick();
+	}
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(m_apPlayers[i])
+		static int s_ProfilePlayers = g_Profiler.Section("players");
+		CProfileScope Scope(s_ProfilePlayers);
+		for(int i = 0; i < m_NumPlayerIDs; i++)
 		{
-			m_apPlayers[i]->Tick();
-			m_apPlayers[i]->PostTick();
+			CPlayer *pPlayer = m_apPlayers[m_aPlayerIDs[i]];
+			pPlayer->Tick();
+			pPlayer->PostTick();
 		}
 	}
 
+	// every change of a tile frees the slot of the last one
+	if(Layers()->m_TileDiffs.NumFree() > max(1024, Layers()->m_TileDiffs.NumDiffs()))
+		CompactTileDiffs(-1);
+
 	// update voting
 	if(m_VoteCloseTime)
 	{
@@ -586,7 +759,7 @@ void CGameContext::OnTick()
 		{
 			CNetObj_PlayerInput Input = {0};
 			Input.m_Direction = (i&1)?-1:1;
-			m_apPlayers[MAX_CLIENTS-i-1]->OnPredictedInput(&Input);
+			m_apPlayers[Server()->MaxClients()-i-1]->OnPredictedInput(&Input);
 		}
 	}
 #endif
@@ -630,37 +803,29 @@ void CGameContext::OnClientEnter(int ClientID)
         SendChatTarget(ClientID, " ");
     }
 
-	m_VoteUpdate = true;
-}
-
-void CGameContext::UpdateBotInfo(int ClientID, int TEnemy)
-{
-    char NameSkin[64];
-    if (TEnemy == TEAM_ENEMY_TEEPER)
-        str_copy(NameSkin, "x_teeper", sizeof(NameSkin));
-    else if (TEnemy == TEAM_ENEMY_ZOMBITEE)
-        str_copy(NameSkin, "x_zombitee", sizeof(NameSkin));
-    else if (TEnemy == TEAM_ENEMY_SPIDERTEE)
-        str_copy(NameSkin, "x_spidertee", sizeof(NameSkin));
-    else if (TEnemy == TEAM_ENEMY_SKELETEE)
-        str_copy(NameSkin, "x_skeletee", sizeof(NameSkin));
-    else if (TEnemy == TEAM_ANIMAL_TEECOW)
-        str_copy(NameSkin, "x_teecow", sizeof(NameSkin));
-    else if (TEnemy == TEAM_ANIMAL_TEEPIG)
-        str_copy(NameSkin, "x_teepig", sizeof(NameSkin));
-
-    Server()->InitBot(ClientID, TEnemy);
-    str_copy(m_apPlayers[ClientID]->m_TeeInfos.m_SkinName, NameSkin, sizeof(m_apPlayers[ClientID]->m_TeeInfos.m_SkinName));
-    m_apPlayers[ClientID]->m_TeeInfos.m_UseCustomColor = false;
-    m_pController->OnPlayerInfoChange(m_apPlayers[ClientID]);
+	//H-Client: send Map State, from here on the changes come live with the snapshots
+    if (str_comp_nocase(GameType(), "MineTee") == 0 || str_comp_nocase(GameType(), "CTF-BREAK") == 0)
+    {
+        CompactTileDiffs(ClientID);
+        int Size = Layers()->m_TileDiffs.Size();
+        m_apPlayers[ClientID]->m_MineTeeSyncSize = Size;
+        if (Size > 0)
+        {
+            CNetMsg_Sv_TileChangeExt TInfo;
+            TInfo.m_Size = Size;
+            TInfo.m_Index = -1;
 
-}
+            Server()->SendPackMsg(&TInfo, MSGFLAG_VITAL, ClientID);
+            m_apPlayers[ClientID]->m_MineTeeSync = false;
+            m_apPlayers[ClientID]->m_MineTeeSyncTick = Server()->Tick();
+        }
+        else
+            m_apPlayers[ClientID]->m_MineTeeSync = true;
+    }
+    else
+        m_apPlayers[ClientID]->m_MineTeeSync = true;
 
-void CGameContext::CreateBot(int ClientID)
-{
-    int BotClientID = 16+ClientID;
-    m_apPlayers[BotClientID] = new(BotClientID) CPlayer(this, BotClientID, TEAM_ENEMY_TEEPER); //TODO: Need be fixed
-    m_apPlayers[BotClientID]->TryRespawn();
+	m_VoteUpdate = true;
 }
 
 void CGameContext::OnClientConnected(int ClientID)
@@ -669,6 +834,7 @@ void CGameContext::OnClientConnected(int ClientID)
 	const int StartTeam = g_Config.m_SvTournamentMode ? TEAM_SPECTATORS : m_pController->GetAutoTeam(ClientID);
 
 	m_apPlayers[ClientID] = new(ClientID) CPlayer(this, ClientID, StartTeam);
+	AddPlayerID(ClientID);
 	//players[client_id].init(client_id);
 	//players[client_id].client_id = client_id;
 
@@ -677,7 +843,7 @@ void CGameContext::OnClientConnected(int ClientID)
 #ifdef CONF_DEBUG
 	if(g_Config.m_DbgDummies)
 	{
-		if(ClientID >= MAX_CLIENTS-g_Config.m_DbgDummies)
+		if(ClientID >= Server()->MaxClients()-g_Config.m_DbgDummies)
 			return;
 	}
 #endif
@@ -691,24 +857,8 @@ void CGameContext::OnClientConnected(int ClientID)
 	Msg.m_pMessage = g_Config.m_SvMotd;
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
 
-	//H-Client: send Map State
-    if (str_comp_nocase(GameType(), "MineTee") == 0 || str_comp_nocase(GameType(), "CTF-BREAK") == 0)
-    {
-        int Size = Layers()->m_BuffNetTileChange.size();
-        if (Size > 0)
-        {
-            CNetMsg_Sv_TileChangeExt TInfo;
-            TInfo.m_Size = Size;
-            TInfo.m_Index = -1;
-
-            Server()->SendPackMsg(&TInfo, MSGFLAG_VITAL, ClientID);
-            m_apPlayers[ClientID]->m_MineTeeSync = false;
-        }
-        else
-            m_apPlayers[ClientID]->m_MineTeeSync = true;
-    }
-    else
-        m_apPlayers[ClientID]->m_MineTeeSync = true;
+	//H-Client: the map state goes out on enter, the tile changes before that would not reach it live
+	m_apPlayers[ClientID]->m_MineTeeSync = true;
 }
 
 void CGameContext::OnClientDrop(int ClientID, const char *pReason)
@@ -717,6 +867,7 @@ void CGameContext::OnClientDrop(int ClientID, const char *pReason)
 	m_apPlayers[ClientID]->OnDisconnect(pReason);
 	delete m_apPlayers[ClientID];
 	m_apPlayers[ClientID] = 0;
+	RemovePlayerID(ClientID);
 
 	(void)m_pController->CheckTeamBalance();
 	m_VoteUpdate = true;
@@ -846,7 +997,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			if(g_Config.m_SvVoteKickMin)
 			{
 				int PlayerNum = 0;
-				for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+				for(int i = 0; i < Server()->MaxClients(); ++i)
 					if(m_apPlayers[i] && m_apPlayers[i]->GetTeam() != TEAM_SPECTATORS)
 						++PlayerNum;
 
@@ -859,7 +1010,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			}
 
 			int KickID = str_toint(pMsg->m_Value);
-			if(KickID < 0 || KickID >= MAX_CLIENTS-MAX_BOTS || !m_apPlayers[KickID])
+			if(KickID < 0 || KickID >= Server()->MaxClients() || !m_apPlayers[KickID])
 			{
 				SendChatTarget(ClientID, "Invalid client id to kick");
 				return;
@@ -899,7 +1050,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			}
 
 			int SpectateID = str_toint(pMsg->m_Value);
-			if(SpectateID < 0 || SpectateID >= MAX_CLIENTS-MAX_BOTS || !m_apPlayers[SpectateID] || m_apPlayers[SpectateID]->GetTeam() == TEAM_SPECTATORS)
+			if(SpectateID < 0 || SpectateID >= Server()->MaxClients() || !m_apPlayers[SpectateID] || m_apPlayers[SpectateID]->GetTeam() == TEAM_SPECTATORS)
 			{
 				SendChatTarget(ClientID, "Invalid client id to move");
 				return;
@@ -1145,8 +1296,11 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
     {
         CNetMsg_Cl_TileChangeRequest *pMsg = (CNetMsg_Cl_TileChangeRequest *)pRawMsg;
         int CIndex = pMsg->m_Index;
+        pPlayer->m_MineTeeSyncTick = Server()->Tick();
 
-        if(CIndex < 0 || CIndex >= Layers()->m_BuffNetTileChange.size())
+        // the changes after the client joined came live, the slots up to there keep their index
+        int SyncSize = min(pPlayer->m_MineTeeSyncSize, Layers()->m_TileDiffs.Size());
+        if(CIndex < 0 || CIndex >= SyncSize)
         {
             m_apPlayers[ClientID]->m_MineTeeSync =true;
             return;
@@ -1154,24 +1308,32 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 
         for (int o=0; o<TILECHANGE_MAX_PACKS; o++)
         {
-            if (CIndex+o >= Layers()->m_BuffNetTileChange.size())
+            int Index = CIndex+o;
+            if (Index >= SyncSize)
             {
                 m_apPlayers[ClientID]->m_MineTeeSync =true;
                 break;
             }
 
-            CNetMsg_Sv_TileChangeExt *pTileChange = static_cast<CNetMsg_Sv_TileChangeExt*>(&Layers()->m_BuffNetTileChange[CIndex+o]);
-            if (!pTileChange)
-                continue;
+            // a slot freed by a newer change, the client only needs it to ask for the next chunk or to finish
+            CNetMsg_Sv_TileChangeExt TileChange;
+            if (!Layers()->m_TileDiffs.Get(Index, &TileChange))
+            {
+                if (o < TILECHANGE_MAX_PACKS-1 && Index < SyncSize-1)
+                    continue;
+                mem_zero(&TileChange, sizeof(TileChange));
+                TileChange.m_Act = TILE_SKIP;
+            }
+
             CMsgPacker Msg(NETMSGTYPE_SV_TILECHANGEEXT);
             Msg.AddInt(-1);
-            Msg.AddInt(CIndex+o);
-            Msg.AddInt(pTileChange->m_X);
-            Msg.AddInt(pTileChange->m_Y);
-            Msg.AddInt(pTileChange->m_ITile);
-            Msg.AddInt(pTileChange->m_State);
-            Msg.AddInt(pTileChange->m_Col);
-            Msg.AddInt(pTileChange->m_Act);
+            Msg.AddInt(Index);
+            Msg.AddInt(TileChange.m_X);
+            Msg.AddInt(TileChange.m_Y);
+            Msg.AddInt(TileChange.m_ITile);
+            Msg.AddInt(TileChange.m_State);
+            Msg.AddInt(TileChange.m_Col);
+            Msg.AddInt(TileChange.m_Act);
             Server()->SendMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_FLUSH, ClientID);
         }
 
@@ -1521,6 +1683,474 @@ void CGameContext::ConVote(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 }
 
+void CGameContext::ConEntityPools(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	char aBuf[256];
+	for(CEntityPool *pPool = CEntityPool::First(); pPool; pPool = pPool->Next())
+	{
+		str_format(aBuf, sizeof(aBuf), "%s: %d/%d used, peak %d, %d on the heap (%d overflows), %d recycled",
+			pPool->Name(), pPool->Used(), pPool->Capacity(), pPool->m_Peak, pPool->m_NumHeap, pPool->m_NumOverflows, pPool->m_NumRecycled);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "entity_pools", aBuf);
+	}
+}
+
+// the queries as they were before the world had a grid, walking the whole type list
+static int RefFindEntities(CGameWorld *pWorld, vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
+{
+	int Num = 0;
+	for(CEntity *pEnt = pWorld->FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+	{
+		if(distance(pEnt->m_Pos, Pos) < Radius+pEnt->m_ProximityRadius)
+		{
+			ppEnts[Num++] = pEnt;
+			if(Num == Max)
+				break;
+		}
+	}
+	return Num;
+}
+
+static CEntity *RefIntersectCharacter(CGameWorld *pWorld, vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, CEntity *pNotThis)
+{
+	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
+	CEntity *pClosest = 0;
+	for(CEntity *p = pWorld->FindFirst(CGameWorld::ENTTYPE_CHARACTER); p; p = p->TypeNext())
+	{
+		if(p == pNotThis)
+			continue;
+
+		vec2 IntersectPos = closest_point_on_line(Pos0, Pos1, p->m_Pos);
+		float Len = distance(p->m_Pos, IntersectPos);
+		if(Len < p->m_ProximityRadius+Radius)
+		{
+			Len = distance(Pos0, IntersectPos);
+			if(Len < ClosestLen)
+			{
+				NewPos = IntersectPos;
+				ClosestLen = Len;
+				pClosest = p;
+			}
+		}
+	}
+	return pClosest;
+}
+
+static CEntity *RefClosestCharacter(CGameWorld *pWorld, vec2 Pos, float Radius, CEntity *pNotThis)
+{
+	float ClosestRange = Radius*2;
+	CEntity *pClosest = 0;
+	for(CEntity *p = pWorld->FindFirst(CGameWorld::ENTTYPE_CHARACTER); p; p = p->TypeNext())
+	{
+		if(p == pNotThis)
+			continue;
+
+		float Len = distance(Pos, p->m_Pos);
+		if(Len < p->m_ProximityRadius+Radius && Len < ClosestRange)
+		{
+			ClosestRange = Len;
+			pClosest = p;
+		}
+	}
+	return pClosest;
+}
+
+static vec2 RandomWorldPos(int Width, int Height)
+{
+	// some of it outside of the map, like projectiles flying off
+	if(rand()%20 == 0)
+		return vec2((float)(rand()%(Width+2000)-1000), (float)(rand()%(Height+2000)-1000));
+	return vec2((float)(rand()%Width), (float)(rand()%Height));
+}
+
+void CGameContext::ConBenchWorld(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int NumEntities = pResult->NumArguments() ? clamp(pResult->GetInteger(0), 1, 8192) : 2000;
+	int Width = max(pSelf->Collision()->GetWidth()*32, 32);
+	int Height = max(pSelf->Collision()->GetHeight()*32, 32);
+
+	enum
+	{
+		NUM_ROUNDS=50,
+		NUM_QUERIES=200,
+		MAX_FOUND=64,
+	};
+
+	// a world of its own so the game is not touched. half pickups, the rest characters and projectiles
+	CGameWorld World;
+	World.SetGameServer(pSelf);
+	World.InitGrid(Width, Height);
+	CEntity **apEnts = (CEntity **)mem_alloc(NumEntities*sizeof(CEntity *), 1);
+	for(int i = 0; i < NumEntities; i++)
+	{
+		int Type = i%4 == 0 ? CGameWorld::ENTTYPE_CHARACTER : i%4 == 1 ? CGameWorld::ENTTYPE_PROJECTILE : CGameWorld::ENTTYPE_PICKUP;
+		apEnts[i] = new CEntity(&World, Type);
+		apEnts[i]->m_ProximityRadius = Type == CGameWorld::ENTTYPE_CHARACTER ? 28.0f : Type == CGameWorld::ENTTYPE_PICKUP ? 14.0f : 0.0f;
+		apEnts[i]->SetPos(RandomWorldPos(Width, Height));
+		World.InsertEntity(apEnts[i]);
+	}
+
+	int64 aGridTime[3] = {0}, aScanTime[3] = {0};
+	int Mismatches = 0;
+	int Found = 0;
+	for(int r = 0; r < NUM_ROUNDS; r++)
+	{
+		// let a tenth of them move, a few jump far
+		for(int i = 0; i < NumEntities/10; i++)
+		{
+			CEntity *pEnt = apEnts[rand()%NumEntities];
+			if(rand()%10 == 0)
+				pEnt->SetPos(RandomWorldPos(Width, Height));
+			else
+				pEnt->SetPos(pEnt->m_Pos+vec2((float)(rand()%65-32), (float)(rand()%65-32)));
+		}
+
+		for(int q = 0; q < NUM_QUERIES; q++)
+		{
+			vec2 Pos = RandomWorldPos(Width, Height);
+			static const float s_aRadius[4] = {14.0f, 64.0f, 135.0f, 400.0f}; // hammer, spawn, explosion, bot sight
+			float Radius = s_aRadius[rand()%4];
+			int Type = rand()%2 ? CGameWorld::ENTTYPE_PICKUP : CGameWorld::ENTTYPE_CHARACTER;
+			CEntity *apFound[MAX_FOUND], *apRefFound[MAX_FOUND];
+
+			int64 Start = time_get();
+			int Num = World.FindEntities(Pos, Radius, apFound, MAX_FOUND, Type);
+			aGridTime[0] += time_get()-Start;
+			Start = time_get();
+			int RefNum = RefFindEntities(&World, Pos, Radius, apRefFound, MAX_FOUND, Type);
+			aScanTime[0] += time_get()-Start;
+			if(Num != RefNum || mem_comp(apFound, apRefFound, Num*sizeof(CEntity *)) != 0)
+				Mismatches++;
+			Found += Num;
+
+			// laser and projectile like lines
+			vec2 To = Pos+GetDir((float)(rand()%628)/100.0f)*(float)(rand()%800);
+			CEntity *pNotThis = Num ? apFound[0] : 0;
+			float LineRadius = rand()%2 ? 0.0f : 6.0f;
+			vec2 At = vec2(0, 0), RefAt = vec2(0, 0);
+			Start = time_get();
+			CEntity *pHit = World.IntersectCharacter(Pos, To, LineRadius, At, pNotThis);
+			aGridTime[1] += time_get()-Start;
+			Start = time_get();
+			CEntity *pRefHit = RefIntersectCharacter(&World, Pos, To, LineRadius, RefAt, pNotThis);
+			aScanTime[1] += time_get()-Start;
+			if(pHit != pRefHit || (pHit && (At.x != RefAt.x || At.y != RefAt.y)))
+				Mismatches++;
+
+			Start = time_get();
+			CEntity *pClosest = World.ClosestCharacter(Pos, Radius/4, pNotThis);
+			aGridTime[2] += time_get()-Start;
+			Start = time_get();
+			CEntity *pRefClosest = RefClosestCharacter(&World, Pos, Radius/4, pNotThis);
+			aScanTime[2] += time_get()-Start;
+			if(pClosest != pRefClosest)
+				Mismatches++;
+		}
+	}
+	mem_free(apEnts);
+
+	static const char *s_apNames[3] = {"find_entities", "intersect_character", "closest_character"};
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%d entities, %d queries each, %d found, %d mismatches", NumEntities, NUM_ROUNDS*NUM_QUERIES, Found, Mismatches);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_world", aBuf);
+	for(int i = 0; i < 3; i++)
+	{
+		str_format(aBuf, sizeof(aBuf), "%s: grid %.2fus scan %.2fus per query", s_apNames[i],
+			aGridTime[i]*1000000.0/time_freq()/(NUM_ROUNDS*NUM_QUERIES), aScanTime[i]*1000000.0/time_freq()/(NUM_ROUNDS*NUM_QUERIES));
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_world", aBuf);
+	}
+}
+
+static int RandomNavNode(const CNavGraph *pGraph)
+{
+	for(int Tries = 0; Tries < 1000; Tries++)
+	{
+		int Cell = pGraph->NodeCell(rand()%pGraph->NumNodeSlots());
+		if(Cell >= 0)
+			return Cell;
+	}
+	return -1;
+}
+
+void CGameContext::ConBenchNav(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int NumQueries = pResult->NumArguments() ? clamp(pResult->GetInteger(0), 1, 1000000) : 2000;
+
+	enum
+	{
+		MAX_PATH=256,
+		NEAR_RANGE=20, // tiles, about as far as the npcs look for players
+		NUM_UPDATES=1000,
+	};
+
+	// a graph of its own so the one the npcs use is not touched
+	CNavGraph Graph;
+	int64 Start = time_get();
+	Graph.Init(pSelf->Collision());
+	int64 BuildTime = time_get()-Start;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%dx%d tiles, %d nodes, built in %.2fms", Graph.Width(), Graph.Height(), Graph.NumNodes(), BuildTime*1000.0/time_freq());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_nav", aBuf);
+	if(!Graph.NumNodes())
+		return;
+	Graph.PrepareSearches(1);
+
+	// chasing a player close by and crossing the whole map
+	static const char *s_apNames[2] = {"near", "far"};
+	int aPath[MAX_PATH];
+	for(int k = 0; k < 2; k++)
+	{
+		int64 Time = 0;
+		int Reached = 0;
+		int Steps = 0;
+		for(int q = 0; q < NumQueries; q++)
+		{
+			int From = RandomNavNode(&Graph);
+			int To = -1;
+			if(k == 0)
+			{
+				vec2 Pos = Graph.CellCenter(From);
+				for(int Tries = 0; Tries < 20 && To < 0; Tries++)
+					To = Graph.StandingCell(Pos+vec2((rand()%(NEAR_RANGE*2+1)-NEAR_RANGE)*32.0f, (rand()%(NEAR_RANGE*2+1)-NEAR_RANGE)*32.0f), NEAR_RANGE);
+			}
+			if(To < 0)
+				To = RandomNavNode(&Graph);
+
+			Start = time_get();
+			int Length = Graph.FindPath(From, To, aPath, MAX_PATH);
+			Time += time_get()-Start;
+			Steps += Length;
+			if(Length && aPath[Length-1] == To)
+				Reached++;
+		}
+
+		str_format(aBuf, sizeof(aBuf), "%s: %d queries, %.0f per second, %.2fus each, %d reached, %.1f steps on average", s_apNames[k], NumQueries,
+			NumQueries/(Time/(double)time_freq()), Time*1000000.0/time_freq()/NumQueries, Reached, Steps/(float)NumQueries);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_nav", aBuf);
+	}
+
+	// patching the graph around a changed tile, one at a time like the game does
+	Start = time_get();
+	for(int i = 0; i < NUM_UPDATES; i++)
+	{
+		Graph.Invalidate(rand()%Graph.Width(), rand()%Graph.Height());
+		Graph.Update();
+	}
+	int64 UpdateTime = time_get()-Start;
+	str_format(aBuf, sizeof(aBuf), "tile update: %.2fus each, a full build is %.0f of them", UpdateTime*1000000.0/time_freq()/NUM_UPDATES,
+		BuildTime/(UpdateTime/(double)NUM_UPDATES));
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_nav", aBuf);
+}
+
+// hills of grass, dirt and stone with lakes, sand falling into caves, a desert and plants
+static void GenerateBlocksBench(CTile *pTiles, int Width, int Height)
+{
+	mem_zero(pTiles, Width*Height*sizeof(CTile));
+	for(int x = 0; x < Width; x++)
+	{
+		int Surface = Height/4 + (int)(8*sinf(x*0.05f));
+		bool Desert = x >= Width*2/5 && x < Width/2;
+		for(int y = Surface; y < Height; y++)
+		{
+			int Index = BLOCK_STONE;
+			if(y == Surface)
+				Index = Desert ? BLOCK_ARENA : BLOCK_GRASSGROUND;
+			else if(y < Surface+5)
+				Index = Desert ? BLOCK_ARENA : BLOCK_GROUND;
+			pTiles[y*Width+x].m_Index = Index;
+		}
+
+		// a pit with water running into it
+		if(x%100 >= 40 && x%100 < 46)
+			for(int y = Surface; y < Surface+4; y++)
+				pTiles[y*Width+x].m_Index = 0;
+		if(x%100 == 38)
+			pTiles[(Surface-1)*Width+x].m_Index = BLOCK_AGUA;
+
+		// caves with lava below the sand and the dirt
+		if(x%60 >= 20 && x%60 < 30)
+			for(int y = Surface+5; y < Surface+12; y++)
+				pTiles[y*Width+x].m_Index = x%60 == 25 && y == Surface+11 ? BLOCK_LAVA : 0;
+
+		if(Desert && x%9 == 0)
+			pTiles[(Surface-1)*Width+x].m_Index = BLOCK_CACTUS;
+		else if(!Desert && x%7 == 0 && pTiles[Surface*Width+x].m_Index == BLOCK_GRASSGROUND)
+			pTiles[(Surface-1)*Width+x].m_Index = BLOCK_SEED1;
+	}
+}
+
+static void ApplyBlocksBench(CTile *pTiles, int Width, const CWorldSim::CChange *pChange, CWorldSim *pWake)
+{
+	CTile *pTile = &pTiles[pChange->m_Y*Width+pChange->m_X];
+	pTile->m_Index = pChange->m_Act == TILE_CREATE ? pChange->m_Index : 0;
+	pTile->m_Flags = 0;
+	if(pWake)
+		pWake->OnTileChanged(pChange->m_X, pChange->m_Y);
+}
+
+void CGameContext::ConBenchBlocks(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int NumSteps = pResult->NumArguments() ? clamp(pResult->GetInteger(0), 1, 100000) : 200;
+
+	enum
+	{
+		SIZE=1000,
+		SLOW_STEPS=10, // the growing and the ovens run less often
+	};
+
+	// the same world twice, once scanned whole like before and once only where it changes
+	CTile *apTiles[2];
+	for(int i = 0; i < 2; i++)
+	{
+		apTiles[i] = (CTile *)mem_alloc(SIZE*SIZE*sizeof(CTile), 1);
+		GenerateBlocksBench(apTiles[i], SIZE, SIZE);
+	}
+	CTile *pCopy = (CTile *)mem_alloc(SIZE*SIZE*sizeof(CTile), 1);
+
+	CWorldSim aSims[2];
+	int64 aTime[2] = {0, 0};
+	int aChanges[2] = {0, 0};
+	int64 Queued = 0;
+	for(int k = 0; k < 2; k++)
+	{
+		aSims[k].Init(apTiles[k], SIZE, SIZE);
+		srand(1);
+		for(int i = 0; i < NumSteps; i++)
+		{
+			int Steps = CWorldSim::STEP_ENVIRONMENT|CWorldSim::STEP_DESTRUCTION;
+			if(i%SLOW_STEPS == 0)
+				Steps |= CWorldSim::STEP_VEGETAL|CWorldSim::STEP_COOK|CWorldSim::STEP_WEAR;
+
+			int64 Start = time_get();
+			if(k == 0)
+			{
+				mem_copy(pCopy, apTiles[k], SIZE*SIZE*sizeof(CTile));
+				aSims[k].QueueAll();
+			}
+			else
+				Queued += aSims[k].NumQueued(CWorldSim::STEP_ENVIRONMENT);
+			int Num = aSims[k].Run(Steps);
+			for(int c = 0; c < Num; c++)
+				ApplyBlocksBench(apTiles[k], SIZE, aSims[k].GetChange(c), k == 1 ? &aSims[k] : 0);
+			aTime[k] += time_get()-Start;
+			aChanges[k] += Num;
+		}
+	}
+
+	char aBuf[256];
+	static const char *s_apNames[2] = {"full scan", "queued"};
+	for(int k = 0; k < 2; k++)
+	{
+		str_format(aBuf, sizeof(aBuf), "%s: %dx%d tiles, %d steps, %.3fms per step, %d changes", s_apNames[k], (int)SIZE, (int)SIZE, NumSteps,
+			aTime[k]*1000.0/time_freq()/NumSteps, aChanges[k]);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_blocks", aBuf);
+	}
+	str_format(aBuf, sizeof(aBuf), "%.0f cells queued per environment step, %.1fx faster, same world: %s", Queued/(double)NumSteps,
+		aTime[0]/(double)max(aTime[1], (int64)1), mem_comp(apTiles[0], apTiles[1], SIZE*SIZE*sizeof(CTile)) == 0 ? "yes" : "no");
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_blocks", aBuf);
+
+	for(int i = 0; i < 2; i++)
+		mem_free(apTiles[i]);
+	mem_free(pCopy);
+}
+
+void CGameContext::ConBenchTnt(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	CMapItemLayerTilemap *pMineTee = pSelf->Layers()->MineTeeLayer();
+	if(!pMineTee || str_comp_nocase(pSelf->GameType(), "MineTee") != 0)
+	{
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_tnt", "needs the minetee gametype");
+		return;
+	}
+
+	// a square of tnt in the middle of the map, the clients only see it blow up
+	int Size = pResult->NumArguments() ? clamp(pResult->GetInteger(0), 1, 64) : 16;
+	int StartX = max(1, (pMineTee->m_Width-Size)/2);
+	int StartY = max(1, (pMineTee->m_Height-Size)/2);
+	int EndX = min(pMineTee->m_Width-1, StartX+Size);
+	int EndY = min(pMineTee->m_Height-1, StartY+Size);
+	for(int y = StartY; y < EndY; y++)
+		for(int x = StartX; x < EndX; x++)
+			pSelf->Collision()->CreateTile(vec2(x*32, y*32), BLOCK_TNT);
+
+	CTile *pTiles = (CTile *)pSelf->Layers()->Map()->GetData(pMineTee->m_Data);
+	int Before = 0;
+	for(int i = 0; i < pMineTee->m_Width*pMineTee->m_Height; i++)
+		Before += pTiles[i].m_Index != 0;
+
+	int64 Start = time_get();
+	vec2 Pos((StartX+EndX)*16.0f, (StartY+EndY)*16.0f);
+	pSelf->CreateExplosion(Pos, -1, WEAPON_WORLD, false);
+	int64 Time = time_get()-Start;
+
+	int After = 0;
+	for(int i = 0; i < pMineTee->m_Width*pMineTee->m_Height; i++)
+		After += pTiles[i].m_Index != 0;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%dx%d tnt, %d tiles destroyed in %.3fms, %d tile changes queued", EndX-StartX, EndY-StartY,
+		Before-After, Time*1000.0/time_freq(), pSelf->m_NumTileChanges);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_tnt", aBuf);
+}
+
+void CGameContext::ConBenchTileDiffs(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int NumEdits = pResult->NumArguments() > 0 ? clamp(pResult->GetInteger(0), 1, 10000000) : 100000;
+	int Size = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 1, 4096) : 300;
+
+	// random edits on a scratch store, compacted the way OnTick does it
+	CTileDiffStore Store;
+	Store.Init(Size, Size);
+	srand(1);
+	int NumCompacts = 0;
+	int64 CompactTime = 0;
+	int64 Start = time_get();
+	for(int i = 0; i < NumEdits; i++)
+	{
+		int x = rand()%Size;
+		int y = rand()%Size;
+		int State = rand()%3;
+		if(rand()%4 == 0)
+			Store.Set(x, y, State, TILE_DESTROY, 0, 0);
+		else
+			Store.Set(x, y, State, TILE_CREATE, 1+rand()%255, rand()%2);
+
+		if(Store.NumFree() > max(1024, Store.NumDiffs()))
+		{
+			int64 CompactStart = time_get();
+			Store.Compact();
+			CompactTime += time_get()-CompactStart;
+			NumCompacts++;
+		}
+	}
+	int64 Time = time_get()-Start;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%d edits on %dx%d tiles, %.3fus per edit, %d compacts taking %.3fms", NumEdits, Size, Size,
+		Time*1000000.0/time_freq()/NumEdits, NumCompacts, CompactTime*1000.0/time_freq());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_tilediffs", aBuf);
+	str_format(aBuf, sizeof(aBuf), "%d diffs, %d free slots, %d bytes", Store.NumDiffs(), Store.NumFree(), Store.MemoryUsage());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_tilediffs", aBuf);
+
+	// and what the map holds right now
+	const CTileDiffStore *pLive = &pSelf->Layers()->m_TileDiffs;
+	str_format(aBuf, sizeof(aBuf), "live: %d diffs, %d free slots, %d bytes", pLive->NumDiffs(), pLive->NumFree(), pLive->MemoryUsage());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bench_tilediffs", aBuf);
+}
+
+void CGameContext::TileChangedCallback(int x, int y, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	pSelf->m_NavGraph.OnTileChanged(x, y);
+	pSelf->m_WorldSim.OnTileChanged(x, y);
+}
+
 void CGameContext::ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -1556,6 +2186,12 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("force_vote", "ss?r", CFGFLAG_SERVER, ConForceVote, this, "Force a voting option");
 	Console()->Register("clear_votes", "", CFGFLAG_SERVER, ConClearVotes, this, "Clears the voting options");
 	Console()->Register("vote", "r", CFGFLAG_SERVER, ConVote, this, "Force a vote to yes/no");
+	Console()->Register("entity_pools", "", CFGFLAG_SERVER, ConEntityPools, this, "Show how full the entity pools are");
+	Console()->Register("bench_world", "?i", CFGFLAG_SERVER, ConBenchWorld, this, "Time the world queries against a list walk with this many entities");
+	Console()->Register("bench_nav", "?i", CFGFLAG_SERVER, ConBenchNav, this, "Time building the navigation graph of the map and this many path queries on it");
+	Console()->Register("bench_blocks", "?i", CFGFLAG_SERVER, ConBenchBlocks, this, "Time this many steps of the block simulation on a generated 1000x1000 world, full scan against queued cells");
+	Console()->Register("bench_tnt", "?i", CFGFLAG_SERVER, ConBenchTnt, this, "Blow up a square of tnt of this size in the middle of the map, see net_stats for what it sent");
+	Console()->Register("bench_tilediffs", "?i?i", CFGFLAG_SERVER, ConBenchTileDiffs, this, "Time this many random edits of the tile diff store on a square of this size and show its memory, the live one too");
 
 	Console()->Chain("sv_motd", ConchainSpecialMotdupdate, this);
 }
@@ -1566,6 +2202,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 	m_World.SetGameServer(this);
 	m_Events.SetGameServer(this);
+	m_SnapMaster.SetGameServer(this);
 
 	//if(!data) // only load once
 		//data = load_data_from_memory(internal_data);
@@ -1575,6 +2212,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 
 	m_Layers.Init(Kernel());
 	m_Collision.Init(&m_Layers);
+	m_World.InitGrid(m_Collision.GetWidth()*32, m_Collision.GetHeight()*32);
 
 	// reset everything here
 	//world = new GAMEWORLD;
@@ -1594,6 +2232,15 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	else
 		m_pController = new CGameControllerDM(this);
 
+	if(str_comp_nocase(GameType(), "MineTee") == 0)
+	{
+		m_NavGraph.Init(&m_Collision);
+		CMapItemLayerTilemap *pMineTee = m_Layers.MineTeeLayer();
+		if(pMineTee)
+			m_WorldSim.Init((CTile *)m_Layers.Map()->GetData(pMineTee->m_Data), pMineTee->m_Width, pMineTee->m_Height);
+		m_Collision.SetTileChangedCallback(TileChangedCallback, this);
+	}
+
 	// setup core world
 	//for(int i = 0; i < MAX_CLIENTS; i++)
 	//	game.players[i].core.world = &game.world.core;
@@ -1622,13 +2269,6 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 		}
 	}
 
-    //H-Client: Add Bots
-    if (str_find_nocase(GameType(), "minetee"))
-    {
-        for (int o=0; o<25; o++)
-            CreateBot(o);
-    }
-
 	//game.world.insert_entity(game.Controller);
 
 #ifdef CONF_DEBUG
@@ -1636,7 +2276,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	{
 		for(int i = 0; i < g_Config.m_DbgDummies ; i++)
 		{
-			OnClientConnected(MAX_CLIENTS-i-1);
+			OnClientConnected(Server()->MaxClients()-i-1);
 		}
 	}
 #endif
@@ -1651,20 +2291,46 @@ void CGameContext::OnShutdown()
 
 void CGameContext::OnSnap(int ClientID)
 {
+	if(m_SnapMaster.Ready())
+	{
+		m_SnapMaster.Snap(ClientID);
+		if(ClientID != -1 && m_apPlayers[ClientID])
+			m_apPlayers[ClientID]->SnapPersonal();
+		return;
+	}
+
 	m_World.Snap(ClientID);
 	m_pController->Snap(ClientID);
 	m_Events.Snap(ClientID);
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(m_apPlayers[i])
-			m_apPlayers[i]->Snap(ClientID);
-	}
+	for(int i = 0; i < m_NumPlayerIDs; i++)
+		m_apPlayers[m_aPlayerIDs[i]]->Snap(ClientID);
+
+	// after the shared items, so the snapshots of two spectators line up
+	if(ClientID != -1 && m_apPlayers[ClientID])
+		m_apPlayers[ClientID]->SnapSpectatorInfo();
+}
+void CGameContext::OnPreSnap()
+{
+	if(!g_Config.m_SvSnapMaster)
+		return;
+
+	// serialize everything once, the client snapshots are derived from it
+	m_SnapMaster.Begin();
+	m_World.Snap(-1);
+	m_pController->Snap(-1);
+	m_Events.Snap(-1);
+
+	for(int i = 0; i < m_NumPlayerIDs; i++)
+		m_apPlayers[m_aPlayerIDs[i]]->Snap(-1);
+	m_SnapMaster.End();
 }
-void CGameContext::OnPreSnap() {}
+
 void CGameContext::OnPostSnap()
 {
+	m_SnapMaster.Clear();
 	m_Events.Clear();
+	FlushTileChanges();
 }
 
 bool CGameContext::IsClientReady(int ClientID)
@@ -1677,11 +2343,6 @@ bool CGameContext::IsClientPlayer(int ClientID)
 	return m_apPlayers[ClientID] && m_apPlayers[ClientID]->GetTeam() == TEAM_SPECTATORS ? false : true;
 }
 
-bool CGameContext::IsClientBot(int ClientID)
-{
-	return m_apPlayers[ClientID] && m_apPlayers[ClientID]->GetTeam() != TEAM_ENEMY_TEEPER? false : true;
-}
-
 const char *CGameContext::GameType() { return m_pController && m_pController->m_pGameType ? m_pController->m_pGameType : ""; }
 const char *CGameContext::Version() { return GAME_VERSION; }
 const char *CGameContext::NetVersion() { return GAME_NETVERSION; }
@@ -13,7 +13,10 @@
 #include "eventhandler.h"
 #include "gamecontroller.h"
 #include "gameworld.h"
+#include "navgraph.h"
+#include "worldsim.h"
 #include "player.h"
+#include "snapmaster.h"
 
 /*
 	Tick
@@ -35,6 +38,14 @@
 			Events handler (EVENT_HANDLER::snap)
 			All players (CPlayer::snap)
 
+	Snap with sv_snap_master
+		Game Context (CGameContext::presnap)
+			Everything above once with SnappingClient -1 into the snapshot master
+		Game Context (CGameContext::snap)
+			Snapshot master (CSnapMaster::snap)
+				Copy the items visible to the client and patch the per client fields
+			Snapping player (CPlayer::snap_personal)
+
 */
 class CGameContext : public IGameServer
 {
@@ -59,12 +70,35 @@ class CGameContext : public IGameServer
 	static void ConForceVote(IConsole::IResult *pResult, void *pUserData);
 	static void ConClearVotes(IConsole::IResult *pResult, void *pUserData);
 	static void ConVote(IConsole::IResult *pResult, void *pUserData);
+	static void ConEntityPools(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchWorld(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchNav(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchBlocks(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchTnt(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchTileDiffs(IConsole::IResult *pResult, void *pUserData);
+	static void TileChangedCallback(int x, int y, void *pUserData);
 	static void ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
 	CGameContext(int Resetting);
 	void Construct(int Resetting);
 
 	bool m_Resetting;
+
+	// tile changes of the current tick, see SendTileChange
+	struct CTileChange
+	{
+		int m_Key; // (state*height+y)*width+x
+		int m_Value; // 0 to destroy, else tile+1 and the collision in bit 9
+		bool operator<(const CTileChange &Other) const { return m_Key < Other.m_Key; }
+	};
+	CTileChange *m_pTileChanges;
+	int m_NumTileChanges;
+	int m_TileChangeCapacity;
+
+	void FlushTileChanges();
+
+	// drops the free slots of the tile diffs unless someone downloads them
+	void CompactTileDiffs(int JoiningID);
 public:
 	IServer *Server() const { return m_pServer; }
 	class IConsole *Console() { return m_pConsole; }
@@ -78,13 +112,27 @@ public:
 	void Clear();
 
 	CEventHandler m_Events;
+	CSnapMaster m_SnapMaster;
 	CPlayer *m_apPlayers[MAX_CLIENTS];
 
+	// the ids of the players above in ascending order, for the loops that
+	// run every tick or snapshot
+	int m_aPlayerIDs[MAX_CLIENTS];
+	int m_NumPlayerIDs;
+	void AddPlayerID(int ClientID);
+	void RemovePlayerID(int ClientID);
+
 	IGameController *m_pController;
 	CGameWorld m_World;
 
+	// where the npcs can walk and the blocks that change on their own, only for minetee
+	CNavGraph m_NavGraph;
+	CWorldSim m_WorldSim;
+	int m_NumNpcsSpawned; // seeds the npcs, snap ids are reused after a timeout
+
 	// helper functions
 	class CCharacter *GetPlayerChar(int ClientID);
+	void *SnapNewItem(int Type, int ID, int Size, int Clip=CSnapMaster::CLIP_NONE, vec2 Pos=vec2(0,0), const CClientMask &Mask=CmaskAll());
 
 	// voting
 	void StartVote(const char *pDesc, const char *pCommand, const char *pReason);
@@ -118,7 +166,7 @@ public:
 	void CreateHammerHit(vec2 Pos);
 	void CreatePlayerSpawn(vec2 Pos);
 	void CreateDeath(vec2 Pos, int Who);
-	void CreateSound(vec2 Pos, int Sound, int Mask=-1);
+	void CreateSound(vec2 Pos, int Sound, const CClientMask &Mask=CmaskAll());
 	void CreateSoundGlobal(int Sound, int Target=-1);
     void CreateTombstone(vec2 Pos); //H-Client
 
@@ -137,6 +185,8 @@ public:
 	void SendWeaponPickup(int ClientID, int Weapon);
 	void SendBroadcast(const char *pText, int ClientID);
 
+	// queues a tile change for everyone, they go out together after the next snapshot
+	void SendTileChange(int x, int y, int Act, int ITile, int Col, int State);
 
 	//
 	void CheckPureTuning();
@@ -167,13 +217,6 @@ public:
 	virtual const char *Version();
 	virtual const char *NetVersion();
 	virtual const char *HClientNetVersion(); //H-Client
-	virtual void CreateBot(int ClientID); //H-Client
-	virtual void UpdateBotInfo(int ClientID, int TEnemy); //H-Client
-	bool IsClientBot(int ClientID); //H-Client
 };
 
-inline int CmaskAll() { return -1; }
-inline int CmaskOne(int ClientID) { return 1<<ClientID; }
-inline int CmaskAllExceptOne(int ClientID) { return 0x7fffffff^CmaskOne(ClientID); }
-inline bool CmaskIsSet(int Mask, int ClientID) { return (Mask&CmaskOne(ClientID)) != 0; }
 #endif
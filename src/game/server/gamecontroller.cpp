@@ -6,6 +6,7 @@
 #include <game/generated/protocol.h>
 
 #include "entities/pickup.h"
+#include "entities/npc.h"
 #include "gamecontroller.h"
 #include "gamecontext.h"
 #include <time.h> //H-Client
@@ -241,7 +242,7 @@ bool IGameController::OnEntity(int Index, vec2 Pos)
 	if(Type != -1)
 	{
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, Type, SubType);
-		pPickup->m_Pos = Pos;
+		pPickup->SetPos(Pos);
 		return true;
 	}
 
@@ -438,7 +439,7 @@ int IGameController::OnCharacterDeath(class CCharacter *pVictim, class CPlayer *
 		else
 		{
 			pKiller->m_Score++; // normal kill
-            if (pVictim->GetPlayer()->GetTeam() < TEAM_ANIMAL_TEECOW && pKiller->GetCharacter())
+            if (pKiller->GetCharacter())
                 pKiller->GetCharacter()->m_Kills++;
 		}
 	}
@@ -447,6 +448,16 @@ int IGameController::OnCharacterDeath(class CCharacter *pVictim, class CPlayer *
 	return 0;
 }
 
+void IGameController::OnNpcDeath(class CNpc *pNpc, class CPlayer *pKiller, int Weapon)
+{
+	// do scoreing, the animals don't count for the kill streak
+	if(!pKiller || Weapon == WEAPON_GAME)
+		return;
+	pKiller->m_Score++;
+	if(pNpc->IsMonster() && pKiller->GetCharacter())
+		pKiller->GetCharacter()->m_Kills++;
+}
+
 void IGameController::OnCharacterSpawn(class CCharacter *pChr)
 {
 	// default health
@@ -577,7 +588,7 @@ void IGameController::Tick()
 	// check for inactive players
 	if(g_Config.m_SvInactiveKickTime > 0 )
 	{
-		for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+		for(int i = 0; i < Server()->MaxClients(); ++i)
 		{
 			if(GameServer()->m_apPlayers[i] && GameServer()->m_apPlayers[i]->GetTeam() != TEAM_SPECTATORS && !Server()->IsAuthed(i))
 			{
@@ -626,7 +637,7 @@ bool IGameController::IsTeamplay() const
 
 void IGameController::Snap(int SnappingClient)
 {
-	CNetObj_GameInfo *pGameInfoObj = (CNetObj_GameInfo *)Server()->SnapNewItem(NETOBJTYPE_GAMEINFO, 0, sizeof(CNetObj_GameInfo));
+	CNetObj_GameInfo *pGameInfoObj = (CNetObj_GameInfo *)GameServer()->SnapNewItem(NETOBJTYPE_GAMEINFO, 0, sizeof(CNetObj_GameInfo));
 	if(!pGameInfoObj)
 		return;
 
@@ -655,7 +666,7 @@ int IGameController::GetAutoTeam(int NotThisID)
 		return 0;
 
 	int aNumplayers[2] = {0,0};
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(int i = 0; i < Server()->MaxClients(); i++)
 	{
 		if(GameServer()->m_apPlayers[i] && i != NotThisID)
 		{
@@ -697,7 +708,7 @@ bool IGameController::CheckTeamBalance()
 		return true;
 
 	int aT[2] = {0, 0};
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(int i = 0; i < Server()->MaxClients(); i++)
 	{
 		CPlayer *pP = GameServer()->m_apPlayers[i];
 		if(pP && pP->GetTeam() != TEAM_SPECTATORS)
@@ -729,7 +740,7 @@ bool IGameController::CanChangeTeam(CPlayer *pPlayer, int JoinTeam)
 	if (!IsTeamplay() || JoinTeam == TEAM_SPECTATORS || !g_Config.m_SvTeambalanceTime)
 		return true;
 
-	for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+	for(int i = 0; i < Server()->MaxClients(); i++)
 	{
 		CPlayer *pP = GameServer()->m_apPlayers[i];
 		if(pP && pP->GetTeam() != TEAM_SPECTATORS)
@@ -775,7 +786,7 @@ void IGameController::DoWincheck()
 			// gather some stats
 			int Topscore = 0;
 			int TopscoreCount = 0;
-			for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; i++)
+			for(int i = 0; i < Server()->MaxClients(); i++)
 			{
 				if(GameServer()->m_apPlayers[i])
 				{
@@ -807,9 +818,6 @@ int IGameController::ClampTeam(int Team)
 	if(Team < 0)
 		return TEAM_SPECTATORS;
 
-    if (str_find_nocase(GameServer()->GameType(), "minetee") && Team > TEAM_BLUE)
-        return Team;
-
 	if(IsTeamplay())
 		return Team&1;
 	return 0;
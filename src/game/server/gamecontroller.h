@@ -124,6 +124,17 @@ public:
 	*/
 	virtual int OnCharacterDeath(class CCharacter *pVictim, class CPlayer *pKiller, int Weapon);
 
+	/*
+		Function: on_npc_death
+			Called when a monster or animal dies.
+
+		Arguments:
+			npc - The npc that died.
+			killer - The player that killed it, 0 if none.
+			weapon - What weapon that killed it.
+	*/
+	virtual void OnNpcDeath(class CNpc *pNpc, class CPlayer *pKiller, int Weapon);
+
 
 	virtual void OnPlayerInfoChange(class CPlayer *pP);
 
@@ -1,8 +1,10 @@
 #include "cem.h"
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <game/generated/protocol.h>
 #include <game/server/entities/character.h>
 #include <game/server/entities/pickup.h>
+#include <game/server/entities/npc.h>
 #include <game/server/gamecontext.h>
 
 #include <cstring>
@@ -16,982 +18,102 @@ CGameControllerMINETEE::CGameControllerMINETEE(class CGameContext *pGameServer)
 	m_TimeDestruction = Server()->Tick();
 	m_TimeCook = Server()->Tick();
 	m_TimeWear = Server()->Tick();
+	m_apNpcs = 0;
+	m_NpcCapacity = 0;
+}
+
+CGameControllerMINETEE::~CGameControllerMINETEE()
+{
+	if(m_apNpcs)
+		mem_free(m_apNpcs);
+}
+
+void CGameControllerMINETEE::ApplyWorldChange(const CWorldSim::CChange *pChange)
+{
+	GameServer()->SendTileChange(pChange->m_X, pChange->m_Y, pChange->m_Act, pChange->m_Index, pChange->m_Col, 0);
+
+	vec2 Pos(pChange->m_X<<5, pChange->m_Y<<5);
+	if(pChange->m_Act == TILE_CREATE)
+		GameServer()->Collision()->CreateTile(Pos, pChange->m_Index, pChange->m_Col ? CCollision::COLFLAG_SOLID : 0);
+	else
+		GameServer()->Collision()->DestroyTile(Pos);
+
+	if(pChange->m_Drop >= 0)
+	{
+		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, pChange->m_Drop);
+		pPickup->SetPos(vec2(pChange->m_X*32.0f + 8.0f, pChange->m_Y*32.0f + 8.0f));
+	}
+}
+
+void CGameControllerMINETEE::HurtOnCactus()
+{
+	// every cactus tile close to a player hurts
+	CCollision *pCollision = GameServer()->Collision();
+	for(int i = 0; i < GameServer()->m_NumPlayerIDs; i++)
+	{
+		CCharacter *pChr = GameServer()->m_apPlayers[GameServer()->m_aPlayerIDs[i]]->GetCharacter();
+		if(!pChr || !pChr->IsAlive())
+			continue;
+
+		int MinX = max(0, (int)((pChr->m_Pos.x-52.0f)/32.0f)), MaxX = min(pCollision->GetWidth()-1, (int)((pChr->m_Pos.x+20.0f)/32.0f));
+		int MinY = max(0, (int)((pChr->m_Pos.y-52.0f)/32.0f)), MaxY = min(pCollision->GetHeight()-1, (int)((pChr->m_Pos.y+20.0f)/32.0f));
+		for(int y = MinY; y <= MaxY; y++)
+			for(int x = MinX; x <= MaxX; x++)
+			{
+				if(pCollision->GetMineTeeBlockAt(x<<5, y<<5) == BLOCK_CACTUS && distance(pChr->m_Pos, vec2((x<<5)+16.0f, (y<<5)+16.0f)) <= 36.0f)
+					pChr->TakeDamage(vec2(0.0f, 0.0f), 1.0f, pChr->GetPlayer()->GetCID(), WEAPON_WORLD);
+			}
+	}
 }
 
 void CGameControllerMINETEE::Tick()
 {
-    bool Vegetal=false, Envirionment=false, Destruction=false, Cook = false, Wear = false;
+    int Steps = 0;
 
     //Control Actions
     if (Server()->Tick() - m_TimeVegetal > Server()->TickSpeed()*60.0f)
     {
-        Vegetal = true;
+        Steps |= CWorldSim::STEP_VEGETAL;
         m_TimeVegetal = Server()->Tick();
     }
     if (Server()->Tick() - m_TimeEnv > Server()->TickSpeed()*0.75f)
     {
-        Envirionment = true;
+        Steps |= CWorldSim::STEP_ENVIRONMENT;
         m_TimeEnv = Server()->Tick();
     }
     if (Server()->Tick() - m_TimeDestruction > Server()->TickSpeed()*0.5f)
     {
-        Destruction = true;
+        Steps |= CWorldSim::STEP_DESTRUCTION;
         m_TimeDestruction = Server()->Tick();
     }
     if (Server()->Tick() - m_TimeCook > Server()->TickSpeed()*5.0f)
     {
-        Cook = true;
+        Steps |= CWorldSim::STEP_COOK;
         m_TimeCook = Server()->Tick();
     }
     if (Server()->Tick() - m_TimeWear > Server()->TickSpeed()*75.0f)
     {
-        Wear = true;
+        Steps |= CWorldSim::STEP_WEAR;
         m_TimeWear = Server()->Tick();
     }
 
+	//Actions
+	if(Steps)
+	{
+		static int s_ProfileWorld = g_Profiler.Section("controller.world");
+		CProfileScope Scope(s_ProfileWorld);
 
-    //Actions
-    bool ActionRun = false;
-    if (Vegetal || Envirionment || Destruction || Cook || Wear)
-    {
-        CMapItemLayerTilemap *pTmap = (CMapItemLayerTilemap *)GameServer()->Layers()->MineTeeLayer();
-        if (pTmap)
-        {
-            CTile *pTiles = (CTile *)GameServer()->Layers()->Map()->GetData(pTmap->m_Data);
-            CTile *pTempTiles = static_cast<CTile*>(mem_alloc(sizeof(CTile)*pTmap->m_Width*pTmap->m_Height,1));
-            mem_copy(pTempTiles, pTiles, sizeof(CTile)*pTmap->m_Width*pTmap->m_Height);
-
-            for(int y = 0; y < pTmap->m_Height-1; y++)
-            {
-                for(int x = 0; x < pTmap->m_Width-1; x++)
-                {
-                    int c = y*pTmap->m_Width+x;
-
-                    if (Envirionment)
-                    {
-                        if (((pTempTiles[c].m_Index >= BLOCK_UNDEF82 && pTempTiles[c].m_Index <= BLOCK_AGUA) || (pTempTiles[c].m_Index >= BLOCK_UNDEF104 && pTempTiles[c].m_Index <= BLOCK_LAVA)) && y+1 < pTmap->m_Height && x+1 < pTmap->m_Width)
-                        {
-                            int tc = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[tc].m_Index == 0 || (pTempTiles[tc].m_Index >= BLOCK_UNDEF82 && pTempTiles[tc].m_Index < BLOCK_UNDEF84) || (pTempTiles[tc].m_Index >= BLOCK_UNDEF104 && pTempTiles[tc].m_Index < BLOCK_UNDEF106))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y+1;
-                                if (pTempTiles[c].m_Index >= BLOCK_UNDEF82 && pTempTiles[c].m_Index <= BLOCK_AGUA)
-                                    TileInfo.m_ITile = BLOCK_UNDEF84;
-                                else
-                                    TileInfo.m_ITile = BLOCK_UNDEF106;
-                                TileInfo.m_Col = 0;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-
-                                if (pTempTiles[c].m_Index >= BLOCK_UNDEF82 && pTempTiles[c].m_Index <= BLOCK_AGUA)
-                                    GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_UNDEF84, 0);
-                                else
-                                   GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_UNDEF106, 0);
-                            }
-                            else if ((pTempTiles[c].m_Index >= BLOCK_UNDEF104 && pTempTiles[c].m_Index <= BLOCK_LAVA && pTempTiles[tc].m_Index >= BLOCK_UNDEF82 && pTempTiles[tc].m_Index <= BLOCK_AGUA) ||
-                                     (pTempTiles[c].m_Index >= BLOCK_UNDEF82 && pTempTiles[c].m_Index <= BLOCK_AGUA && pTempTiles[tc].m_Index >= BLOCK_UNDEF104 && pTempTiles[tc].m_Index <= BLOCK_LAVA))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y+1;
-                                TileInfo.m_ITile = BLOCK_RUDINIUM;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_RUDINIUM);
-                            }
-
-                            tc = y*pTmap->m_Width+(x+1);
-                            int tb = (y+1)*pTmap->m_Width+(x+1);
-                            int te = (y-1)*pTmap->m_Width+(x+1);
-                            int tl = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[tl].m_Index != 0 && (pTempTiles[tl].m_Index < BLOCK_UNDEF82 || pTempTiles[tl].m_Index > BLOCK_AGUA) && (pTempTiles[tl].m_Index < BLOCK_UNDEF104 || pTempTiles[tl].m_Index > BLOCK_LAVA) &&
-                                pTempTiles[tc].m_Index == 0 &&
-                                (pTempTiles[tb].m_Index < BLOCK_UNDEF82 || pTempTiles[tb].m_Index > BLOCK_AGUA) && (pTempTiles[tb].m_Index < BLOCK_UNDEF104 || pTempTiles[tb].m_Index > BLOCK_LAVA) &&
-                                pTempTiles[c].m_Index-1 != BLOCK_UNDEF82-1 && pTempTiles[c].m_Index-1 != BLOCK_UNDEF104-1 &&
-                                (pTempTiles[te].m_Index < BLOCK_UNDEF82 || pTempTiles[te].m_Index > BLOCK_AGUA) && (pTempTiles[te].m_Index < BLOCK_UNDEF104 || pTempTiles[te].m_Index > BLOCK_LAVA))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x+1;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = pTiles[c].m_Index-1;
-                                TileInfo.m_Col = 0;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), pTiles[c].m_Index-1, 0);
-                            }
-                            tc = y*pTmap->m_Width+(x-1);
-                            tb = (y+1)*pTmap->m_Width+(x-1);
-                            te = (y-1)*pTmap->m_Width+(x-1);
-                            if (pTempTiles[tl].m_Index != 0 && pTempTiles[tl].m_Index != BLOCK_AGUA && pTempTiles[tl].m_Index != BLOCK_LAVA &&
-                                pTempTiles[tc].m_Index == 0 &&
-                                (pTempTiles[tb].m_Index < BLOCK_UNDEF82 || pTempTiles[tb].m_Index > BLOCK_AGUA) && (pTempTiles[tb].m_Index < BLOCK_UNDEF104 || pTempTiles[tb].m_Index > BLOCK_LAVA) &&
-                                pTempTiles[c].m_Index-1 != BLOCK_UNDEF82-1 && pTempTiles[c].m_Index-1 != BLOCK_UNDEF104-1 &&
-                                (pTempTiles[te].m_Index < BLOCK_UNDEF82 || pTempTiles[te].m_Index > BLOCK_AGUA) && (pTempTiles[te].m_Index < BLOCK_UNDEF104 || pTempTiles[te].m_Index > BLOCK_LAVA))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x-1;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = pTiles[c].m_Index-1;
-                                TileInfo.m_Col = 0;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), pTiles[c].m_Index-1, 0);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_ROSAR || pTempTiles[c].m_Index == BLOCK_ROSAY)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == BLOCK_GROUND)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y+1;
-                                TileInfo.m_ITile = BLOCK_APGRASS;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_APGRASS);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_BED)
-                        {
-                            int indexT = y*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index == BLOCK_BED)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_UNDEF48;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_UNDEF48);
-
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x+1;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_UNDEF49;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_UNDEF49);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_INVENTARY)
-                        {
-                            int indexT = y*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index == BLOCK_INVENTARY)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_INVTA;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_INVTA);
-
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x+1;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_INVTB;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_INVTB);
-                            }
-                        }
-
-
-                        if (y>0)
-                        {
-                            if (pTempTiles[c].m_Index == BLOCK_GROUND)
-                            {
-                                bool found = false;
-                                for (int o=y-1; o>=0; o--)
-                                {
-                                    int indexT = o*pTmap->m_Width+x;
-                                    if (pTempTiles[indexT].m_Index != 0 && (pTempTiles[indexT].m_Index < BLOCK_SEED2 || pTempTiles[indexT].m_Index > BLOCK_SEED8))
-                                    {
-                                        found = true;
-                                        break;
-                                    }
-                                }
-
-                                if (!found)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y;
-                                    TileInfo.m_ITile = BLOCK_GRASSGROUND;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_CREATE;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_GRASSGROUND);
-                                }
-                            }
-                            else if (pTempTiles[c].m_Index == BLOCK_GRASSGROUND)
-                            {
-                                int indexT = (y-1)*pTmap->m_Width+x;
-                                if (pTempTiles[indexT].m_Index != 0 && (pTempTiles[indexT].m_Index < BLOCK_SEED2 || pTempTiles[indexT].m_Index > BLOCK_SEED8))
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y;
-                                    if (pTempTiles[indexT].m_Index == BLOCK_NIEVE)
-                                        TileInfo.m_ITile = BLOCK_BNGRASS;
-                                    else
-                                        TileInfo.m_ITile = BLOCK_GROUND;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_CREATE;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    if (pTempTiles[indexT].m_Index == BLOCK_NIEVE)
-                                        GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_BNGRASS);
-                                    else
-                                        GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_GROUND);
-                                }
-                            }
-                            else if (pTempTiles[c].m_Index == BLOCK_HORNO_OFF)
-                            {
-                                int indexT = (y-1)*pTmap->m_Width+x;
-                                int indexR = y*pTmap->m_Width+(x-1);
-                                int indexS = y*pTmap->m_Width+(x+1);
-                                if (pTempTiles[indexT].m_Index == BLOCK_CARBONP || pTempTiles[indexR].m_Index == BLOCK_CARBONP || pTempTiles[indexS].m_Index == BLOCK_CARBONP)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y;
-                                    TileInfo.m_ITile = BLOCK_HORNO_ON;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_CREATE;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_HORNO_ON);
-
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    if (pTempTiles[indexT].m_Index == BLOCK_CARBONP)
-                                    {
-                                        TileInfo.m_X = x;
-                                        TileInfo.m_Y = y-1;
-                                    }
-                                    else if (pTempTiles[indexR].m_Index == BLOCK_CARBONP)
-                                    {
-                                        TileInfo.m_X = x-1;
-                                        TileInfo.m_Y = y;
-                                    }
-                                    else if (pTempTiles[indexS].m_Index == BLOCK_CARBONP)
-                                    {
-                                        TileInfo.m_X = x+1;
-                                        TileInfo.m_Y = y;
-                                    }
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                }
-                            }
-                        }
-
-                        //BLOCK FALL
-                        if (pTempTiles[c].m_Index == BLOCK_ARENA || pTempTiles[c].m_Index == BLOCK_ARENAB || pTempTiles[c].m_Index == BLOCK_NIEVE || pTempTiles[c].m_Index == BLOCK_CARBONP)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y+1;
-                                TileInfo.m_ITile = pTempTiles[c].m_Index;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), pTempTiles[c].m_Index);
-                            }
-                        }
-
-                        //BLOCK DAMAGE
-                        if (pTempTiles[c].m_Index == BLOCK_CACTUS)
-                        {
-                            for (size_t e=0; e<MAX_CLIENTS; e++)
-                            {
-                                if (!GameServer()->m_apPlayers[e] || !GameServer()->m_apPlayers[e]->GetCharacter() || !GameServer()->m_apPlayers[e]->GetCharacter()->IsAlive())
-                                    continue;
-
-                                if (distance(GameServer()->m_apPlayers[e]->GetCharacter()->m_Pos, vec2((x<<5)+16.0f,(y<<5)+16.0f)) <= 36.0f)
-                                    GameServer()->m_apPlayers[e]->GetCharacter()->TakeDamage(vec2(0.0f, 0.0f), 1.0f, GameServer()->m_apPlayers[e]->GetCID(), WEAPON_WORLD);
-                            }
-                        }
-                    }
-
-                    if (Destruction)
-                    {
-                        if (pTempTiles[c].m_Index == BLOCK_AZUCAR)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index != BLOCK_AZUCAR && pTempTiles[indexT].m_Index != BLOCK_APGRASS)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_AZUCAR);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_CACTUS)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index != BLOCK_CACTUS && pTempTiles[indexT].m_Index != BLOCK_ARENA && pTempTiles[indexT].m_Index != BLOCK_ARENAB)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_CACTUS);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_LUZ)
-                        {
-                            bool found = false;
-
-                            int indexT = y*pTmap->m_Width+(x-1);
-                            if (pTempTiles[indexT].m_Index != 0 && pTempTiles[indexT].m_Index != BLOCK_LAVA && pTempTiles[indexT].m_Index != BLOCK_AGUA)
-                                found = true;
-                            indexT = y*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index != 0 && pTempTiles[indexT].m_Index != BLOCK_LAVA && pTempTiles[indexT].m_Index != BLOCK_AGUA)
-                                found = true;
-                            indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index != 0 && pTempTiles[indexT].m_Index != BLOCK_LAVA && pTempTiles[indexT].m_Index != BLOCK_AGUA)
-                                found = true;
-
-                            if (!found)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_LUZ);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index >= BLOCK_SEED1 && pTempTiles[c].m_Index <= BLOCK_SEED8)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_SEEDM);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_UNDEF48)
-                        {
-                            int indexT = y*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_BED);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_UNDEF49)
-                        {
-                            int indexT = y*pTmap->m_Width+(x-1);
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_BED);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_INVTA)
-                        {
-                            int indexT = y*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_INVENTARY);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_INVTB)
-                        {
-                            int indexT = y*pTmap->m_Width+(x-1);
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_INVENTARY);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_UNDEF84)
-                        {
-                            int indexT = (y-1)*pTmap->m_Width+x;
-                            int indexR = y*pTmap->m_Width+(x-1);
-                            int indexS = y*pTmap->m_Width+(x+1);
-                            if ((pTempTiles[indexT].m_Index < BLOCK_UNDEF82 || pTempTiles[indexT].m_Index > BLOCK_AGUA) &&
-                                (pTempTiles[indexR].m_Index < BLOCK_UNDEF82 || pTempTiles[indexR].m_Index > BLOCK_AGUA) &&
-                                (pTempTiles[indexS].m_Index < BLOCK_UNDEF82 || pTempTiles[indexS].m_Index > BLOCK_AGUA))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_UNDEF106)
-                        {
-                            int indexT = (y-1)*pTmap->m_Width+x;
-                            int indexR = y*pTmap->m_Width+(x-1);
-                            int indexS = y*pTmap->m_Width+(x+1);
-                            if ((pTempTiles[indexT].m_Index < BLOCK_UNDEF104 || pTempTiles[indexT].m_Index > BLOCK_LAVA) &&
-                                (pTempTiles[indexR].m_Index < BLOCK_UNDEF104 || pTempTiles[indexR].m_Index > BLOCK_LAVA) &&
-                                (pTempTiles[indexS].m_Index < BLOCK_UNDEF104 || pTempTiles[indexS].m_Index > BLOCK_LAVA))
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index == BLOCK_ROSAR || pTempTiles[c].m_Index == BLOCK_ROSAY)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = -1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_DESTROY;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, pTempTiles[c].m_Index);
-                                pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                            }
-                        }
-                    }
-
-                    if (Vegetal)
-                    {
-                        /** Crecimiento **/
-                        if (pTempTiles[c].m_Index == BLOCK_AZUCAR)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == BLOCK_AZUCAR || pTempTiles[indexT].m_Index == BLOCK_APGRASS)
-                            {
-                                indexT = (y-1)*pTmap->m_Width+x;
-                                if (pTempTiles[indexT].m_Index == 0)
-                                {
-                                    int tam=0;
-                                    bool canC = false;
-                                    for(int u=1; u<=5; u++)
-                                    {
-                                        int indexA = (y+u)*pTmap->m_Width+x;
-                                        if (pTempTiles[indexA].m_Index == BLOCK_AZUCAR)
-                                            tam++;
-                                        else
-                                        {
-                                            if (pTempTiles[indexA].m_Index == BLOCK_APGRASS)
-                                                canC = true;
-                                            break;
-                                        }
-                                    }
-
-                                    if ((rand()%10) == 7 && canC && tam < 5)
-                                    {
-                                        CNetMsg_Sv_TileChangeExt TileInfo;
-                                        TileInfo.m_Size = -1;
-                                        TileInfo.m_Index = -1;
-                                        TileInfo.m_X = x;
-                                        TileInfo.m_Y = y-1;
-                                        TileInfo.m_ITile = BLOCK_AZUCAR;
-                                        TileInfo.m_Col = 1;
-                                        TileInfo.m_Act = TILE_CREATE;
-                                        TileInfo.m_State = 0;
-
-                                        Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                        GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_AZUCAR);
-                                    }
-                                }
-                            }
-                        }
-
-                        if (pTempTiles[c].m_Index == BLOCK_CACTUS)
-                        {
-                            int indexT = (y+1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == BLOCK_CACTUS || pTempTiles[indexT].m_Index == BLOCK_ARENA || pTempTiles[indexT].m_Index == BLOCK_ARENAB)
-                            {
-                                indexT = (y-1)*pTmap->m_Width+x;
-                                if (pTempTiles[indexT].m_Index == 0)
-                                {
-                                    int tam=0;
-                                    bool canC = false;
-                                    for(int u=1; u<=5; u++)
-                                    {
-                                        int indexA = (y+u)*pTmap->m_Width+x;
-                                        if (pTempTiles[indexA].m_Index == BLOCK_CACTUS)
-                                            tam++;
-                                        else
-                                        {
-                                            if (pTempTiles[indexA].m_Index == BLOCK_ARENA || pTempTiles[indexA].m_Index == BLOCK_ARENAB)
-                                                canC = true;
-                                            break;
-                                        }
-                                    }
-
-                                    if ((rand()%10) == 7 && canC && tam < 8)
-                                    {
-                                        CNetMsg_Sv_TileChangeExt TileInfo;
-                                        TileInfo.m_Size = -1;
-                                        TileInfo.m_Index = -1;
-                                        TileInfo.m_X = x;
-                                        TileInfo.m_Y = y-1;
-                                        TileInfo.m_ITile = BLOCK_CACTUS;
-                                        TileInfo.m_Col = 1;
-                                        TileInfo.m_Act = TILE_CREATE;
-                                        TileInfo.m_State = 0;
-
-                                        Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                        GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_CACTUS);
-                                    }
-                                }
-                            }
-                        }
-                        else if (pTempTiles[c].m_Index >= BLOCK_SEED1 && pTempTiles[c].m_Index < BLOCK_SEED8)
-                        {
-                            if ((rand()%1) == 0)
-                            {
-                                int nindex = pTempTiles[c].m_Index+1;
-                                int cindex = (y+1)*pTmap->m_Width+x;
-                                if (pTempTiles[cindex].m_Index != BLOCK_APGRASS && nindex > BLOCK_SEED4)
-                                    nindex = BLOCK_SEED4;
-
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = nindex;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), nindex);
-                            }
-                        }
-
-                        /** Creacion **/
-                        if ((rand()%100)==3 && (pTempTiles[c].m_Index == BLOCK_ARENA || pTempTiles[c].m_Index == BLOCK_ARENAB))
-                        {
-                            int indexT = (y-1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                bool found = false;
-
-                                for (int i=-4; i<5; i++)
-                                {
-                                    int indexT = (y-1)*pTmap->m_Width+(x+i);
-                                    if (pTempTiles[indexT].m_Index == BLOCK_CACTUS)
-                                    {
-                                        found = true;
-                                        break;
-                                    }
-                                }
-
-                                if (!found)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = BLOCK_CACTUS;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_CREATE;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_CACTUS);
-                                }
-                            }
-                        }
-                        else if ((rand()%100)==3 && pTempTiles[c].m_Index == BLOCK_SEED4)
-                        {
-                            int indexT = y*pTmap->m_Width+(x+1);
-                            int indexE = (y+1)*pTmap->m_Width+(x+1);
-                            if (pTempTiles[indexT].m_Index == 0 && pTempTiles[indexE].m_Index == BLOCK_GRASSGROUND)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x+1;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_SEED1;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_SEED1);
-                            }
-                        }
-
-                        /** Muerte **/
-                        if (pTempTiles[c].m_Index == BLOCK_APGRASS)
-                        {
-                            int indexT = (y-1)*pTmap->m_Width+x;
-                            if (pTempTiles[indexT].m_Index == 0)
-                            {
-                                CNetMsg_Sv_TileChangeExt TileInfo;
-                                TileInfo.m_Size = -1;
-                                TileInfo.m_Index = -1;
-                                TileInfo.m_X = x;
-                                TileInfo.m_Y = y;
-                                TileInfo.m_ITile = BLOCK_GROUND;
-                                TileInfo.m_Col = 1;
-                                TileInfo.m_Act = TILE_CREATE;
-                                TileInfo.m_State = 0;
-
-                                Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_GROUND);
-                            }
-                        }
-                    }
-
-                    if (Cook)
-                    {
-                        if (y > 0)
-                        {
-                            if (pTempTiles[c].m_Index == BLOCK_HORNO_ON)
-                            {
-                                int indexT = (y-1)*pTmap->m_Width+x;
-                                if (pTempTiles[indexT].m_Index == BLOCK_ARENA || pTempTiles[indexT].m_Index == BLOCK_ARENAB)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                    CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_CRISTAL);
-                                    pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                                }
-                                else if (pTempTiles[indexT].m_Index == BLOCK_STONE)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                    CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_STONE2);
-                                    pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                                }
-                                else if (pTempTiles[indexT].m_Index == BLOCK_UNDEF63)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                    CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_TARENA);
-                                    pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                                }
-                                else if (pTempTiles[indexT].m_Index == BLOCK_GOLD)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                    CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_OROP);
-                                    pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                                }
-                                else if (pTempTiles[indexT].m_Index == BLOCK_PLATA)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                    CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_PLATAP);
-                                    pPickup->m_Pos = vec2(TileInfo.m_X*32.0f + 8.0f, TileInfo.m_Y*32.0f + 8.0f);
-                                }
-                                else if (pTempTiles[indexT].m_Index != 0 && pTempTiles[indexT].m_Index != BLOCK_CRISTAL && pTempTiles[indexT].m_Index != BLOCK_STONE2)
-                                {
-                                    CNetMsg_Sv_TileChangeExt TileInfo;
-                                    TileInfo.m_Size = -1;
-                                    TileInfo.m_Index = -1;
-                                    TileInfo.m_X = x;
-                                    TileInfo.m_Y = y-1;
-                                    TileInfo.m_ITile = -1;
-                                    TileInfo.m_Col = 1;
-                                    TileInfo.m_Act = TILE_DESTROY;
-                                    TileInfo.m_State = 0;
-
-                                    Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                                    GameServer()->Collision()->DestroyTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5));
-                                }
-                            }
-                        }
-                    }
-
-                    if (Wear)
-                    {
+		// only the cells that can change are looked at, applying the changes queues their neighbours
+		CWorldSim *pSim = &GameServer()->m_WorldSim;
+		int Num = pSim->Run(Steps);
+		for(int i = 0; i < Num; i++)
+			ApplyWorldChange(pSim->GetChange(i));
 
-                        if (pTempTiles[c].m_Index == BLOCK_HORNO_ON)
-                        {
-                            CNetMsg_Sv_TileChangeExt TileInfo;
-                            TileInfo.m_Size = -1;
-                            TileInfo.m_Index = -1;
-                            TileInfo.m_X = x;
-                            TileInfo.m_Y = y;
-                            TileInfo.m_ITile = BLOCK_HORNO_OFF;
-                            TileInfo.m_Col = 1;
-                            TileInfo.m_Act = TILE_CREATE;
-                            TileInfo.m_State = 0;
-
-                            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                            GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_HORNO_OFF);
-                        }
-                        else if ((rand()%100) == 2 && pTempTiles[c].m_Index == BLOCK_STONE2)
-                        {
-                            CNetMsg_Sv_TileChangeExt TileInfo;
-                            TileInfo.m_Size = -1;
-                            TileInfo.m_Index = -1;
-                            TileInfo.m_X = x;
-                            TileInfo.m_Y = y;
-                            TileInfo.m_ITile = BLOCK_STONE2BREAK;
-                            TileInfo.m_Col = 1;
-                            TileInfo.m_Act = TILE_CREATE;
-                            TileInfo.m_State = 0;
-
-                            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                            GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_STONE2BREAK);
-                        }
-                        else if ((rand()%100) == 2 && pTempTiles[c].m_Index == BLOCK_STONE2BREAK)
-                        {
-                            CNetMsg_Sv_TileChangeExt TileInfo;
-                            TileInfo.m_Size = -1;
-                            TileInfo.m_Index = -1;
-                            TileInfo.m_X = x;
-                            TileInfo.m_Y = y;
-                            TileInfo.m_ITile = BLOCK_STONE2MOO;
-                            TileInfo.m_Col = 1;
-                            TileInfo.m_Act = TILE_CREATE;
-                            TileInfo.m_State = 0;
-
-                            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
-                            GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_STONE2MOO);
-                        }
-                    }
-                }
-            }
+		if(Steps&CWorldSim::STEP_ENVIRONMENT)
+			HurtOnCactus();
+	}
 
-            mem_free(pTempTiles);
-        }
-    }
+	TickNpcs();
 
 	IGameController::Tick();
 }
@@ -999,30 +121,8 @@ void CGameControllerMINETEE::Tick()
 void CGameControllerMINETEE::OnCharacterSpawn(class CCharacter *pChr)
 {
 	pChr->IncreaseHealth(10);
-
-	// Zombies Weapons
-	switch (pChr->GetPlayer()->GetTeam())
-	{
-        case TEAM_ENEMY_TEEPER:
-            pChr->GiveBlock(BLOCK_TNT, 1);
-            pChr->SetWeapon(NUM_WEAPONS+BLOCK_TNT);
-            break;
-
-        case TEAM_ENEMY_ZOMBITEE:
-        case TEAM_ENEMY_SPIDERTEE:
-            pChr->GiveWeapon(WEAPON_HAMMER, -1);
-            pChr->SetWeapon(WEAPON_HAMMER);
-            break;
-
-        case TEAM_ENEMY_SKELETEE:
-            pChr->GiveWeapon(WEAPON_GRENADE, -1);
-            pChr->SetWeapon(WEAPON_GRENADE);
-            break;
-
-        default:
-            pChr->GiveWeapon(WEAPON_HAMMER, -1);
-            pChr->SetWeapon(WEAPON_HAMMER);
-	}
+	pChr->GiveWeapon(WEAPON_HAMMER, -1);
+	pChr->SetWeapon(WEAPON_HAMMER);
 }
 
 int CGameControllerMINETEE::OnCharacterDeath(class CCharacter *pVictim, class CPlayer *pKiller, int Weapon)
@@ -1040,8 +140,7 @@ int CGameControllerMINETEE::OnCharacterDeath(class CCharacter *pVictim, class CP
                 if (pVictim->m_aBlocks[Index-NUM_WEAPONS].m_Got)
                 {
                     CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_DROPITEM, Index-NUM_WEAPONS);
-                    pPickup->m_Pos = pVictim->m_Pos;
-                    pPickup->m_Pos.y -= 18.0f;
+                    pPickup->SetPos(vec2(pVictim->m_Pos.x, pVictim->m_Pos.y-18.0f));
                     pPickup->m_Vel = vec2((((rand()%2)==0)?1:-1)*(rand()%10), -5);
                     pPickup->m_Amount = pVictim->m_aBlocks[Index-NUM_WEAPONS].m_Amount;
                     pPickup->m_Owner = pVictim->GetPlayer()->GetCID();
@@ -1050,10 +149,14 @@ int CGameControllerMINETEE::OnCharacterDeath(class CCharacter *pVictim, class CP
         }
     }
 
-    if (pVictim->GetPlayer() == pKiller)
-        return 1;
+    return 1;
+}
 
-    if (g_Config.m_SvGameMode == 1 && pKiller->GetCharacter() && pVictim->GetPlayer()->GetTeam() > TEAM_BLUE && pVictim->GetPlayer()->GetTeam() < TEAM_ANIMAL_TEECOW)
+void CGameControllerMINETEE::OnNpcDeath(class CNpc *pNpc, class CPlayer *pKiller, int Weapon)
+{
+    IGameController::OnNpcDeath(pNpc, pKiller, Weapon);
+
+    if (g_Config.m_SvGameMode == 1 && pKiller && pKiller->GetCharacter() && pNpc->IsMonster())
     {
         int Kills = pKiller->GetCharacter()->m_Kills;
         if (Kills > 0 && (Kills%8) == 0)
@@ -1065,35 +168,86 @@ int CGameControllerMINETEE::OnCharacterDeath(class CCharacter *pVictim, class CP
         }
     }
 
-    if (pVictim->GetPlayer()->GetTeam() == TEAM_ANIMAL_TEECOW)
+    if (pNpc->GetType() == TEAM_ANIMAL_TEECOW)
     {
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_FOOD, FOOD_COW);
-		pPickup->m_Pos = pVictim->m_Pos;
+		pPickup->SetPos(pNpc->m_Pos);
         pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_CUERO);
-		pPickup->m_Pos = pVictim->m_Pos;
-
-		return 0;
+		pPickup->SetPos(pNpc->m_Pos);
     }
-    else if (pVictim->GetPlayer()->GetTeam() == TEAM_ANIMAL_TEEPIG)
+    else if (pNpc->GetType() == TEAM_ANIMAL_TEEPIG)
     {
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_FOOD, FOOD_PIG);
-		pPickup->m_Pos = pVictim->m_Pos;
-		return 0;
+		pPickup->SetPos(pNpc->m_Pos);
     }
-    else if (pVictim->GetPlayer()->GetTeam() == TEAM_ENEMY_TEEPER)
+    else if (pNpc->GetType() == TEAM_ENEMY_TEEPER)
     {
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_POLVORA);
-		pPickup->m_Pos = pVictim->m_Pos;
-		return 0;
+		pPickup->SetPos(pNpc->m_Pos);
     }
-    else if (pVictim->GetPlayer()->GetTeam() == TEAM_ENEMY_SKELETEE)
+    else if (pNpc->GetType() == TEAM_ENEMY_SKELETEE)
     {
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, POWERUP_BLOCK, BLOCK_HUESO);
-		pPickup->m_Pos = pVictim->m_Pos;
-		return 0;
+		pPickup->SetPos(pNpc->m_Pos);
     }
+}
 
-    return 1;
+void CGameControllerMINETEE::TickNpcs()
+{
+	static int s_ProfileNpcs = g_Profiler.Section("controller.npcs");
+	CProfileScope Scope(s_ProfileNpcs);
+
+	CNpc::CTargets Targets;
+	CNpc::GatherTargets(GameServer(), &Targets);
+
+	// the ones waiting for removal still hold their pool slot
+	int Num = 0;
+	for(CNpc *pNpc = (CNpc *)GameServer()->m_World.FindFirst(CGameWorld::ENTTYPE_NPC); pNpc; pNpc = (CNpc *)pNpc->TypeNext())
+	{
+		Num++;
+		if((!g_Config.m_SvMonsters && pNpc->IsMonster()) || (!g_Config.m_SvAnimals && pNpc->IsAnimal()))
+			GameServer()->m_World.DestroyEntity(pNpc);
+	}
+
+	// one per tick, like the bots used to come back one by one
+	if(Num < g_Config.m_SvNpcs)
+	{
+		int Type;
+		if(Targets.m_IsDay)
+		{
+			int aTypes[3] = { TEAM_ENEMY_TEEPER, TEAM_ENEMY_ZOMBITEE, TEAM_ENEMY_SKELETEE };
+			Type = aTypes[rand()%3];
+		}
+		else
+		{
+			int aTypes[2] = { TEAM_ANIMAL_TEECOW, TEAM_ANIMAL_TEEPIG };
+			Type = aTypes[rand()%2];
+		}
+
+		vec2 Pos;
+		if(CanSpawn(Type, &Pos))
+			new CNpc(&GameServer()->m_World, Type, Pos);
+	}
+
+	// all of the ai at once, the targets are the same for everyone
+	Num = 0;
+	for(CNpc *pNpc = (CNpc *)GameServer()->m_World.FindFirst(CGameWorld::ENTTYPE_NPC); pNpc; pNpc = (CNpc *)pNpc->TypeNext())
+	{
+		if(Num == m_NpcCapacity)
+		{
+			int Capacity = max(256, m_NpcCapacity*2);
+			CNpc **apNpcs = (CNpc **)mem_alloc(Capacity*sizeof(CNpc *), 1);
+			if(m_apNpcs)
+			{
+				mem_copy(apNpcs, m_apNpcs, Num*sizeof(CNpc *));
+				mem_free(m_apNpcs);
+			}
+			m_apNpcs = apNpcs;
+			m_NpcCapacity = Capacity;
+		}
+		m_apNpcs[Num++] = pNpc;
+	}
+	CNpc::UpdateAll(GameServer(), m_apNpcs, Num, &Targets);
 }
 
 bool CGameControllerMINETEE::CanJoinTeam(int Team, int NotThisID)
@@ -3,19 +3,30 @@
 #ifndef GAME_SERVER_GAMEMODES_MINETEE_H
 #define GAME_SERVER_GAMEMODES_MINETEE_H
 #include <game/server/gamecontroller.h>
+#include <game/server/worldsim.h>
 
 class CGameControllerMINETEE : public IGameController
 {
 public:
 	CGameControllerMINETEE(class CGameContext *pGameServer);
+	virtual ~CGameControllerMINETEE();
 	virtual void Tick();
 
 	virtual void OnCharacterSpawn(class CCharacter *pChr);
 	virtual int OnCharacterDeath(class CCharacter *pVictim, class CPlayer *pKiller, int Weapon);
+	virtual void OnNpcDeath(class CNpc *pNpc, class CPlayer *pKiller, int Weapon);
 	virtual bool OnChat(int cid, int team, const char *msg);
 	bool CanJoinTeam(int Team, int NotThisID);
 
 private:
+	void TickNpcs();
+	void ApplyWorldChange(const CWorldSim::CChange *pChange);
+	void HurtOnCactus();
+
+	// the npcs of this tick, handed to the ai in one go
+	class CNpc **m_apNpcs;
+	int m_NpcCapacity;
+
 	float m_TimeVegetal;
 	float m_TimeEnv;
 	float m_TimeDestruction;
@@ -32,7 +32,7 @@ bool CGameControllerCTF::OnEntity(int Index, vec2 Pos)
 
 	CFlag *F = new CFlag(&GameServer()->m_World, Team);
 	F->m_StandPos = Pos;
-	F->m_Pos = Pos;
+	F->SetPos(Pos);
 	m_apFlags[Team] = F;
 	GameServer()->m_World.InsertEntity(F);
 	return true;
@@ -109,7 +109,7 @@ void CGameControllerCTF::Snap(int SnappingClient)
 {
 	IGameController::Snap(SnappingClient);
 
-	CNetObj_GameData *pGameDataObj = (CNetObj_GameData *)Server()->SnapNewItem(NETOBJTYPE_GAMEDATA, 0, sizeof(CNetObj_GameData));
+	CNetObj_GameData *pGameDataObj = (CNetObj_GameData *)GameServer()->SnapNewItem(NETOBJTYPE_GAMEDATA, 0, sizeof(CNetObj_GameData));
 	if(!pGameDataObj)
 		return;
 
@@ -167,7 +167,7 @@ void CGameControllerCTF::Tick()
 		if(F->m_pCarryingCharacter)
 		{
 			// update flag position
-			F->m_Pos = F->m_pCarryingCharacter->m_Pos;
+			F->SetPos(F->m_pCarryingCharacter->m_Pos);
 
 			if(m_apFlags[fi^1] && m_apFlags[fi^1]->m_AtStand)
 			{
@@ -273,7 +273,9 @@ void CGameControllerCTF::Tick()
 				else
 				{
 					F->m_Vel.y += GameServer()->m_World.m_Core.m_Tuning.m_Gravity;
-					GameServer()->Collision()->MoveBox(&F->m_Pos, &F->m_Vel, vec2(F->ms_PhysSize, F->ms_PhysSize), 0.5f);
+					vec2 Pos = F->m_Pos;
+					GameServer()->Collision()->MoveBox(&Pos, &F->m_Vel, vec2(F->ms_PhysSize, F->ms_PhysSize), 0.5f);
+					F->SetPos(Pos);
 				}
 			}
 		}
@@ -32,7 +32,7 @@ bool CGameControllerCTFB::OnEntity(int Index, vec2 Pos)
 
 	CFlag *F = new CFlag(&GameServer()->m_World, Team);
 	F->m_StandPos = Pos;
-	F->m_Pos = Pos;
+	F->SetPos(Pos);
 	m_apFlags[Team] = F;
 	GameServer()->m_World.InsertEntity(F);
 	return true;
@@ -116,7 +116,7 @@ void CGameControllerCTFB::Snap(int SnappingClient)
 {
 	IGameController::Snap(SnappingClient);
 
-	CNetObj_GameData *pGameDataObj = (CNetObj_GameData *)Server()->SnapNewItem(NETOBJTYPE_GAMEDATA, 0, sizeof(CNetObj_GameData));
+	CNetObj_GameData *pGameDataObj = (CNetObj_GameData *)GameServer()->SnapNewItem(NETOBJTYPE_GAMEDATA, 0, sizeof(CNetObj_GameData));
 	if(!pGameDataObj)
 		return;
 
@@ -186,7 +186,7 @@ void CGameControllerCTFB::Tick()
                             TileInfo.m_Act = TILE_CREATE;
                             TileInfo.m_State = 0;
 
-                            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                            GameServer()->SendTileChange(TileInfo.m_X, TileInfo.m_Y, TileInfo.m_Act, TileInfo.m_ITile, TileInfo.m_Col, TileInfo.m_State);
                             GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), pTiles[c].m_Index, 0);
                         }
                         else if ((pTempTiles[c].m_Index == BLOCK_LAVA && pTempTiles[tc].m_Index == BLOCK_AGUA) || (pTempTiles[c].m_Index == BLOCK_AGUA && pTempTiles[tc].m_Index == BLOCK_LAVA))
@@ -201,7 +201,7 @@ void CGameControllerCTFB::Tick()
                             TileInfo.m_Act = TILE_CREATE;
                             TileInfo.m_State = 0;
 
-                            Server()->SendPackMsg(&TileInfo, MSGFLAG_VITAL, -1);
+                            GameServer()->SendTileChange(TileInfo.m_X, TileInfo.m_Y, TileInfo.m_Act, TileInfo.m_ITile, TileInfo.m_Col, TileInfo.m_State);
                             GameServer()->Collision()->CreateTile(vec2(TileInfo.m_X<<5, TileInfo.m_Y<<5), BLOCK_RUDINIUM);
                         }
                     }
@@ -236,7 +236,7 @@ void CGameControllerCTFB::Tick()
 		if(F->m_pCarryingCharacter)
 		{
 			// update flag position
-			F->m_Pos = F->m_pCarryingCharacter->m_Pos;
+			F->SetPos(F->m_pCarryingCharacter->m_Pos);
 
 			if(m_apFlags[fi^1] && m_apFlags[fi^1]->m_AtStand)
 			{
@@ -342,7 +342,9 @@ void CGameControllerCTFB::Tick()
 				else
 				{
 					F->m_Vel.y += GameServer()->m_World.m_Core.m_Tuning.m_Gravity;
-					GameServer()->Collision()->MoveBox(&F->m_Pos, &F->m_Vel, vec2(F->ms_PhysSize, F->ms_PhysSize), 0.5f);
+					vec2 Pos = F->m_Pos;
+					GameServer()->Collision()->MoveBox(&Pos, &F->m_Vel, vec2(F->ms_PhysSize, F->ms_PhysSize), 0.5f);
+					F->SetPos(Pos);
 				}
 			}
 		}
@@ -1,6 +1,10 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
+#include <algorithm> // sort
+
+#include <engine/shared/profiler.h>
+
 #include "gameworld.h"
 #include "entity.h"
 #include "gamecontext.h"
@@ -15,8 +19,31 @@ CGameWorld::CGameWorld()
 
 	m_Paused = false;
 	m_ResetRequested = false;
+	static const char *s_apTypeNames[NUM_ENTTYPES] = {"projectile", "laser", "pickup", "flag", "character", "trunk", "npc"};
 	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
 		m_apFirstEntityTypes[i] = 0;
+		m_aMaxProximityRadius[i] = 0.0f;
+
+		char aName[CProfiler::MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "world.tick.%s", s_apTypeNames[i]);
+		m_aProfileTick[i] = g_Profiler.Section(aName);
+		str_format(aName, sizeof(aName), "world.tickdefered.%s", s_apTypeNames[i]);
+		m_aProfileTickDefered[i] = g_Profiler.Section(aName);
+		str_format(aName, sizeof(aName), "world.snap.%s", s_apTypeNames[i]);
+		m_aProfileSnap[i] = g_Profiler.Section(aName);
+	}
+	m_pNextTraverseEntity = 0;
+	m_InsertOrder = 0;
+
+	m_GridWidth = 0;
+	m_GridHeight = 0;
+	m_apGridCells = 0;
+	m_Query.m_apEntities = 0;
+	m_Query.m_Capacity = 0;
+	m_SnapQuery.m_apEntities = 0;
+	m_SnapQuery.m_Capacity = 0;
+	InitGrid(0, 0);
 }
 
 CGameWorld::~CGameWorld()
@@ -25,6 +52,12 @@ CGameWorld::~CGameWorld()
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 		while(m_apFirstEntityTypes[i])
 			delete m_apFirstEntityTypes[i];
+
+	mem_free(m_apGridCells);
+	if(m_Query.m_apEntities)
+		mem_free(m_Query.m_apEntities);
+	if(m_SnapQuery.m_apEntities)
+		mem_free(m_SnapQuery.m_apEntities);
 }
 
 void CGameWorld::SetGameServer(CGameContext *pGameServer)
@@ -33,6 +66,116 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pServer = m_pGameServer->Server();
 }
 
+void CGameWorld::InitGrid(int Width, int Height)
+{
+	// take everything out and size the grid for the map
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			UnlinkCell(pEnt);
+
+	if(m_apGridCells)
+		mem_free(m_apGridCells);
+	m_GridWidth = max(1, (Width+GRID_CELLSIZE-1)/GRID_CELLSIZE);
+	m_GridHeight = max(1, (Height+GRID_CELLSIZE-1)/GRID_CELLSIZE);
+	int Size = NUM_ENTTYPES*m_GridWidth*m_GridHeight*sizeof(CEntity *);
+	m_apGridCells = (CEntity **)mem_alloc(Size, 1);
+	mem_zero(m_apGridCells, Size);
+
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			LinkCell(pEnt, GridCell(pEnt->m_Pos));
+}
+
+bool CGameWorld::CompareInsertOrder(const CEntity *pA, const CEntity *pB)
+{
+	// the type lists have the newest entity first
+	return pA->m_InsertOrder > pB->m_InsertOrder;
+}
+
+int CGameWorld::GridX(float x) const
+{
+	if(!(x >= 0.0f))
+		return 0;
+	if(x >= (float)(m_GridWidth*GRID_CELLSIZE))
+		return m_GridWidth-1;
+	return (int)x/GRID_CELLSIZE;
+}
+
+int CGameWorld::GridY(float y) const
+{
+	if(!(y >= 0.0f))
+		return 0;
+	if(y >= (float)(m_GridHeight*GRID_CELLSIZE))
+		return m_GridHeight-1;
+	return (int)y/GRID_CELLSIZE;
+}
+
+void CGameWorld::LinkCell(CEntity *pEnt, int Cell)
+{
+	CEntity **ppFirst = &m_apGridCells[pEnt->m_ObjType*m_GridWidth*m_GridHeight + Cell];
+	if(*ppFirst)
+		(*ppFirst)->m_pPrevCellEntity = pEnt;
+	pEnt->m_pNextCellEntity = *ppFirst;
+	pEnt->m_pPrevCellEntity = 0;
+	pEnt->m_GridCell = Cell;
+	*ppFirst = pEnt;
+}
+
+void CGameWorld::UnlinkCell(CEntity *pEnt)
+{
+	if(pEnt->m_GridCell == -1)
+		return;
+
+	if(pEnt->m_pPrevCellEntity)
+		pEnt->m_pPrevCellEntity->m_pNextCellEntity = pEnt->m_pNextCellEntity;
+	else
+		m_apGridCells[pEnt->m_ObjType*m_GridWidth*m_GridHeight + pEnt->m_GridCell] = pEnt->m_pNextCellEntity;
+	if(pEnt->m_pNextCellEntity)
+		pEnt->m_pNextCellEntity->m_pPrevCellEntity = pEnt->m_pPrevCellEntity;
+
+	pEnt->m_pNextCellEntity = 0;
+	pEnt->m_pPrevCellEntity = 0;
+	pEnt->m_GridCell = -1;
+}
+
+void CGameWorld::UpdateEntityCell(CEntity *pEnt)
+{
+	int Cell = GridCell(pEnt->m_Pos);
+	if(Cell == pEnt->m_GridCell)
+		return;
+	UnlinkCell(pEnt);
+	LinkCell(pEnt, Cell);
+}
+
+int CGameWorld::QueryGrid(CQueryBuffer *pBuffer, int Type, vec2 Min, vec2 Max)
+{
+	// everything of the type that sits in a cell touching the box. the cells
+	// are not in list order, callers sort what is left after their tests
+	int Num = 0;
+	int x0 = GridX(Min.x), x1 = GridX(Max.x);
+	int y0 = GridY(Min.y), y1 = GridY(Max.y);
+	CEntity **ppCells = &m_apGridCells[Type*m_GridWidth*m_GridHeight];
+	for(int y = y0; y <= y1; y++)
+		for(int x = x0; x <= x1; x++)
+			for(CEntity *pEnt = ppCells[y*m_GridWidth+x]; pEnt; pEnt = pEnt->m_pNextCellEntity)
+			{
+				if(Num == pBuffer->m_Capacity)
+				{
+					int Capacity = max(64, pBuffer->m_Capacity*2);
+					CEntity **ppEnts = (CEntity **)mem_alloc(Capacity*sizeof(CEntity *), 1);
+					if(pBuffer->m_apEntities)
+					{
+						mem_copy(ppEnts, pBuffer->m_apEntities, Num*sizeof(CEntity *));
+						mem_free(pBuffer->m_apEntities);
+					}
+					pBuffer->m_apEntities = ppEnts;
+					pBuffer->m_Capacity = Capacity;
+				}
+				pBuffer->m_apEntities[Num++] = pEnt;
+			}
+	return Num;
+}
+
 CEntity *CGameWorld::FindFirst(int Type)
 {
 	return Type < 0 || Type >= NUM_ENTTYPES ? 0 : m_apFirstEntityTypes[Type];
@@ -43,19 +186,25 @@ int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max,
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
+	// one unit more so rounding can't leave a cell out
+	float Range = Radius+m_aMaxProximityRadius[Type]+1.0f;
+	int NumCandidates = QueryGrid(&m_Query, Type, Pos-vec2(Range, Range), Pos+vec2(Range, Range));
+
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type];	pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	for(int i = 0; i < NumCandidates; i++)
 	{
+		CEntity *pEnt = m_Query.m_apEntities[i];
 		if(distance(pEnt->m_Pos, Pos) < Radius+pEnt->m_ProximityRadius)
-		{
-			if(ppEnts)
-				ppEnts[Num] = pEnt;
-			Num++;
-			if(Num == Max)
-				break;
-		}
+			m_Query.m_apEntities[Num++] = pEnt;
 	}
 
+	// same ones as walking the type list would give first
+	std::sort(m_Query.m_apEntities, m_Query.m_apEntities+Num, CompareInsertOrder);
+	if(Num > Max)
+		Num = Max;
+	if(ppEnts)
+		mem_copy(ppEnts, m_Query.m_apEntities, Num*sizeof(CEntity *));
+
 	return Num;
 }
 
@@ -72,6 +221,10 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = 0x0;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	pEnt->m_InsertOrder = ++m_InsertOrder;
+	m_aMaxProximityRadius[pEnt->m_ObjType] = max(m_aMaxProximityRadius[pEnt->m_ObjType], pEnt->m_ProximityRadius);
+	LinkCell(pEnt, GridCell(pEnt->m_Pos));
 }
 
 void CGameWorld::DestroyEntity(CEntity *pEnt)
@@ -99,18 +252,41 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = 0;
 	pEnt->m_pPrevTypeEntity = 0;
+	UnlinkCell(pEnt);
 }
 
 //
 void CGameWorld::Snap(int SnappingClient)
 {
 	for(int i = 0; i < NUM_ENTTYPES; i++)
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
+	{
+		CProfileScope Scope(m_aProfileSnap[i]);
+
+		// projectiles are clipped where they are now, not at m_Pos
+		if(SnappingClient == -1 || i == ENTTYPE_PROJECTILE)
 		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
-			pEnt = m_pNextTraverseEntity;
+			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
+			{
+				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				pEnt->Snap(SnappingClient);
+				pEnt = m_pNextTraverseEntity;
+			}
+			continue;
 		}
+
+		// only the cells around the view, the rest would be clipped by NetworkClipped anyway
+		vec2 ViewPos = GameServer()->m_apPlayers[SnappingClient]->m_ViewPos;
+		int NumCandidates = QueryGrid(&m_SnapQuery, i, ViewPos-vec2(1001.0f, 801.0f), ViewPos+vec2(1001.0f, 801.0f));
+		int Num = 0;
+		for(int k = 0; k < NumCandidates; k++)
+			if(!m_SnapQuery.m_apEntities[k]->NetworkClipped(SnappingClient))
+				m_SnapQuery.m_apEntities[Num++] = m_SnapQuery.m_apEntities[k];
+
+		// snap them in list order so the snapshots stay the same
+		std::sort(m_SnapQuery.m_apEntities, m_SnapQuery.m_apEntities+Num, CompareInsertOrder);
+		for(int k = 0; k < Num; k++)
+			m_SnapQuery.m_apEntities[k]->Snap(SnappingClient);
+	}
 }
 
 void CGameWorld::Reset()
@@ -158,36 +334,54 @@ void CGameWorld::Tick()
 			GameServer()->SendChat(-1, CGameContext::CHAT_ALL, "Teams have been balanced");
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CProfileScope Scope(m_aProfileTick[i]);
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 				pEnt->Tick();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 
 		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CProfileScope Scope(m_aProfileTickDefered[i]);
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 				pEnt->TickDefered();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 	}
 
 	RemoveEntities();
+
+#ifdef CONF_DEBUG
+	// everything that moves has to go through SetPos or the grid misses it
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			dbg_assert(pEnt->m_GridCell == GridCell(pEnt->m_Pos), "entity moved without SetPos");
+			dbg_assert(pEnt->m_ProximityRadius <= m_aMaxProximityRadius[i], "proximity radius grew");
+		}
+#endif
 }
 
 
-// TODO: should be more general
-CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis)
+CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis, int Type)
 {
-	// Find other players
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
-	CCharacter *pClosest = 0;
+	CEntity *pClosest = 0;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	float Range = Radius+m_aMaxProximityRadius[Type]+1.0f;
+	vec2 Min = vec2(min(Pos0.x, Pos1.x)-Range, min(Pos0.y, Pos1.y)-Range);
+	vec2 Max = vec2(max(Pos0.x, Pos1.x)+Range, max(Pos0.y, Pos1.y)+Range);
+	int Num = QueryGrid(&m_Query, Type, Min, Max);
+	for(int i = 0; i < Num; i++)
  	{
+		CEntity *p = m_Query.m_apEntities[i];
 		if(p == pNotThis)
 			continue;
 
@@ -195,8 +389,9 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 		float Len = distance(p->m_Pos, IntersectPos);
 		if(Len < p->m_ProximityRadius+Radius)
 		{
+			// ties go to the one the type list has first
 			Len = distance(Pos0, IntersectPos);
-			if(Len < ClosestLen)
+			if(Len < ClosestLen || (pClosest && Len == ClosestLen && CompareInsertOrder(p, pClosest)))
 			{
 				NewPos = IntersectPos;
 				ClosestLen = Len;
@@ -208,6 +403,11 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 	return pClosest;
 }
 
+CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis)
+{
+	return (CCharacter *)IntersectEntity(Pos0, Pos1, Radius, NewPos, pNotThis, ENTTYPE_CHARACTER);
+}
+
 
 CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, CEntity *pNotThis)
 {
@@ -215,16 +415,18 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, CEntity *pNotTh
 	float ClosestRange = Radius*2;
 	CCharacter *pClosest = 0;
 
-	CCharacter *p = (CCharacter *)GameServer()->m_World.FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	float Range = Radius+m_aMaxProximityRadius[ENTTYPE_CHARACTER]+1.0f;
+	int Num = QueryGrid(&m_Query, ENTTYPE_CHARACTER, Pos-vec2(Range, Range), Pos+vec2(Range, Range));
+	for(int i = 0; i < Num; i++)
  	{
+		CCharacter *p = (CCharacter *)m_Query.m_apEntities[i];
 		if(p == pNotThis)
 			continue;
 
 		float Len = distance(Pos, p->m_Pos);
 		if(Len < p->m_ProximityRadius+Radius)
 		{
-			if(Len < ClosestRange)
+			if(Len < ClosestRange || (pClosest && Len == ClosestRange && CompareInsertOrder(p, pClosest)))
 			{
 				ClosestRange = Len;
 				pClosest = p;
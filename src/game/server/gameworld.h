@@ -24,7 +24,11 @@ public:
 		ENTTYPE_FLAG,
 		ENTTYPE_CHARACTER,
 		ENTTYPE_TRUNK,
-		NUM_ENTTYPES
+		ENTTYPE_NPC,
+		NUM_ENTTYPES,
+
+		// the entities are also sorted into a uniform grid of this many units
+		GRID_CELLSIZE = 256,
 	};
 
 private:
@@ -34,6 +38,37 @@ private:
 	CEntity *m_pNextTraverseEntity;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// one list per type and cell. entities outside of the map sit in the border cells
+	int m_GridWidth;
+	int m_GridHeight;
+	CEntity **m_apGridCells;
+	float m_aMaxProximityRadius[NUM_ENTTYPES];
+	int64 m_InsertOrder;
+
+	// scratch space for the grid queries, snapping has its own as
+	// the entities might query the world from their Snap
+	class CQueryBuffer
+	{
+	public:
+		CEntity **m_apEntities;
+		int m_Capacity;
+	};
+	CQueryBuffer m_Query;
+	CQueryBuffer m_SnapQuery;
+
+	int GridX(float x) const;
+	int GridY(float y) const;
+	int GridCell(vec2 Pos) const { return GridY(Pos.y)*m_GridWidth + GridX(Pos.x); }
+	void LinkCell(CEntity *pEnt, int Cell);
+	void UnlinkCell(CEntity *pEnt);
+	static bool CompareInsertOrder(const CEntity *pA, const CEntity *pB);
+	int QueryGrid(CQueryBuffer *pBuffer, int Type, vec2 Min, vec2 Max);
+
+	// profiler sections per type
+	int m_aProfileTick[NUM_ENTTYPES];
+	int m_aProfileTickDefered[NUM_ENTTYPES];
+	int m_aProfileSnap[NUM_ENTTYPES];
+
 	class CGameContext *m_pGameServer;
 	class IServer *m_pServer;
 
@@ -50,6 +85,27 @@ public:
 
 	void SetGameServer(CGameContext *pGameServer);
 
+	/*
+		Function: init_grid
+			Sizes the entity grid for a map, entities already in
+			the world are sorted in again.
+
+		Arguments:
+			width - Width of the map in units.
+			height - Height of the map in units.
+	*/
+	void InitGrid(int Width, int Height);
+
+	/*
+		Function: update_entity_cell
+			Moves an entity to the grid cell of its position. Called
+			by CEntity::SetPos.
+
+		Arguments:
+			entity - Entity that moved
+	*/
+	void UpdateEntityCell(CEntity *pEnt);
+
 	CEntity *FindFirst(int Type);
 
 	/*
@@ -69,6 +125,23 @@ public:
 	*/
 	int FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type);
 
+	/*
+		Function: intersect_entity
+			Finds the closest entity of a type that intersects the line.
+
+		Arguments:
+			pos0 - Start position
+			pos2 - End position
+			radius - How for from the line the entity is allowed to be.
+			new_pos - Intersection position
+			notthis - Entity to ignore intersecting with
+			type - Type of the entities to check.
+
+		Returns:
+			Returns a pointer to the closest hit or NULL of there is no intersection.
+	*/
+	CEntity *IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, CEntity *pNotThis, int Type);
+
 	/*
 		Function: interserct_CCharacter
 			Finds the closest CCharacter that intersects the line.
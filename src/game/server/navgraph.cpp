@@ -0,0 +1,430 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <algorithm>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/collision.h>
+
+#include "navgraph.h"
+
+CNavGraph::CNavGraph()
+{
+	m_pCollision = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_pCellFlags = 0;
+	m_pNodeOf = 0;
+	m_pNodes = 0;
+	m_NumNodes = 0;
+	m_NodeCapacity = 0;
+	m_pFreeNodes = 0;
+	m_NumFree = 0;
+	m_pDirty = 0;
+	m_NumDirty = 0;
+	m_DirtyCapacity = 0;
+	m_Revision = 0;
+	mem_zero(m_aSearches, sizeof(m_aSearches));
+}
+
+CNavGraph::~CNavGraph()
+{
+	Clear();
+}
+
+void CNavGraph::Clear()
+{
+	if(m_pCellFlags)
+		mem_free(m_pCellFlags);
+	if(m_pNodeOf)
+		mem_free(m_pNodeOf);
+	if(m_pNodes)
+	{
+		mem_free(m_pNodes);
+		mem_free(m_pFreeNodes);
+	}
+	if(m_pDirty)
+		mem_free(m_pDirty);
+	for(int i = 0; i < MAX_SEARCHES; i++)
+	{
+		CSearch *pSearch = &m_aSearches[i];
+		if(!pSearch->m_Capacity)
+			continue;
+		mem_free(pSearch->m_pSeen);
+		mem_free(pSearch->m_pClosed);
+		mem_free(pSearch->m_pCost);
+		mem_free(pSearch->m_pParent);
+		mem_free(pSearch->m_pHeap);
+	}
+	mem_zero(m_aSearches, sizeof(m_aSearches));
+
+	m_pCellFlags = 0;
+	m_pNodeOf = 0;
+	m_pNodes = 0;
+	m_NumNodes = 0;
+	m_NodeCapacity = 0;
+	m_pFreeNodes = 0;
+	m_NumFree = 0;
+	m_pDirty = 0;
+	m_NumDirty = 0;
+	m_DirtyCapacity = 0;
+	m_Width = 0;
+	m_Height = 0;
+}
+
+void CNavGraph::Init(CCollision *pCollision)
+{
+	Clear();
+	m_pCollision = pCollision;
+	m_Width = pCollision->GetWidth();
+	m_Height = pCollision->GetHeight();
+	m_Revision++;
+
+	int NumCells = m_Width*m_Height;
+	m_pCellFlags = (unsigned char *)mem_alloc(max(NumCells, 1), 1);
+	m_pNodeOf = (int *)mem_alloc(max(NumCells, 1)*sizeof(int), 1);
+	for(int y = 0; y < m_Height; y++)
+		for(int x = 0; x < m_Width; x++)
+		{
+			m_pCellFlags[y*m_Width+x] = ReadCellFlags(x, y);
+			m_pNodeOf[y*m_Width+x] = -1;
+		}
+
+	for(int y = 0; y < m_Height; y++)
+		for(int x = 0; x < m_Width; x++)
+			RebuildCell(x, y);
+}
+
+int CNavGraph::ReadCellFlags(int x, int y) const
+{
+	// the middle of the tile, half blocks count as solid and plants don't
+	float cx = x*32.0f+16.0f;
+	float cy = y*32.0f+16.0f;
+	int Flags = 0;
+	if(m_pCollision->CheckPoint(cx, cy))
+		Flags |= CELL_SOLID;
+	if(m_pCollision->GetCollisionAt(cx, cy)&CCollision::COLFLAG_DEATH)
+		Flags |= CELL_DEATH;
+	return Flags;
+}
+
+int CNavGraph::Heuristic(int From, int To) const
+{
+	int dx = absolute(From%m_Width - To%m_Width);
+	int dy = To/m_Width - From/m_Width;
+	return 10*dx + (dy < 0 ? -12*dy : 3*dy);
+}
+
+int CNavGraph::AllocNode(int Cell)
+{
+	int Node;
+	if(m_NumFree)
+		Node = m_pFreeNodes[--m_NumFree];
+	else
+	{
+		if(m_NumNodes == m_NodeCapacity)
+		{
+			int Capacity = max(1024, m_NodeCapacity*2);
+			CNode *pNodes = (CNode *)mem_alloc(Capacity*sizeof(CNode), 1);
+			int *pFreeNodes = (int *)mem_alloc(Capacity*sizeof(int), 1);
+			if(m_pNodes)
+			{
+				mem_copy(pNodes, m_pNodes, m_NumNodes*sizeof(CNode));
+				mem_copy(pFreeNodes, m_pFreeNodes, m_NumFree*sizeof(int));
+				mem_free(m_pNodes);
+				mem_free(m_pFreeNodes);
+			}
+			m_pNodes = pNodes;
+			m_pFreeNodes = pFreeNodes;
+			m_NodeCapacity = Capacity;
+		}
+		Node = m_NumNodes++;
+	}
+
+	m_pNodes[Node].m_Cell = Cell;
+	m_pNodes[Node].m_NumEdges = 0;
+	m_pNodeOf[Cell] = Node;
+	return Node;
+}
+
+void CNavGraph::FreeNode(int Cell)
+{
+	int Node = m_pNodeOf[Cell];
+	m_pNodes[Node].m_Cell = -1;
+	m_pNodes[Node].m_NumEdges = 0;
+	m_pFreeNodes[m_NumFree++] = Node;
+	m_pNodeOf[Cell] = -1;
+}
+
+void CNavGraph::AddEdge(CNode *pNode, int To, int Cost, int Type)
+{
+	dbg_assert(pNode->m_NumEdges < MAX_EDGES, "too many nav edges");
+	CEdge *pEdge = &pNode->m_aEdges[pNode->m_NumEdges++];
+	pEdge->m_To = To;
+	pEdge->m_Cost = Cost;
+	pEdge->m_Type = Type;
+}
+
+void CNavGraph::RebuildCell(int x, int y)
+{
+	if(x < 0 || x >= m_Width || y < 0 || y >= m_Height)
+		return;
+
+	int Cell = y*m_Width+x;
+	if(!Standable(x, y))
+	{
+		if(m_pNodeOf[Cell] >= 0)
+			FreeNode(Cell);
+		return;
+	}
+
+	// built aside, allocating the node might move the others
+	CNode Node;
+	Node.m_Cell = Cell;
+	Node.m_NumEdges = 0;
+
+	int Room = 0;
+	while(Room < JUMP_HEIGHT+1 && Free(x, y-1-Room))
+		Room++;
+
+	for(int s = -1; s <= 1; s += 2)
+	{
+		int nx = x+s;
+		if(Standable(nx, y))
+			AddEdge(&Node, y*m_Width+nx, 10, EDGE_WALK);
+		else if(Free(nx, y))
+		{
+			// step off and drop down to the next thing to stand on
+			int fy = y+1;
+			while(Free(nx, fy) && !Solid(nx, fy+1))
+				fy++;
+			if(Standable(nx, fy))
+				AddEdge(&Node, fy*m_Width+nx, 10+3*(fy-y), EDGE_FALL);
+		}
+
+		// a jump to the highest place per column that the tee gets over to
+		for(int d = 1; d <= JUMP_WIDTH && Room > 0; d++)
+		{
+			int tx = x+s*d;
+			for(int ty = y-min((int)JUMP_HEIGHT, Room-1); ty <= y+2; ty++)
+			{
+				if((d == 1 && ty >= y) || !Standable(tx, ty))
+					continue;
+
+				int Peak = min(ty, y)-1;
+				bool Clear = y-Peak <= Room;
+				for(int i = 1; Clear && i <= d; i++)
+					Clear = Free(x+s*i, Peak);
+				for(int i = Peak+1; Clear && i < ty; i++)
+					Clear = Free(tx, i);
+				if(!Clear)
+					continue;
+
+				AddEdge(&Node, ty*m_Width+tx, 10*d + (ty < y ? 12*(y-ty) : 3*(ty-y)) + 10, EDGE_JUMP);
+				break;
+			}
+		}
+	}
+
+	int Index = m_pNodeOf[Cell] >= 0 ? m_pNodeOf[Cell] : AllocNode(Cell);
+	m_pNodes[Index] = Node;
+}
+
+void CNavGraph::RebuildArea(int x, int y)
+{
+	// every cell with a walk or jump that looks at this tile
+	for(int cy = y-3; cy <= y+JUMP_HEIGHT+2; cy++)
+		for(int cx = x-JUMP_WIDTH-1; cx <= x+JUMP_WIDTH+1; cx++)
+			RebuildCell(cx, cy);
+
+	// and the ones that fall down this column
+	for(int cy = y-1; Free(x, cy); cy--)
+	{
+		RebuildCell(x-1, cy);
+		RebuildCell(x+1, cy);
+	}
+}
+
+void CNavGraph::OnTileChanged(int x, int y)
+{
+	if(!m_pCellFlags || x < 0 || x >= m_Width || y < 0 || y >= m_Height)
+		return;
+
+	int Flags = ReadCellFlags(x, y);
+	if(Flags == m_pCellFlags[y*m_Width+x])
+		return;
+	m_pCellFlags[y*m_Width+x] = Flags;
+	Invalidate(x, y);
+}
+
+void CNavGraph::Invalidate(int x, int y)
+{
+	if(m_NumDirty == m_DirtyCapacity)
+	{
+		int Capacity = max(64, m_DirtyCapacity*2);
+		int *pDirty = (int *)mem_alloc(Capacity*sizeof(int), 1);
+		if(m_pDirty)
+		{
+			mem_copy(pDirty, m_pDirty, m_NumDirty*sizeof(int));
+			mem_free(m_pDirty);
+		}
+		m_pDirty = pDirty;
+		m_DirtyCapacity = Capacity;
+	}
+	m_pDirty[m_NumDirty++] = y*m_Width+x;
+}
+
+void CNavGraph::Update()
+{
+	if(!m_NumDirty)
+		return;
+
+	for(int i = 0; i < m_NumDirty; i++)
+		RebuildArea(m_pDirty[i]%m_Width, m_pDirty[i]/m_Width);
+	m_NumDirty = 0;
+	m_Revision++;
+}
+
+int CNavGraph::StandingCell(vec2 Pos, int Depth) const
+{
+	if(Pos.x < 0 || Pos.y < 0)
+		return -1;
+	int x = (int)(Pos.x/32.0f);
+	int y = (int)(Pos.y/32.0f);
+	if(x >= m_Width)
+		return -1;
+
+	for(int i = 0; i <= Depth && y+i < m_Height; i++)
+	{
+		int Cell = (y+i)*m_Width+x;
+		if(m_pNodeOf[Cell] >= 0)
+			return Cell;
+		if(m_pCellFlags[Cell])
+			break;
+	}
+	return -1;
+}
+
+const CNavGraph::CEdge *CNavGraph::FindEdge(int From, int To) const
+{
+	if(!IsStanding(From))
+		return 0;
+
+	const CNode *pNode = &m_pNodes[m_pNodeOf[From]];
+	for(int i = 0; i < pNode->m_NumEdges; i++)
+		if(pNode->m_aEdges[i].m_To == To)
+			return &pNode->m_aEdges[i];
+	return 0;
+}
+
+void CNavGraph::PrepareSearches(int Num)
+{
+	for(int i = 0; i < Num && i < MAX_SEARCHES; i++)
+	{
+		CSearch *pSearch = &m_aSearches[i];
+		if(pSearch->m_Capacity >= m_NodeCapacity)
+			continue;
+
+		// the stamps can start over, nothing searches while the graph changes
+		if(pSearch->m_Capacity)
+		{
+			mem_free(pSearch->m_pSeen);
+			mem_free(pSearch->m_pClosed);
+			mem_free(pSearch->m_pCost);
+			mem_free(pSearch->m_pParent);
+		}
+		else
+			pSearch->m_pHeap = (CHeapItem *)mem_alloc((MAX_EXPANSIONS*MAX_EDGES+1)*sizeof(CHeapItem), 1);
+		pSearch->m_pSeen = (int *)mem_alloc(m_NodeCapacity*sizeof(int), 1);
+		pSearch->m_pClosed = (int *)mem_alloc(m_NodeCapacity*sizeof(int), 1);
+		pSearch->m_pCost = (int *)mem_alloc(m_NodeCapacity*sizeof(int), 1);
+		pSearch->m_pParent = (int *)mem_alloc(m_NodeCapacity*sizeof(int), 1);
+		mem_zero(pSearch->m_pSeen, m_NodeCapacity*sizeof(int));
+		mem_zero(pSearch->m_pClosed, m_NodeCapacity*sizeof(int));
+		pSearch->m_Capacity = m_NodeCapacity;
+		pSearch->m_Stamp = 0;
+	}
+}
+
+int CNavGraph::FindPath(int From, int To, int *pPath, int MaxLength, int Search)
+{
+	if(From == To || !IsStanding(From) || !IsStanding(To))
+		return 0;
+
+	CSearch *pSearch = &m_aSearches[Search];
+	dbg_assert(pSearch->m_Capacity >= m_NumNodes, "nav search used before PrepareSearches");
+	int *pSeen = pSearch->m_pSeen;
+	int *pClosed = pSearch->m_pClosed;
+	int *pCost = pSearch->m_pCost;
+	int *pParent = pSearch->m_pParent;
+	CHeapItem *pHeap = pSearch->m_pHeap;
+	int Stamp = ++pSearch->m_Stamp;
+
+	int Start = m_pNodeOf[From];
+	int Goal = m_pNodeOf[To];
+	pSeen[Start] = Stamp;
+	pCost[Start] = 0;
+	pParent[Start] = -1;
+
+	int NumHeap = 0;
+	pHeap[NumHeap].m_Score = Heuristic(From, To);
+	pHeap[NumHeap++].m_Node = Start;
+
+	int Best = Start;
+	int BestScore = Heuristic(From, To);
+	int Expansions = 0;
+	while(NumHeap && Expansions < MAX_EXPANSIONS)
+	{
+		std::pop_heap(pHeap, pHeap+NumHeap);
+		int Node = pHeap[--NumHeap].m_Node;
+		if(pClosed[Node] == Stamp)
+			continue;
+		pClosed[Node] = Stamp;
+		Expansions++;
+
+		if(Node == Goal)
+		{
+			Best = Node;
+			break;
+		}
+		int Score = Heuristic(m_pNodes[Node].m_Cell, To);
+		if(Score < BestScore)
+		{
+			BestScore = Score;
+			Best = Node;
+		}
+
+		const CNode *pNode = &m_pNodes[Node];
+		for(int i = 0; i < pNode->m_NumEdges; i++)
+		{
+			const CEdge *pEdge = &pNode->m_aEdges[i];
+			int Next = m_pNodeOf[pEdge->m_To];
+			if(Next < 0 || pClosed[Next] == Stamp)
+				continue;
+
+			int Cost = pCost[Node]+pEdge->m_Cost;
+			if(pSeen[Next] == Stamp && pCost[Next] <= Cost)
+				continue;
+			pSeen[Next] = Stamp;
+			pCost[Next] = Cost;
+			pParent[Next] = Node;
+
+			pHeap[NumHeap].m_Score = Cost+Heuristic(pEdge->m_To, To);
+			pHeap[NumHeap++].m_Node = Next;
+			std::push_heap(pHeap, pHeap+NumHeap);
+		}
+	}
+
+	// walk back from the end, only the first MaxLength cells are kept
+	int Length = 0;
+	for(int Node = Best; Node != Start; Node = pParent[Node])
+		Length++;
+	int i = Length;
+	for(int Node = Best; Node != Start; Node = pParent[Node])
+	{
+		i--;
+		if(i < MaxLength)
+			pPath[i] = m_pNodes[Node].m_Cell;
+	}
+	return min(Length, MaxLength);
+}
@@ -0,0 +1,154 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_NAVGRAPH_H
+#define GAME_SERVER_NAVGRAPH_H
+
+#include <base/vmath.h>
+
+/*
+	Class: Navigation graph
+		The tiles a tee can stand on and how to get from one to the
+		next by walking, jumping or falling. Built from the collision
+		at map load, the tile changes only patch the area around them.
+*/
+class CNavGraph
+{
+public:
+	enum
+	{
+		EDGE_WALK=0,
+		EDGE_JUMP,
+		EDGE_FALL,
+
+		// in tiles, a ground jump gets about five high
+		JUMP_HEIGHT=4,
+		JUMP_WIDTH=4,
+
+		// walk and fall to both sides and a jump per column
+		MAX_EDGES=4+2*JUMP_WIDTH,
+
+		// searches give up here and return the way to the closest node they saw
+		MAX_EXPANSIONS=4096,
+
+		// searches that can run at the same time, one per thread
+		MAX_SEARCHES=17,
+	};
+
+	struct CEdge
+	{
+		int m_To; // cell
+		unsigned short m_Cost;
+		unsigned char m_Type;
+	};
+
+	CNavGraph();
+	~CNavGraph();
+
+	void Init(class CCollision *pCollision);
+	void Clear();
+
+	// queues the area around the tile if its collision changed, Update applies it
+	void OnTileChanged(int x, int y);
+	void Invalidate(int x, int y);
+	void Update();
+
+	// makes the first Num searches ready for the current graph, call it after Update
+	void PrepareSearches(int Num);
+
+	/*
+		Function: FindPath
+			A* from one standing cell to another. Only reads the graph,
+			different searches can run on different threads.
+
+		Arguments:
+			From - Cell to start at.
+			To - Cell to go to.
+			pPath - Gets the cells to go through, without From.
+			MaxLength - Size of pPath, longer paths get cut.
+			Search - Which of the prepared searches to use.
+
+		Returns:
+			The number of cells written, 0 if there is no way to get
+			closer. A path that can't reach To leads to the node the
+			search found closest to it.
+	*/
+	int FindPath(int From, int To, int *pPath, int MaxLength, int Search=0);
+
+	// the standing cell at the position or up to Depth tiles below it, -1 if none
+	int StandingCell(vec2 Pos, int Depth) const;
+	const CEdge *FindEdge(int From, int To) const;
+	bool IsStanding(int Cell) const { return Cell >= 0 && Cell < m_Width*m_Height && m_pNodeOf[Cell] >= 0; }
+	vec2 CellCenter(int Cell) const { return vec2((Cell%m_Width)*32.0f+16.0f, (Cell/m_Width)*32.0f+16.0f); }
+
+	int Width() const { return m_Width; }
+	int Height() const { return m_Height; }
+	int NumNodes() const { return m_NumNodes-m_NumFree; }
+	int NumNodeSlots() const { return m_NumNodes; }
+	int NodeCell(int Node) const { return m_pNodes[Node].m_Cell; }
+	int Revision() const { return m_Revision; }
+
+private:
+	enum
+	{
+		CELL_SOLID=1,
+		CELL_DEATH=2,
+	};
+
+	struct CNode
+	{
+		int m_Cell; // -1 when free
+		int m_NumEdges;
+		CEdge m_aEdges[MAX_EDGES];
+	};
+
+	struct CHeapItem
+	{
+		int m_Score;
+		int m_Node;
+		bool operator<(const CHeapItem &Other) const { return m_Score > Other.m_Score; }
+	};
+
+	class CCollision *m_pCollision;
+	int m_Width;
+	int m_Height;
+	unsigned char *m_pCellFlags;
+	int *m_pNodeOf;
+
+	CNode *m_pNodes;
+	int m_NumNodes;
+	int m_NodeCapacity;
+	int *m_pFreeNodes;
+	int m_NumFree;
+
+	int *m_pDirty;
+	int m_NumDirty;
+	int m_DirtyCapacity;
+	int m_Revision;
+
+	// search state, one per node slot
+	struct CSearch
+	{
+		int *m_pSeen;
+		int *m_pClosed;
+		int *m_pCost;
+		int *m_pParent;
+		CHeapItem *m_pHeap;
+		int m_Capacity;
+		int m_Stamp;
+	};
+	CSearch m_aSearches[MAX_SEARCHES];
+
+	int ReadCellFlags(int x, int y) const;
+	bool Solid(int x, int y) const { return x >= 0 && x < m_Width && y >= 0 && y < m_Height && (m_pCellFlags[y*m_Width+x]&CELL_SOLID); }
+	bool Free(int x, int y) const { return x >= 0 && x < m_Width && y >= 0 && y < m_Height && !m_pCellFlags[y*m_Width+x]; }
+	bool Standable(int x, int y) const { return Free(x, y) && Solid(x, y+1); }
+	int Heuristic(int From, int To) const;
+
+	int AllocNode(int Cell);
+	void FreeNode(int Cell);
+	void AddEdge(CNode *pNode, int To, int Cost, int Type);
+	void RebuildCell(int x, int y);
+	void RebuildArea(int x, int y);
+};
+
+#endif
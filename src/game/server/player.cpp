@@ -24,6 +24,8 @@ CPlayer::CPlayer(CGameContext *pGameServer, int ClientID, int Team)
 
 	m_MineTeeTeam = 0; //H-Client
     m_MineTeeSync = false; //H-Client
+    m_MineTeeSyncSize = 0; //H-Client
+    m_MineTeeSyncTick = 0; //H-Client
 }
 
 CPlayer::~CPlayer()
@@ -35,7 +37,7 @@ CPlayer::~CPlayer()
 void CPlayer::Tick()
 {
 #ifdef CONF_DEBUG
-	if(!g_Config.m_DbgDummies || m_ClientID < MAX_CLIENTS-g_Config.m_DbgDummies)
+	if(!g_Config.m_DbgDummies || m_ClientID < Server()->MaxClients()-g_Config.m_DbgDummies)
 #endif
 	if(!Server()->ClientIngame(m_ClientID))
 		return;
@@ -88,7 +90,7 @@ void CPlayer::PostTick()
 	// update latency value
 	if(m_PlayerFlags&PLAYERFLAG_SCOREBOARD)
 	{
-		for(int i = 0; i < MAX_CLIENTS-MAX_BOTS; ++i)
+		for(int i = 0; i < Server()->MaxClients(); ++i)
 		{
 			if(GameServer()->m_apPlayers[i] && GameServer()->m_apPlayers[i]->GetTeam() != TEAM_SPECTATORS)
 				m_aActLatency[i] = GameServer()->m_apPlayers[i]->m_Latency.m_Min;
@@ -103,12 +105,12 @@ void CPlayer::PostTick()
 void CPlayer::Snap(int SnappingClient)
 {
 #ifdef CONF_DEBUG
-	if(!g_Config.m_DbgDummies || m_ClientID < MAX_CLIENTS-g_Config.m_DbgDummies)
+	if(!g_Config.m_DbgDummies || m_ClientID < Server()->MaxClients()-g_Config.m_DbgDummies)
 #endif
 	if(!Server()->ClientIngame(m_ClientID))
 		return;
 
-	CNetObj_ClientInfo *pClientInfo = static_cast<CNetObj_ClientInfo *>(Server()->SnapNewItem(NETOBJTYPE_CLIENTINFO, m_ClientID, sizeof(CNetObj_ClientInfo)));
+	CNetObj_ClientInfo *pClientInfo = static_cast<CNetObj_ClientInfo *>(GameServer()->SnapNewItem(NETOBJTYPE_CLIENTINFO, m_ClientID, sizeof(CNetObj_ClientInfo)));
 	if(!pClientInfo)
 		return;
 
@@ -120,7 +122,7 @@ void CPlayer::Snap(int SnappingClient)
 	pClientInfo->m_ColorBody = m_TeeInfos.m_ColorBody;
 	pClientInfo->m_ColorFeet = m_TeeInfos.m_ColorFeet;
 
-	CNetObj_PlayerInfo *pPlayerInfo = static_cast<CNetObj_PlayerInfo *>(Server()->SnapNewItem(NETOBJTYPE_PLAYERINFO, m_ClientID, sizeof(CNetObj_PlayerInfo)));
+	CNetObj_PlayerInfo *pPlayerInfo = static_cast<CNetObj_PlayerInfo *>(GameServer()->SnapNewItem(NETOBJTYPE_PLAYERINFO, m_ClientID, sizeof(CNetObj_PlayerInfo)));
 	if(!pPlayerInfo)
 		return;
 
@@ -131,18 +133,34 @@ void CPlayer::Snap(int SnappingClient)
 	pPlayerInfo->m_Team = m_Team;
 
 	if(m_ClientID == SnappingClient)
+	{
 		pPlayerInfo->m_Local = 1;
+		Server()->SnapSetLocal(&pPlayerInfo->m_Local);
+	}
+}
 
-	if(m_ClientID == SnappingClient && m_Team == TEAM_SPECTATORS)
-	{
-		CNetObj_SpectatorInfo *pSpectatorInfo = static_cast<CNetObj_SpectatorInfo *>(Server()->SnapNewItem(NETOBJTYPE_SPECTATORINFO, m_ClientID, sizeof(CNetObj_SpectatorInfo)));
-		if(!pSpectatorInfo)
-			return;
+void CPlayer::SnapPersonal()
+{
+	SnapSpectatorInfo();
 
-		pSpectatorInfo->m_SpectatorID = m_SpectatorID;
-		pSpectatorInfo->m_X = m_ViewPos.x;
-		pSpectatorInfo->m_Y = m_ViewPos.y;
-	}
+	CCharacter *pChr = GetCharacter();
+	if(pChr && !pChr->NetworkClipped(m_ClientID))
+		pChr->SnapInventory();
+}
+
+void CPlayer::SnapSpectatorInfo()
+{
+	if(m_Team != TEAM_SPECTATORS)
+		return;
+
+	// only the own one is sent, the same id for everyone lets spectators share their snapshots
+	CNetObj_SpectatorInfo *pSpectatorInfo = static_cast<CNetObj_SpectatorInfo *>(Server()->SnapNewItem(NETOBJTYPE_SPECTATORINFO, 0, sizeof(CNetObj_SpectatorInfo)));
+	if(!pSpectatorInfo)
+		return;
+
+	pSpectatorInfo->m_SpectatorID = m_SpectatorID;
+	pSpectatorInfo->m_X = m_ViewPos.x;
+	pSpectatorInfo->m_Y = m_ViewPos.y;
 }
 
 void CPlayer::OnDisconnect(const char *pReason)
@@ -268,28 +286,6 @@ void CPlayer::TryRespawn()
 {
 	vec2 SpawnPos;
 
-    if (str_find_nocase(GameServer()->GameType(),"minetee") && m_Team > TEAM_BLUE)
-    {
-        int Time = -1;
-        Time = (Server()->Tick()-GameServer()->m_pController->GetRoundStartTick()) / (float)Server()->TickSpeed();
-        bool MineTeeIsDay = (static_cast<int>(Time/300)%2)?false:true;
-        if (300 < 0)
-            MineTeeIsDay = true;
-
-        if (!MineTeeIsDay)
-        {
-            int Teams[2] = { TEAM_ANIMAL_TEECOW, TEAM_ANIMAL_TEEPIG };
-            m_Team = Teams[rand()%2];
-        }
-        else
-        {
-            int Teams[3] = { TEAM_ENEMY_TEEPER, TEAM_ENEMY_ZOMBITEE, TEAM_ENEMY_SKELETEE };
-            m_Team = Teams[rand()%3];
-        }
-
-        GameServer()->UpdateBotInfo(m_ClientID, m_Team);
-    }
-
 	if(!GameServer()->m_pController->CanSpawn(m_Team, &SpawnPos))
 		return;
 
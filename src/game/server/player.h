@@ -27,6 +27,8 @@ public:
 	void Tick();
 	void PostTick();
 	void Snap(int SnappingClient);
+	void SnapPersonal();
+	void SnapSpectatorInfo();
 
 	void OnDirectInput(CNetObj_PlayerInput *NewInput);
 	void OnPredictedInput(CNetObj_PlayerInput *NewInput);
@@ -51,6 +53,8 @@ public:
 	bool m_IsReady;
 
 	bool m_MineTeeSync; //H-Client
+	int m_MineTeeSyncSize; //H-Client: tile diffs the client downloads
+	int m_MineTeeSyncTick; //H-Client: last tile request of the download
 
 	//
 	int m_Vote;
@@ -0,0 +1,126 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/shared/config.h>
+#include <game/generated/protocol.h>
+
+#include "snapmaster.h"
+#include "gamecontext.h"
+
+//////////////////////////////////////////////////
+// Snapshot master
+//////////////////////////////////////////////////
+CSnapMaster::CSnapMaster()
+{
+	m_pGameServer = 0;
+	Clear();
+}
+
+void CSnapMaster::SetGameServer(CGameContext *pGameServer)
+{
+	m_pGameServer = pGameServer;
+}
+
+void CSnapMaster::Clear()
+{
+	m_NumItems = 0;
+	m_DataSize = 0;
+	m_Building = false;
+	m_Ready = false;
+}
+
+void CSnapMaster::Begin()
+{
+	Clear();
+	m_Building = true;
+}
+
+void CSnapMaster::End()
+{
+	m_Building = false;
+	m_Ready = true;
+}
+
+void *CSnapMaster::NewItem(int Type, int ID, int Size, int Clip, vec2 Pos, const CClientMask &Mask)
+{
+	if(m_DataSize + Size > MAX_DATASIZE || m_NumItems >= MAX_ITEMS)
+	{
+		dbg_assert(m_DataSize < MAX_DATASIZE, "too much data");
+		dbg_assert(m_NumItems < MAX_ITEMS, "too many items");
+		return 0;
+	}
+
+	CItem *pItem = &m_aItems[m_NumItems++];
+	pItem->m_Type = Type;
+	pItem->m_ID = ID;
+	pItem->m_Size = Size;
+	pItem->m_Offset = m_DataSize;
+	pItem->m_Clip = Clip;
+	pItem->m_Mask = Mask;
+	pItem->m_Pos = Pos;
+
+	void *pData = (char *)m_aData + m_DataSize;
+	mem_zero(pData, Size);
+	m_DataSize += (Size+3)&~3;
+	return pData;
+}
+
+bool CSnapMaster::Clipped(const CItem *pItem, int SnappingClient) const
+{
+	if(SnappingClient == -1 || pItem->m_Clip == CLIP_NONE)
+		return false;
+
+	vec2 ViewPos = GameServer()->m_apPlayers[SnappingClient]->m_ViewPos;
+	if(pItem->m_Clip == CLIP_EVENT)
+		return !CmaskIsSet(pItem->m_Mask, SnappingClient) || distance(ViewPos, pItem->m_Pos) >= 1500.0f;
+
+	float dx = ViewPos.x-pItem->m_Pos.x;
+	float dy = ViewPos.y-pItem->m_Pos.y;
+	if(absolute(dx) > 1000.0f || absolute(dy) > 800.0f)
+		return true;
+	return distance(ViewPos, pItem->m_Pos) > 1100.0f;
+}
+
+void CSnapMaster::Patch(const CItem *pItem, void *pData, int SnappingClient) const
+{
+	// the master holds what a demo would see, strip it down to what this client may know
+	CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
+	if(pItem->m_Type == NETOBJTYPE_CHARACTER)
+	{
+		if(pItem->m_ID != SnappingClient && (g_Config.m_SvStrictSpectateMode || pItem->m_ID != pPlayer->m_SpectatorID))
+		{
+			CNetObj_Character *pCharacter = (CNetObj_Character *)pData;
+			pCharacter->m_Health = 0;
+			pCharacter->m_Armor = 0;
+			pCharacter->m_AmmoCount = 0;
+		}
+	}
+	else if(pItem->m_Type == NETOBJTYPE_PLAYERINFO)
+	{
+		CNetObj_PlayerInfo *pPlayerInfo = (CNetObj_PlayerInfo *)pData;
+		pPlayerInfo->m_Latency = pPlayer->m_aActLatency[pItem->m_ID];
+		pPlayerInfo->m_Local = pItem->m_ID == SnappingClient ? 1 : 0;
+		if(pPlayerInfo->m_Local)
+			GameServer()->Server()->SnapSetLocal(&pPlayerInfo->m_Local);
+	}
+}
+
+void CSnapMaster::Snap(int SnappingClient)
+{
+	if(SnappingClient != -1 && !GameServer()->m_apPlayers[SnappingClient])
+		return;
+
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		const CItem *pItem = &m_aItems[i];
+		if(Clipped(pItem, SnappingClient))
+			continue;
+
+		void *pData = GameServer()->Server()->SnapNewItem(pItem->m_Type, pItem->m_ID, pItem->m_Size);
+		if(!pData)
+			return;
+
+		mem_copy(pData, (char *)m_aData + pItem->m_Offset, pItem->m_Size);
+		if(SnappingClient != -1)
+			Patch(pItem, pData, SnappingClient);
+	}
+}
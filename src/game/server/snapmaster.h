@@ -0,0 +1,71 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_SNAPMASTER_H
+#define GAME_SERVER_SNAPMASTER_H
+
+#include <base/vmath.h>
+
+#include "clientmask.h"
+
+/*
+	Class: Snapshot master
+		Holds all snap items of a tick together with the information
+		needed to clip them for a client. The world is serialized once
+		into it and every client snapshot is copied out of it.
+*/
+class CSnapMaster
+{
+public:
+	enum
+	{
+		// the whole map, a client only gets what is near it
+		MAX_ITEMS=4096,
+		MAX_DATASIZE=256*1024,
+
+		CLIP_NONE=0, // always visible
+		CLIP_VIEW, // same rule as CEntity::NetworkClipped
+		CLIP_EVENT, // client mask and event range
+	};
+
+private:
+	struct CItem
+	{
+		int m_Type;
+		int m_ID;
+		int m_Size;
+		int m_Offset;
+		int m_Clip;
+		CClientMask m_Mask;
+		vec2 m_Pos;
+	};
+
+	CItem m_aItems[MAX_ITEMS];
+	int m_aData[MAX_DATASIZE/sizeof(int)];
+	int m_NumItems;
+	int m_DataSize;
+	bool m_Building;
+	bool m_Ready;
+
+	class CGameContext *m_pGameServer;
+
+	bool Clipped(const CItem *pItem, int SnappingClient) const;
+	void Patch(const CItem *pItem, void *pData, int SnappingClient) const;
+
+public:
+	CGameContext *GameServer() const { return m_pGameServer; }
+	void SetGameServer(CGameContext *pGameServer);
+
+	CSnapMaster();
+	void Clear();
+	void Begin();
+	void End();
+
+	bool Building() const { return m_Building; }
+	bool Ready() const { return m_Ready; }
+	int NumItems() const { return m_NumItems; }
+
+	void *NewItem(int Type, int ID, int Size, int Clip, vec2 Pos, const CClientMask &Mask);
+	void Snap(int SnappingClient);
+};
+
+#endif
@@ -0,0 +1,487 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <algorithm>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/generated/protocol.h>
+
+#include "worldsim.h"
+
+static bool IsWater(int Index) { return Index >= BLOCK_UNDEF82 && Index <= BLOCK_AGUA; }
+static bool IsLava(int Index) { return Index >= BLOCK_UNDEF104 && Index <= BLOCK_LAVA; }
+static bool IsFluid(int Index) { return IsWater(Index) || IsLava(Index); }
+static bool IsSand(int Index) { return Index == BLOCK_ARENA || Index == BLOCK_ARENAB; }
+
+CWorldSim::CWorldSim()
+{
+	m_pTiles = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_pQueued = 0;
+	for(int i = 0; i < NUM_STEPS; i++)
+	{
+		m_apQueue[i] = 0;
+		m_aNumQueued[i] = 0;
+		m_aQueueCapacity[i] = 0;
+	}
+	m_pProcess = 0;
+	m_ProcessCapacity = 0;
+	m_pChanges = 0;
+	m_NumChanges = 0;
+	m_ChangeCapacity = 0;
+}
+
+CWorldSim::~CWorldSim()
+{
+	Clear();
+}
+
+void CWorldSim::Clear()
+{
+	if(m_pQueued)
+		mem_free(m_pQueued);
+	for(int i = 0; i < NUM_STEPS; i++)
+	{
+		if(m_apQueue[i])
+			mem_free(m_apQueue[i]);
+		m_apQueue[i] = 0;
+		m_aNumQueued[i] = 0;
+		m_aQueueCapacity[i] = 0;
+	}
+	if(m_pProcess)
+		mem_free(m_pProcess);
+	if(m_pChanges)
+		mem_free(m_pChanges);
+
+	m_pTiles = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_pQueued = 0;
+	m_pProcess = 0;
+	m_ProcessCapacity = 0;
+	m_pChanges = 0;
+	m_NumChanges = 0;
+	m_ChangeCapacity = 0;
+}
+
+void CWorldSim::Init(CTile *pTiles, int Width, int Height)
+{
+	Clear();
+	m_pTiles = pTiles;
+	m_Width = Width;
+	m_Height = Height;
+	m_pQueued = (unsigned char *)mem_alloc(max(Width*Height, 1), 1);
+	mem_zero(m_pQueued, max(Width*Height, 1));
+	QueueAll();
+}
+
+int CWorldSim::StepsOf(int Index)
+{
+	int Steps = 0;
+	if(IsFluid(Index) || IsSand(Index) || Index == BLOCK_ROSAR || Index == BLOCK_ROSAY || Index == BLOCK_BED || Index == BLOCK_INVENTARY ||
+		Index == BLOCK_GROUND || Index == BLOCK_GRASSGROUND || Index == BLOCK_HORNO_OFF || Index == BLOCK_NIEVE || Index == BLOCK_CARBONP)
+		Steps |= STEP_ENVIRONMENT;
+	if(Index == BLOCK_AZUCAR || Index == BLOCK_CACTUS || Index == BLOCK_LUZ || (Index >= BLOCK_SEED1 && Index <= BLOCK_SEED8) ||
+		Index == BLOCK_UNDEF48 || Index == BLOCK_UNDEF49 || Index == BLOCK_INVTA || Index == BLOCK_INVTB ||
+		Index == BLOCK_UNDEF84 || Index == BLOCK_UNDEF106 || Index == BLOCK_ROSAR || Index == BLOCK_ROSAY)
+		Steps |= STEP_DESTRUCTION;
+	if(Index == BLOCK_AZUCAR || Index == BLOCK_CACTUS || (Index >= BLOCK_SEED1 && Index < BLOCK_SEED8) || IsSand(Index) || Index == BLOCK_APGRASS)
+		Steps |= STEP_VEGETAL;
+	if(Index == BLOCK_HORNO_ON)
+		Steps |= STEP_COOK;
+	if(Index == BLOCK_HORNO_ON || Index == BLOCK_STONE2 || Index == BLOCK_STONE2BREAK)
+		Steps |= STEP_WEAR;
+	return Steps;
+}
+
+void CWorldSim::Queue(int x, int y)
+{
+	// the border stays like it is, the rules look one tile around
+	if(x < 1 || x >= m_Width-1 || y < 1 || y >= m_Height-1)
+		return;
+
+	int Cell = y*m_Width+x;
+	int Steps = StepsOf(m_pTiles[Cell].m_Index) & ~m_pQueued[Cell];
+	if(!Steps)
+		return;
+	m_pQueued[Cell] |= Steps;
+
+	for(int s = 0; s < NUM_STEPS; s++)
+	{
+		if(!(Steps&(1<<s)))
+			continue;
+		if(m_aNumQueued[s] == m_aQueueCapacity[s])
+		{
+			int Capacity = max(1024, m_aQueueCapacity[s]*2);
+			int *pQueue = (int *)mem_alloc(Capacity*sizeof(int), 1);
+			if(m_apQueue[s])
+			{
+				mem_copy(pQueue, m_apQueue[s], m_aNumQueued[s]*sizeof(int));
+				mem_free(m_apQueue[s]);
+			}
+			m_apQueue[s] = pQueue;
+			m_aQueueCapacity[s] = Capacity;
+		}
+		m_apQueue[s][m_aNumQueued[s]++] = Cell;
+	}
+}
+
+void CWorldSim::QueueAll()
+{
+	for(int y = 1; y < m_Height-1; y++)
+		for(int x = 1; x < m_Width-1; x++)
+			Queue(x, y);
+}
+
+void CWorldSim::OnTileChanged(int x, int y)
+{
+	if(!m_pQueued || x < 0 || x >= m_Width || y < 0 || y >= m_Height)
+		return;
+
+	for(int dy = -1; dy <= 1; dy++)
+		for(int dx = -1; dx <= 1; dx++)
+			Queue(x+dx, y+dy);
+
+	// the ground turns to grass when nothing is above it, all the way up
+	int fy = y+1;
+	while(fy < m_Height && (At(x, fy) == 0 || (At(x, fy) >= BLOCK_SEED2 && At(x, fy) <= BLOCK_SEED8)))
+		fy++;
+	Queue(x, fy);
+}
+
+int CWorldSim::NumQueued(int Step) const
+{
+	for(int s = 0; s < NUM_STEPS; s++)
+		if(Step == 1<<s)
+			return m_aNumQueued[s];
+	return 0;
+}
+
+void CWorldSim::AddChange(int x, int y, int Act, int Index, int Col, int Drop)
+{
+	if(m_NumChanges == m_ChangeCapacity)
+	{
+		int Capacity = max(256, m_ChangeCapacity*2);
+		CChange *pChanges = (CChange *)mem_alloc(Capacity*sizeof(CChange), 1);
+		if(m_pChanges)
+		{
+			mem_copy(pChanges, m_pChanges, m_NumChanges*sizeof(CChange));
+			mem_free(m_pChanges);
+		}
+		m_pChanges = pChanges;
+		m_ChangeCapacity = Capacity;
+	}
+
+	CChange *pChange = &m_pChanges[m_NumChanges++];
+	pChange->m_X = x;
+	pChange->m_Y = y;
+	pChange->m_Act = Act;
+	pChange->m_Index = Index;
+	pChange->m_Col = Col;
+	pChange->m_Drop = Drop;
+}
+
+void CWorldSim::Create(int x, int y, int Index, int Col)
+{
+	AddChange(x, y, TILE_CREATE, Index, Col, -1);
+}
+
+void CWorldSim::Destroy(int x, int y, int Drop)
+{
+	AddChange(x, y, TILE_DESTROY, -1, 1, Drop);
+}
+
+int CWorldSim::Run(int Steps)
+{
+	m_NumChanges = 0;
+	if(!m_pQueued)
+		return 0;
+
+	for(int s = 0; s < NUM_STEPS; s++)
+	{
+		int Step = 1<<s;
+		int Num = m_aNumQueued[s];
+		if(!(Steps&Step) || !Num)
+			continue;
+
+		// taken out first, the cells that stay get queued again
+		if(Num > m_ProcessCapacity)
+		{
+			if(m_pProcess)
+				mem_free(m_pProcess);
+			m_ProcessCapacity = max(Num, m_ProcessCapacity*2);
+			m_pProcess = (int *)mem_alloc(m_ProcessCapacity*sizeof(int), 1);
+		}
+		mem_copy(m_pProcess, m_apQueue[s], Num*sizeof(int));
+		m_aNumQueued[s] = 0;
+		for(int i = 0; i < Num; i++)
+			m_pQueued[m_pProcess[i]] &= ~Step;
+
+		// in map order like a full scan would go
+		std::sort(m_pProcess, m_pProcess+Num);
+		for(int i = 0; i < Num; i++)
+		{
+			int x = m_pProcess[i]%m_Width;
+			int y = m_pProcess[i]/m_Width;
+			if((StepsOf(At(x, y))&Step) && Evaluate(x, y, Step))
+				Queue(x, y);
+		}
+	}
+	return m_NumChanges;
+}
+
+bool CWorldSim::Evaluate(int x, int y, int Step)
+{
+	switch(Step)
+	{
+	case STEP_ENVIRONMENT: return Environment(x, y);
+	case STEP_DESTRUCTION: return Destruction(x, y);
+	case STEP_VEGETAL: return Vegetal(x, y);
+	case STEP_COOK: return Cook(x, y);
+	case STEP_WEAR: return Wear(x, y);
+	}
+	return false;
+}
+
+bool CWorldSim::Environment(int x, int y)
+{
+	int Index = At(x, y);
+	int Below = At(x, y+1);
+
+	if(IsFluid(Index))
+	{
+		// falls down and turns to stone on the other fluid
+		if(Below == 0 || (Below >= BLOCK_UNDEF82 && Below < BLOCK_UNDEF84) || (Below >= BLOCK_UNDEF104 && Below < BLOCK_UNDEF106))
+			Create(x, y+1, IsWater(Index) ? BLOCK_UNDEF84 : BLOCK_UNDEF106, 0);
+		else if((IsLava(Index) && IsWater(Below)) || (IsWater(Index) && IsLava(Below)))
+			Create(x, y+1, BLOCK_RUDINIUM, 1);
+
+		// and spreads to the sides on the ground, a level less each tile
+		bool Spreads = Index != BLOCK_UNDEF82 && Index != BLOCK_UNDEF104;
+		if(Spreads && Below != 0 && !IsFluid(Below) && At(x+1, y) == 0 && !IsFluid(At(x+1, y+1)) && !IsFluid(At(x+1, y-1)))
+			Create(x+1, y, Index-1, 0);
+		if(Spreads && Below != 0 && Below != BLOCK_AGUA && Below != BLOCK_LAVA && At(x-1, y) == 0 && !IsFluid(At(x-1, y+1)) && !IsFluid(At(x-1, y-1)))
+			Create(x-1, y, Index-1, 0);
+	}
+	else if(Index == BLOCK_ROSAR || Index == BLOCK_ROSAY)
+	{
+		if(Below == BLOCK_GROUND)
+			Create(x, y+1, BLOCK_APGRASS, 1);
+	}
+	else if(Index == BLOCK_BED)
+	{
+		if(At(x+1, y) == BLOCK_BED)
+		{
+			Create(x, y, BLOCK_UNDEF48, 1);
+			Create(x+1, y, BLOCK_UNDEF49, 1);
+		}
+	}
+	else if(Index == BLOCK_INVENTARY)
+	{
+		if(At(x+1, y) == BLOCK_INVENTARY)
+		{
+			Create(x, y, BLOCK_INVTA, 1);
+			Create(x+1, y, BLOCK_INVTB, 1);
+		}
+	}
+
+	if(Index == BLOCK_GROUND)
+	{
+		bool Covered = false;
+		for(int o = y-1; o >= 0 && !Covered; o--)
+			Covered = At(x, o) != 0 && (At(x, o) < BLOCK_SEED2 || At(x, o) > BLOCK_SEED8);
+		if(!Covered)
+			Create(x, y, BLOCK_GRASSGROUND, 1);
+	}
+	else if(Index == BLOCK_GRASSGROUND)
+	{
+		int Above = At(x, y-1);
+		if(Above != 0 && (Above < BLOCK_SEED2 || Above > BLOCK_SEED8))
+			Create(x, y, Above == BLOCK_NIEVE ? BLOCK_BNGRASS : BLOCK_GROUND, 1);
+	}
+	else if(Index == BLOCK_HORNO_OFF)
+	{
+		// lit by coal next to it, the coal burns away
+		if(At(x, y-1) == BLOCK_CARBONP || At(x-1, y) == BLOCK_CARBONP || At(x+1, y) == BLOCK_CARBONP)
+		{
+			Create(x, y, BLOCK_HORNO_ON, 1);
+			if(At(x, y-1) == BLOCK_CARBONP)
+				Destroy(x, y-1, -1);
+			else if(At(x-1, y) == BLOCK_CARBONP)
+				Destroy(x-1, y, -1);
+			else
+				Destroy(x+1, y, -1);
+		}
+	}
+
+	// blocks that fall
+	if((IsSand(Index) || Index == BLOCK_NIEVE || Index == BLOCK_CARBONP) && Below == 0)
+	{
+		Destroy(x, y, -1);
+		Create(x, y+1, Index, 1);
+	}
+	return false;
+}
+
+bool CWorldSim::Destruction(int x, int y)
+{
+	// what lost the block that holds it
+	int Index = At(x, y);
+	int Below = At(x, y+1);
+	if(Index == BLOCK_AZUCAR)
+	{
+		if(Below != BLOCK_AZUCAR && Below != BLOCK_APGRASS)
+			Destroy(x, y, BLOCK_AZUCAR);
+	}
+	else if(Index == BLOCK_CACTUS)
+	{
+		if(Below != BLOCK_CACTUS && !IsSand(Below))
+			Destroy(x, y, BLOCK_CACTUS);
+	}
+	else if(Index == BLOCK_LUZ)
+	{
+		bool Held = false;
+		int aSides[3] = { At(x-1, y), At(x+1, y), Below };
+		for(int i = 0; i < 3; i++)
+			if(aSides[i] != 0 && aSides[i] != BLOCK_LAVA && aSides[i] != BLOCK_AGUA)
+				Held = true;
+		if(!Held)
+			Destroy(x, y, BLOCK_LUZ);
+	}
+	else if(Index >= BLOCK_SEED1 && Index <= BLOCK_SEED8)
+	{
+		if(Below == 0)
+			Destroy(x, y, BLOCK_SEEDM);
+	}
+	else if(Index == BLOCK_UNDEF48 || Index == BLOCK_INVTA)
+	{
+		if(At(x+1, y) == 0)
+			Destroy(x, y, Index == BLOCK_UNDEF48 ? BLOCK_BED : BLOCK_INVENTARY);
+	}
+	else if(Index == BLOCK_UNDEF49 || Index == BLOCK_INVTB)
+	{
+		if(At(x-1, y) == 0)
+			Destroy(x, y, Index == BLOCK_UNDEF49 ? BLOCK_BED : BLOCK_INVENTARY);
+	}
+	else if(Index == BLOCK_UNDEF84)
+	{
+		// falling water dries up without water to come from
+		if(!IsWater(At(x, y-1)) && !IsWater(At(x-1, y)) && !IsWater(At(x+1, y)))
+			Destroy(x, y, -1);
+	}
+	else if(Index == BLOCK_UNDEF106)
+	{
+		if(!IsLava(At(x, y-1)) && !IsLava(At(x-1, y)) && !IsLava(At(x+1, y)))
+			Destroy(x, y, -1);
+	}
+	else if(Index == BLOCK_ROSAR || Index == BLOCK_ROSAY)
+	{
+		if(Below == 0)
+			Destroy(x, y, Index);
+	}
+	return false;
+}
+
+bool CWorldSim::Vegetal(int x, int y)
+{
+	int Index = At(x, y);
+	int Above = At(x, y-1);
+	int Below = At(x, y+1);
+
+	// sugar cane and cactus grow on top, up to a height
+	if((Index == BLOCK_AZUCAR && (Below == BLOCK_AZUCAR || Below == BLOCK_APGRASS)) ||
+		(Index == BLOCK_CACTUS && (Below == BLOCK_CACTUS || IsSand(Below))))
+	{
+		if(Above != 0)
+			return false;
+
+		int Height = 0;
+		bool Rooted = false;
+		for(int u = 1; u <= 5; u++)
+		{
+			int Ground = At(x, y+u);
+			if(Ground == Index)
+				Height++;
+			else
+			{
+				Rooted = Index == BLOCK_AZUCAR ? Ground == BLOCK_APGRASS : IsSand(Ground);
+				break;
+			}
+		}
+
+		if((rand()%10) == 7 && Rooted && Height < (Index == BLOCK_AZUCAR ? 5 : 8))
+			Create(x, y-1, Index, 1);
+		return true;
+	}
+	else if(Index >= BLOCK_SEED1 && Index < BLOCK_SEED8)
+	{
+		// the grown tile queues it again
+		int Next = Index+1;
+		if(Below != BLOCK_APGRASS && Next > BLOCK_SEED4)
+			Next = BLOCK_SEED4;
+		Create(x, y, Next, 1);
+
+		// and a grown plant spreads to the grass next to it
+		if(Index == BLOCK_SEED4 && At(x+1, y) == 0 && At(x+1, y+1) == BLOCK_GRASSGROUND && (rand()%100) == 3)
+			Create(x+1, y, BLOCK_SEED1, 1);
+	}
+	else if(IsSand(Index))
+	{
+		// a new cactus, but not right next to another one
+		if(Above != 0)
+			return false;
+		if((rand()%100) == 3)
+		{
+			bool Found = false;
+			for(int i = -4; i < 5 && !Found; i++)
+				Found = At(x+i, y-1) == BLOCK_CACTUS;
+			if(!Found)
+				Create(x, y-1, BLOCK_CACTUS, 1);
+		}
+		return true;
+	}
+	else if(Index == BLOCK_APGRASS)
+	{
+		if(Above == 0)
+			Create(x, y, BLOCK_GROUND, 1);
+	}
+	return false;
+}
+
+bool CWorldSim::Cook(int x, int y)
+{
+	// an oven that burns melts what is on it
+	int Above = At(x, y-1);
+	if(At(x, y) != BLOCK_HORNO_ON || Above == 0 || Above == BLOCK_CRISTAL || Above == BLOCK_STONE2)
+		return false;
+
+	int Drop = -1;
+	if(IsSand(Above))
+		Drop = BLOCK_CRISTAL;
+	else if(Above == BLOCK_STONE)
+		Drop = BLOCK_STONE2;
+	else if(Above == BLOCK_UNDEF63)
+		Drop = BLOCK_TARENA;
+	else if(Above == BLOCK_GOLD)
+		Drop = BLOCK_OROP;
+	else if(Above == BLOCK_PLATA)
+		Drop = BLOCK_PLATAP;
+	Destroy(x, y-1, Drop);
+	return false;
+}
+
+bool CWorldSim::Wear(int x, int y)
+{
+	int Index = At(x, y);
+	if(Index == BLOCK_HORNO_ON)
+	{
+		Create(x, y, BLOCK_HORNO_OFF, 1);
+		return false;
+	}
+
+	// stone bricks crack over time
+	if((rand()%100) == 2)
+		Create(x, y, Index == BLOCK_STONE2 ? BLOCK_STONE2BREAK : BLOCK_STONE2MOO, 1);
+	return true;
+}
@@ -0,0 +1,104 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_WORLDSIM_H
+#define GAME_SERVER_WORLDSIM_H
+
+#include <game/mapitems.h>
+
+/*
+	Class: World simulation
+		The MineTee blocks that change on their own: flowing water
+		and lava, falling sand, plants, ovens and the blocks that
+		break without support. Only the cells that could change are
+		looked at. A cell waits in the queue of a step until the step
+		runs, a tile change queues the cells around it again.
+*/
+class CWorldSim
+{
+public:
+	enum
+	{
+		STEP_ENVIRONMENT=1,
+		STEP_DESTRUCTION=2,
+		STEP_VEGETAL=4,
+		STEP_COOK=8,
+		STEP_WEAR=16,
+		NUM_STEPS=5,
+	};
+
+	// what a step decided, applied by the caller
+	struct CChange
+	{
+		int m_X;
+		int m_Y;
+		int m_Act; // TILE_CREATE or TILE_DESTROY
+		int m_Index;
+		int m_Col;
+		int m_Drop; // block that falls out of a destroyed tile, -1 for none
+	};
+
+	CWorldSim();
+	~CWorldSim();
+
+	void Init(CTile *pTiles, int Width, int Height);
+	void Clear();
+
+	// queues the tile and its neighbours again, call it after a tile changed
+	void OnTileChanged(int x, int y);
+
+	// queues every cell, like the first step after Init
+	void QueueAll();
+
+	/*
+		Function: Run
+			Looks at the queued cells of the steps and collects what
+			changes. The tiles are only read, so every step sees the
+			world like it was before.
+
+		Arguments:
+			Steps - STEP_* flags of the steps to run.
+
+		Returns:
+			The number of changes, see GetChange.
+	*/
+	int Run(int Steps);
+	const CChange *GetChange(int Index) const { return &m_pChanges[Index]; }
+
+	int NumQueued(int Step) const;
+	int NumChanges() const { return m_NumChanges; }
+
+private:
+	CTile *m_pTiles;
+	int m_Width;
+	int m_Height;
+
+	unsigned char *m_pQueued; // STEP_* flags per cell
+	int *m_apQueue[NUM_STEPS];
+	int m_aNumQueued[NUM_STEPS];
+	int m_aQueueCapacity[NUM_STEPS];
+
+	int *m_pProcess;
+	int m_ProcessCapacity;
+
+	CChange *m_pChanges;
+	int m_NumChanges;
+	int m_ChangeCapacity;
+
+	int At(int x, int y) const { return x >= 0 && x < m_Width && y >= 0 && y < m_Height ? m_pTiles[y*m_Width+x].m_Index : 0; }
+	static int StepsOf(int Index);
+
+	void Queue(int x, int y);
+	void AddChange(int x, int y, int Act, int Index, int Col, int Drop);
+	void Create(int x, int y, int Index, int Col);
+	void Destroy(int x, int y, int Drop);
+
+	// returns true if the cell has to be looked at again next time
+	bool Evaluate(int x, int y, int Step);
+	bool Environment(int x, int y);
+	bool Destruction(int x, int y);
+	bool Vegetal(int x, int y);
+	bool Cook(int x, int y);
+	bool Wear(int x, int y);
+};
+
+#endif
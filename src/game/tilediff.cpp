@@ -0,0 +1,184 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <base/math.h>
+
+#include "tilediff.h"
+
+static int Pack(int Act, int ITile, int Col) { return (Act == TILE_CREATE ? 1 : 0) | (Col ? 2 : 0) | (ITile<<2); }
+
+CTileDiffStore::CTileDiffStore()
+{
+	m_Width = 0;
+	m_Height = 0;
+	m_pSlots = 0;
+	m_NumSlots = 0;
+	m_NumFree = 0;
+	m_SlotCapacity = 0;
+	m_pHash = 0;
+	m_HashMask = -1;
+	m_NumHashed = 0;
+}
+
+CTileDiffStore::~CTileDiffStore()
+{
+	if(m_pSlots)
+		mem_free(m_pSlots);
+	if(m_pHash)
+		mem_free(m_pHash);
+}
+
+void CTileDiffStore::Init(int Width, int Height)
+{
+	Clear();
+	m_Width = Width;
+	m_Height = Height;
+}
+
+void CTileDiffStore::Clear()
+{
+	m_NumSlots = 0;
+	m_NumFree = 0;
+	m_NumHashed = 0;
+	for(int b = 0; b <= m_HashMask; b++)
+		m_pHash[b] = -1;
+}
+
+int CTileDiffStore::Find(int Key) const
+{
+	if(!m_pHash)
+		return -1;
+	for(unsigned b = Bucket(Key); m_pHash[b] != -1; b = (b+1)&m_HashMask)
+		if(m_pSlots[m_pHash[b]].m_Key == Key)
+			return b;
+	return -1;
+}
+
+void CTileDiffStore::Unhash(int Bucket)
+{
+	// move the following entries of the probe sequence back into the gap
+	int Gap = Bucket;
+	m_pHash[Gap] = -1;
+	for(int b = (Gap+1)&m_HashMask; m_pHash[b] != -1; b = (b+1)&m_HashMask)
+	{
+		int Home = this->Bucket(m_pSlots[m_pHash[b]].m_Key);
+		if(((b-Home)&m_HashMask) >= ((b-Gap)&m_HashMask))
+		{
+			m_pHash[Gap] = m_pHash[b];
+			m_pHash[b] = -1;
+			Gap = b;
+		}
+	}
+	m_NumHashed--;
+}
+
+void CTileDiffStore::Rehash(int NumBuckets)
+{
+	if(m_pHash)
+		mem_free(m_pHash);
+	m_pHash = (int *)mem_alloc(NumBuckets*sizeof(int), 1);
+	m_HashMask = NumBuckets-1;
+	m_NumHashed = 0;
+	for(int b = 0; b <= m_HashMask; b++)
+		m_pHash[b] = -1;
+
+	for(int i = 0; i < m_NumSlots; i++)
+	{
+		if(m_pSlots[i].m_Key == FREE_KEY)
+			continue;
+		unsigned b = Bucket(m_pSlots[i].m_Key);
+		while(m_pHash[b] != -1)
+			b = (b+1)&m_HashMask;
+		m_pHash[b] = i;
+		m_NumHashed++;
+	}
+}
+
+bool CTileDiffStore::Set(int x, int y, int State, int Act, int ITile, int Col)
+{
+	if(x < 0 || x >= m_Width || y < 0 || y >= m_Height || State < 0 || State > 2)
+		return false;
+
+	// keep the table at most half full
+	if((m_NumHashed+1)*2 > m_HashMask+1)
+		Rehash(max(1024, (m_HashMask+1)*2));
+
+	if(m_NumSlots == m_SlotCapacity)
+	{
+		int Capacity = max(1024, m_SlotCapacity*2);
+		CSlot *pSlots = (CSlot *)mem_alloc(Capacity*sizeof(CSlot), 1);
+		if(m_pSlots)
+		{
+			mem_copy(pSlots, m_pSlots, m_NumSlots*sizeof(CSlot));
+			mem_free(m_pSlots);
+		}
+		m_pSlots = pSlots;
+		m_SlotCapacity = Capacity;
+	}
+
+	int Key = this->Key(x, y, State);
+	int Index = m_NumSlots++;
+	m_pSlots[Index].m_Key = Key;
+	m_pSlots[Index].m_Value = Pack(Act, ITile, Col);
+
+	int b = Find(Key);
+	if(b >= 0)
+	{
+		m_pSlots[m_pHash[b]].m_Key = FREE_KEY;
+		m_NumFree++;
+		m_pHash[b] = Index;
+		return true;
+	}
+
+	b = Bucket(Key);
+	while(m_pHash[b] != -1)
+		b = (b+1)&m_HashMask;
+	m_pHash[b] = Index;
+	m_NumHashed++;
+	return false;
+}
+
+void CTileDiffStore::Remove(int x, int y, int State)
+{
+	if(x < 0 || x >= m_Width || y < 0 || y >= m_Height || State < 0 || State > 2)
+		return;
+
+	int b = Find(Key(x, y, State));
+	if(b < 0)
+		return;
+	m_pSlots[m_pHash[b]].m_Key = FREE_KEY;
+	m_NumFree++;
+	Unhash(b);
+}
+
+bool CTileDiffStore::Get(int Index, CNetMsg_Sv_TileChangeExt *pTile) const
+{
+	if(Index < 0 || Index >= m_NumSlots || m_pSlots[Index].m_Key == FREE_KEY)
+		return false;
+
+	int Key = m_pSlots[Index].m_Key;
+	int Value = m_pSlots[Index].m_Value;
+	pTile->m_Size = -1;
+	pTile->m_Index = Index;
+	pTile->m_X = Key%m_Width;
+	pTile->m_Y = (Key/m_Width)%m_Height;
+	pTile->m_State = Key/(m_Width*m_Height);
+	pTile->m_Act = Value&1 ? TILE_CREATE : TILE_DESTROY;
+	pTile->m_Col = (Value>>1)&1;
+	pTile->m_ITile = Value>>2;
+	return true;
+}
+
+void CTileDiffStore::Compact()
+{
+	if(!m_NumFree)
+		return;
+
+	int Num = 0;
+	for(int i = 0; i < m_NumSlots; i++)
+		if(m_pSlots[i].m_Key != FREE_KEY)
+			m_pSlots[Num++] = m_pSlots[i];
+	m_NumSlots = Num;
+	m_NumFree = 0;
+	Rehash(m_HashMask+1);
+}
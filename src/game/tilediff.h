@@ -0,0 +1,85 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_TILEDIFF_H
+#define GAME_TILEDIFF_H
+
+#include <game/generated/protocol.h>
+
+/*
+	Class: Tile diff store
+		The MineTee tiles that differ from the map, one diff per tile
+		and layer state, sent to the clients that join later. The
+		diffs sit in slots in the order they happened, a newer change
+		of the same tile frees the old slot and takes a new one at the
+		end. Slot indices stay the same until Compact, so a client can
+		download them in chunks while the map changes.
+*/
+class CTileDiffStore
+{
+public:
+	CTileDiffStore();
+	~CTileDiffStore();
+
+	void Init(int Width, int Height);
+	void Clear();
+
+	/*
+		Function: Set
+			Stores the latest change of a tile.
+
+		Arguments:
+			x, y, State - Tile and layer state of the change.
+			Act - TILE_CREATE or TILE_DESTROY.
+			ITile, Col - The new tile, for TILE_CREATE.
+
+		Returns:
+			True if an older change of the tile was replaced.
+	*/
+	bool Set(int x, int y, int State, int Act, int ITile, int Col);
+	void Remove(int x, int y, int State);
+
+	// fills pTile with the slot, returns false for a free slot
+	bool Get(int Index, CNetMsg_Sv_TileChangeExt *pTile) const;
+
+	// drops the free slots, this changes the indices
+	void Compact();
+
+	int Size() const { return m_NumSlots; }
+	int NumDiffs() const { return m_NumSlots-m_NumFree; }
+	int NumFree() const { return m_NumFree; }
+	int MemoryUsage() const { return m_SlotCapacity*sizeof(CSlot) + (m_HashMask+1)*sizeof(int); }
+
+private:
+	enum
+	{
+		FREE_KEY=-1,
+	};
+
+	struct CSlot
+	{
+		int m_Key; // (state*height+y)*width+x, FREE_KEY for a free slot
+		int m_Value; // act, collision and tile, see Pack
+	};
+
+	int m_Width;
+	int m_Height;
+
+	CSlot *m_pSlots;
+	int m_NumSlots;
+	int m_NumFree;
+	int m_SlotCapacity;
+
+	// open addressing, slot index per bucket or -1
+	int *m_pHash;
+	int m_HashMask;
+	int m_NumHashed;
+
+	int Key(int x, int y, int State) const { return (State*m_Height+y)*m_Width+x; }
+	unsigned Bucket(int Key) const { return ((unsigned)Key*2654435761u)&m_HashMask; }
+
+	int Find(int Key) const; // bucket of the key or -1
+	void Unhash(int Bucket);
+	void Rehash(int NumBuckets);
+};
+
+#endif
@@ -85,10 +85,16 @@ MACRO_CONFIG_INT(SvVoteKick, sv_vote_kick, 1, 0, 1, CFGFLAG_SERVER, "Allow votin
 MACRO_CONFIG_INT(SvVoteKickMin, sv_vote_kick_min, 0, 0, MAX_CLIENTS, CFGFLAG_SERVER, "Minimum number of players required to start a kick vote")
 MACRO_CONFIG_INT(SvVoteKickBantime, sv_vote_kick_bantime, 5, 0, 1440, CFGFLAG_SERVER, "The time to ban a player if kicked by vote. 0 makes it just use kick")
 
+MACRO_CONFIG_INT(SvSnapMaster, sv_snap_master, 1, 0, 1, CFGFLAG_SERVER, "Serialize the world once per tick and derive the client snapshots from it")
+
 /** MineTee **/
 MACRO_CONFIG_INT(SvGameMode, sv_gamemode, 0, 0, 1, CFGFLAG_SERVER, "MineTee GameMode")
 MACRO_CONFIG_INT(SvMonsters, sv_monsters, 1, 0, 1, CFGFLAG_SERVER, "Enable/Disable Monsters")
 MACRO_CONFIG_INT(SvAnimals, sv_animals, 1, 0, 1, CFGFLAG_SERVER, "Enable/Disable Animals")
+MACRO_CONFIG_INT(SvNpcs, sv_npcs, 25, 0, 1024, CFGFLAG_SERVER, "Number of monsters and animals")
+MACRO_CONFIG_INT(SvTileBatches, sv_tile_batches, 1, 0, 1, CFGFLAG_SERVER, "Send the tile changes of a tick together after the snapshot (0 = one message per tile)")
+MACRO_CONFIG_INT(SvTileSyncTimeout, sv_tile_sync_timeout, 10, 1, 600, CFGFLAG_SERVER, "Seconds without a tile request before a joining client stops holding back the tile diff compaction")
+MACRO_CONFIG_INT(SvNpcThreads, sv_npc_threads, 0, 0, 16, CFGFLAG_SERVER, "Number of worker threads used to run the npc ai (0 = tick thread only)")
 MACRO_CONFIG_INT(SvNight, sv_night, -1, -1, 4, CFGFLAG_SERVER, "Night Level")
 MACRO_CONFIG_INT(SvNightTime, sv_night_tme, 300, 0, 9999, CFGFLAG_SERVER, "Night time")
 
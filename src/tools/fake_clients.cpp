@@ -0,0 +1,685 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/message.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+
+#include <game/generated/protocol.h>
+#include <game/version.h>
+
+#include <cstdlib>
+
+// connects a lot of clients to a server and plays like them, to see how the
+// server copes without having the players for it
+
+enum
+{
+	MAX_FAKE_CLIENTS=512,
+	MAX_RECORDED_INPUTS=64*1024,
+	NUM_INPUT_INTS=sizeof(CNetObj_PlayerInput)/sizeof(int),
+	MAX_SNAP_PARTS=32, // a bit for each in m_SnapParts
+
+	// snapshot delay buckets of one millisecond
+	MAX_DELAY=1000,
+};
+
+class CFakeClient
+{
+public:
+	enum
+	{
+		STATE_OFFLINE=0,
+		STATE_CONNECTING,
+		STATE_LOADING,
+		STATE_ENTERING,
+		STATE_INGAME,
+		STATE_DROPPED,
+	};
+
+	CNetClient m_Net;
+	int m_ID;
+	int m_State;
+
+	// map download
+	int m_MapCrc;
+	int m_MapChunk;
+
+	// snapshot receiving
+	CSnapshotStorage m_Snapshots;
+	char m_aSnapData[CSnapshot::MAX_SIZE];
+	unsigned m_SnapParts;
+	int m_RecvTick;
+	int m_AckTick;
+	int64 m_AckTime;
+
+	// the time tick 0 would have arrived at, the earliest seen
+	int64 m_TickBase;
+	bool m_HasTickBase;
+
+	int m_LastInputTick;
+	int64 m_PingTime;
+};
+
+static CFakeClient *s_pClients = 0;
+static int s_NumClients = 8;
+static CSnapshotDelta s_SnapshotDelta;
+static CNetObjHandler s_NetObjHandler;
+
+static int s_aaRecordedInputs[MAX_RECORDED_INPUTS][NUM_INPUT_INTS];
+static int s_NumRecordedInputs = 0;
+static int s_InputLead = 3;
+
+// counters since the last report
+static int s_NumSnapshots = 0;
+static int s_NumEmptySnapshots = 0;
+static int s_NumMultiSnapshots = 0;
+static int s_NumBadSnapshots = 0;
+static int s_NumInputs = 0;
+static int s_NumLateInputs = 0;
+static int s_MapBytes = 0;
+static int s_aSnapDelays[MAX_DELAY+1];
+static int s_aPings[MAX_DELAY+1];
+
+static void SendMsg(CFakeClient *pClient, CMsgPacker *pMsg, bool System, int Flags)
+{
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientID = 0;
+	Packet.m_pData = pMsg->Data();
+	Packet.m_DataSize = pMsg->Size();
+
+	// same packing as the client does
+	*((unsigned char*)Packet.m_pData) <<= 1;
+	if(System)
+		*((unsigned char*)Packet.m_pData) |= 1;
+
+	Packet.m_Flags = Flags;
+	pClient->m_Net.Send(&Packet);
+}
+
+static void AddSample(int *pBuckets, int64 Time)
+{
+	int Ms = (int)(Time*1000/time_freq());
+	pBuckets[clamp(Ms, 0, (int)MAX_DELAY)]++;
+}
+
+static int Percentile(const int *pBuckets, int Percent)
+{
+	int Total = 0;
+	for(int i = 0; i <= MAX_DELAY; i++)
+		Total += pBuckets[i];
+	if(!Total)
+		return 0;
+
+	int Count = 0;
+	for(int i = 0; i <= MAX_DELAY; i++)
+	{
+		Count += pBuckets[i];
+		if(Count*100 >= Total*Percent)
+			return i;
+	}
+	return MAX_DELAY;
+}
+
+static void GetInput(CFakeClient *pClient, int Tick, CNetObj_PlayerInput *pInput)
+{
+	// recorded input, every client starts somewhere else in it
+	if(s_NumRecordedInputs)
+	{
+		mem_copy(pInput, s_aaRecordedInputs[(Tick+pClient->m_ID*37)%s_NumRecordedInputs], sizeof(*pInput));
+		return;
+	}
+
+	// walk around, jump, shoot and hook now and then
+	int Phase = Tick+pClient->m_ID*23;
+	mem_zero(pInput, sizeof(*pInput));
+	pInput->m_Direction = (Phase/100)%3-1;
+	pInput->m_TargetX = (Phase/50)%2 ? 100 : -100;
+	pInput->m_TargetY = (pClient->m_ID%5)*20-40;
+	pInput->m_Jump = (Phase%40) < 5;
+	pInput->m_Fire = Phase/25; // counts presses and releases
+	pInput->m_Hook = (Phase%120) > 90;
+	pInput->m_WantedWeapon = (Phase/500)%WEAPON_NINJA+1;
+}
+
+static void SendInput(CFakeClient *pClient)
+{
+	if(pClient->m_State != CFakeClient::STATE_INGAME || pClient->m_AckTick < 0)
+		return;
+
+	// guess the tick the server is in from the last snapshot
+	int64 Now = time_get();
+	int PredTick = pClient->m_AckTick+(int)((Now-pClient->m_AckTime)*SERVER_TICK_SPEED/time_freq())+s_InputLead;
+	if(PredTick <= pClient->m_LastInputTick)
+		return;
+	pClient->m_LastInputTick = PredTick;
+
+	CNetObj_PlayerInput Input;
+	GetInput(pClient, PredTick, &Input);
+
+	CMsgPacker Msg(NETMSG_INPUT);
+	Msg.AddInt(pClient->m_AckTick);
+	Msg.AddInt(PredTick);
+	Msg.AddInt(sizeof(Input));
+	const int *pData = (const int *)&Input;
+	for(int i = 0; i < NUM_INPUT_INTS; i++)
+		Msg.AddInt(pData[i]);
+	SendMsg(pClient, &Msg, true, NETSENDFLAG_FLUSH);
+	s_NumInputs++;
+
+	// keep an eye on the latency too
+	if(Now-pClient->m_PingTime > time_freq())
+	{
+		CMsgPacker Ping(NETMSG_PING);
+		SendMsg(pClient, &Ping, true, NETSENDFLAG_FLUSH);
+		pClient->m_PingTime = Now;
+	}
+}
+
+static void OnSnapshot(CFakeClient *pClient, int Msg, CUnpacker *pUnpacker)
+{
+	int NumParts = 1;
+	int Part = 0;
+	int GameTick = pUnpacker->GetInt();
+	int DeltaTick = GameTick-pUnpacker->GetInt();
+	int PartSize = 0;
+	int Crc = 0;
+
+	if(Msg == NETMSG_SNAP)
+	{
+		NumParts = pUnpacker->GetInt();
+		Part = pUnpacker->GetInt();
+	}
+	if(Msg != NETMSG_SNAPEMPTY)
+	{
+		Crc = pUnpacker->GetInt();
+		PartSize = pUnpacker->GetInt();
+	}
+
+	const char *pData = (const char *)pUnpacker->GetRaw(PartSize);
+	if(pUnpacker->Error() || NumParts < 1 || NumParts > MAX_SNAP_PARTS || Part < 0 || Part >= NumParts ||
+		PartSize < 0 || PartSize > MAX_SNAPSHOT_PACKSIZE || GameTick < pClient->m_RecvTick)
+		return;
+
+	if(GameTick != pClient->m_RecvTick)
+	{
+		pClient->m_SnapParts = 0;
+		pClient->m_RecvTick = GameTick;
+	}
+	mem_copy(&pClient->m_aSnapData[Part*MAX_SNAPSHOT_PACKSIZE], pData, PartSize);
+	pClient->m_SnapParts |= 1<<Part;
+	if(pClient->m_SnapParts != (unsigned)((1<<NumParts)-1))
+		return;
+	pClient->m_SnapParts = 0;
+
+	// how late it came compared to the earliest snapshot so far
+	int64 Now = time_get();
+	int64 TickTime = Now-(int64)GameTick*time_freq()/SERVER_TICK_SPEED;
+	if(!pClient->m_HasTickBase || TickTime < pClient->m_TickBase)
+	{
+		pClient->m_TickBase = TickTime;
+		pClient->m_HasTickBase = true;
+	}
+	AddSample(s_aSnapDelays, TickTime-pClient->m_TickBase);
+
+	// find the snapshot it was deltaed against
+	static CSnapshot s_EmptySnap;
+	s_EmptySnap.Clear();
+	CSnapshot *pDeltaShot = &s_EmptySnap;
+	if(DeltaTick >= 0 && pClient->m_Snapshots.Get(DeltaTick, 0, &pDeltaShot, 0) < 0)
+	{
+		// lost it, make the server send a full one
+		pClient->m_AckTick = -1;
+		return;
+	}
+
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	char aSnap[CSnapshot::MAX_SIZE];
+	int CompleteSize = (NumParts-1)*MAX_SNAPSHOT_PACKSIZE+PartSize;
+	void *pDeltaData = s_SnapshotDelta.EmptyDelta();
+	int DeltaSize = sizeof(int)*3;
+	if(CompleteSize)
+	{
+		DeltaSize = CVariableInt::Decompress(pClient->m_aSnapData, CompleteSize, aDeltaData, sizeof(aDeltaData));
+		if(DeltaSize < 0)
+		{
+			s_NumBadSnapshots++;
+			return;
+		}
+		pDeltaData = aDeltaData;
+	}
+
+	int SnapSize = s_SnapshotDelta.UnpackDelta(pDeltaShot, (CSnapshot *)aSnap, pDeltaData, DeltaSize);
+	if(SnapSize < 0 || (Msg != NETMSG_SNAPEMPTY && ((CSnapshot *)aSnap)->Crc() != Crc))
+	{
+		s_NumBadSnapshots++;
+		return;
+	}
+
+	s_NumSnapshots++;
+	if(Msg == NETMSG_SNAPEMPTY)
+		s_NumEmptySnapshots++;
+	if(NumParts > 1)
+		s_NumMultiSnapshots++;
+
+	// keep what the server can still delta against and ack the new one
+	pClient->m_Snapshots.PurgeUntil(DeltaTick);
+	pClient->m_Snapshots.Add(GameTick, Now, SnapSize, aSnap, 0);
+	pClient->m_AckTick = GameTick;
+	pClient->m_AckTime = Now;
+}
+
+static void OnMessage(CFakeClient *pClient, CNetChunk *pPacket)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+
+	int Msg = Unpacker.GetInt();
+	int Sys = Msg&1;
+	Msg >>= 1;
+
+	// game messages are not looked at
+	if(Unpacker.Error() || !Sys)
+		return;
+
+	if(Msg == NETMSG_MAP_CHANGE)
+	{
+		Unpacker.GetString();
+		pClient->m_MapCrc = Unpacker.GetInt();
+		Unpacker.GetInt();
+		if(Unpacker.Error())
+			return;
+
+		// download it like a client without the map would
+		pClient->m_State = CFakeClient::STATE_LOADING;
+		pClient->m_MapChunk = 0;
+		pClient->m_AckTick = -1;
+		pClient->m_RecvTick = 0;
+		pClient->m_Snapshots.PurgeAll();
+		CMsgPacker Packer(NETMSG_REQUEST_MAP_DATA);
+		Packer.AddInt(pClient->m_MapChunk);
+		SendMsg(pClient, &Packer, true, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+	}
+	else if(Msg == NETMSG_MAP_DATA)
+	{
+		int Last = Unpacker.GetInt();
+		int MapCrc = Unpacker.GetInt();
+		int Chunk = Unpacker.GetInt();
+		int Size = Unpacker.GetInt();
+		Unpacker.GetRaw(Size);
+		if(Unpacker.Error() || MapCrc != pClient->m_MapCrc || Chunk != pClient->m_MapChunk)
+			return;
+		s_MapBytes += Size;
+
+		if(Last)
+		{
+			CMsgPacker Packer(NETMSG_READY);
+			SendMsg(pClient, &Packer, true, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		}
+		else
+		{
+			CMsgPacker Packer(NETMSG_REQUEST_MAP_DATA);
+			Packer.AddInt(++pClient->m_MapChunk);
+			SendMsg(pClient, &Packer, true, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		}
+	}
+	else if(Msg == NETMSG_CON_READY)
+	{
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "fake%d", pClient->m_ID);
+		CNetMsg_Cl_StartInfo StartInfo;
+		StartInfo.m_pName = aName;
+		StartInfo.m_pClan = "";
+		StartInfo.m_Country = -1;
+		StartInfo.m_pSkin = "default";
+		StartInfo.m_UseCustomColor = 0;
+		StartInfo.m_ColorBody = 0;
+		StartInfo.m_ColorFeet = 0;
+		CMsgPacker Packer(StartInfo.MsgID());
+		StartInfo.Pack(&Packer);
+		SendMsg(pClient, &Packer, false, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+
+		CMsgPacker EnterMsg(NETMSG_ENTERGAME);
+		SendMsg(pClient, &EnterMsg, true, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		pClient->m_State = CFakeClient::STATE_ENTERING;
+	}
+	else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+	{
+		if(pClient->m_State == CFakeClient::STATE_ENTERING)
+			pClient->m_State = CFakeClient::STATE_INGAME;
+		OnSnapshot(pClient, Msg, &Unpacker);
+	}
+	else if(Msg == NETMSG_INPUTTIMING)
+	{
+		Unpacker.GetInt();
+		int TimeLeft = Unpacker.GetInt();
+		if(!Unpacker.Error() && TimeLeft < 0)
+			s_NumLateInputs++;
+	}
+	else if(Msg == NETMSG_PING_REPLY)
+		AddSample(s_aPings, time_get()-pClient->m_PingTime);
+}
+
+static void UpdateClient(CFakeClient *pClient)
+{
+	if(pClient->m_State == CFakeClient::STATE_OFFLINE || pClient->m_State == CFakeClient::STATE_DROPPED)
+		return;
+
+	pClient->m_Net.Update();
+	if(pClient->m_Net.State() == NETSTATE_OFFLINE)
+	{
+		dbg_msg("fake_clients", "client %d dropped: %s", pClient->m_ID, pClient->m_Net.ErrorString());
+		pClient->m_State = CFakeClient::STATE_DROPPED;
+		return;
+	}
+
+	if(pClient->m_State == CFakeClient::STATE_CONNECTING && pClient->m_Net.State() == NETSTATE_ONLINE)
+	{
+		CMsgPacker Msg(NETMSG_INFO);
+		Msg.AddString(GAME_NETVERSION, 128);
+		Msg.AddString(g_Config.m_Password, 128);
+		Msg.AddString(HCLIENT_VERSION, 128);
+		SendMsg(pClient, &Msg, true, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		pClient->m_State = CFakeClient::STATE_LOADING;
+	}
+
+	CNetChunk Packet;
+	while(pClient->m_Net.Recv(&Packet))
+		OnMessage(pClient, &Packet);
+
+	SendInput(pClient);
+}
+
+static bool ConnectClient(CFakeClient *pClient, int ID, NETADDR *pAddr)
+{
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = pAddr->type;
+	if(!pClient->m_Net.Open(BindAddr, 0))
+	{
+		dbg_msg("fake_clients", "could not open a socket for client %d", ID);
+		return false;
+	}
+
+	pClient->m_ID = ID;
+	pClient->m_State = CFakeClient::STATE_CONNECTING;
+	pClient->m_Snapshots.Init();
+	pClient->m_SnapParts = 0;
+	pClient->m_RecvTick = 0;
+	pClient->m_AckTick = -1;
+	pClient->m_AckTime = 0;
+	pClient->m_HasTickBase = false;
+	pClient->m_LastInputTick = -1;
+	pClient->m_PingTime = 0;
+	pClient->m_Net.Connect(pAddr);
+	return true;
+}
+
+static bool LoadInputs(const char *pFilename)
+{
+	// one tick per line, the CNetObj_PlayerInput fields separated by spaces
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+		return false;
+
+	int Size = (int)io_length(File);
+	char *pBuf = (char *)mem_alloc(Size+1, 1);
+	io_read(File, pBuf, Size);
+	pBuf[Size] = 0;
+	io_close(File);
+
+	char *pCur = pBuf;
+	while(*pCur && s_NumRecordedInputs < MAX_RECORDED_INPUTS)
+	{
+		int *pInput = s_aaRecordedInputs[s_NumRecordedInputs];
+		int i = 0;
+		while(*pCur && *pCur != '\n')
+		{
+			char *pEnd;
+			long Value = strtol(pCur, &pEnd, 10);
+			if(pEnd == pCur)
+			{
+				pCur++;
+				continue;
+			}
+			if(i < NUM_INPUT_INTS)
+				pInput[i++] = (int)Value;
+			pCur = pEnd;
+		}
+		if(*pCur)
+			pCur++;
+		if(i == NUM_INPUT_INTS)
+			s_NumRecordedInputs++;
+	}
+	mem_free(pBuf);
+	return s_NumRecordedInputs > 0;
+}
+
+// the econ gives the tick times of the server
+static NETSOCKET s_EconSocket;
+static bool s_EconConnected = false;
+static char s_aEconBuf[4096];
+static int s_EconBufSize = 0;
+
+static void EconSend(const char *pLine)
+{
+	if(!s_EconConnected)
+		return;
+	net_tcp_send(s_EconSocket, pLine, str_length(pLine));
+	net_tcp_send(s_EconSocket, "\n", 1);
+}
+
+static void EconUpdate()
+{
+	if(!s_EconConnected)
+		return;
+
+	int Bytes;
+	while((Bytes = net_tcp_recv(s_EconSocket, s_aEconBuf+s_EconBufSize, sizeof(s_aEconBuf)-1-s_EconBufSize)) > 0)
+	{
+		// the lines come with zero bytes after them
+		int End = s_EconBufSize+Bytes;
+		for(int i = s_EconBufSize; i < End; i++)
+			if(s_aEconBuf[i])
+				s_aEconBuf[s_EconBufSize++] = s_aEconBuf[i];
+		s_aEconBuf[s_EconBufSize] = 0;
+
+		// print the summary lines of the commands sent
+		char *pLine = s_aEconBuf;
+		char *pEnd;
+		while((pEnd = (char *)str_find(pLine, "\n")))
+		{
+			*pEnd = 0;
+			const char *pText = str_find(pLine, "]: ");
+			if(pText && (str_find(pText, "ticks=") == pText+3 || str_find(pText, "total ") == pText+3))
+				dbg_msg("fake_clients", "server %s", pText+3);
+			pLine = pEnd+1;
+		}
+		s_EconBufSize = str_length(pLine);
+		mem_move(s_aEconBuf, pLine, s_EconBufSize);
+		if(s_EconBufSize == sizeof(s_aEconBuf)-1)
+			s_EconBufSize = 0;
+	}
+}
+
+static bool EconConnect(NETADDR Addr, const char *pPassword)
+{
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = Addr.type;
+	s_EconSocket = net_tcp_create(BindAddr);
+	if(s_EconSocket.type == NETTYPE_INVALID || net_tcp_connect(s_EconSocket, &Addr) != 0)
+		return false;
+	net_set_non_blocking(s_EconSocket);
+	s_EconConnected = true;
+	EconSend(pPassword);
+	return true;
+}
+
+static void Report(int64 Elapsed, const NETSTATS *pPrevStats)
+{
+	int aStates[CFakeClient::STATE_DROPPED+1] = {0};
+	for(int i = 0; i < s_NumClients; i++)
+		aStates[s_pClients[i].m_State]++;
+
+	NETSTATS Stats;
+	net_stats(&Stats);
+	float Seconds = Elapsed/(float)time_freq();
+
+	dbg_msg("fake_clients", "ingame=%d loading=%d dropped=%d in=%.1fkB/s out=%.1fkB/s map=%.1fkB/s",
+		aStates[CFakeClient::STATE_INGAME], aStates[CFakeClient::STATE_CONNECTING]+aStates[CFakeClient::STATE_LOADING]+aStates[CFakeClient::STATE_ENTERING],
+		aStates[CFakeClient::STATE_DROPPED], (Stats.recv_bytes-pPrevStats->recv_bytes)/1024.0f/Seconds,
+		(Stats.sent_bytes-pPrevStats->sent_bytes)/1024.0f/Seconds, s_MapBytes/1024.0f/Seconds);
+	dbg_msg("fake_clients", "snaps=%.1f/s empty=%d multi=%d bad=%d delay_p50=%dms delay_p99=%dms ping_p50=%dms ping_p99=%dms inputs=%.1f/s late=%d",
+		s_NumSnapshots/Seconds, s_NumEmptySnapshots, s_NumMultiSnapshots, s_NumBadSnapshots,
+		Percentile(s_aSnapDelays, 50), Percentile(s_aSnapDelays, 99), Percentile(s_aPings, 50), Percentile(s_aPings, 99),
+		s_NumInputs/Seconds, s_NumLateInputs);
+
+	s_NumSnapshots = 0;
+	s_NumEmptySnapshots = 0;
+	s_NumMultiSnapshots = 0;
+	s_NumBadSnapshots = 0;
+	s_NumInputs = 0;
+	s_NumLateInputs = 0;
+	s_MapBytes = 0;
+	mem_zero(s_aSnapDelays, sizeof(s_aSnapDelays));
+	mem_zero(s_aPings, sizeof(s_aPings));
+
+	// the tick times and traffic the server saw in the meantime
+	EconSend("tick_times; net_stats");
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+	net_init();
+	CNetBase::Init();
+
+	const char *pAddress = "127.0.0.1:8303";
+	const char *pEconAddress = 0;
+	const char *pEconPassword = "";
+	int Seconds = 60;
+	int ConnectInterval = 20;
+	int ReportInterval = 5;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		const char *pArg = argv[i]; // ignore_convention
+		const char *pValue = i+1 < argc ? argv[i+1] : 0; // ignore_convention
+		if(!pValue)
+		{
+			dbg_msg("fake_clients", "missing value for '%s'", pArg);
+			return -1;
+		}
+		i++;
+
+		if(str_comp(pArg, "-n") == 0)
+			s_NumClients = clamp(atoi(pValue), 1, (int)MAX_FAKE_CLIENTS);
+		else if(str_comp(pArg, "-a") == 0)
+			pAddress = pValue;
+		else if(str_comp(pArg, "-t") == 0)
+			Seconds = atoi(pValue);
+		else if(str_comp(pArg, "-c") == 0)
+			ConnectInterval = max(atoi(pValue), 0);
+		else if(str_comp(pArg, "-r") == 0)
+			ReportInterval = max(atoi(pValue), 1);
+		else if(str_comp(pArg, "-l") == 0)
+			s_InputLead = atoi(pValue);
+		else if(str_comp(pArg, "-p") == 0)
+			str_copy(g_Config.m_Password, pValue, sizeof(g_Config.m_Password));
+		else if(str_comp(pArg, "-e") == 0)
+			pEconAddress = pValue;
+		else if(str_comp(pArg, "-ep") == 0)
+			pEconPassword = pValue;
+		else if(str_comp(pArg, "-i") == 0)
+		{
+			if(!LoadInputs(pValue))
+			{
+				dbg_msg("fake_clients", "could not load inputs from '%s'", pValue);
+				return -1;
+			}
+			dbg_msg("fake_clients", "loaded %d ticks of input", s_NumRecordedInputs);
+		}
+		else
+		{
+			dbg_msg("fake_clients", "usage: fake_clients [-n clients] [-a server address] [-t seconds] [-c connect interval ms] [-r report interval s]");
+			dbg_msg("fake_clients", "                    [-l input lead ticks] [-p password] [-i input file] [-e econ address] [-ep econ password]");
+			return -1;
+		}
+	}
+
+	NETADDR Addr;
+	if(net_host_lookup(pAddress, &Addr, NETTYPE_ALL) != 0)
+	{
+		dbg_msg("fake_clients", "could not resolve '%s'", pAddress);
+		return -1;
+	}
+	if(!Addr.port)
+		Addr.port = 8303;
+
+	if(pEconAddress)
+	{
+		NETADDR EconAddr;
+		if(net_host_lookup(pEconAddress, &EconAddr, NETTYPE_ALL) != 0 || !EconConnect(EconAddr, pEconPassword))
+			dbg_msg("fake_clients", "could not connect to the econ at '%s'", pEconAddress);
+	}
+
+	for(int i = 0; i < NUM_NETOBJTYPES; i++)
+		s_SnapshotDelta.SetStaticsize(i, s_NetObjHandler.GetObjSize(i));
+
+	s_pClients = new CFakeClient[s_NumClients];
+	for(int i = 0; i < s_NumClients; i++)
+		s_pClients[i].m_State = CFakeClient::STATE_OFFLINE;
+
+	int64 Start = time_get();
+	int64 End = Seconds > 0 ? Start+Seconds*time_freq() : -1;
+	int64 NextConnect = Start;
+	int64 LastReport = Start;
+	int NumConnected = 0;
+	NETSTATS LastStats;
+	net_stats(&LastStats);
+
+	while(End < 0 || time_get() < End)
+	{
+		int64 Now = time_get();
+
+		// don't connect all at once, the server would count it as a flood
+		while(NumConnected < s_NumClients && Now >= NextConnect)
+		{
+			ConnectClient(&s_pClients[NumConnected], NumConnected, &Addr);
+			NumConnected++;
+			NextConnect += ConnectInterval*time_freq()/1000;
+		}
+
+		for(int i = 0; i < NumConnected; i++)
+			UpdateClient(&s_pClients[i]);
+		EconUpdate();
+
+		if(Now-LastReport >= ReportInterval*time_freq())
+		{
+			Report(Now-LastReport, &LastStats);
+			net_stats(&LastStats);
+			LastReport = Now;
+		}
+
+		thread_sleep(1);
+	}
+
+	for(int i = 0; i < NumConnected; i++)
+	{
+		if(s_pClients[i].m_State != CFakeClient::STATE_DROPPED)
+			s_pClients[i].m_Net.Disconnect("load test done");
+		s_pClients[i].m_Snapshots.PurgeAll();
+	}
+	if(s_EconConnected)
+		net_tcp_close(s_EconSocket);
+	delete[] s_pClients;
+	return 0;
+}
@@ -0,0 +1,384 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/huffman.h>
+#include <engine/shared/snapshot.h>
+
+#include <cstdlib>
+
+// the coder as it was, one symbol per lut lookup and one byte per write
+class CHuffmanRef
+{
+	enum
+	{
+		EOF_SYMBOL=256,
+		MAX_SYMBOLS=EOF_SYMBOL+1,
+		MAX_NODES=MAX_SYMBOLS*2-1,
+		LUTBITS=10,
+		LUTSIZE=1<<LUTBITS,
+		LUTMASK=LUTSIZE-1,
+	};
+
+	struct CNode
+	{
+		unsigned m_Bits;
+		unsigned m_NumBits;
+		unsigned short m_aLeafs[2];
+		unsigned char m_Symbol;
+	};
+
+	struct CConstructNode
+	{
+		unsigned short m_NodeId;
+		int m_Frequency;
+	};
+
+	CNode m_aNodes[MAX_NODES];
+	CNode *m_apDecodeLut[LUTSIZE];
+	CNode *m_pStartNode;
+	int m_NumNodes;
+
+	void Setbits_r(CNode *pNode, int Bits, unsigned Depth)
+	{
+		if(pNode->m_aLeafs[1] != 0xffff)
+			Setbits_r(&m_aNodes[pNode->m_aLeafs[1]], Bits|(1<<Depth), Depth+1);
+		if(pNode->m_aLeafs[0] != 0xffff)
+			Setbits_r(&m_aNodes[pNode->m_aLeafs[0]], Bits, Depth+1);
+		if(pNode->m_NumBits)
+		{
+			pNode->m_Bits = Bits;
+			pNode->m_NumBits = Depth;
+		}
+	}
+
+public:
+	void Init(const unsigned *pFrequencies)
+	{
+		mem_zero(this, sizeof(*this));
+
+		CConstructNode aStorage[MAX_SYMBOLS];
+		CConstructNode *apLeft[MAX_SYMBOLS];
+		int NumLeft = MAX_SYMBOLS;
+		for(int i = 0; i < MAX_SYMBOLS; i++)
+		{
+			m_aNodes[i].m_NumBits = 0xFFFFFFFF;
+			m_aNodes[i].m_Symbol = i;
+			m_aNodes[i].m_aLeafs[0] = 0xffff;
+			m_aNodes[i].m_aLeafs[1] = 0xffff;
+			aStorage[i].m_Frequency = i == EOF_SYMBOL ? 1 : pFrequencies[i];
+			aStorage[i].m_NodeId = i;
+			apLeft[i] = &aStorage[i];
+		}
+
+		m_NumNodes = MAX_SYMBOLS;
+		while(NumLeft > 1)
+		{
+			for(int Size = NumLeft, Changed = 1; Changed; Size--)
+			{
+				Changed = 0;
+				for(int i = 0; i < Size-1; i++)
+				{
+					if(apLeft[i]->m_Frequency < apLeft[i+1]->m_Frequency)
+					{
+						CConstructNode *pTemp = apLeft[i];
+						apLeft[i] = apLeft[i+1];
+						apLeft[i+1] = pTemp;
+						Changed = 1;
+					}
+				}
+			}
+
+			m_aNodes[m_NumNodes].m_NumBits = 0;
+			m_aNodes[m_NumNodes].m_aLeafs[0] = apLeft[NumLeft-1]->m_NodeId;
+			m_aNodes[m_NumNodes].m_aLeafs[1] = apLeft[NumLeft-2]->m_NodeId;
+			apLeft[NumLeft-2]->m_NodeId = m_NumNodes;
+			apLeft[NumLeft-2]->m_Frequency = apLeft[NumLeft-1]->m_Frequency + apLeft[NumLeft-2]->m_Frequency;
+			m_NumNodes++;
+			NumLeft--;
+		}
+		m_pStartNode = &m_aNodes[m_NumNodes-1];
+		Setbits_r(m_pStartNode, 0, 0);
+
+		for(int i = 0; i < LUTSIZE; i++)
+		{
+			unsigned Bits = i;
+			int k;
+			CNode *pNode = m_pStartNode;
+			for(k = 0; k < LUTBITS; k++)
+			{
+				pNode = &m_aNodes[pNode->m_aLeafs[Bits&1]];
+				Bits >>= 1;
+				if(pNode->m_NumBits)
+				{
+					m_apDecodeLut[i] = pNode;
+					break;
+				}
+			}
+			if(k == LUTBITS)
+				m_apDecodeLut[i] = pNode;
+		}
+	}
+
+	int Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize)
+	{
+		const unsigned char *pSrc = (const unsigned char *)pInput;
+		unsigned char *pDst = (unsigned char *)pOutput;
+		unsigned char *pDstEnd = pDst + OutputSize;
+		unsigned Bits = 0;
+		unsigned Bitcount = 0;
+
+		for(int n = 0; n <= InputSize; n++)
+		{
+			int Symbol = n < InputSize ? *pSrc++ : (int)EOF_SYMBOL;
+			Bits |= m_aNodes[Symbol].m_Bits << Bitcount;
+			Bitcount += m_aNodes[Symbol].m_NumBits;
+			while(Bitcount >= 8)
+			{
+				*pDst++ = (unsigned char)(Bits&0xff);
+				if(pDst == pDstEnd)
+					return -1;
+				Bits >>= 8;
+				Bitcount -= 8;
+			}
+		}
+		*pDst++ = Bits;
+		return (int)(pDst - (const unsigned char *)pOutput);
+	}
+
+	int Decompress(const void *pInput, int InputSize, void *pOutput, int OutputSize)
+	{
+		unsigned char *pDst = (unsigned char *)pOutput;
+		unsigned char *pSrc = (unsigned char *)pInput;
+		unsigned char *pDstEnd = pDst + OutputSize;
+		unsigned char *pSrcEnd = pSrc + InputSize;
+		unsigned Bits = 0;
+		unsigned Bitcount = 0;
+		CNode *pEof = &m_aNodes[EOF_SYMBOL];
+
+		while(1)
+		{
+			CNode *pNode = 0;
+			if(Bitcount >= LUTBITS)
+				pNode = m_apDecodeLut[Bits&LUTMASK];
+			while(Bitcount < 24 && pSrc != pSrcEnd)
+			{
+				Bits |= (*pSrc++) << Bitcount;
+				Bitcount += 8;
+			}
+			if(!pNode)
+				pNode = m_apDecodeLut[Bits&LUTMASK];
+			if(!pNode)
+				return -1;
+
+			if(pNode->m_NumBits)
+			{
+				Bits >>= pNode->m_NumBits;
+				Bitcount -= pNode->m_NumBits;
+			}
+			else
+			{
+				Bits >>= LUTBITS;
+				Bitcount -= LUTBITS;
+				while(1)
+				{
+					pNode = &m_aNodes[pNode->m_aLeafs[Bits&1]];
+					Bitcount--;
+					Bits >>= 1;
+					if(pNode->m_NumBits)
+						break;
+					if(Bitcount == 0)
+						return -1;
+				}
+			}
+
+			if(pNode == pEof)
+				break;
+			if(pDst == pDstEnd)
+				return -1;
+			*pDst++ = pNode->m_Symbol;
+		}
+		return (int)(pDst - (const unsigned char *)pOutput);
+	}
+};
+
+enum
+{
+	MAX_PACKETS=4096,
+	PACKET_SIZE=1400,
+};
+
+static unsigned s_Seed = 1;
+static int Random(int Max)
+{
+	s_Seed = s_Seed*1103515245+12345;
+	return (s_Seed>>16)%Max;
+}
+
+// packet payloads like the game sends them: variable int compressed snapshot deltas
+static int GeneratePackets(unsigned char (*paPackets)[PACKET_SIZE], int *pSizes, int NumPackets)
+{
+	static char s_aaSnaps[2][CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	static unsigned char s_aStream[1024*1024];
+	static CSnapshotBuilder s_Builder;
+	static CSnapshotDelta s_Delta;
+
+	int aaData[128][12];
+	for(int i = 0; i < 128; i++)
+		for(int d = 0; d < 12; d++)
+			aaData[i][d] = Random(3000);
+
+	int StreamSize = 0;
+	CSnapshot *pPrev = (CSnapshot *)s_aaSnaps[1];
+	pPrev->Clear();
+	for(int Tick = 0; StreamSize < (int)sizeof(s_aStream)-CSnapshot::MAX_SIZE*5; Tick++)
+	{
+		s_Builder.Init();
+		for(int i = 0; i < 128; i++)
+		{
+			if(i < 16 || Random(8) == 0)
+				aaData[i][Random(12)] += Random(64)-32;
+			aaData[i][0] = i < 16 ? Tick : aaData[i][0];
+			int *pData = (int *)s_Builder.NewItem(1+i%8, i, 4*(4+i%8));
+			mem_copy(pData, aaData[i], 4*(4+i%8));
+		}
+		CSnapshot *pSnap = (CSnapshot *)s_aaSnaps[Tick&1];
+		s_Builder.Finish(pSnap);
+		int DeltaSize = s_Delta.CreateDelta(pPrev, pSnap, s_aDelta);
+		StreamSize += CVariableInt::Compress(s_aDelta, DeltaSize, s_aStream+StreamSize, sizeof(s_aStream)-StreamSize);
+		pPrev = pSnap;
+	}
+
+	// cut into packets of different sizes
+	int Offset = 0;
+	for(int i = 0; i < NumPackets; i++)
+	{
+		pSizes[i] = 1+Random(PACKET_SIZE-1);
+		if(Offset+pSizes[i] > StreamSize)
+			Offset = 0;
+		mem_copy(paPackets[i], s_aStream+Offset, pSizes[i]);
+		Offset += pSizes[i];
+	}
+	return NumPackets;
+}
+
+static int Run(const char *pName, const unsigned *pFrequencies, unsigned char (*paPackets)[PACKET_SIZE], int *pSizes, int NumPackets, int Rounds)
+{
+	static CHuffman s_Huffman;
+	static CHuffmanRef s_Ref;
+	static unsigned char s_aaComp[MAX_PACKETS][PACKET_SIZE*2];
+	static int s_aCompSizes[MAX_PACKETS];
+	unsigned char aRef[PACKET_SIZE*2];
+	unsigned char aOut[PACKET_SIZE];
+	int Errors = 0;
+
+	s_Huffman.Init(pFrequencies);
+	s_Ref.Init(pFrequencies);
+
+	// both directions have to give exactly what the old code gave
+	int TotalSize = 0;
+	int TotalComp = 0;
+	for(int i = 0; i < NumPackets; i++)
+	{
+		s_aCompSizes[i] = s_Huffman.Compress(paPackets[i], pSizes[i], s_aaComp[i], sizeof(s_aaComp[i]));
+		int RefSize = s_Ref.Compress(paPackets[i], pSizes[i], aRef, sizeof(aRef));
+		if(s_aCompSizes[i] != RefSize || mem_comp(s_aaComp[i], aRef, RefSize) != 0)
+		{
+			dbg_msg("huffman_bench", "%s: packet %d compresses differently", pName, i);
+			Errors++;
+			continue;
+		}
+
+		int OutSize = s_Huffman.Decompress(s_aaComp[i], s_aCompSizes[i], aOut, sizeof(aOut));
+		if(OutSize != pSizes[i] || mem_comp(aOut, paPackets[i], OutSize) != 0)
+		{
+			dbg_msg("huffman_bench", "%s: packet %d does not survive the round trip", pName, i);
+			Errors++;
+		}
+
+		// too small buffers and cut off input fail the same way
+		int Small = max(1, s_aCompSizes[i]-1-Random(4));
+		if(s_Huffman.Compress(paPackets[i], pSizes[i], aRef, Small) != s_Ref.Compress(paPackets[i], pSizes[i], aRef, Small))
+		{
+			dbg_msg("huffman_bench", "%s: packet %d does not fail into a small buffer", pName, i);
+			Errors++;
+		}
+		if(pSizes[i] > 1 && s_Huffman.Decompress(s_aaComp[i], s_aCompSizes[i], aOut, pSizes[i]-1) != -1)
+		{
+			dbg_msg("huffman_bench", "%s: packet %d decompresses into a too small buffer", pName, i);
+			Errors++;
+		}
+		if(s_Huffman.Decompress(s_aaComp[i], s_aCompSizes[i]/2, aOut, sizeof(aOut)) != -1)
+		{
+			dbg_msg("huffman_bench", "%s: packet %d decompresses with half of its data", pName, i);
+			Errors++;
+		}
+
+		TotalSize += pSizes[i];
+		TotalComp += s_aCompSizes[i];
+	}
+
+	int64 aTimes[4] = {0};
+	for(int r = 0; r < Rounds; r++)
+	{
+		int64 Start = time_get();
+		for(int i = 0; i < NumPackets; i++)
+			s_Ref.Compress(paPackets[i], pSizes[i], aRef, sizeof(aRef));
+		aTimes[0] += time_get()-Start;
+
+		Start = time_get();
+		for(int i = 0; i < NumPackets; i++)
+			s_Huffman.Compress(paPackets[i], pSizes[i], aRef, sizeof(aRef));
+		aTimes[1] += time_get()-Start;
+
+		Start = time_get();
+		for(int i = 0; i < NumPackets; i++)
+			s_Ref.Decompress(s_aaComp[i], s_aCompSizes[i], aOut, sizeof(aOut));
+		aTimes[2] += time_get()-Start;
+
+		Start = time_get();
+		for(int i = 0; i < NumPackets; i++)
+			s_Huffman.Decompress(s_aaComp[i], s_aCompSizes[i], aOut, sizeof(aOut));
+		aTimes[3] += time_get()-Start;
+	}
+
+	// throughput in uncompressed data
+	double MBytes = (double)TotalSize*Rounds/(1024.0*1024.0);
+	double Freq = (double)time_freq();
+	dbg_msg("huffman_bench", "%s: %d packets, %d bytes -> %d bytes", pName, NumPackets, TotalSize, TotalComp);
+	dbg_msg("huffman_bench", "  compress:   %8.1f MB/s (was %8.1f MB/s)", MBytes*Freq/aTimes[1], MBytes*Freq/aTimes[0]);
+	dbg_msg("huffman_bench", "  decompress: %8.1f MB/s (was %8.1f MB/s)", MBytes*Freq/aTimes[3], MBytes*Freq/aTimes[2]);
+	return Errors;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	static unsigned char s_aaPackets[MAX_PACKETS][PACKET_SIZE];
+	static int s_aSizes[MAX_PACKETS];
+	int Rounds = 20;
+	if(argc > 1) // ignore_convention
+		Rounds = max(1, atoi(argv[1])); // ignore_convention
+
+	int NumPackets = GeneratePackets(s_aaPackets, s_aSizes, MAX_PACKETS);
+
+	// a table made from the packets, the way the network table was made
+	unsigned aFrequencies[256] = {0};
+	for(int i = 0; i < NumPackets; i++)
+		for(int b = 0; b < s_aSizes[i]; b++)
+			aFrequencies[s_aaPackets[i][b]]++;
+	int Errors = Run("packets", aFrequencies, s_aaPackets, s_aSizes, NumPackets, Rounds);
+
+	// a very skewed table gives codes much longer than the lut
+	for(int i = 0; i < 256; i++)
+		aFrequencies[i] = 1+(i < 16 ? (1<<(16-i)) : 0);
+	Errors += Run("long codes", aFrequencies, s_aaPackets, s_aSizes, NumPackets, max(1, Rounds/4));
+
+	if(Errors)
+		dbg_msg("huffman_bench", "%d errors", Errors);
+	return Errors ? -1 : 0;
+}
@@ -0,0 +1,340 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/shared/snapshotkernels.h>
+
+#include <game/generated/protocol.h>
+
+#include <cstdlib>
+
+static unsigned s_Seed = 1;
+static int Random(int Max)
+{
+	s_Seed = s_Seed*1103515245+12345;
+	return (s_Seed>>16)%Max;
+}
+
+// values like the game sends them, mostly small with the odd large or negative one
+static int RandomValue()
+{
+	switch(Random(8))
+	{
+	case 0: return Random(0x7fff)<<Random(17);
+	case 1: return -Random(5000);
+	case 2: return Random(2) ? (-0x7fffffff-1) : 0x7fffffff;
+	default: return Random(2000);
+	}
+}
+
+// fills the builder with as many items as fit, keys are unique and in random order
+static int BuildSnapshot(CSnapshot *pSnap, int *pKeys)
+{
+	static CSnapshotBuilder s_Builder;
+	s_Builder.Init();
+
+	int NumItems = 0;
+	while(1)
+	{
+		int Type = 1+Random(20);
+		int ID = Random(4096);
+		if(s_Builder.GetItemData((Type<<16)|ID))
+			continue;
+		int *pData = (int *)s_Builder.NewItem(Type, ID, 4*(2+Random(6)));
+		if(!pData)
+			break;
+		pData[0] = ID;
+		pKeys[NumItems++] = (Type<<16)|ID;
+	}
+	s_Builder.Finish(pSnap);
+	return NumItems;
+}
+
+// next snapshot of a game: most items stay, some move, a few come and go
+static int NextSnapshot(CSnapshot *pFrom, CSnapshot *pTo)
+{
+	static CSnapshotBuilder s_Builder;
+	s_Builder.Init();
+
+	for(int i = 0; i < pFrom->NumItems(); i++)
+	{
+		if(Random(50) == 0)
+			continue;
+		CSnapshotItem *pItem = pFrom->GetItem(i);
+		int Size = pFrom->GetItemSize(i);
+		int *pData = (int *)s_Builder.NewItem(pItem->Type(), pItem->ID(), Size);
+		mem_copy(pData, pItem->Data(), Size);
+		if(Random(3) == 0)
+		{
+			for(int c = Random(Size/4)+1; c > 0; c--)
+				pData[Random(Size/4)] += Random(4) ? Random(64)-32 : RandomValue();
+		}
+	}
+	for(int n = Random(40); n > 0; n--)
+	{
+		int Type = 1+Random(20);
+		int ID = Random(4096);
+		if(s_Builder.GetItemData((Type<<16)|ID))
+			continue;
+		int Size = 4*(1+Random(24));
+		int *pData = (int *)s_Builder.NewItem(Type, ID, Size);
+		if(!pData)
+			break;
+		for(int b = 0; b < Size/4; b++)
+			pData[b] = RandomValue();
+	}
+	return s_Builder.Finish(pTo);
+}
+
+static void BenchLookups(int Rounds)
+{
+	static char s_aSnapData[CSnapshot::MAX_SIZE];
+	static int s_aKeys[1024];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnapData;
+	int NumItems = BuildSnapshot(pSnap, s_aKeys);
+
+	// every item once and as many misses, like the client looking up the previous snapshot
+	int Lookups = 0;
+	int Found = 0;
+	int64 Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+	{
+		for(int i = 0; i < NumItems; i++)
+		{
+			Found += pSnap->GetItemIndex(s_aKeys[i]) != -1;
+			Found += pSnap->GetItemIndex(s_aKeys[i]^0x8000) != -1;
+			Lookups += 2;
+		}
+	}
+	int64 Linear = time_get()-Start;
+
+	static CSnapshotIndex s_Index;
+	Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+		s_Index.Build(pSnap);
+	int64 Build = time_get()-Start;
+
+	Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+	{
+		for(int i = 0; i < NumItems; i++)
+		{
+			Found += s_Index.GetItemIndex(s_aKeys[i]) != -1;
+			Found += s_Index.GetItemIndex(s_aKeys[i]^0x8000) != -1;
+		}
+	}
+	int64 Indexed = time_get()-Start;
+
+	// both lookups have to agree
+	for(int i = 0; i < NumItems; i++)
+	{
+		if(s_Index.GetItemIndex(s_aKeys[i]) != pSnap->GetItemIndex(s_aKeys[i]))
+			dbg_msg("snapshot_bench", "index mismatch for key %x", s_aKeys[i]);
+	}
+
+	double Freq = (double)time_freq();
+	dbg_msg("snapshot_bench", "lookups: items=%d rounds=%d lookups/round=%d found=%d", NumItems, Rounds, Lookups/Rounds, Found);
+	dbg_msg("snapshot_bench", "  linear:  %8.2f ns/lookup", Linear*1e9/Freq/Lookups);
+	dbg_msg("snapshot_bench", "  indexed: %8.2f ns/lookup, %8.2f us/build", Indexed*1e9/Freq/Lookups, Build*1e6/Freq/Rounds);
+}
+
+enum
+{
+	MAX_PAIRS=64,
+};
+
+// the snapshots the kernels run on, pair i goes from snapshot i to i+1
+static char s_aaSnapData[MAX_PAIRS+1][CSnapshot::MAX_SIZE];
+
+static int GenerateSnapshots(int NumPairs)
+{
+	static int s_aKeys[1024];
+	BuildSnapshot((CSnapshot *)s_aaSnapData[0], s_aKeys);
+	for(int i = 0; i < NumPairs; i++)
+		NextSnapshot((CSnapshot *)s_aaSnapData[i], (CSnapshot *)s_aaSnapData[i+1]);
+	return NumPairs;
+}
+
+// collects the snapshots of a recorded demo, one every few ticks so the pairs look like real deltas
+class CDemoSnapshots : public CDemoPlayer::IListner
+{
+public:
+	int m_NumSnaps;
+	int m_Skip;
+
+	virtual void OnDemoPlayerSnapshot(void *pData, int Size)
+	{
+		if(m_NumSnaps > MAX_PAIRS || m_Skip-- > 0)
+			return;
+		m_Skip = 2;
+		mem_copy(s_aaSnapData[m_NumSnaps++], pData, Size);
+	}
+	virtual void OnDemoPlayerMessage(void *pData, int Size) {}
+};
+
+static int LoadDemoSnapshots(const char *pFilename, int argc, const char **argv) // ignore_convention
+{
+	// the deltas leave out the sizes of the game's items like for the client
+	static CSnapshotDelta s_SnapshotDelta;
+	CNetObjHandler NetObjHandler;
+	for(int i = 0; i < NUM_NETOBJTYPES; i++)
+		s_SnapshotDelta.SetStaticsize(i, NetObjHandler.GetObjSize(i));
+	CNetBase::Init();
+	IStorageTW *pStorage = CreateStorage("Teeworlds", argc, argv); // ignore_convention
+	IConsole *pConsole = CreateConsole(0);
+	CDemoPlayer *pPlayer = new CDemoPlayer(&s_SnapshotDelta);
+	CDemoSnapshots Snapshots;
+	Snapshots.m_NumSnaps = 0;
+	Snapshots.m_Skip = 0;
+	pPlayer->SetListner(&Snapshots);
+
+	if(!pStorage || pPlayer->Load(pStorage, pConsole, pFilename, IStorageTW::TYPE_ALL) != 0)
+	{
+		dbg_msg("snapshot_bench", "could not load demo '%s'", pFilename);
+		return 0;
+	}
+
+	// play it as fast as possible until the end or enough snapshots
+	pPlayer->Play();
+	pPlayer->SetSpeed(1000000.0f);
+	while(pPlayer->IsPlaying() && !pPlayer->BaseInfo()->m_Paused && Snapshots.m_NumSnaps <= MAX_PAIRS)
+		pPlayer->Update();
+	pPlayer->Stop();
+	return max(Snapshots.m_NumSnaps-1, 0);
+}
+
+// the crc like it was before the kernels, a plain sum over the item data
+static int ReferenceCrc(CSnapshot *pSnap)
+{
+	unsigned Crc = 0;
+	for(int i = 0; i < pSnap->NumItems(); i++)
+	{
+		const int *pData = (const int *)pSnap->GetItem(i)->Data();
+		for(int b = 0; b < pSnap->GetItemSize(i)/4; b++)
+			Crc += (unsigned)pData[b];
+	}
+	return (int)Crc;
+}
+
+// runs the delta code on the snapshot pairs with every kernel set and checks them against the scalar reference
+static int BenchKernels(const char *pSource, int NumPairs)
+{
+	static char s_aaDeltaRef[MAX_PAIRS][CSnapshot::MAX_SIZE];
+	static char s_aaUnpackRef[MAX_PAIRS][CSnapshot::MAX_SIZE];
+	static int s_aDeltaSizeRef[MAX_PAIRS];
+	static int s_aUnpackSizeRef[MAX_PAIRS];
+	static int s_aCrcRef[MAX_PAIRS];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	static char s_aUnpack[CSnapshot::MAX_SIZE];
+	static CSnapshotDelta s_aDeltas[CSnapshotKernels::NUM_KERNELS];
+
+	int Errors = 0;
+	double Freq = (double)time_freq();
+	dbg_msg("snapshot_bench", "kernels on %s: pairs=%d items=%d", pSource, NumPairs, ((CSnapshot *)s_aaSnapData[0])->NumItems());
+
+	// the packed crc has to give the same as the old per item sum
+	for(int i = 0; i <= NumPairs; i++)
+	{
+		CSnapshot *pSnap = (CSnapshot *)s_aaSnapData[i];
+		if(pSnap->Crc() != ReferenceCrc(pSnap))
+		{
+			dbg_msg("snapshot_bench", "  snapshot %d crc %08x, the per item sum gives %08x", i, pSnap->Crc(), ReferenceCrc(pSnap));
+			Errors++;
+		}
+	}
+
+	for(int k = 0; k < CSnapshotKernels::NUM_KERNELS; k++)
+	{
+		const CSnapshotKernels::CKernels *pKernels = CSnapshotKernels::Get(k);
+		if(!pKernels)
+			continue;
+		CSnapshotKernels::Select(k);
+
+		CSnapshotDelta *pDelta = &s_aDeltas[k];
+		int64 DeltaTime = 0, UnpackTime = 0, CrcTime = 0;
+		for(int i = 0; i < NumPairs; i++)
+		{
+			CSnapshot *pFrom = (CSnapshot *)s_aaSnapData[i];
+			CSnapshot *pTo = (CSnapshot *)s_aaSnapData[i+1];
+
+			int64 Start = time_get();
+			int DeltaSize = pDelta->CreateDelta(pFrom, pTo, s_aDelta);
+			DeltaTime += time_get()-Start;
+
+			Start = time_get();
+			int UnpackSize = pDelta->UnpackDelta(pFrom, (CSnapshot *)s_aUnpack, s_aDelta, DeltaSize);
+			UnpackTime += time_get()-Start;
+
+			Start = time_get();
+			int Crc = pTo->Crc();
+			CrcTime += time_get()-Start;
+
+			if(k == CSnapshotKernels::KERNELS_SCALAR)
+			{
+				s_aDeltaSizeRef[i] = DeltaSize;
+				s_aUnpackSizeRef[i] = UnpackSize;
+				s_aCrcRef[i] = Crc;
+				mem_copy(s_aaDeltaRef[i], s_aDelta, DeltaSize);
+				mem_copy(s_aaUnpackRef[i], s_aUnpack, max(UnpackSize, 0));
+				if(UnpackSize < 0 || ((CSnapshot *)s_aUnpack)->Crc() != Crc || ReferenceCrc((CSnapshot *)s_aUnpack) != Crc)
+				{
+					dbg_msg("snapshot_bench", "  pair %d does not survive the delta round trip", i);
+					Errors++;
+				}
+			}
+			else if(DeltaSize != s_aDeltaSizeRef[i] || mem_comp(s_aDelta, s_aaDeltaRef[i], DeltaSize) != 0 ||
+				UnpackSize != s_aUnpackSizeRef[i] || mem_comp(s_aUnpack, s_aaUnpackRef[i], max(UnpackSize, 0)) != 0 ||
+				Crc != s_aCrcRef[i])
+			{
+				dbg_msg("snapshot_bench", "  %s differs from scalar on pair %d", pKernels->m_pName, i);
+				Errors++;
+			}
+		}
+
+		// the undiff stats have to match as well
+		for(int t = 0; t < 32 && k != CSnapshotKernels::KERNELS_SCALAR; t++)
+		{
+			if(pDelta->GetDataRate(t) != s_aDeltas[CSnapshotKernels::KERNELS_SCALAR].GetDataRate(t))
+			{
+				dbg_msg("snapshot_bench", "  %s data rate of type %d differs from scalar", pKernels->m_pName, t);
+				Errors++;
+			}
+		}
+
+		dbg_msg("snapshot_bench", "  %-6s delta %7.2f us  unpack %7.2f us  crc %6.2f us  (per pair)", pKernels->m_pName,
+			DeltaTime*1e6/Freq/NumPairs, UnpackTime*1e6/Freq/NumPairs, CrcTime*1e6/Freq/NumPairs);
+	}
+	return Errors;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int Rounds = 200;
+	if(argc > 1) // ignore_convention
+		Rounds = max(1, atoi(argv[1])); // ignore_convention
+
+	BenchLookups(Rounds);
+	int Errors = BenchKernels("generated snapshots", GenerateSnapshots(MAX_PAIRS));
+
+	// real layouts from a recorded demo
+	if(argc > 2) // ignore_convention
+	{
+		int NumPairs = LoadDemoSnapshots(argv[2], argc, argv); // ignore_convention
+		if(NumPairs > 0)
+			Errors += BenchKernels(argv[2], NumPairs); // ignore_convention
+		else
+			Errors++;
+	}
+
+	if(Errors)
+		dbg_msg("snapshot_bench", "%d errors", Errors);
+	return Errors ? -1 : 0;
+}
@@ -0,0 +1,268 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot.h>
+
+#include <cstdlib>
+
+// the codec as it was, one byte at a time
+static unsigned char *RefPack(unsigned char *pDst, int i)
+{
+	*pDst = (i>>25)&0x40;
+	i = i^(i>>31);
+	*pDst |= i&0x3F;
+	i >>= 6;
+	if(i)
+	{
+		*pDst |= 0x80;
+		while(1)
+		{
+			pDst++;
+			*pDst = i&(0x7F);
+			i >>= 7;
+			*pDst |= (i!=0)<<7;
+			if(!i)
+				break;
+		}
+	}
+	pDst++;
+	return pDst;
+}
+
+static const unsigned char *RefUnpack(const unsigned char *pSrc, int *pInOut)
+{
+	int Sign = (*pSrc>>6)&1;
+	*pInOut = *pSrc&0x3F;
+	do
+	{
+		if(!(*pSrc&0x80)) break;
+		pSrc++;
+		*pInOut |= (*pSrc&(0x7F))<<(6);
+		if(!(*pSrc&0x80)) break;
+		pSrc++;
+		*pInOut |= (*pSrc&(0x7F))<<(6+7);
+		if(!(*pSrc&0x80)) break;
+		pSrc++;
+		*pInOut |= (*pSrc&(0x7F))<<(6+7+7);
+		if(!(*pSrc&0x80)) break;
+		pSrc++;
+		*pInOut |= (unsigned)(*pSrc&(0x7F))<<(6+7+7+7);
+	} while(0);
+	pSrc++;
+	*pInOut ^= -Sign;
+	return pSrc;
+}
+
+static long RefCompress(const void *pSrc, int Size, void *pDst)
+{
+	const int *pInt = (const int *)pSrc;
+	unsigned char *pOut = (unsigned char *)pDst;
+	for(int i = 0; i < Size/4; i++)
+		pOut = RefPack(pOut, pInt[i]);
+	return (long)(pOut-(unsigned char *)pDst);
+}
+
+static long RefDecompress(const void *pSrc, int Size, void *pDst)
+{
+	const unsigned char *pIn = (const unsigned char *)pSrc;
+	const unsigned char *pEnd = pIn+Size;
+	int *pOut = (int *)pDst;
+	while(pIn < pEnd)
+		pIn = RefUnpack(pIn, pOut++);
+	return (long)((unsigned char *)pOut-(unsigned char *)pDst);
+}
+
+static unsigned s_Seed = 1;
+static int Random(int Max)
+{
+	s_Seed = s_Seed*1103515245+12345;
+	return (s_Seed>>16)%Max;
+}
+
+static int RandomInt()
+{
+	return (int)((unsigned)Random(0x10000)<<16 | Random(0x10000)) >> Random(32);
+}
+
+// a game like sequence of snapshots, the deltas between them are what goes over the wire
+static int GenerateDeltas(char *pOut, int MaxSize)
+{
+	static char s_aaSnaps[2][CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	static CSnapshotBuilder s_Builder;
+	static CSnapshotDelta s_Delta;
+
+	// some players, projectiles and pickups
+	int aTypes[256], aIDs[256], aaData[256][16], aSizes[256];
+	int NumItems = 0;
+	for(int i = 0; i < 16; i++, NumItems++)
+	{
+		aTypes[NumItems] = 9; aIDs[NumItems] = i; aSizes[NumItems] = 15; // characters
+		aTypes[++NumItems] = 10; aIDs[NumItems] = i; aSizes[NumItems] = 5; // player infos
+	}
+	for(; NumItems < 200; NumItems++)
+	{
+		aTypes[NumItems] = 2+Random(4); aIDs[NumItems] = NumItems; aSizes[NumItems] = 4+Random(3);
+	}
+	for(int i = 0; i < NumItems; i++)
+		for(int d = 0; d < 16; d++)
+			aaData[i][d] = Random(3000);
+
+	int Size = 0;
+	int Current = 0;
+	CSnapshot *pPrev = (CSnapshot *)s_aaSnaps[1];
+	pPrev->Clear();
+	for(int Tick = 0; ; Tick++)
+	{
+		s_Builder.Init();
+		for(int i = 0; i < NumItems; i++)
+		{
+			if(aTypes[i] == 9)
+			{
+				// moving players change most of their data every tick
+				aaData[i][0] = Tick;
+				for(int d = 1; d < 7; d++)
+					aaData[i][d] += Random(64)-32;
+			}
+			else if(Random(10) == 0)
+				aaData[i][Random(aSizes[i])] = Random(2) ? RandomInt() : Random(3000);
+			int *pData = (int *)s_Builder.NewItem(aTypes[i], aIDs[i], aSizes[i]*4);
+			mem_copy(pData, aaData[i], aSizes[i]*4);
+		}
+		CSnapshot *pSnap = (CSnapshot *)s_aaSnaps[Current];
+		s_Builder.Finish(pSnap);
+
+		int DeltaSize = s_Delta.CreateDelta(pPrev, pSnap, s_aDelta);
+		if(Size+DeltaSize > MaxSize)
+			break;
+		mem_copy(pOut+Size, s_aDelta, DeltaSize);
+		Size += DeltaSize;
+
+		pPrev = pSnap;
+		Current ^= 1;
+	}
+	return Size;
+}
+
+static int Check(const char *pData, int Size, unsigned char *pComp, int *pOut)
+{
+	static unsigned char s_aRef[4*1024*1024];
+	int Errors = 0;
+
+	long CompSize = CVariableInt::Compress(pData, Size, pComp, Size/4*CVariableInt::MAX_BYTES_PACKED);
+	long RefSize = RefCompress(pData, Size, s_aRef);
+	if(CompSize != RefSize || mem_comp(pComp, s_aRef, RefSize) != 0)
+	{
+		dbg_msg("varint_bench", "compress differs from the reference");
+		Errors++;
+	}
+
+	long OutSize = CVariableInt::Decompress(pComp, (int)CompSize, pOut, Size);
+	if(OutSize != Size || mem_comp(pOut, pData, Size) != 0)
+	{
+		dbg_msg("varint_bench", "decompress does not give the data back");
+		Errors++;
+	}
+
+	// broken input has to be caught instead of read or written past
+	if(CompSize > 0 && CVariableInt::Decompress(pComp, (int)CompSize, pOut, Size-4) != -1)
+	{
+		dbg_msg("varint_bench", "decompress into a too small buffer was not caught");
+		Errors++;
+	}
+	if(CompSize > 0 && CVariableInt::Compress(pData, Size, s_aRef, (int)CompSize-1) != -1)
+	{
+		dbg_msg("varint_bench", "compress into a too small buffer was not caught");
+		Errors++;
+	}
+	unsigned char aCut[2] = {0x80, 0x80};
+	if(CVariableInt::Decompress(aCut, 2, pOut, 16) != -1)
+	{
+		dbg_msg("varint_bench", "decompress of a cut off int was not caught");
+		Errors++;
+	}
+	return Errors;
+}
+
+static void Bench(const char *pName, const char *pData, int Size, int Rounds, unsigned char *pComp, int *pOut)
+{
+	long CompSize = 0;
+	int64 Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+		CompSize = RefCompress(pData, Size, pComp);
+	int64 RefCompTime = time_get()-Start;
+
+	Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+		RefDecompress(pComp, (int)CompSize, pOut);
+	int64 RefDecompTime = time_get()-Start;
+
+	Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+		CompSize = CVariableInt::Compress(pData, Size, pComp, Size/4*CVariableInt::MAX_BYTES_PACKED);
+	int64 CompTime = time_get()-Start;
+
+	Start = time_get();
+	for(int r = 0; r < Rounds; r++)
+		CVariableInt::Decompress(pComp, (int)CompSize, pOut, Size);
+	int64 DecompTime = time_get()-Start;
+
+	// throughput in uncompressed data
+	double MBytes = (double)Size*Rounds/(1024.0*1024.0);
+	double Freq = (double)time_freq();
+	dbg_msg("varint_bench", "%s: %d bytes -> %d bytes", pName, Size, (int)CompSize);
+	dbg_msg("varint_bench", "  compress:   %8.1f MB/s (was %8.1f MB/s)", MBytes*Freq/CompTime, MBytes*Freq/RefCompTime);
+	dbg_msg("varint_bench", "  decompress: %8.1f MB/s (was %8.1f MB/s)", MBytes*Freq/DecompTime, MBytes*Freq/RefDecompTime);
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	enum
+	{
+		MAX_DATA=1024*1024,
+	};
+
+	static char s_aData[MAX_DATA];
+	static unsigned char s_aComp[MAX_DATA/4*CVariableInt::MAX_BYTES_PACKED];
+	static int s_aOut[MAX_DATA/4];
+	int Rounds = 50;
+	int Errors = 0;
+
+	if(argc > 1) // ignore_convention
+		Rounds = max(1, atoi(argv[1])); // ignore_convention
+
+	// deltas captured from a game, raw ints as they go into the compression
+	if(argc > 2) // ignore_convention
+	{
+		IOHANDLE File = io_open(argv[2], IOFLAG_READ); // ignore_convention
+		if(!File)
+		{
+			dbg_msg("varint_bench", "could not open '%s'", argv[2]); // ignore_convention
+			return -1;
+		}
+		int Size = (int)io_read(File, s_aData, MAX_DATA)&~3;
+		io_close(File);
+		Errors += Check(s_aData, Size, s_aComp, s_aOut);
+		Bench(argv[2], s_aData, Size, Rounds, s_aComp, s_aOut); // ignore_convention
+	}
+
+	int Size = GenerateDeltas(s_aData, MAX_DATA);
+	Errors += Check(s_aData, Size, s_aComp, s_aOut);
+	Bench("snapshot deltas", s_aData, Size, Rounds, s_aComp, s_aOut);
+
+	// ints of every length
+	int *pInts = (int *)s_aData;
+	for(int i = 0; i < MAX_DATA/4; i++)
+		pInts[i] = RandomInt();
+	Errors += Check(s_aData, MAX_DATA, s_aComp, s_aOut);
+	Bench("random ints", s_aData, MAX_DATA, Rounds, s_aComp, s_aOut);
+
+	if(Errors)
+		dbg_msg("varint_bench", "%d errors", Errors);
+	return Errors ? -1 : 0;
+}